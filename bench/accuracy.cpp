@@ -0,0 +1,637 @@
+// Accuracy of klein's kernels against a double precision reference
+//
+// Usage: klein_accuracy [--out <file>] [--filter <substring>]
+//                       [--samples <n>] [--seed <n>]
+//
+// Every operation is evaluated on randomly sampled inputs (rotors, motors,
+// lines, planes, points, ...). The float result is compared against the same
+// operation evaluated in double precision by the independent multivector
+// implementation in pga.hpp, starting from the exact same float inputs.
+// Inputs that the operation expects to be normalized are normalized in double
+// precision before being rounded to float so that only the error of the
+// kernel itself is measured.
+//
+// Two errors are reported per sample:
+//
+// - ulp: the largest absolute component error in units in the last place of
+//   the largest reference component. Component-wise ULP errors are not
+//   meaningful for components that cancel to (nearly) zero.
+// - rel: the Euclidean norm of the error relative to that of the reference
+//
+// Results of operations returning a scalar (the inner product of planes, or
+// the meet of a plane and a point, for example) can cancel to nearly zero, in
+// which case the maximum errors reflect the conditioning of the operation
+// rather than the kernel. The mean is representative in either case.
+//
+// The maximum and mean of each over all samples are written as JSON along
+// with the instruction set and whether KLEIN_PRECISE was defined. Samples
+// producing NaN or infinite results are counted separately. The
+// operations exercising the approximate reciprocal (square root) fast paths
+// are the normalizations, scalar division, point * point, sqrt, exp, and log.
+// Comparing the reports of klein_accuracy, klein_accuracy_sse42, and
+// klein_accuracy_precise shows the cost of each fast path.
+
+#include "bench.hpp"
+#include "pga.hpp"
+
+#include <klein/klein.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifndef KLEIN_BENCH_BUILD_TYPE
+#    define KLEIN_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+using namespace kln;
+using bench::rng;
+using bench::pga::mv;
+namespace pga = bench::pga;
+
+struct outcome
+{
+    mv actual;
+    mv expected;
+};
+
+struct accuracy
+{
+    std::string name;
+    double max_ulp  = 0.0;
+    double mean_ulp = 0.0;
+    double max_rel  = 0.0;
+    double mean_rel = 0.0;
+
+    // Samples producing NaN or infinite results, which are excluded from the
+    // errors above
+    size_t non_finite = 0;
+};
+
+class harness
+{
+public:
+    harness(size_t samples, uint64_t seed, char const* filter) noexcept
+        : samples_{samples}
+        , seed_{seed}
+        , filter_{filter}
+    {}
+
+    // Evaluate `sample` (which maps a random number generator to an outcome)
+    // for every sample and record the errors under `name`
+    template <typename F>
+    void run(char const* name, F&& sample)
+    {
+        if (filter_ != nullptr && std::strstr(name, filter_) == nullptr)
+        {
+            return;
+        }
+
+        // Every operation sees the same sequence of random numbers
+        rng r{seed_};
+        accuracy a;
+        a.name = name;
+        for (size_t i = 0; i != samples_; ++i)
+        {
+            outcome o  = sample(r);
+            double ulp = ulp_error(o);
+            double rel = relative_error(o);
+            if (!std::isfinite(ulp) || !std::isfinite(rel))
+            {
+                ++a.non_finite;
+                continue;
+            }
+            a.max_ulp = ulp > a.max_ulp ? ulp : a.max_ulp;
+            a.max_rel = rel > a.max_rel ? rel : a.max_rel;
+            a.mean_ulp += ulp;
+            a.mean_rel += rel;
+        }
+        if (a.non_finite != samples_)
+        {
+            a.mean_ulp /= static_cast<double>(samples_ - a.non_finite);
+            a.mean_rel /= static_cast<double>(samples_ - a.non_finite);
+        }
+
+        std::fprintf(stderr,
+                     "%-28s max ulp %9.3g  mean ulp %9.3g  max rel %9.3g  "
+                     "mean rel %9.3g",
+                     name,
+                     a.max_ulp,
+                     a.mean_ulp,
+                     a.max_rel,
+                     a.mean_rel);
+        if (a.non_finite != 0)
+        {
+            std::fprintf(stderr, "  non-finite %zu", a.non_finite);
+        }
+        std::fprintf(stderr, "\n");
+        results_.push_back(std::move(a));
+    }
+
+    void write_json(std::FILE* file, char const* build) const
+    {
+#ifdef KLEIN_PRECISE
+        char const* precise = "true";
+#else
+        char const* precise = "false";
+#endif
+        std::fprintf(file, "{\n");
+        std::fprintf(file, "  \"isa\": \"%s\",\n", bench::isa());
+        std::fprintf(file, "  \"precise\": %s,\n", precise);
+        std::fprintf(file, "  \"build_type\": \"%s\",\n", build);
+        std::fprintf(file, "  \"samples\": %zu,\n", samples_);
+        std::fprintf(file,
+                     "  \"seed\": %llu,\n",
+                     static_cast<unsigned long long>(seed_));
+        std::fprintf(file, "  \"results\": [");
+        for (size_t i = 0; i != results_.size(); ++i)
+        {
+            accuracy const& a = results_[i];
+            std::fprintf(file,
+                         "%s\n    {\"name\": \"%s\", \"max_ulp\": %.6g, "
+                         "\"mean_ulp\": %.6g, \"max_rel\": %.6g, "
+                         "\"mean_rel\": %.6g, \"non_finite\": %zu}",
+                         i == 0 ? "" : ",",
+                         a.name.c_str(),
+                         a.max_ulp,
+                         a.mean_ulp,
+                         a.max_rel,
+                         a.mean_rel,
+                         a.non_finite);
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+    }
+
+private:
+    static double ulp_error(outcome const& o) noexcept
+    {
+        double scale = pga::max_abs(o.expected);
+        double error = 0.0;
+        for (int i = 0; i != 16; ++i)
+        {
+            double e = std::abs(o.actual[i] - o.expected[i]);
+            error    = e > error || e != e ? e : error;
+        }
+        // Spacing of floats in the binade of the largest component
+        double ulp = scale < 0x1p-126 ? 0x1p-149
+                                      : std::ldexp(1.0, std::ilogb(scale) - 23);
+        return error / ulp;
+    }
+
+    static double relative_error(outcome const& o) noexcept
+    {
+        double error = 0.0;
+        double norm  = 0.0;
+        for (int i = 0; i != 16; ++i)
+        {
+            double e = o.actual[i] - o.expected[i];
+            error += e * e;
+            norm += o.expected[i] * o.expected[i];
+        }
+        return norm == 0.0 ? std::sqrt(error) : std::sqrt(error / norm);
+    }
+
+    size_t samples_;
+    uint64_t seed_;
+    char const* filter_;
+    std::vector<accuracy> results_;
+};
+
+constexpr double pi = 3.14159265358979323846;
+
+float uniform(rng& r, double lo, double hi) noexcept
+{
+    return static_cast<float>(r.uniform(lo, hi));
+}
+
+// Random inputs. Versors and lines are normalized in double precision and
+// then rounded.
+
+rotor random_rotor(rng& r) noexcept
+{
+    rotor out{uniform(r, -pi, pi),
+              uniform(r, -1.0, 1.0),
+              uniform(r, -1.0, 1.0),
+              uniform(r, 0.1, 1.0)};
+    return pga::to_rotor(pga::normalized(pga::from(out)));
+}
+
+translator random_translator(rng& r) noexcept
+{
+    return translator{uniform(r, 0.0, 10.0),
+                      uniform(r, -1.0, 1.0),
+                      uniform(r, -1.0, 1.0),
+                      uniform(r, 0.1, 1.0)};
+}
+
+motor random_motor(rng& r) noexcept
+{
+    rotor ro      = random_rotor(r);
+    translator tr = random_translator(r);
+    return pga::to_motor(pga::normalized(pga::from(tr) * pga::from(ro)));
+}
+
+plane random_plane(rng& r) noexcept
+{
+    return plane{uniform(r, -1.0, 1.0),
+                 uniform(r, -1.0, 1.0),
+                 uniform(r, -1.0, 1.0),
+                 uniform(r, -10.0, 10.0)};
+}
+
+point random_point(rng& r) noexcept
+{
+    return point{uniform(r, -10.0, 10.0),
+                 uniform(r, -10.0, 10.0),
+                 uniform(r, -10.0, 10.0)};
+}
+
+direction random_direction(rng& r) noexcept
+{
+    return direction{
+        uniform(r, -1.0, 1.0), uniform(r, -1.0, 1.0), uniform(r, -1.0, 1.0)};
+}
+
+branch random_branch(rng& r) noexcept
+{
+    return branch{
+        uniform(r, -1.0, 1.0), uniform(r, -1.0, 1.0), uniform(r, -1.0, 1.0)};
+}
+
+ideal_line random_ideal_line(rng& r) noexcept
+{
+    return ideal_line{uniform(r, -10.0, 10.0),
+                      uniform(r, -10.0, 10.0),
+                      uniform(r, -10.0, 10.0)};
+}
+
+// A general (not necessarily simple) line
+line random_line(rng& r) noexcept
+{
+    return line{uniform(r, -10.0, 10.0),
+                uniform(r, -10.0, 10.0),
+                uniform(r, -10.0, 10.0),
+                uniform(r, -1.0, 1.0),
+                uniform(r, -1.0, 1.0),
+                uniform(r, -1.0, 1.0)};
+}
+
+// The join of two points
+line random_simple_line(rng& r) noexcept
+{
+    return random_point(r) & random_point(r);
+}
+
+float random_scale(rng& r) noexcept
+{
+    return uniform(r, 0.25, 4.0);
+}
+
+// r X ~r for rotors, translators and motors and p X p for planes
+template <typename V, typename X>
+outcome sandwich(V const& v, X const& x) noexcept
+{
+    mv m = pga::from(v);
+    mv y = pga::from(x);
+    if constexpr (std::is_same_v<V, plane>)
+    {
+        return {pga::from(v(x)), m * y * m};
+    }
+    else
+    {
+        return {pga::from(v(x)), m * y * ~m};
+    }
+}
+
+template <typename A, typename B>
+outcome product(A const& a, B const& b) noexcept
+{
+    return {pga::from(a * b), pga::from(a) * pga::from(b)};
+}
+
+template <typename A, typename B>
+outcome inner(A const& a, B const& b) noexcept
+{
+    return {pga::from(a | b), pga::from(a) | pga::from(b)};
+}
+
+template <typename A, typename B>
+outcome meet(A const& a, B const& b) noexcept
+{
+    return {pga::from(a ^ b), pga::from(a) ^ pga::from(b)};
+}
+
+template <typename A, typename B>
+outcome join(A const& a, B const& b) noexcept
+{
+    return {pga::from(a & b), pga::from(a) & pga::from(b)};
+}
+
+template <typename T>
+outcome normalize(T x) noexcept
+{
+    mv expected = pga::normalized(pga::from(x));
+    x.normalize();
+    return {pga::from(x), expected};
+}
+
+template <typename T>
+outcome divide(T const& x, float s) noexcept
+{
+    return {pga::from(x / s), (1.0 / s) * pga::from(x)};
+}
+
+void normalizations(harness& h)
+{
+    h.run("normalize rotor", [](rng& r) {
+        return normalize(random_rotor(r) * random_scale(r));
+    });
+    h.run("normalize motor", [](rng& r) {
+        return normalize(random_motor(r) * random_scale(r));
+    });
+    h.run("normalize_precise motor", [](rng& r) {
+        motor m     = random_motor(r) * random_scale(r);
+        mv expected = pga::normalized(pga::from(m));
+        m.normalize_precise();
+        return outcome{pga::from(m), expected};
+    });
+    h.run("normalize plane", [](rng& r) {
+        return normalize(random_plane(r));
+    });
+    h.run("normalize line", [](rng& r) {
+        return normalize(random_simple_line(r));
+    });
+    h.run("normalize branch", [](rng& r) {
+        return normalize(random_branch(r));
+    });
+    h.run("normalize point", [](rng& r) {
+        point p = random_point(r);
+        p.p3_   = _mm_mul_ps(p.p3_, _mm_set1_ps(random_scale(r)));
+        return normalize(p);
+    });
+    h.run("normalize direction", [](rng& r) {
+        // Directions are ideal, so the reference is the Euclidean length
+        direction d = random_direction(r);
+        mv expected = pga::from(d);
+        double norm = std::sqrt(expected[13] * expected[13]
+                                + expected[11] * expected[11]
+                                + expected[7] * expected[7]);
+        d.normalize();
+        return outcome{pga::from(d), (1.0 / norm) * expected};
+    });
+}
+
+void divisions(harness& h)
+{
+    h.run("rotor / float", [](rng& r) {
+        return divide(random_rotor(r), random_scale(r));
+    });
+    h.run("motor / float", [](rng& r) {
+        return divide(random_motor(r), random_scale(r));
+    });
+    h.run("plane / float", [](rng& r) {
+        return divide(random_plane(r), random_scale(r));
+    });
+    h.run("point / float", [](rng& r) {
+        return divide(random_point(r), random_scale(r));
+    });
+    h.run("line / float", [](rng& r) {
+        return divide(random_line(r), random_scale(r));
+    });
+}
+
+void products(harness& h)
+{
+    h.run("rotor * rotor", [](rng& r) {
+        return product(random_rotor(r), random_rotor(r));
+    });
+    h.run("rotor * translator", [](rng& r) {
+        return product(random_rotor(r), random_translator(r));
+    });
+    h.run("motor * motor", [](rng& r) {
+        return product(random_motor(r), random_motor(r));
+    });
+    h.run("plane * plane", [](rng& r) {
+        return product(random_plane(r), random_plane(r));
+    });
+    h.run("plane * point", [](rng& r) {
+        return product(random_plane(r), random_point(r));
+    });
+    h.run("branch * branch", [](rng& r) {
+        return product(random_branch(r), random_branch(r));
+    });
+    h.run("point * point", [](rng& r) {
+        // Scaled such that the scalar part is one
+        point a = random_point(r);
+        point b = random_point(r);
+        mv ab   = pga::from(a) * pga::from(b);
+        return outcome{pga::from(a * b), (1.0 / ab[0]) * ab};
+    });
+}
+
+void sandwiches(harness& h)
+{
+    h.run("rotor(plane)", [](rng& r) {
+        return sandwich(random_rotor(r), random_plane(r));
+    });
+    h.run("rotor(line)", [](rng& r) {
+        return sandwich(random_rotor(r), random_line(r));
+    });
+    h.run("rotor(point)", [](rng& r) {
+        return sandwich(random_rotor(r), random_point(r));
+    });
+    h.run("rotor(direction)", [](rng& r) {
+        return sandwich(random_rotor(r), random_direction(r));
+    });
+    h.run("translator(plane)", [](rng& r) {
+        return sandwich(random_translator(r), random_plane(r));
+    });
+    h.run("translator(line)", [](rng& r) {
+        return sandwich(random_translator(r), random_line(r));
+    });
+    h.run("translator(point)", [](rng& r) {
+        return sandwich(random_translator(r), random_point(r));
+    });
+    h.run("motor(plane)", [](rng& r) {
+        return sandwich(random_motor(r), random_plane(r));
+    });
+    h.run("motor(line)", [](rng& r) {
+        return sandwich(random_motor(r), random_line(r));
+    });
+    h.run("motor(point)", [](rng& r) {
+        return sandwich(random_motor(r), random_point(r));
+    });
+    h.run("motor(direction)", [](rng& r) {
+        return sandwich(random_motor(r), random_direction(r));
+    });
+    h.run("motor(origin)", [](rng& r) {
+        motor m = random_motor(r);
+        mv o    = pga::from(point{0.f, 0.f, 0.f});
+        return outcome{pga::from(m(origin{})),
+                       pga::from(m) * o * ~pga::from(m)};
+    });
+    h.run("motor(point*)", [](rng& r) {
+        // The batch kernel on a small array. The errors of the last element
+        // are reported.
+        motor m = random_motor(r);
+        point in[4];
+        point out[4];
+        for (point& p : in)
+        {
+            p = random_point(r);
+        }
+        m(in, out, 4);
+        mv expected = pga::from(m) * pga::from(in[3]) * ~pga::from(m);
+        return outcome{pga::from(out[3]), expected};
+    });
+    h.run("plane(plane)", [](rng& r) {
+        plane p = random_plane(r);
+        p       = pga::to_plane(pga::normalized(pga::from(p)));
+        return sandwich(p, random_plane(r));
+    });
+}
+
+void exp_logs(harness& h)
+{
+    h.run("exp(line)", [](rng& r) {
+        line l = random_line(r) * 0.5f;
+        return outcome{pga::from(exp(l)), pga::exp(pga::from(l))};
+    });
+    h.run("log(motor)", [](rng& r) {
+        motor m = random_motor(r);
+        return outcome{pga::from(log(m)), pga::log(pga::from(m))};
+    });
+    h.run("sqrt(motor)", [](rng& r) {
+        motor m = random_motor(r);
+        return outcome{pga::from(sqrt(m)), pga::sqrt(pga::from(m))};
+    });
+    h.run("exp(branch)", [](rng& r) {
+        branch b = random_branch(r);
+        return outcome{pga::from(exp(b)), pga::exp(pga::from(b))};
+    });
+    h.run("log(rotor)", [](rng& r) {
+        rotor ro = random_rotor(r);
+        return outcome{pga::from(log(ro)), pga::log(pga::from(ro))};
+    });
+    h.run("sqrt(rotor)", [](rng& r) {
+        rotor ro = random_rotor(r);
+        return outcome{pga::from(sqrt(ro)), pga::sqrt(pga::from(ro))};
+    });
+    h.run("exp(ideal_line)", [](rng& r) {
+        ideal_line l = random_ideal_line(r);
+        return outcome{pga::from(exp(l)), pga::exp(pga::from(l))};
+    });
+}
+
+void exterior(harness& h)
+{
+    h.run("plane ^ plane", [](rng& r) {
+        return meet(random_plane(r), random_plane(r));
+    });
+    h.run("plane ^ line", [](rng& r) {
+        return meet(random_plane(r), random_line(r));
+    });
+    h.run("plane ^ point", [](rng& r) {
+        return meet(random_plane(r), random_point(r));
+    });
+    h.run("line ^ line", [](rng& r) {
+        return meet(random_line(r), random_line(r));
+    });
+    h.run("point & point", [](rng& r) {
+        return join(random_point(r), random_point(r));
+    });
+    h.run("point & line", [](rng& r) {
+        return join(random_point(r), random_line(r));
+    });
+    h.run("plane & point", [](rng& r) {
+        return join(random_plane(r), random_point(r));
+    });
+    h.run("plane | plane", [](rng& r) {
+        return inner(random_plane(r), random_plane(r));
+    });
+    h.run("plane | line", [](rng& r) {
+        return inner(random_plane(r), random_line(r));
+    });
+    h.run("plane | point", [](rng& r) {
+        return inner(random_plane(r), random_point(r));
+    });
+    h.run("line | line", [](rng& r) {
+        return inner(random_line(r), random_line(r));
+    });
+    h.run("point | line", [](rng& r) {
+        return inner(random_point(r), random_line(r));
+    });
+    h.run("point | point", [](rng& r) {
+        return inner(random_point(r), random_point(r));
+    });
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t samples     = 100000;
+    size_t seed        = 1;
+    char const* filter = nullptr;
+    char const* out    = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        char const* arg  = argv[i];
+        char const* next = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok          = next != nullptr;
+        if (ok && std::strcmp(arg, "--out") == 0)
+        {
+            out = next;
+        }
+        else if (ok && std::strcmp(arg, "--filter") == 0)
+        {
+            filter = next;
+        }
+        else if (ok && std::strcmp(arg, "--samples") == 0)
+        {
+            ok = bench::parse_size(next, samples);
+        }
+        else if (ok && std::strcmp(arg, "--seed") == 0)
+        {
+            ok = bench::parse_size(next, seed);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return 1;
+        }
+        ++i;
+    }
+
+    harness h{samples, seed, filter};
+    normalizations(h);
+    divisions(h);
+    products(h);
+    sandwiches(h);
+    exp_logs(h);
+    exterior(h);
+
+    std::FILE* file = out ? std::fopen(out, "w") : stdout;
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open %s\n", out);
+        return 1;
+    }
+    h.write_json(file, KLEIN_BENCH_BUILD_TYPE);
+    if (out)
+    {
+        std::fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,401 @@
+#pragma once
+
+// A minimal runtime benchmark harness. Each benchmark is a callable taking an
+// iteration count. The harness grows the iteration count until a single run
+// exceeds the minimum time and reports the fastest of several such runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+#if defined(__linux__)
+#    include <unistd.h>
+#endif
+
+namespace bench
+{
+// Prevent the compiler from discarding a computed value
+template <typename T>
+inline void do_not_optimize(T const& value)
+{
+#if defined(_MSC_VER)
+    static char const volatile* sink;
+    sink = reinterpret_cast<char const volatile*>(&value);
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Force all pending writes to memory to be considered observable
+inline void clobber()
+{
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+// xorshift64*, seeded identically for every run unless a seed is given
+class rng
+{
+public:
+    rng() noexcept = default;
+
+    explicit rng(uint64_t seed) noexcept
+        : state_{seed != 0 ? seed : 0x9e3779b97f4a7c15ull}
+    {}
+
+    // Uniform in [lo, hi)
+    double uniform(double lo, double hi) noexcept
+    {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        uint64_t bits = (state_ * 0x2545f4914f6cdd1dull) >> 11;
+        return lo + (hi - lo) * static_cast<double>(bits) * 0x1p-53;
+    }
+
+    unsigned index(unsigned count) noexcept
+    {
+        return static_cast<unsigned>(uniform(0.0, count)) % count;
+    }
+
+private:
+    uint64_t state_ = 0x9e3779b97f4a7c15ull;
+};
+
+struct config
+{
+    // Minimum duration of a single timed run in seconds
+    double min_time = 0.05;
+
+    // Number of timed runs of which the fastest is reported
+    int repetitions = 3;
+
+    size_t min_elements = 1000;
+    size_t max_elements = 10000000;
+
+    // Last level cache size used to classify batch working sets. Zero if
+    // unknown.
+    size_t llc_bytes = 0;
+
+    // Only benchmarks whose name contains this string are run
+    char const* filter = nullptr;
+
+    // Print every run to stderr
+    bool verbose = true;
+};
+
+struct result
+{
+    std::string name;
+
+    // "single" for latency bound operations on one entity and "batch" for
+    // throughput over arrays
+    char const* kind;
+    size_t elements;
+    bool in_place;
+
+    // Bytes read and written by one pass over the batch
+    size_t working_set;
+    size_t iterations;
+    double ns_per_op;
+    double elements_per_second;
+
+    // Deviation from a double precision reference. Negative if not measured.
+    double max_error = -1.0;
+    double rms_error = -1.0;
+};
+
+// Size of the level 1 (data), 2, or 3 cache. Zero if unknown.
+inline size_t detect_cache_bytes(int level)
+{
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+    long size = 0;
+    switch (level)
+    {
+    case 1:
+        size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+        break;
+    case 2:
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        break;
+    case 3:
+        size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        break;
+    default:
+        break;
+    }
+    if (size > 0)
+    {
+        return static_cast<size_t>(size);
+    }
+#else
+    (void)level;
+#endif
+    return 0;
+}
+
+inline size_t detect_llc_bytes()
+{
+    size_t l3 = detect_cache_bytes(3);
+    return l3 != 0 ? l3 : detect_cache_bytes(2);
+}
+
+class runner
+{
+public:
+    explicit runner(config const& cfg)
+        : cfg_{cfg}
+    {}
+
+    [[nodiscard]] config const& cfg() const noexcept
+    {
+        return cfg_;
+    }
+
+    [[nodiscard]] bool enabled(char const* name) const noexcept
+    {
+        return cfg_.filter == nullptr || std::strstr(name, cfg_.filter);
+    }
+
+    // Time body(iterations) where each iteration performs `ops` operations
+    // on `elements` entities
+    template <typename F>
+    void run(char const* name,
+             char const* kind,
+             size_t elements,
+             bool in_place,
+             size_t working_set,
+             size_t ops,
+             F&& body)
+    {
+        using clock = std::chrono::steady_clock;
+
+        // Warm up (and fault in any untouched pages)
+        body(size_t{1});
+
+        size_t iterations = 1;
+        double best       = 0.0;
+        for (int r = 0; r != cfg_.repetitions; ++r)
+        {
+            while (true)
+            {
+                auto start = clock::now();
+                body(iterations);
+                double elapsed
+                    = std::chrono::duration<double>(clock::now() - start)
+                          .count();
+                if (elapsed >= cfg_.min_time)
+                {
+                    double per_iteration = elapsed / iterations;
+                    if (r == 0 || per_iteration < best)
+                    {
+                        best = per_iteration;
+                    }
+                    break;
+                }
+                // Aim slightly past the minimum time on the next attempt
+                double scale = elapsed > 0.0 ? 1.2 * cfg_.min_time / elapsed
+                                             : 100.0;
+                scale        = std::clamp(scale, 2.0, 100.0);
+                iterations   = static_cast<size_t>(iterations * scale);
+            }
+        }
+
+        result out;
+        out.name                = name;
+        out.kind                = kind;
+        out.elements            = elements;
+        out.in_place            = in_place;
+        out.working_set         = working_set;
+        out.iterations          = iterations;
+        out.ns_per_op           = best * 1e9 / ops;
+        out.elements_per_second = ops / best;
+        results_.push_back(out);
+        if (!cfg_.verbose)
+        {
+            return;
+        }
+
+        std::fprintf(stderr,
+                     "%-32s %-6s %10zu %-12s %10.3f ns/op %12.4g elem/s\n",
+                     name,
+                     kind,
+                     elements,
+                     in_place ? "in-place" : "out-of-place",
+                     out.ns_per_op,
+                     out.elements_per_second);
+    }
+
+    [[nodiscard]] std::vector<result> const& results() const noexcept
+    {
+        return results_;
+    }
+
+    // Attach the error of the most recent run
+    void set_error(double max_error, double rms_error)
+    {
+        result& r   = results_.back();
+        r.max_error = max_error;
+        r.rms_error = rms_error;
+        std::fprintf(stderr,
+                     "%-32s max error %10.3g  rms error %10.3g\n",
+                     "",
+                     max_error,
+                     rms_error);
+    }
+
+    void write_json(std::FILE* file, char const* isa, char const* build) const
+    {
+        std::fprintf(file, "{\n");
+        std::fprintf(file, "  \"isa\": \"%s\",\n", isa);
+        std::fprintf(file, "  \"build_type\": \"%s\",\n", build);
+        std::fprintf(file, "  \"llc_bytes\": %zu,\n", cfg_.llc_bytes);
+        std::fprintf(file, "  \"results\": [");
+        for (size_t i = 0; i != results_.size(); ++i)
+        {
+            result const& r = results_[i];
+            char const* residency
+                = cfg_.llc_bytes == 0
+                      ? "unknown"
+                      : r.working_set <= cfg_.llc_bytes ? "cache" : "dram";
+            std::fprintf(file,
+                         "%s\n    {\"name\": \"%s\", \"kind\": \"%s\", "
+                         "\"elements\": %zu, \"in_place\": %s, "
+                         "\"working_set\": %zu, \"residency\": \"%s\", "
+                         "\"iterations\": %zu, \"ns_per_op\": %.6g, "
+                         "\"elements_per_second\": %.6g",
+                         i == 0 ? "" : ",",
+                         r.name.c_str(),
+                         r.kind,
+                         r.elements,
+                         r.in_place ? "true" : "false",
+                         r.working_set,
+                         residency,
+                         r.iterations,
+                         r.ns_per_op,
+                         r.elements_per_second);
+            if (r.max_error >= 0.0)
+            {
+                std::fprintf(file,
+                             ", \"max_error\": %.6g, \"rms_error\": %.6g",
+                             r.max_error,
+                             r.rms_error);
+            }
+            std::fprintf(file, "}");
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+    }
+
+private:
+    config cfg_;
+    std::vector<result> results_;
+};
+
+inline bool parse_size(char const* arg, size_t& out)
+{
+    char* end;
+    double value = std::strtod(arg, &end);
+    if (*end != '\0' || value < 1.0)
+    {
+        return false;
+    }
+    out = static_cast<size_t>(value);
+    return true;
+}
+
+// Parse the options shared by all benchmark executables. Returns false and
+// reports the offending argument on failure.
+inline bool parse_args(int argc, char** argv, config& cfg, char const*& out)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        char const* arg  = argv[i];
+        char const* next = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok          = next != nullptr;
+        if (ok && std::strcmp(arg, "--out") == 0)
+        {
+            out = next;
+        }
+        else if (ok && std::strcmp(arg, "--filter") == 0)
+        {
+            cfg.filter = next;
+        }
+        else if (ok && std::strcmp(arg, "--min-elements") == 0)
+        {
+            ok = parse_size(next, cfg.min_elements);
+        }
+        else if (ok && std::strcmp(arg, "--max-elements") == 0)
+        {
+            ok = parse_size(next, cfg.max_elements);
+        }
+        else if (ok && std::strcmp(arg, "--llc-bytes") == 0)
+        {
+            ok = parse_size(next, cfg.llc_bytes);
+        }
+        else if (ok && std::strcmp(arg, "--min-time") == 0)
+        {
+            cfg.min_time = std::strtod(next, nullptr);
+            ok           = cfg.min_time > 0.0;
+        }
+        else if (ok && std::strcmp(arg, "--repetitions") == 0)
+        {
+            cfg.repetitions = std::atoi(next);
+            ok              = cfg.repetitions > 0;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+// Instruction set the executable was built for
+inline char const* isa()
+{
+#ifdef KLEIN_SSE_4_1
+    return "sse4.1";
+#else
+    return "sse3";
+#endif
+}
+
+// Write the JSON report to `out` (stdout if null). Returns the process exit
+// code.
+inline int write_results(runner const& run, char const* out, char const* build)
+{
+    std::FILE* file = out ? std::fopen(out, "w") : stdout;
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open %s\n", out);
+        return 1;
+    }
+    run.write_json(file, isa(), build);
+    if (out)
+    {
+        std::fclose(file);
+    }
+    return 0;
+}
+} // namespace bench
@@ -0,0 +1,477 @@
+// Comparison of klein against the scalar reference implementations in
+// reference.hpp on matched workloads
+//
+// Usage: klein_compare [--out <file>] [--filter <substring>]
+//                      [--min-elements <n>] [--max-elements <n>]
+//                      [--min-time <seconds>] [--repetitions <n>]
+//                      [--llc-bytes <n>]
+//
+// Workloads:
+//
+// - point_cloud: a single rigid transformation applied to an array of points
+// - hierarchy: world transforms of a binary tree of joints computed from
+//   their local transforms (each joint's parent precedes it)
+// - skinning: vertices influenced by four of 64 bones. Klein motors and dual
+//   quaternions are blended linearly and renormalized, matrices use linear
+//   blend skinning. The klein_fast variant renormalizes with
+//   motor::normalize (approximate reciprocal square root) instead of
+//   motor::normalize_precise.
+//
+// Every variant is timed and the points it produces are compared against the
+// same algorithm evaluated in double precision from the same inputs. Results
+// are written in the same JSON format as klein_bench with the maximum and
+// root mean square position error of each run added. Element counts default
+// to 1e3 through 1e6.
+
+#include "bench.hpp"
+#include "reference.hpp"
+
+#include <klein/klein.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#ifndef KLEIN_BENCH_BUILD_TYPE
+#    define KLEIN_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+using bench::clobber;
+using bench::rng;
+using namespace bench::ref;
+
+// Parameters of a rigid transformation from which every representation is
+// built. Float representations are built from the parameters rounded to
+// float so that all of them see identical inputs.
+struct transform
+{
+    double angle;
+    vec3<double> axis;
+    vec3<double> translation;
+
+    static transform random(rng& r, double max_angle, double max_offset)
+    {
+        transform out;
+        out.angle = r.uniform(-max_angle, max_angle);
+        vec3<double> axis{
+            r.uniform(-1.0, 1.0), r.uniform(-1.0, 1.0), r.uniform(0.1, 1.0)};
+        out.axis        = (1.0 / length(axis)) * axis;
+        out.translation = {r.uniform(-max_offset, max_offset),
+                           r.uniform(-max_offset, max_offset),
+                           r.uniform(0.1, max_offset)};
+        return out;
+    }
+
+    template <typename T>
+    [[nodiscard]] quat_vec<T> as_quat_vec() const noexcept
+    {
+        auto cast = [](vec3<double> v) {
+            return vec3<T>{static_cast<T>(static_cast<float>(v.x)),
+                           static_cast<T>(static_cast<float>(v.y)),
+                           static_cast<T>(static_cast<float>(v.z))};
+        };
+        T a = static_cast<T>(static_cast<float>(angle));
+        return {axis_angle(a, cast(axis)), cast(translation)};
+    }
+
+    [[nodiscard]] kln::motor as_motor() const noexcept
+    {
+        vec3<float> t = as_quat_vec<float>().t;
+        kln::rotor r{static_cast<float>(angle),
+                     static_cast<float>(axis.x),
+                     static_cast<float>(axis.y),
+                     static_cast<float>(axis.z)};
+        kln::translator tr{length(t), t.x, t.y, t.z};
+        return tr * r;
+    }
+};
+
+vec3<double> widen(vec3<float> p) noexcept
+{
+    return {p.x, p.y, p.z};
+}
+
+vec3<double> widen(kln::point const& p) noexcept
+{
+    return {p.x(), p.y(), p.z()};
+}
+
+// Lets motors share the generic code paths of the reference types
+kln::point apply(kln::motor const& m, vec3<float> p) noexcept
+{
+    return m(kln::point{p.x, p.y, p.z});
+}
+
+// Position error of float results against a double precision reference
+template <typename P>
+void measure(bench::runner& run,
+             P const* result,
+             vec3<double> const* expected,
+             size_t count)
+{
+    double max = 0.0;
+    double sum = 0.0;
+    for (size_t i = 0; i != count; ++i)
+    {
+        double e = length(widen(result[i]) - expected[i]);
+        max      = e > max ? e : max;
+        sum += e * e;
+    }
+    run.set_error(max, std::sqrt(sum / count));
+}
+
+// Time `body` (which processes `count` elements per call) under
+// `workload/variant`. Returns false if the variant is filtered out.
+template <typename F>
+bool variant(bench::runner& run,
+             char const* workload,
+             char const* variant,
+             size_t count,
+             size_t working_set,
+             F&& body)
+{
+    std::string name = std::string{workload} + "/" + variant;
+    if (!run.enabled(name.c_str()))
+    {
+        return false;
+    }
+    run.run(name.c_str(), "batch", count, false, working_set, count,
+            [&](size_t n) {
+                for (size_t i = 0; i != n; ++i)
+                {
+                    body();
+                    clobber();
+                }
+            });
+    return true;
+}
+
+void point_cloud(bench::runner& run)
+{
+    for (size_t count = run.cfg().min_elements;
+         count <= run.cfg().max_elements;
+         count *= 10)
+    {
+        rng r;
+        transform xf = transform::random(r, 3.0, 10.0);
+
+        std::vector<vec3<float>> in(count);
+        std::vector<vec3<float>> out(count);
+        std::vector<kln::point> kln_in(count);
+        std::vector<kln::point> kln_out(count);
+        std::vector<vec3<double>> expected(count);
+        quat_vec<double> truth = xf.as_quat_vec<double>();
+        for (size_t i = 0; i != count; ++i)
+        {
+            in[i] = {static_cast<float>(r.uniform(-10.0, 10.0)),
+                     static_cast<float>(r.uniform(-10.0, 10.0)),
+                     static_cast<float>(r.uniform(-10.0, 10.0))};
+            kln_in[i]   = kln::point{in[i].x, in[i].y, in[i].z};
+            expected[i] = apply(truth, widen(in[i]));
+        }
+
+        size_t ws            = 2 * count * sizeof(vec3<float>);
+        size_t kln_ws        = 2 * count * sizeof(kln::point);
+        kln::motor m         = xf.as_motor();
+        quat_vec<float> qv   = xf.as_quat_vec<float>();
+        dual_quat<float> dq  = to_dual_quat(qv);
+        mat3x4<float> mat    = to_mat3x4(qv);
+        vec3<float> const* p = in.data();
+        vec3<float>* q       = out.data();
+
+        if (variant(run, "point_cloud", "klein", count, kln_ws, [&] {
+                m(kln_in.data(), kln_out.data(), count);
+            }))
+        {
+            measure(run, kln_out.data(), expected.data(), count);
+        }
+        if (variant(run, "point_cloud", "quat_vec", count, ws, [&] {
+                for (size_t i = 0; i != count; ++i)
+                {
+                    q[i] = apply(qv, p[i]);
+                }
+            }))
+        {
+            measure(run, q, expected.data(), count);
+        }
+        if (variant(run, "point_cloud", "dual_quat", count, ws, [&] {
+                for (size_t i = 0; i != count; ++i)
+                {
+                    q[i] = apply(dq, p[i]);
+                }
+            }))
+        {
+            measure(run, q, expected.data(), count);
+        }
+        if (variant(run, "point_cloud", "mat3x4", count, ws, [&] {
+                for (size_t i = 0; i != count; ++i)
+                {
+                    q[i] = apply(mat, p[i]);
+                }
+            }))
+        {
+            measure(run, q, expected.data(), count);
+        }
+    }
+}
+
+// Compute world transforms from local transforms where parent(i) < i and
+// world[0] = local[0]
+template <typename X>
+void propagate(X const* local, X* world, size_t count) noexcept
+{
+    world[0] = local[0];
+    for (size_t i = 1; i != count; ++i)
+    {
+        world[i] = world[(i - 1) / 2] * local[i];
+    }
+}
+
+void hierarchy(bench::runner& run)
+{
+    // The error is measured by transforming a probe point by every world
+    // transform
+    vec3<float> const probe{1.f, 1.f, 1.f};
+
+    for (size_t count = run.cfg().min_elements;
+         count <= run.cfg().max_elements;
+         count *= 10)
+    {
+        rng r;
+        std::vector<transform> xf(count);
+        for (transform& x : xf)
+        {
+            x = transform::random(r, 1.0, 1.0);
+        }
+
+        std::vector<quat_vec<double>> truth_local(count);
+        std::vector<quat_vec<double>> truth_world(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            truth_local[i] = xf[i].as_quat_vec<double>();
+        }
+        propagate(truth_local.data(), truth_world.data(), count);
+        std::vector<vec3<double>> expected(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            expected[i] = apply(truth_world[i], widen(probe));
+        }
+
+        // Each variant builds its local transforms, times the propagation,
+        // and transforms the probe by the resulting world transforms
+        auto run_variant = [&](char const* name, auto make, auto probed) {
+            using X = decltype(make(xf[0]));
+            std::vector<X> local(count);
+            std::vector<X> world(count);
+            for (size_t i = 0; i != count; ++i)
+            {
+                local[i] = make(xf[i]);
+            }
+            if (variant(run, "hierarchy", name, count, 2 * count * sizeof(X),
+                        [&] {
+                            propagate(local.data(), world.data(), count);
+                        }))
+            {
+                for (size_t i = 0; i != count; ++i)
+                {
+                    probed[i] = apply(world[i], probe);
+                }
+                measure(run, probed.data(), expected.data(), count);
+            }
+        };
+
+        run_variant(
+            "klein",
+            [](transform const& x) { return x.as_motor(); },
+            std::vector<kln::point>(count));
+        run_variant(
+            "quat_vec",
+            [](transform const& x) { return x.as_quat_vec<float>(); },
+            std::vector<vec3<float>>(count));
+        run_variant(
+            "dual_quat",
+            [](transform const& x) {
+                return to_dual_quat(x.as_quat_vec<float>());
+            },
+            std::vector<vec3<float>>(count));
+        run_variant(
+            "mat3x4",
+            [](transform const& x) {
+                return to_mat3x4(x.as_quat_vec<float>());
+            },
+            std::vector<vec3<float>>(count));
+    }
+}
+
+struct influence
+{
+    unsigned index[4];
+    float weight[4];
+};
+
+// Dual quaternion linear blending with motors
+void skin(kln::motor const* m,
+          influence const* w,
+          kln::point const* in,
+          kln::point* out,
+          size_t count,
+          bool precise) noexcept
+{
+    __m128 const sign = _mm_set1_ps(-0.f);
+    for (size_t i = 0; i != count; ++i)
+    {
+        // Flip each motor into the hemisphere of the first with a branchless
+        // sign transfer of the dot product of the rotational parts
+        kln::motor const& pivot = m[w[i].index[0]];
+        kln::motor b{_mm_setzero_ps(), _mm_setzero_ps()};
+        for (int j = 0; j != 4; ++j)
+        {
+            kln::motor const& mj = m[w[i].index[j]];
+
+            __m128 d  = _mm_mul_ps(pivot.p1_, mj.p1_);
+            d         = _mm_add_ps(d, KLN_SWIZZLE(d, 2, 3, 0, 1));
+            d         = _mm_add_ps(d, KLN_SWIZZLE(d, 1, 0, 3, 2));
+            __m128 wj = _mm_xor_ps(_mm_set1_ps(w[i].weight[j]),
+                                   _mm_and_ps(d, sign));
+            b.p1_     = _mm_add_ps(b.p1_, _mm_mul_ps(wj, mj.p1_));
+            b.p2_     = _mm_add_ps(b.p2_, _mm_mul_ps(wj, mj.p2_));
+        }
+        if (precise)
+        {
+            b.normalize_precise();
+        }
+        else
+        {
+            b.normalize();
+        }
+        out[i] = b(in[i]);
+    }
+}
+
+void skinning(bench::runner& run)
+{
+    constexpr unsigned bone_count = 64;
+
+    rng r;
+    std::vector<transform> xf(bone_count);
+    for (transform& x : xf)
+    {
+        x = transform::random(r, 2.0, 2.0);
+    }
+
+    std::vector<kln::motor> motors(bone_count);
+    std::vector<dual_quat<float>> dqs(bone_count);
+    std::vector<mat3x4<float>> mats(bone_count);
+    std::vector<dual_quat<double>> truth_dqs(bone_count);
+    std::vector<mat3x4<double>> truth_mats(bone_count);
+    for (unsigned i = 0; i != bone_count; ++i)
+    {
+        motors[i]     = xf[i].as_motor();
+        dqs[i]        = to_dual_quat(xf[i].as_quat_vec<float>());
+        mats[i]       = to_mat3x4(xf[i].as_quat_vec<float>());
+        truth_dqs[i]  = to_dual_quat(xf[i].as_quat_vec<double>());
+        truth_mats[i] = to_mat3x4(xf[i].as_quat_vec<double>());
+    }
+
+    for (size_t count = run.cfg().min_elements;
+         count <= run.cfg().max_elements;
+         count *= 10)
+    {
+        std::vector<influence> inf(count);
+        std::vector<vec3<float>> in(count);
+        std::vector<vec3<float>> out(count);
+        std::vector<kln::point> kln_in(count);
+        std::vector<kln::point> kln_out(count);
+        std::vector<vec3<double>> dlb(count);
+        std::vector<vec3<double>> lbs(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            float total = 0.f;
+            for (int j = 0; j != 4; ++j)
+            {
+                inf[i].index[j]  = r.index(bone_count);
+                inf[i].weight[j] = static_cast<float>(r.uniform(0.1, 1.0));
+                total += inf[i].weight[j];
+            }
+            double weight[4];
+            for (int j = 0; j != 4; ++j)
+            {
+                inf[i].weight[j] /= total;
+                weight[j] = inf[i].weight[j];
+            }
+
+            in[i] = {static_cast<float>(r.uniform(-1.0, 1.0)),
+                     static_cast<float>(r.uniform(-1.0, 1.0)),
+                     static_cast<float>(r.uniform(-1.0, 1.0))};
+            kln_in[i] = kln::point{in[i].x, in[i].y, in[i].z};
+            dlb[i]    = apply(blend(truth_dqs.data(), inf[i].index, weight),
+                           widen(in[i]));
+            lbs[i]    = apply(blend(truth_mats.data(), inf[i].index, weight),
+                           widen(in[i]));
+        }
+
+        influence const* w   = inf.data();
+        vec3<float> const* p = in.data();
+        vec3<float>* q       = out.data();
+        size_t ws  = count * (sizeof(influence) + 2 * sizeof(vec3<float>));
+        size_t kws = count * (sizeof(influence) + 2 * sizeof(kln::point));
+
+        // Klein is run with both the approximate and the precise motor
+        // normalization
+        for (bool precise : {true, false})
+        {
+            char const* name = precise ? "klein" : "klein_fast";
+            if (variant(run, "skinning", name, count, kws, [&] {
+                    skin(motors.data(), w, kln_in.data(), kln_out.data(),
+                         count, precise);
+                }))
+            {
+                measure(run, kln_out.data(), dlb.data(), count);
+            }
+        }
+        if (variant(run, "skinning", "dual_quat", count, ws, [&] {
+                for (size_t i = 0; i != count; ++i)
+                {
+                    dual_quat<float> b
+                        = blend(dqs.data(), w[i].index, w[i].weight);
+                    q[i] = apply(b, p[i]);
+                }
+            }))
+        {
+            measure(run, q, dlb.data(), count);
+        }
+        if (variant(run, "skinning", "mat3x4", count, ws, [&] {
+                for (size_t i = 0; i != count; ++i)
+                {
+                    mat3x4<float> b
+                        = blend(mats.data(), w[i].index, w[i].weight);
+                    q[i] = apply(b, p[i]);
+                }
+            }))
+        {
+            measure(run, q, lbs.data(), count);
+        }
+    }
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bench::config cfg;
+    cfg.llc_bytes    = bench::detect_llc_bytes();
+    cfg.max_elements = 1000000;
+    char const* out  = nullptr;
+    if (!bench::parse_args(argc, argv, cfg, out))
+    {
+        return 1;
+    }
+
+    bench::runner run{cfg};
+    point_cloud(run);
+    hierarchy(run);
+    skinning(run);
+
+    return bench::write_results(run, out, KLEIN_BENCH_BUILD_TYPE);
+}
@@ -0,0 +1,252 @@
+// Runtime throughput benchmarks
+//
+// Usage: klein_bench [--out <file>] [--filter <substring>]
+//                    [--min-elements <n>] [--max-elements <n>]
+//                    [--min-time <seconds>] [--repetitions <n>]
+//                    [--llc-bytes <n>]
+//
+// Results are printed to stderr as a table and written as JSON to the
+// output file (stdout by default). Batch benchmarks run over element counts
+// from --min-elements to --max-elements in powers of ten. The default upper
+// bound is 1e7. Pass --max-elements 100000000 to include 1e8 element runs,
+// which need several gigabytes of memory.
+//
+// Chained and in-place runs apply the same motor or rotor over and over, so
+// the entities are only stable in magnitude if the versor is normalized to
+// full precision. The run additionally flushes denormals to zero such that
+// residual drift over long runs never times microcode assists instead of
+// the kernels.
+
+#include "bench.hpp"
+
+#include <klein/klein.hpp>
+
+#include <pmmintrin.h>
+#include <vector>
+
+#ifndef KLEIN_BENCH_BUILD_TYPE
+#    define KLEIN_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+using bench::clobber;
+using bench::do_not_optimize;
+
+kln::motor make_motor(float t)
+{
+    kln::motor m{0.3f + t,
+                 0.5f,
+                 kln::line{1.f, -2.f, 0.5f, 0.2f + t, -0.4f, 0.8f}};
+    m.normalize_precise();
+    return m;
+}
+
+kln::rotor make_rotor(float t)
+{
+    return kln::rotor{0.7f + t, 1.f, -2.f + t, 0.5f};
+}
+
+// Latency bound operations where each result feeds the next
+void single(bench::runner& run)
+{
+    constexpr size_t ops = 256;
+    auto single_op       = [&](char const* name, auto&& body) {
+        if (run.enabled(name))
+        {
+            run.run(name, "single", 1, true, 0, ops, body);
+        }
+    };
+
+    single_op("rotor_add", [](size_t n) {
+        kln::rotor a = make_rotor(0.f);
+        kln::rotor b = make_rotor(0.1f) * 1e-6f;
+        for (size_t i = 0; i != n * ops; ++i)
+        {
+            a = a + b;
+        }
+        do_not_optimize(a);
+    });
+
+    single_op("rotor_composition", [](size_t n) {
+        kln::rotor a = make_rotor(0.f);
+        kln::rotor b = make_rotor(0.1f);
+        for (size_t i = 0; i != n * ops; ++i)
+        {
+            a = a * b;
+        }
+        do_not_optimize(a);
+    });
+
+    single_op("motor_composition", [](size_t n) {
+        kln::motor a = make_motor(0.f);
+        kln::motor b = make_motor(0.1f);
+        for (size_t i = 0; i != n * ops; ++i)
+        {
+            a = a * b;
+        }
+        do_not_optimize(a);
+    });
+
+    single_op("motor_application", [](size_t n) {
+        kln::motor m = make_motor(0.f);
+        kln::point p{1.f, 2.f, 3.f};
+        for (size_t i = 0; i != n * ops; ++i)
+        {
+            p = m(p);
+        }
+        do_not_optimize(p);
+    });
+
+    single_op("motor_to_mat3x4", [](size_t n) {
+        kln::motor m = make_motor(0.f);
+        for (size_t i = 0; i != n * ops; ++i)
+        {
+            kln::mat3x4 mat = m.as_mat3x4();
+            do_not_optimize(mat);
+            // Feed the matrix back so successive conversions are dependent
+            m.p1_ = _mm_add_ps(m.p1_,
+                               _mm_mul_ps(mat.cols[0], _mm_set1_ps(0.f)));
+        }
+        do_not_optimize(m);
+    });
+
+    single_op("motor_to_mat4x4", [](size_t n) {
+        kln::motor m = make_motor(0.f);
+        for (size_t i = 0; i != n * ops; ++i)
+        {
+            kln::mat4x4 mat = m.as_mat4x4();
+            do_not_optimize(mat);
+            m.p1_ = _mm_add_ps(m.p1_,
+                               _mm_mul_ps(mat.cols[0], _mm_set1_ps(0.f)));
+        }
+        do_not_optimize(m);
+    });
+}
+
+// Throughput over arrays of `count` entities, both in place and out of place
+template <typename T, typename Init, typename Apply>
+void batch(bench::runner& run, char const* name, Init&& init, Apply&& apply)
+{
+    if (!run.enabled(name))
+    {
+        return;
+    }
+
+    for (size_t count = run.cfg().min_elements;
+         count <= run.cfg().max_elements;
+         count *= 10)
+    {
+        std::vector<T> in(count);
+        std::vector<T> out(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            in[i]  = init(i);
+            out[i] = in[i];
+        }
+
+        run.run(name,
+                "batch",
+                count,
+                false,
+                2 * count * sizeof(T),
+                count,
+                [&](size_t n) {
+                    for (size_t i = 0; i != n; ++i)
+                    {
+                        apply(in.data(), out.data(), count);
+                        clobber();
+                    }
+                });
+
+        run.run(name,
+                "batch",
+                count,
+                true,
+                count * sizeof(T),
+                count,
+                [&](size_t n) {
+                    for (size_t i = 0; i != n; ++i)
+                    {
+                        apply(out.data(), out.data(), count);
+                        clobber();
+                    }
+                });
+    }
+}
+
+void batches(bench::runner& run)
+{
+    kln::motor const m = make_motor(0.f);
+    kln::rotor const r = make_rotor(0.f);
+
+    auto point_at = [](size_t i) {
+        float f = static_cast<float>(i & 1023);
+        return kln::point{f, -0.5f * f, 1.f + f};
+    };
+    auto line_at = [](size_t i) {
+        float f = static_cast<float>(i & 1023);
+        return kln::line{f, 1.f, -f, 0.f, 1.f, 0.5f};
+    };
+    auto plane_at = [](size_t i) {
+        float f = static_cast<float>(i & 1023);
+        return kln::plane{1.f, f, 0.5f, -f};
+    };
+    auto motor_at
+        = [](size_t i) { return make_motor(static_cast<float>(i & 1023)); };
+
+    batch<kln::point>(run,
+                      "motor_application_points",
+                      point_at,
+                      [&](kln::point* in, kln::point* out, size_t n) {
+                          m(in, out, n);
+                      });
+    batch<kln::line>(run,
+                     "motor_application_lines",
+                     line_at,
+                     [&](kln::line* in, kln::line* out, size_t n) {
+                         m(in, out, n);
+                     });
+    batch<kln::plane>(run,
+                      "motor_application_planes",
+                      plane_at,
+                      [&](kln::plane* in, kln::plane* out, size_t n) {
+                          m(in, out, n);
+                      });
+    batch<kln::point>(run,
+                      "rotor_application_points",
+                      point_at,
+                      [&](kln::point* in, kln::point* out, size_t n) {
+                          r(in, out, n);
+                      });
+    batch<kln::motor>(run,
+                      "motor_composition_batch",
+                      motor_at,
+                      [&](kln::motor* in, kln::motor* out, size_t n) {
+                          for (size_t i = 0; i != n; ++i)
+                          {
+                              out[i] = m * in[i];
+                          }
+                      });
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bench::config cfg;
+    cfg.llc_bytes   = bench::detect_llc_bytes();
+    char const* out = nullptr;
+    if (!bench::parse_args(argc, argv, cfg, out))
+    {
+        return 1;
+    }
+
+    _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+
+    bench::runner run{cfg};
+    single(run);
+    batches(run);
+
+    return bench::write_results(run, out, KLEIN_BENCH_BUILD_TYPE);
+}
@@ -0,0 +1,384 @@
+#pragma once
+
+// A dense double precision multivector of the projective geometric algebra
+// P(R*_{3,0,1}) used as the reference for accuracy measurements. Products are
+// evaluated blade by blade from the basis bitmasks, so nothing here shares
+// code (or rounding behavior) with the SIMD kernels being measured.
+//
+// Blades are indexed by bitmask with e0 = 1, e1 = 2, e2 = 4 and e3 = 8 and
+// stored in canonical (ascending) order. Klein names some blades in a
+// different order (e31, e032, e021), which the conversions account for.
+
+#include <klein/klein.hpp>
+
+#include <cmath>
+
+namespace bench::pga
+{
+struct mv
+{
+    double c[16] = {};
+
+    [[nodiscard]] double operator[](int blade) const noexcept
+    {
+        return c[blade];
+    }
+
+    double& operator[](int blade) noexcept
+    {
+        return c[blade];
+    }
+};
+
+[[nodiscard]] inline int grade(int blade) noexcept
+{
+    return ((blade >> 0) & 1) + ((blade >> 1) & 1) + ((blade >> 2) & 1)
+           + ((blade >> 3) & 1);
+}
+
+// Sign of reordering the product of two canonical blades into canonical order
+[[nodiscard]] inline double reorder_sign(int a, int b) noexcept
+{
+    int swaps = 0;
+    for (a >>= 1; a != 0; a >>= 1)
+    {
+        swaps += grade(a & b);
+    }
+    return (swaps & 1) ? -1.0 : 1.0;
+}
+
+[[nodiscard]] inline mv operator+(mv const& a, mv const& b) noexcept
+{
+    mv out;
+    for (int i = 0; i != 16; ++i)
+    {
+        out[i] = a[i] + b[i];
+    }
+    return out;
+}
+
+[[nodiscard]] inline mv operator*(double s, mv const& a) noexcept
+{
+    mv out;
+    for (int i = 0; i != 16; ++i)
+    {
+        out[i] = s * a[i];
+    }
+    return out;
+}
+
+// Geometric product
+[[nodiscard]] inline mv operator*(mv const& a, mv const& b) noexcept
+{
+    mv out;
+    for (int i = 0; i != 16; ++i)
+    {
+        for (int j = 0; j != 16; ++j)
+        {
+            // e0 squares to zero
+            if (a[i] != 0.0 && b[j] != 0.0 && (i & j & 1) == 0)
+            {
+                out[i ^ j] += reorder_sign(i, j) * a[i] * b[j];
+            }
+        }
+    }
+    return out;
+}
+
+// Exterior product
+[[nodiscard]] inline mv operator^(mv const& a, mv const& b) noexcept
+{
+    mv out;
+    for (int i = 0; i != 16; ++i)
+    {
+        for (int j = 0; j != 16; ++j)
+        {
+            if ((i & j) == 0)
+            {
+                out[i | j] += reorder_sign(i, j) * a[i] * b[j];
+            }
+        }
+    }
+    return out;
+}
+
+// Symmetric inner product: the grade |r - s| part of the product of grade r
+// and grade s blades
+[[nodiscard]] inline mv operator|(mv const& a, mv const& b) noexcept
+{
+    mv out;
+    for (int i = 0; i != 16; ++i)
+    {
+        for (int j = 0; j != 16; ++j)
+        {
+            int g = grade(i) - grade(j);
+            if ((i & j & 1) == 0 && grade(i ^ j) == (g < 0 ? -g : g))
+            {
+                out[i ^ j] += reorder_sign(i, j) * a[i] * b[j];
+            }
+        }
+    }
+    return out;
+}
+
+[[nodiscard]] inline mv operator~(mv const& a) noexcept
+{
+    mv out;
+    for (int i = 0; i != 16; ++i)
+    {
+        int g  = grade(i);
+        out[i] = (g * (g - 1) / 2) & 1 ? -a[i] : a[i];
+    }
+    return out;
+}
+
+// Sign of the blade klein names for a bitmask relative to the canonical one
+[[nodiscard]] inline double klein_sign(int blade) noexcept
+{
+    // e31 = -e13, e021 = -e012, e032 = -e023
+    return blade == 10 || blade == 7 || blade == 13 ? -1.0 : 1.0;
+}
+
+// The Poincaré dual of klein's operator!, which maps the coefficient of each
+// blade (by klein's names) to the coefficient of its complement
+[[nodiscard]] inline mv operator!(mv const& a) noexcept
+{
+    mv out;
+    for (int i = 0; i != 16; ++i)
+    {
+        out[15 ^ i] = klein_sign(i) * klein_sign(15 ^ i) * a[i];
+    }
+    return out;
+}
+
+// Regressive product
+[[nodiscard]] inline mv operator&(mv const& a, mv const& b) noexcept
+{
+    return !(!a ^ !b);
+}
+
+// Inverse of a multivector m for which m * ~m is a dual number s + p e0123
+// (all versors and blades). The result satisfies m * inverse(m) = 1.
+[[nodiscard]] inline mv inverse(mv const& m) noexcept
+{
+    mv n = m * ~m;
+    mv inv;
+    inv[0]  = 1.0 / n[0];
+    inv[15] = -n[15] / (n[0] * n[0]);
+    return ~m * inv;
+}
+
+// Scale m such that m * ~m = 1 (or -1 for points). For motors and lines this
+// removes the pseudoscalar part of m * ~m as well.
+[[nodiscard]] inline mv normalized(mv const& m) noexcept
+{
+    mv n = m * ~m;
+    double s = std::sqrt(std::abs(n[0]));
+    mv inv_sqrt;
+    // (s^2 + p e0123)^(-1/2) = 1 / s - p / (2 s^3) e0123
+    inv_sqrt[0]  = 1.0 / s;
+    inv_sqrt[15] = -0.5 * n[15] / (s * s * s);
+    return m * inv_sqrt;
+}
+
+[[nodiscard]] inline double max_abs(mv const& m) noexcept
+{
+    double out = 0.0;
+    for (double c : m.c)
+    {
+        out = std::abs(c) > out ? std::abs(c) : out;
+    }
+    return out;
+}
+
+// Exponential of a bivector by scaling and squaring of the Taylor series
+[[nodiscard]] inline mv exp(mv const& b) noexcept
+{
+    int squarings = 0;
+    double scale  = 1.0;
+    while (max_abs(b) * scale > 0.125)
+    {
+        scale *= 0.5;
+        ++squarings;
+    }
+    mv x = scale * b;
+    mv out;
+    mv term;
+    out[0]  = 1.0;
+    term[0] = 1.0;
+    for (int k = 1; k != 24; ++k)
+    {
+        term = (1.0 / k) * (term * x);
+        out  = out + term;
+    }
+    for (int i = 0; i != squarings; ++i)
+    {
+        out = out * out;
+    }
+    return out;
+}
+
+// Principal square root of a normalized rotor or motor
+[[nodiscard]] inline mv sqrt(mv const& m) noexcept
+{
+    mv one;
+    one[0] = 1.0;
+    return normalized(one + normalized(m));
+}
+
+// Principal logarithm of a rotor or motor, returning a bivector. Repeated
+// square roots bring m close to the identity where the series
+// log(exp(x)) = <x>_2 - <x>_2^3 / 6 + O(x^5) converges quickly.
+[[nodiscard]] inline mv log(mv const& m) noexcept
+{
+    constexpr int roots = 16;
+    mv x                = normalized(m);
+    for (int i = 0; i != roots; ++i)
+    {
+        x = sqrt(x);
+    }
+    mv b;
+    for (int i = 0; i != 16; ++i)
+    {
+        b[i] = grade(i) == 2 ? x[i] : 0.0;
+    }
+    b = b + (-1.0 / 6.0) * (b * b * b);
+    return static_cast<double>(1 << roots) * b;
+}
+
+namespace detail
+{
+    // Blades of the lanes of each klein partition
+    constexpr int p0_blades[4] = {1, 2, 4, 8};   // e0, e1, e2, e3
+    constexpr int p1_blades[4] = {0, 12, 10, 6}; // 1, e23, e31, e12
+    constexpr int p2_blades[4] = {15, 3, 5, 9};  // e0123, e01, e02, e03
+    constexpr int p3_blades[4] = {14, 13, 11, 7}; // e123, e032, e013, e021
+
+    // Read the lanes [first, 4) of a partition
+    inline void KLN_VEC_CALL read(mv& out,
+                                  __m128 partition,
+                                  int const* blades,
+                                  int first = 0) noexcept
+    {
+        float lanes[4];
+        _mm_storeu_ps(lanes, partition);
+        for (int i = first; i != 4; ++i)
+        {
+            out[blades[i]] = klein_sign(blades[i]) * lanes[i];
+        }
+    }
+
+    // Write m to the lanes [first, 4) of a partition, rounding to float
+    [[nodiscard]] inline __m128 write(mv const& m,
+                                      int const* blades,
+                                      int first = 0) noexcept
+    {
+        float lanes[4] = {};
+        for (int i = first; i != 4; ++i)
+        {
+            lanes[i] = static_cast<float>(klein_sign(blades[i]) * m[blades[i]]);
+        }
+        return _mm_loadu_ps(lanes);
+    }
+} // namespace detail
+
+// Conversions from klein entities. Only the lanes that belong to the entity
+// are read (the unused lanes of lines, branches and directions are ignored).
+[[nodiscard]] inline mv from(float s) noexcept
+{
+    mv out;
+    out[0] = s;
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::dual d) noexcept
+{
+    mv out;
+    out[0]  = d.p;
+    out[15] = d.q;
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::plane const& p) noexcept
+{
+    mv out;
+    detail::read(out, p.p0_, detail::p0_blades);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::point const& p) noexcept
+{
+    mv out;
+    detail::read(out, p.p3_, detail::p3_blades);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::direction const& d) noexcept
+{
+    mv out;
+    detail::read(out, d.p3_, detail::p3_blades, 1);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::branch const& b) noexcept
+{
+    mv out;
+    detail::read(out, b.p1_, detail::p1_blades, 1);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::ideal_line const& l) noexcept
+{
+    mv out;
+    detail::read(out, l.p2_, detail::p2_blades, 1);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::line const& l) noexcept
+{
+    mv out;
+    detail::read(out, l.p1_, detail::p1_blades, 1);
+    detail::read(out, l.p2_, detail::p2_blades, 1);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::rotor const& r) noexcept
+{
+    mv out;
+    detail::read(out, r.p1_, detail::p1_blades);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::translator const& t) noexcept
+{
+    mv out;
+    out[0] = 1.0;
+    detail::read(out, t.p2_, detail::p2_blades, 1);
+    return out;
+}
+
+[[nodiscard]] inline mv from(kln::motor const& m) noexcept
+{
+    mv out;
+    detail::read(out, m.p1_, detail::p1_blades);
+    detail::read(out, m.p2_, detail::p2_blades);
+    return out;
+}
+
+// Round a double precision plane, rotor or motor to float
+[[nodiscard]] inline kln::rotor to_rotor(mv const& m) noexcept
+{
+    return kln::rotor{detail::write(m, detail::p1_blades)};
+}
+
+[[nodiscard]] inline kln::plane to_plane(mv const& m) noexcept
+{
+    return kln::plane{detail::write(m, detail::p0_blades)};
+}
+
+[[nodiscard]] inline kln::motor to_motor(mv const& m) noexcept
+{
+    return kln::motor{detail::write(m, detail::p1_blades),
+                      detail::write(m, detail::p2_blades)};
+}
+} // namespace bench::pga
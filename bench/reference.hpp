@@ -0,0 +1,290 @@
+#pragma once
+
+// Scalar reference implementations of the classical representations of rigid
+// transformations. These are written the way a typical math library would
+// implement them (without intrinsics) and serve two purposes:
+//
+// - compiled with T = float, they are the baseline klein is timed against,
+// - compiled with T = double, they provide the ground truth used to measure
+//   the numerical error of every float implementation, klein included.
+//
+// All rotations are right handed and all compositions follow the column
+// vector convention: compose(a, b) applies b first.
+
+#include <cmath>
+
+namespace bench
+{
+namespace ref
+{
+    template <typename T>
+    struct vec3
+    {
+        T x;
+        T y;
+        T z;
+    };
+
+    template <typename T>
+    vec3<T> operator+(vec3<T> a, vec3<T> b) noexcept
+    {
+        return {a.x + b.x, a.y + b.y, a.z + b.z};
+    }
+
+    template <typename T>
+    vec3<T> operator-(vec3<T> a, vec3<T> b) noexcept
+    {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    template <typename T>
+    vec3<T> operator*(T s, vec3<T> a) noexcept
+    {
+        return {s * a.x, s * a.y, s * a.z};
+    }
+
+    template <typename T>
+    vec3<T> cross(vec3<T> a, vec3<T> b) noexcept
+    {
+        return {a.y * b.z - a.z * b.y,
+                a.z * b.x - a.x * b.z,
+                a.x * b.y - a.y * b.x};
+    }
+
+    template <typename T>
+    T dot(vec3<T> a, vec3<T> b) noexcept
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    template <typename T>
+    T length(vec3<T> a) noexcept
+    {
+        return std::sqrt(dot(a, a));
+    }
+
+    // w + xi + yj + zk
+    template <typename T>
+    struct quat
+    {
+        T w;
+        T x;
+        T y;
+        T z;
+    };
+
+    template <typename T>
+    quat<T> operator*(quat<T> a, quat<T> b) noexcept
+    {
+        return {a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+                a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w};
+    }
+
+    template <typename T>
+    quat<T> operator+(quat<T> a, quat<T> b) noexcept
+    {
+        return {a.w + b.w, a.x + b.x, a.y + b.y, a.z + b.z};
+    }
+
+    template <typename T>
+    quat<T> operator*(T s, quat<T> a) noexcept
+    {
+        return {s * a.w, s * a.x, s * a.y, s * a.z};
+    }
+
+    template <typename T>
+    quat<T> conjugate(quat<T> a) noexcept
+    {
+        return {a.w, -a.x, -a.y, -a.z};
+    }
+
+    template <typename T>
+    T dot(quat<T> a, quat<T> b) noexcept
+    {
+        return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    template <typename T>
+    quat<T> normalized(quat<T> a) noexcept
+    {
+        return (T{1} / std::sqrt(dot(a, a))) * a;
+    }
+
+    // Rotation by `angle` radians about the unit `axis`
+    template <typename T>
+    quat<T> axis_angle(T angle, vec3<T> axis) noexcept
+    {
+        T s = std::sin(angle * T{0.5});
+        return {std::cos(angle * T{0.5}), s * axis.x, s * axis.y, s * axis.z};
+    }
+
+    // q v q* expanded to two cross products
+    template <typename T>
+    vec3<T> rotate(quat<T> q, vec3<T> v) noexcept
+    {
+        vec3<T> u{q.x, q.y, q.z};
+        vec3<T> t = T{2} * cross(u, v);
+        return v + q.w * t + cross(u, t);
+    }
+
+    // A rotation followed by a translation
+    template <typename T>
+    struct quat_vec
+    {
+        quat<T> r;
+        vec3<T> t;
+    };
+
+    template <typename T>
+    quat_vec<T> operator*(quat_vec<T> const& a, quat_vec<T> const& b) noexcept
+    {
+        return {a.r * b.r, rotate(a.r, b.t) + a.t};
+    }
+
+    template <typename T>
+    vec3<T> apply(quat_vec<T> const& a, vec3<T> p) noexcept
+    {
+        return rotate(a.r, p) + a.t;
+    }
+
+    // real + ε dual where the dual part encodes the translation as
+    // dual = t r / 2
+    template <typename T>
+    struct dual_quat
+    {
+        quat<T> real;
+        quat<T> dual;
+    };
+
+    template <typename T>
+    dual_quat<T> to_dual_quat(quat_vec<T> const& a) noexcept
+    {
+        quat<T> t{T{0}, a.t.x, a.t.y, a.t.z};
+        return {a.r, T{0.5} * (t * a.r)};
+    }
+
+    template <typename T>
+    dual_quat<T> operator*(dual_quat<T> const& a,
+                           dual_quat<T> const& b) noexcept
+    {
+        return {a.real * b.real, a.real * b.dual + a.dual * b.real};
+    }
+
+    // Scale the real part to unit length and remove the component of the
+    // dual part parallel to it so that the result is a rigid transformation
+    template <typename T>
+    dual_quat<T> normalized(dual_quat<T> const& a) noexcept
+    {
+        T inv        = T{1} / std::sqrt(dot(a.real, a.real));
+        quat<T> real = inv * a.real;
+        quat<T> dual = inv * a.dual;
+        dual         = dual + (-dot(real, dual)) * real;
+        return {real, dual};
+    }
+
+    template <typename T>
+    vec3<T> apply(dual_quat<T> const& a, vec3<T> p) noexcept
+    {
+        quat<T> t = T{2} * (a.dual * conjugate(a.real));
+        return rotate(a.real, p) + vec3<T>{t.x, t.y, t.z};
+    }
+
+    // Dual quaternion linear blending of four weighted transformations. Each
+    // term is flipped into the hemisphere of the first to take the shortest
+    // path.
+    template <typename T>
+    dual_quat<T> blend(dual_quat<T> const* bones,
+                       unsigned const (&index)[4],
+                       T const (&weight)[4]) noexcept
+    {
+        dual_quat<T> out{};
+        quat<T> pivot = bones[index[0]].real;
+        for (int i = 0; i != 4; ++i)
+        {
+            dual_quat<T> const& b = bones[index[i]];
+
+            T w      = dot(pivot, b.real) < T{0} ? -weight[i] : weight[i];
+            out.real = out.real + w * b.real;
+            out.dual = out.dual + w * b.dual;
+        }
+        return normalized(out);
+    }
+
+    // Affine transformation stored as three rows of four columns where the
+    // last column is the translation
+    template <typename T>
+    struct mat3x4
+    {
+        T m[3][4];
+    };
+
+    template <typename T>
+    mat3x4<T> to_mat3x4(quat_vec<T> const& a) noexcept
+    {
+        quat<T> q = a.r;
+        T xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        T xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        T wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+        return {{{T{1} - T{2} * (yy + zz),
+                  T{2} * (xy - wz),
+                  T{2} * (xz + wy),
+                  a.t.x},
+                 {T{2} * (xy + wz),
+                  T{1} - T{2} * (xx + zz),
+                  T{2} * (yz - wx),
+                  a.t.y},
+                 {T{2} * (xz - wy),
+                  T{2} * (yz + wx),
+                  T{1} - T{2} * (xx + yy),
+                  a.t.z}}};
+    }
+
+    template <typename T>
+    mat3x4<T> operator*(mat3x4<T> const& a, mat3x4<T> const& b) noexcept
+    {
+        mat3x4<T> out;
+        for (int r = 0; r != 3; ++r)
+        {
+            for (int c = 0; c != 4; ++c)
+            {
+                out.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c]
+                              + a.m[r][2] * b.m[2][c];
+            }
+            out.m[r][3] += a.m[r][3];
+        }
+        return out;
+    }
+
+    template <typename T>
+    vec3<T> apply(mat3x4<T> const& a, vec3<T> p) noexcept
+    {
+        T const(&m)[3][4] = a.m;
+        return {m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+                m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+                m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]};
+    }
+
+    // Linear blend skinning. The blended matrix is generally not rigid.
+    template <typename T>
+    mat3x4<T> blend(mat3x4<T> const* bones,
+                    unsigned const (&index)[4],
+                    T const (&weight)[4]) noexcept
+    {
+        mat3x4<T> out{};
+        for (int i = 0; i != 4; ++i)
+        {
+            mat3x4<T> const& b = bones[index[i]];
+            for (int r = 0; r != 3; ++r)
+            {
+                for (int c = 0; c != 4; ++c)
+                {
+                    out.m[r][c] += weight[i] * b.m[r][c];
+                }
+            }
+        }
+        return out;
+    }
+} // namespace ref
+} // namespace bench
@@ -0,0 +1,499 @@
+// Roofline analysis of the batch (variadic) sandwich kernels
+//
+// Usage: klein_roofline [--out <file>] [--filter <substring>]
+//                       [--min-bytes <n>] [--max-bytes <n>]
+//                       [--min-time <seconds>] [--repetitions <n>]
+//
+// The working set of every batch kernel is swept in powers of two from
+// --min-bytes (4 KiB by default) to --max-bytes (twice the last level cache,
+// clamped to [64 MiB, 1 GiB], by default) so that it passes through the L1,
+// L2 and L3 caches and finally DRAM. Each kernel is run both out of place
+// (half of the working set is read and the other half written) and in place.
+//
+// The machine roofline is measured first:
+//
+// - the peak arithmetic throughput of independent packed multiply-add chains
+//   held in registers, and
+// - the bandwidth of a streaming multiply over the same working set sizes
+//   with the same access pattern (out of place or in place) as the kernels.
+//
+// For every kernel and working set, the achieved GB/s and GFLOP/s, the
+// arithmetic intensity (flops per byte), the attainable performance
+// min(peak, intensity * bandwidth), and the achieved fraction of it are
+// reported, along with whether the kernel is memory or compute bound at that
+// size. A memory bound kernel running near its roof only benefits from
+// moving fewer bytes (streaming stores avoid the read for ownership of the
+// output) or more cores. One far below its roof, typically in DRAM, may
+// benefit from software prefetching.
+//
+// Flops are counted as four per packed arithmetic instruction in the per
+// element loop of each kernel (lanes that are discarded included), and bytes
+// as the size of the element read plus the size of the element written.
+//
+// In place runs apply the same versor over and over, so it is normalized to
+// full precision and denormals are flushed to zero, as in klein_bench.
+
+#include "bench.hpp"
+
+#include <klein/klein.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <pmmintrin.h>
+#include <string>
+#include <vector>
+
+#ifndef KLEIN_BENCH_BUILD_TYPE
+#    define KLEIN_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+using bench::clobber;
+using bench::do_not_optimize;
+
+struct caches
+{
+    size_t l1 = bench::detect_cache_bytes(1);
+    size_t l2 = bench::detect_cache_bytes(2);
+    size_t l3 = bench::detect_cache_bytes(3);
+
+    // The smallest level holding `bytes`
+    [[nodiscard]] char const* level(size_t bytes) const noexcept
+    {
+        if (l1 == 0 && l2 == 0 && l3 == 0)
+        {
+            return "unknown";
+        }
+        if (bytes <= l1)
+        {
+            return "L1";
+        }
+        if (bytes <= l2)
+        {
+            return "L2";
+        }
+        if (bytes <= l3)
+        {
+            return "L3";
+        }
+        return "DRAM";
+    }
+};
+
+struct machine
+{
+    double peak_gflops = 0.0;
+
+    // Streaming bandwidth per working set size, out of place and in place
+    std::vector<size_t> sizes;
+    std::vector<double> copy_gbps;
+    std::vector<double> in_place_gbps;
+};
+
+struct row
+{
+    std::string name;
+    bool in_place;
+    size_t elements;
+    size_t working_set;
+    double flops_per_element;
+    size_t bytes_per_element;
+    double gbps;
+    double gflops;
+    double roof_gflops;
+    bool memory_bound;
+};
+
+struct context
+{
+    bench::runner& run;
+    caches const& cache;
+    machine const& roof;
+    std::vector<row>& rows;
+};
+
+// Peak packed multiply-add throughput. The chains are independent so that
+// throughput rather than latency limits the loop.
+double measure_peak_gflops(bench::runner& run)
+{
+    constexpr size_t chains = 12;
+    constexpr size_t steps  = 1024;
+    run.run("peak_flops", "single", 1, true, 0, steps, [](size_t n) {
+        __m128 acc[chains];
+        for (size_t c = 0; c != chains; ++c)
+        {
+            acc[c] = _mm_set1_ps(static_cast<float>(c));
+        }
+        float volatile scale  = 0.999f;
+        float volatile offset = 1e-3f;
+        __m128 a              = _mm_set1_ps(scale);
+        __m128 b              = _mm_set1_ps(offset);
+        for (size_t i = 0; i != n * steps; ++i)
+        {
+            for (size_t c = 0; c != chains; ++c)
+            {
+                acc[c] = _mm_add_ps(_mm_mul_ps(acc[c], a), b);
+            }
+        }
+        for (size_t c = 1; c != chains; ++c)
+        {
+            acc[0] = _mm_add_ps(acc[0], acc[c]);
+        }
+        do_not_optimize(acc[0]);
+    });
+    // Two packed instructions of four lanes per chain and step
+    return run.results().back().elements_per_second * chains * 8 * 1e-9;
+}
+
+// Bandwidth of out[i] = s * in[i] (or in place) over a working set of `bytes`
+double measure_gbps(bench::runner& run, size_t bytes, bool in_place)
+{
+    size_t count = in_place ? bytes / sizeof(kln::point)
+                            : bytes / (2 * sizeof(kln::point));
+    count        = std::max<size_t>(count, 1);
+    std::vector<kln::point> in(count, kln::point{1.f, 2.f, 3.f});
+    std::vector<kln::point> out(in_place ? 0 : count);
+    kln::point* src = in.data();
+    kln::point* dst = in_place ? in.data() : out.data();
+
+    // Keep the multiply by one from being folded away (which would turn the
+    // loop into memcpy or eliminate it entirely when in place)
+    float volatile one = 1.f;
+    __m128 s           = _mm_set1_ps(one);
+    run.run(in_place ? "stream_in_place" : "stream_copy",
+            "batch",
+            count,
+            in_place,
+            bytes,
+            count,
+            [&](size_t n) {
+                for (size_t i = 0; i != n; ++i)
+                {
+                    for (size_t j = 0; j != count; ++j)
+                    {
+                        dst[j].p3_ = _mm_mul_ps(src[j].p3_, s);
+                    }
+                    clobber();
+                }
+            });
+    return run.results().back().elements_per_second * 2 * sizeof(kln::point)
+           * 1e-9;
+}
+
+machine measure_machine(bench::runner& run, size_t min_bytes, size_t max_bytes)
+{
+    machine out;
+    out.peak_gflops = measure_peak_gflops(run);
+    std::fprintf(stderr, "peak %.2f GFLOP/s\n", out.peak_gflops);
+    for (size_t bytes = min_bytes; bytes <= max_bytes; bytes *= 2)
+    {
+        out.sizes.push_back(bytes);
+        out.copy_gbps.push_back(measure_gbps(run, bytes, false));
+        out.in_place_gbps.push_back(measure_gbps(run, bytes, true));
+        std::fprintf(stderr,
+                     "stream %12zu bytes  %8.2f GB/s out of place  %8.2f GB/s "
+                     "in place\n",
+                     bytes,
+                     out.copy_gbps.back(),
+                     out.in_place_gbps.back());
+    }
+    return out;
+}
+
+// Time `apply(in, out, count)` over every working set size and derive the
+// roofline metrics
+template <typename T, typename Init, typename Apply>
+void sweep(context& ctx,
+           char const* name,
+           double flops_per_element,
+           Init&& init,
+           Apply&& apply)
+{
+    if (!ctx.run.enabled(name))
+    {
+        return;
+    }
+
+    for (size_t s = 0; s != ctx.roof.sizes.size(); ++s)
+    {
+        size_t bytes = ctx.roof.sizes[s];
+        for (bool in_place : {false, true})
+        {
+            size_t count = in_place ? bytes / sizeof(T)
+                                    : bytes / (2 * sizeof(T));
+            count        = std::max<size_t>(count, 1);
+            std::vector<T> in(count);
+            for (size_t i = 0; i != count; ++i)
+            {
+                in[i] = init(i);
+            }
+            std::vector<T> out(in_place ? 0 : count);
+            T* src = in.data();
+            T* dst = in_place ? in.data() : out.data();
+
+            ctx.run.run(name,
+                        "batch",
+                        count,
+                        in_place,
+                        bytes,
+                        count,
+                        [&](size_t n) {
+                            for (size_t i = 0; i != n; ++i)
+                            {
+                                apply(src, dst, count);
+                                clobber();
+                            }
+                        });
+
+            double eps = ctx.run.results().back().elements_per_second;
+            row r;
+            r.name              = name;
+            r.in_place          = in_place;
+            r.elements          = count;
+            r.working_set       = bytes;
+            r.flops_per_element = flops_per_element;
+            r.bytes_per_element = 2 * sizeof(T);
+            r.gbps              = eps * r.bytes_per_element * 1e-9;
+            r.gflops            = eps * flops_per_element * 1e-9;
+
+            double bandwidth   = in_place ? ctx.roof.in_place_gbps[s]
+                                          : ctx.roof.copy_gbps[s];
+            double intensity   = flops_per_element / r.bytes_per_element;
+            double memory_roof = intensity * bandwidth;
+            r.memory_bound     = memory_roof < ctx.roof.peak_gflops;
+            r.roof_gflops      = r.memory_bound ? memory_roof
+                                                : ctx.roof.peak_gflops;
+
+            std::fprintf(stderr,
+                         "%-26s %-12s %12zu %-7s AI %5.3f %8.2f GB/s %8.2f "
+                         "GFLOP/s  %5.1f%% of %s roof\n",
+                         name,
+                         in_place ? "in-place" : "out-of-place",
+                         bytes,
+                         ctx.cache.level(bytes),
+                         intensity,
+                         r.gbps,
+                         r.gflops,
+                         100.0 * r.gflops / r.roof_gflops,
+                         r.memory_bound ? "memory" : "compute");
+            ctx.rows.push_back(std::move(r));
+        }
+    }
+}
+
+void kernels(context& ctx)
+{
+    kln::motor m{0.3f, 0.5f, kln::line{1.f, -2.f, 0.5f, 0.2f, -0.4f, 0.8f}};
+    m.normalize_precise();
+    kln::rotor r{0.7f, 1.f, -2.f, 0.5f};
+
+    auto point_at = [](size_t i) {
+        float f = static_cast<float>(i & 1023);
+        return kln::point{f, -0.5f * f, 1.f + f};
+    };
+    auto direction_at = [](size_t i) {
+        float f = static_cast<float>(i & 1023);
+        return kln::direction{f, 1.f, -f};
+    };
+    auto line_at = [](size_t i) {
+        float f = static_cast<float>(i & 1023);
+        return kln::line{f, 1.f, -f, 0.f, 1.f, 0.5f};
+    };
+    auto plane_at = [](size_t i) {
+        float f = static_cast<float>(i & 1023);
+        return kln::plane{1.f, f, 0.5f, -f};
+    };
+
+    // sw312<true, true>: 4 multiplies and 3 adds per point
+    sweep<kln::point>(ctx,
+                      "motor_points",
+                      28.0,
+                      point_at,
+                      [&](kln::point* in, kln::point* out, size_t n) {
+                          m(in, out, n);
+                      });
+    // sw312<true, false>: 3 multiplies and 2 adds per direction
+    sweep<kln::direction>(
+        ctx,
+        "motor_directions",
+        20.0,
+        direction_at,
+        [&](kln::direction* in, kln::direction* out, size_t n) {
+            m(in, out, n);
+        });
+    // sw012<true, true>: 3 multiplies, 3 adds, and a dot product per plane
+    sweep<kln::plane>(ctx,
+                      "motor_planes",
+                      36.0,
+                      plane_at,
+                      [&](kln::plane* in, kln::plane* out, size_t n) {
+                          m(in, out, n);
+                      });
+    // swMM<true, true, true>: 9 multiplies and 7 adds per line
+    sweep<kln::line>(ctx,
+                     "motor_lines",
+                     64.0,
+                     line_at,
+                     [&](kln::line* in, kln::line* out, size_t n) {
+                         m(in, out, n);
+                     });
+    // sw012<true, false>: 3 multiplies and 2 adds per point or plane
+    sweep<kln::point>(ctx,
+                      "rotor_points",
+                      20.0,
+                      point_at,
+                      [&](kln::point* in, kln::point* out, size_t n) {
+                          r(in, out, n);
+                      });
+    sweep<kln::plane>(ctx,
+                      "rotor_planes",
+                      20.0,
+                      plane_at,
+                      [&](kln::plane* in, kln::plane* out, size_t n) {
+                          r(in, out, n);
+                      });
+    // swMM<true, false, true>: 6 multiplies and 4 adds per line
+    sweep<kln::line>(ctx,
+                     "rotor_lines",
+                     40.0,
+                     line_at,
+                     [&](kln::line* in, kln::line* out, size_t n) {
+                         r(in, out, n);
+                     });
+}
+
+void write_json(std::FILE* file,
+                caches const& cache,
+                machine const& roof,
+                std::vector<row> const& rows)
+{
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"isa\": \"%s\",\n", bench::isa());
+    std::fprintf(file, "  \"build_type\": \"%s\",\n", KLEIN_BENCH_BUILD_TYPE);
+    std::fprintf(file,
+                 "  \"caches\": {\"l1\": %zu, \"l2\": %zu, \"l3\": %zu},\n",
+                 cache.l1,
+                 cache.l2,
+                 cache.l3);
+    std::fprintf(file, "  \"peak_gflops\": %.6g,\n", roof.peak_gflops);
+    std::fprintf(file, "  \"bandwidth\": [");
+    for (size_t i = 0; i != roof.sizes.size(); ++i)
+    {
+        std::fprintf(file,
+                     "%s\n    {\"working_set\": %zu, \"level\": \"%s\", "
+                     "\"gbps\": %.6g, \"in_place_gbps\": %.6g}",
+                     i == 0 ? "" : ",",
+                     roof.sizes[i],
+                     cache.level(roof.sizes[i]),
+                     roof.copy_gbps[i],
+                     roof.in_place_gbps[i]);
+    }
+    std::fprintf(file, "\n  ],\n");
+    std::fprintf(file, "  \"results\": [");
+    for (size_t i = 0; i != rows.size(); ++i)
+    {
+        row const& r = rows[i];
+        std::fprintf(
+            file,
+            "%s\n    {\"name\": \"%s\", \"in_place\": %s, \"elements\": %zu, "
+            "\"working_set\": %zu, \"level\": \"%s\", "
+            "\"flops_per_element\": %.6g, \"bytes_per_element\": %zu, "
+            "\"intensity\": %.6g, \"gbps\": %.6g, \"gflops\": %.6g, "
+            "\"roof_gflops\": %.6g, \"efficiency\": %.6g, \"bound\": \"%s\"}",
+            i == 0 ? "" : ",",
+            r.name.c_str(),
+            r.in_place ? "true" : "false",
+            r.elements,
+            r.working_set,
+            cache.level(r.working_set),
+            r.flops_per_element,
+            r.bytes_per_element,
+            r.flops_per_element / r.bytes_per_element,
+            r.gbps,
+            r.gflops,
+            r.roof_gflops,
+            r.gflops / r.roof_gflops,
+            r.memory_bound ? "memory" : "compute");
+    }
+    std::fprintf(file, "\n  ]\n}\n");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bench::config cfg;
+    cfg.verbose      = false;
+    cfg.llc_bytes    = bench::detect_llc_bytes();
+    size_t min_bytes = 4096;
+    size_t max_bytes = std::clamp<size_t>(
+        2 * cfg.llc_bytes, size_t{64} << 20, size_t{1} << 30);
+    char const* out = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        char const* arg  = argv[i];
+        char const* next = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool ok          = next != nullptr;
+        if (ok && std::strcmp(arg, "--out") == 0)
+        {
+            out = next;
+        }
+        else if (ok && std::strcmp(arg, "--filter") == 0)
+        {
+            cfg.filter = next;
+        }
+        else if (ok && std::strcmp(arg, "--min-bytes") == 0)
+        {
+            ok = bench::parse_size(next, min_bytes);
+        }
+        else if (ok && std::strcmp(arg, "--max-bytes") == 0)
+        {
+            ok = bench::parse_size(next, max_bytes);
+        }
+        else if (ok && std::strcmp(arg, "--min-time") == 0)
+        {
+            cfg.min_time = std::strtod(next, nullptr);
+            ok           = cfg.min_time > 0.0;
+        }
+        else if (ok && std::strcmp(arg, "--repetitions") == 0)
+        {
+            cfg.repetitions = std::atoi(next);
+            ok              = cfg.repetitions > 0;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", arg);
+            return 1;
+        }
+        ++i;
+    }
+
+    _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
+    _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
+
+    bench::runner run{cfg};
+    caches cache;
+    machine roof = measure_machine(run, min_bytes, max_bytes);
+    std::vector<row> rows;
+    context ctx{run, cache, roof, rows};
+    kernels(ctx);
+
+    std::FILE* file = out ? std::fopen(out, "w") : stdout;
+    if (file == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open %s\n", out);
+        return 1;
+    }
+    write_json(file, cache, roof, rows);
+    if (out)
+    {
+        std::fclose(file);
+    }
+    return 0;
+}
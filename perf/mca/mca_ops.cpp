@@ -0,0 +1,118 @@
+// Thin wrappers around every public operator for static throughput analysis.
+//
+// Each wrapper is a separate non-inlined function with C linkage taking its
+// operands by pointer so that the generated code is the operator itself plus
+// the loads and stores of the operands. The report script extracts every
+// function prefixed with kln_mca_ from the assembly and hands it to llvm-mca
+// as its own code region.
+
+#include <klein/klein.hpp>
+
+using namespace kln;
+
+#define KLN_MCA_BINARY(name, A, op, B, R)                          \
+    extern "C" void kln_mca_##name(A const* a, B const* b, R* out) \
+    {                                                              \
+        *out = *a op * b;                                          \
+    }
+
+#define KLN_MCA_UNARY(name, op, A, R)                   \
+    extern "C" void kln_mca_##name(A const* a, R* out) \
+    {                                                   \
+        *out = op * a;                                  \
+    }
+
+#define KLN_MCA_APPLY(name, A, B, R)                               \
+    extern "C" void kln_mca_##name(A const* a, B const* b, R* out) \
+    {                                                              \
+        *out = (*a)(*b);                                           \
+    }
+
+// geometric_product.hpp
+KLN_MCA_BINARY(gp_plane_plane, plane, *, plane, motor)
+KLN_MCA_BINARY(gp_plane_point, plane, *, point, motor)
+KLN_MCA_BINARY(gp_point_plane, point, *, plane, motor)
+KLN_MCA_BINARY(gp_branch_branch, branch, *, branch, rotor)
+KLN_MCA_BINARY(gp_line_line, line, *, line, motor)
+KLN_MCA_BINARY(gp_point_point, point, *, point, translator)
+KLN_MCA_BINARY(gp_rotor_rotor, rotor, *, rotor, rotor)
+KLN_MCA_BINARY(gp_dual_line, dual, *, line, line)
+KLN_MCA_BINARY(gp_line_dual, line, *, dual, line)
+KLN_MCA_BINARY(gp_rotor_translator, rotor, *, translator, motor)
+KLN_MCA_BINARY(gp_translator_rotor, translator, *, rotor, motor)
+KLN_MCA_BINARY(gp_translator_translator, translator, *, translator, translator)
+KLN_MCA_BINARY(gp_rotor_motor, rotor, *, motor, motor)
+KLN_MCA_BINARY(gp_motor_rotor, motor, *, rotor, motor)
+KLN_MCA_BINARY(gp_translator_motor, translator, *, motor, motor)
+KLN_MCA_BINARY(gp_motor_translator, motor, *, translator, motor)
+KLN_MCA_BINARY(gp_motor_motor, motor, *, motor, motor)
+
+// inner_product.hpp
+KLN_MCA_BINARY(ip_plane_plane, plane, |, plane, float)
+KLN_MCA_BINARY(ip_plane_line, plane, |, line, plane)
+KLN_MCA_BINARY(ip_line_plane, line, |, plane, plane)
+KLN_MCA_BINARY(ip_plane_ideal_line, plane, |, ideal_line, plane)
+KLN_MCA_BINARY(ip_ideal_line_plane, ideal_line, |, plane, plane)
+KLN_MCA_BINARY(ip_plane_point, plane, |, point, line)
+KLN_MCA_BINARY(ip_point_plane, point, |, plane, line)
+KLN_MCA_BINARY(ip_line_line, line, |, line, float)
+KLN_MCA_BINARY(ip_point_line, point, |, line, plane)
+KLN_MCA_BINARY(ip_line_point, line, |, point, plane)
+KLN_MCA_BINARY(ip_point_point, point, |, point, float)
+
+// meet.hpp
+KLN_MCA_BINARY(meet_plane_plane, plane, ^, plane, line)
+KLN_MCA_BINARY(meet_plane_branch, plane, ^, branch, point)
+KLN_MCA_BINARY(meet_branch_plane, branch, ^, plane, point)
+KLN_MCA_BINARY(meet_plane_ideal_line, plane, ^, ideal_line, point)
+KLN_MCA_BINARY(meet_ideal_line_plane, ideal_line, ^, plane, point)
+KLN_MCA_BINARY(meet_plane_line, plane, ^, line, point)
+KLN_MCA_BINARY(meet_line_plane, line, ^, plane, point)
+KLN_MCA_BINARY(meet_plane_point, plane, ^, point, dual)
+KLN_MCA_BINARY(meet_point_plane, point, ^, plane, dual)
+KLN_MCA_BINARY(meet_branch_ideal_line, branch, ^, ideal_line, dual)
+KLN_MCA_BINARY(meet_ideal_line_branch, ideal_line, ^, branch, dual)
+KLN_MCA_BINARY(meet_line_line, line, ^, line, dual)
+KLN_MCA_BINARY(meet_line_ideal_line, line, ^, ideal_line, dual)
+KLN_MCA_BINARY(meet_ideal_line_line, ideal_line, ^, line, dual)
+KLN_MCA_BINARY(meet_line_branch, line, ^, branch, dual)
+KLN_MCA_BINARY(meet_branch_line, branch, ^, line, dual)
+
+// join.hpp
+KLN_MCA_UNARY(dual_plane, !, plane, point)
+KLN_MCA_UNARY(dual_point, !, point, plane)
+KLN_MCA_UNARY(dual_line, !, line, line)
+KLN_MCA_UNARY(dual_ideal_line, !, ideal_line, branch)
+KLN_MCA_UNARY(dual_branch, !, branch, ideal_line)
+KLN_MCA_UNARY(dual_dual, !, dual, dual)
+KLN_MCA_BINARY(join_point_point, point, &, point, line)
+KLN_MCA_BINARY(join_point_line, point, &, line, plane)
+KLN_MCA_BINARY(join_line_point, line, &, point, plane)
+KLN_MCA_BINARY(join_point_branch, point, &, branch, plane)
+KLN_MCA_BINARY(join_branch_point, branch, &, point, plane)
+KLN_MCA_BINARY(join_point_ideal_line, point, &, ideal_line, plane)
+KLN_MCA_BINARY(join_ideal_line_point, ideal_line, &, point, plane)
+KLN_MCA_BINARY(join_plane_point, plane, &, point, dual)
+KLN_MCA_BINARY(join_point_plane, point, &, plane, dual)
+
+// Sandwich overloads
+KLN_MCA_APPLY(sw_plane_plane, plane, plane, plane)
+KLN_MCA_APPLY(sw_plane_line, plane, line, line)
+KLN_MCA_APPLY(sw_plane_point, plane, point, point)
+KLN_MCA_APPLY(sw_rotor_plane, rotor, plane, plane)
+KLN_MCA_APPLY(sw_rotor_branch, rotor, branch, branch)
+KLN_MCA_APPLY(sw_rotor_line, rotor, line, line)
+KLN_MCA_APPLY(sw_rotor_point, rotor, point, point)
+KLN_MCA_APPLY(sw_rotor_direction, rotor, direction, direction)
+KLN_MCA_APPLY(sw_translator_plane, translator, plane, plane)
+KLN_MCA_APPLY(sw_translator_line, translator, line, line)
+KLN_MCA_APPLY(sw_translator_point, translator, point, point)
+KLN_MCA_APPLY(sw_motor_plane, motor, plane, plane)
+KLN_MCA_APPLY(sw_motor_line, motor, line, line)
+KLN_MCA_APPLY(sw_motor_point, motor, point, point)
+KLN_MCA_APPLY(sw_motor_direction, motor, direction, direction)
+
+extern "C" void kln_mca_sw_motor_origin(motor const* a, point* out)
+{
+    *out = (*a)(origin{});
+}
@@ -0,0 +1,187 @@
+# Static throughput regression report
+#
+# Usage: cmake -DASM=<file.s> -DLLVM_MCA=<llvm-mca> -DBASELINE=<file>
+#              -DOUTPUT_DIR=<dir> [-DNAME=<name>] [-DMCPU=<cpu>]
+#              [-DTOLERANCE=<fraction>] [-DUPDATE=ON] [-DTOOLCHAIN=<id>]
+#              -P mca_report.cmake
+#
+# Every function named kln_mca_<op> in the assembly becomes an llvm-mca code
+# region. The block reciprocal throughput of each region is compared against
+# the baseline. The script fails if any operator regresses by more than
+# TOLERANCE (relative, 0.05 by default), if an operator present in the
+# baseline has disappeared, or if a new operator is missing from the
+# baseline. With UPDATE=ON the baseline is rewritten instead.
+#
+# The full llvm-mca output and a markdown summary are written to OUTPUT_DIR.
+
+foreach(var ASM LLVM_MCA BASELINE OUTPUT_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "mca_report: ${var} must be defined")
+    endif()
+endforeach()
+if(NOT DEFINED NAME)
+    get_filename_component(NAME ${ASM} NAME_WE)
+endif()
+if(NOT DEFINED MCPU)
+    set(MCPU skylake)
+endif()
+if(NOT DEFINED TOLERANCE)
+    set(TOLERANCE 0.05)
+endif()
+if(NOT DEFINED TOOLCHAIN)
+    set(TOOLCHAIN unknown)
+endif()
+
+# Extract the body of every wrapper between llvm-mca region markers. Assembler
+# directives and comments are dropped. The wrappers are straight line code so
+# a region ends at the first return.
+file(STRINGS ${ASM} lines)
+set(regions "")
+set(inside OFF)
+foreach(line IN LISTS lines)
+    if(line MATCHES "^_?kln_mca_([A-Za-z0-9_]+):")
+        set(inside ON)
+        string(APPEND regions "# LLVM-MCA-BEGIN ${CMAKE_MATCH_1}\n")
+    elseif(inside)
+        if(line MATCHES "^[ \t]*\\." OR line MATCHES "^[ \t]*#"
+           OR line MATCHES "^[ \t]*$")
+            continue()
+        endif()
+        string(APPEND regions "${line}\n")
+        if(line MATCHES "^[ \t]*(ret|retq)([ \t]|$)")
+            string(APPEND regions "# LLVM-MCA-END\n")
+            set(inside OFF)
+        endif()
+    endif()
+endforeach()
+if(inside)
+    message(FATAL_ERROR "mca_report: unterminated function in ${ASM}")
+endif()
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+set(mca_input ${OUTPUT_DIR}/${NAME}.mca.s)
+set(mca_output ${OUTPUT_DIR}/${NAME}.mca.txt)
+file(WRITE ${mca_input} "${regions}")
+
+execute_process(
+    COMMAND ${LLVM_MCA} -mcpu=${MCPU} ${mca_input}
+    OUTPUT_VARIABLE mca
+    ERROR_VARIABLE mca_error
+    RESULT_VARIABLE mca_result
+)
+if(NOT mca_result EQUAL 0)
+    message(FATAL_ERROR "mca_report: llvm-mca failed\n${mca_error}")
+endif()
+file(WRITE ${mca_output} "${mca}")
+
+# The summary view of each region precedes any bracketed table
+string(REGEX MATCHALL
+    "Code Region - [A-Za-z0-9_]+[^[]*Block RThroughput: [0-9.]+"
+    summaries "${mca}")
+set(names "")
+foreach(summary IN LISTS summaries)
+    string(REGEX MATCH "Code Region - ([A-Za-z0-9_]+)" _ "${summary}")
+    set(op ${CMAKE_MATCH_1})
+    string(REGEX MATCH "Block RThroughput: ([0-9.]+)" _ "${summary}")
+    set(current_${op} ${CMAKE_MATCH_1})
+    list(APPEND names ${op})
+endforeach()
+list(LENGTH names count)
+if(count EQUAL 0)
+    message(FATAL_ERROR "mca_report: no regions found in ${ASM}")
+endif()
+
+if(UPDATE)
+    set(content "# Block reciprocal throughput (cycles) per operator\n")
+    string(APPEND content "# toolchain: ${TOOLCHAIN}\n# mcpu: ${MCPU}\n")
+    foreach(op IN LISTS names)
+        string(APPEND content "${op} ${current_${op}}\n")
+    endforeach()
+    file(WRITE ${BASELINE} "${content}")
+    message(STATUS "mca_report: wrote ${count} entries to ${BASELINE}")
+    return()
+endif()
+
+if(NOT EXISTS ${BASELINE})
+    message(FATAL_ERROR "mca_report: missing baseline ${BASELINE}")
+endif()
+file(STRINGS ${BASELINE} baseline_lines)
+set(baseline_names "")
+foreach(line IN LISTS baseline_lines)
+    if(line MATCHES "^# toolchain: (.*)$")
+        set(baseline_toolchain "${CMAKE_MATCH_1}")
+    elseif(line MATCHES "^# mcpu: (.*)$")
+        set(baseline_mcpu "${CMAKE_MATCH_1}")
+    elseif(line MATCHES "^([A-Za-z0-9_]+) ([0-9.]+)$")
+        set(baseline_${CMAKE_MATCH_1} ${CMAKE_MATCH_2})
+        list(APPEND baseline_names ${CMAKE_MATCH_1})
+    endif()
+endforeach()
+if(NOT "${baseline_toolchain}" STREQUAL "${TOOLCHAIN}"
+   OR NOT "${baseline_mcpu}" STREQUAL "${MCPU}")
+    message(WARNING
+        "mca_report: baseline was recorded with ${baseline_toolchain} "
+        "(${baseline_mcpu}) but this run uses ${TOOLCHAIN} (${MCPU})")
+endif()
+
+# CMake has no floating point arithmetic so compare in hundredths of a cycle
+function(to_centi value out)
+    if(value MATCHES "^([0-9]+)\\.([0-9])([0-9])?")
+        set(whole ${CMAKE_MATCH_1})
+        set(tenths ${CMAKE_MATCH_2})
+        set(hundredths "${CMAKE_MATCH_3}")
+        if("${hundredths}" STREQUAL "")
+            set(hundredths 0)
+        endif()
+        math(EXPR result "${whole} * 100 + ${tenths} * 10 + ${hundredths}")
+    else()
+        math(EXPR result "${value} * 100")
+    endif()
+    set(${out} ${result} PARENT_SCOPE)
+endfunction()
+to_centi(${TOLERANCE} tolerance_centi)
+
+set(report "# llvm-mca report: ${NAME}\n\n")
+string(APPEND report "Toolchain `${TOOLCHAIN}`, `-mcpu=${MCPU}`. ")
+string(APPEND report "Block reciprocal throughput in cycles.\n\n")
+string(APPEND report "| Operator | Baseline | Current | Status |\n")
+string(APPEND report "|----------|---------:|--------:|--------|\n")
+set(failures "")
+foreach(op IN LISTS names)
+    if(NOT DEFINED baseline_${op})
+        string(APPEND report "| ${op} | | ${current_${op}} | new |\n")
+        list(APPEND failures "${op} is missing from the baseline")
+        continue()
+    endif()
+    to_centi(${baseline_${op}} before)
+    to_centi(${current_${op}} after)
+    # after > before * (1 + tolerance)
+    math(EXPR limit "${before} * (100 + ${tolerance_centi}) / 100")
+    if(after GREATER limit)
+        set(status "regressed")
+        list(APPEND failures
+            "${op} regressed from ${baseline_${op}} to ${current_${op}}")
+    elseif(after LESS before)
+        set(status "improved")
+    else()
+        set(status "")
+    endif()
+    string(APPEND report
+        "| ${op} | ${baseline_${op}} | ${current_${op}} | ${status} |\n")
+endforeach()
+foreach(op IN LISTS baseline_names)
+    if(NOT DEFINED current_${op})
+        string(APPEND report "| ${op} | ${baseline_${op}} | | removed |\n")
+        list(APPEND failures "${op} is in the baseline but was not measured")
+    endif()
+endforeach()
+file(WRITE ${OUTPUT_DIR}/${NAME}.md "${report}")
+
+if(failures)
+    list(JOIN failures "\n  " failure_text)
+    message(FATAL_ERROR
+        "mca_report: ${NAME} differs from ${BASELINE}\n  ${failure_text}\n"
+        "Rerun with UPDATE=ON (the klein_mca_update target) if intended.")
+endif()
+message(STATUS
+    "mca_report: ${count} operators within tolerance, see ${OUTPUT_DIR}/${NAME}.md")
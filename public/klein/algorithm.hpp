@@ -0,0 +1,313 @@
+#pragma once
+
+#include "direction.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+#include "rotor.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <execution>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#if __has_include(<version>)
+#    include <version>
+#endif
+
+namespace kln
+{
+/// \defgroup algorithm Algorithms
+///
+/// `kln::transform` applies a motor or rotor to a range of points, directions,
+/// planes, or lines with the interface of `std::transform`, optionally taking
+/// a standard execution policy such as `std::execution::par_unseq`.
+///
+/// Rather than invoking the versor once per element (which would recompute
+/// the coefficients of the sandwich product every time), the range is split
+/// into 64 KiB chunks and each chunk is passed to the batch operator of the
+/// versor (`motor::operator()(point*, point*, size_t)`, for example). The
+/// execution policy decides which threads transform which chunks, so the
+/// coefficients are computed once per chunk and the inner loop is the same as
+/// that of the batch operator.
+///
+/// Both ranges must be contiguous (arrays, `std::vector`, or `std::array`)
+/// and either identical or non-overlapping. Iterators of other containers are
+/// rejected at compile time. This is exact from C++20 on, where the standard
+/// can tell contiguous iterators apart. Before C++20, iterators must be
+/// random access and neither reversed nor those of `std::deque`.
+///
+/// !!! example
+///
+///     ```c++
+///         #include <execution>
+///         #include <klein/algorithm.hpp>
+///
+///         std::vector<kln::point> points = load_points();
+///         kln::transform(std::execution::par_unseq,
+///                        points.begin(),
+///                        points.end(),
+///                        points.begin(),
+///                        m);
+///     ```
+///
+/// !!! tip
+///
+///     When the Intel TBB headers are installed, libstdc++ implements the
+///     parallel execution policies with TBB, and any program including
+///     `<execution>` (and thus this header) must link against it
+///     (`TBB::tbb`).
+
+namespace detail
+{
+    // Size of the chunks passed to the batch operators. Since the entities
+    // are 16 or 32 bytes, every chunk spans a whole number of cache lines.
+    constexpr size_t transform_chunk_bytes = size_t{1} << 16;
+
+    // A random access iterator over the integers [0, n) used to enumerate
+    // chunks with the standard algorithms
+    class chunk_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = size_t;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = size_t const*;
+        using reference         = size_t const&;
+
+        chunk_iterator() noexcept = default;
+
+        explicit chunk_iterator(size_t index) noexcept
+            : index_{index}
+        {}
+
+        reference operator*() const noexcept
+        {
+            return index_;
+        }
+
+        value_type operator[](difference_type n) const noexcept
+        {
+            return index_ + n;
+        }
+
+        chunk_iterator& operator++() noexcept
+        {
+            ++index_;
+            return *this;
+        }
+
+        chunk_iterator operator++(int) noexcept
+        {
+            chunk_iterator out = *this;
+            ++index_;
+            return out;
+        }
+
+        chunk_iterator& operator--() noexcept
+        {
+            --index_;
+            return *this;
+        }
+
+        chunk_iterator operator--(int) noexcept
+        {
+            chunk_iterator out = *this;
+            --index_;
+            return out;
+        }
+
+        chunk_iterator& operator+=(difference_type n) noexcept
+        {
+            index_ += n;
+            return *this;
+        }
+
+        chunk_iterator& operator-=(difference_type n) noexcept
+        {
+            index_ -= n;
+            return *this;
+        }
+
+        friend chunk_iterator operator+(chunk_iterator it,
+                                        difference_type n) noexcept
+        {
+            return it += n;
+        }
+
+        friend chunk_iterator operator+(difference_type n,
+                                        chunk_iterator it) noexcept
+        {
+            return it += n;
+        }
+
+        friend chunk_iterator operator-(chunk_iterator it,
+                                        difference_type n) noexcept
+        {
+            return it -= n;
+        }
+
+        friend difference_type operator-(chunk_iterator a,
+                                         chunk_iterator b) noexcept
+        {
+            return static_cast<difference_type>(a.index_ - b.index_);
+        }
+
+        friend bool operator==(chunk_iterator a, chunk_iterator b) noexcept
+        {
+            return a.index_ == b.index_;
+        }
+
+        friend bool operator!=(chunk_iterator a, chunk_iterator b) noexcept
+        {
+            return a.index_ != b.index_;
+        }
+
+        friend bool operator<(chunk_iterator a, chunk_iterator b) noexcept
+        {
+            return a.index_ < b.index_;
+        }
+
+        friend bool operator>(chunk_iterator a, chunk_iterator b) noexcept
+        {
+            return a.index_ > b.index_;
+        }
+
+        friend bool operator<=(chunk_iterator a, chunk_iterator b) noexcept
+        {
+            return a.index_ <= b.index_;
+        }
+
+        friend bool operator>=(chunk_iterator a, chunk_iterator b) noexcept
+        {
+            return a.index_ >= b.index_;
+        }
+
+    private:
+        size_t index_ = 0;
+    };
+
+    template <typename It>
+    using iterator_value_t = typename std::iterator_traits<It>::value_type;
+
+    template <typename It>
+    struct is_reverse_iterator : std::false_type
+    {};
+    template <typename It>
+    struct is_reverse_iterator<std::reverse_iterator<It>> : std::true_type
+    {};
+
+    // Whether It addresses contiguous storage, so the batch operators may run
+    // over the range through a pointer. C++17 has no way to ask, so only the
+    // standard random access iterators that are not contiguous are rejected.
+    template <typename It>
+    constexpr bool is_contiguous_iterator_v =
+#ifdef __cpp_lib_concepts
+        std::contiguous_iterator<It>;
+#else
+        std::is_base_of_v<std::random_access_iterator_tag,
+                          typename std::iterator_traits<It>::iterator_category>
+        && !is_reverse_iterator<It>::value
+        && !std::is_same_v<It,
+                           typename std::deque<iterator_value_t<It>>::iterator>
+        && !std::is_same_v<
+            It,
+            typename std::deque<iterator_value_t<It>>::const_iterator>;
+#endif
+
+    template <typename InputIt, typename OutputIt, typename Versor>
+    constexpr bool is_batch_transform_v
+        = std::is_same_v<iterator_value_t<InputIt>, iterator_value_t<OutputIt>>
+          && std::is_invocable_v<Versor const&,
+                                 iterator_value_t<InputIt>*,
+                                 iterator_value_t<InputIt>*,
+                                 size_t>;
+
+    // Addresses of the contiguous input and output ranges. The batch
+    // operators take a mutable input pointer but only write to the output.
+    template <typename InputIt, typename OutputIt>
+    auto batch_ranges(InputIt first, InputIt last, OutputIt out) noexcept
+    {
+        static_assert(is_contiguous_iterator_v<InputIt>
+                          && is_contiguous_iterator_v<OutputIt>,
+                      "kln::transform requires iterators over contiguous "
+                      "storage (pointers, std::vector, or std::array)");
+        using T = iterator_value_t<InputIt>;
+        struct ranges
+        {
+            T* in;
+            T* out;
+            size_t count;
+        };
+        size_t count = static_cast<size_t>(std::distance(first, last));
+        if (count == 0)
+        {
+            return ranges{nullptr, nullptr, 0};
+        }
+        return ranges{const_cast<T*>(std::addressof(*first)),
+                      std::addressof(*out),
+                      count};
+    }
+} // namespace detail
+
+/// \addtogroup algorithm
+/// @{
+
+/// Apply the motor or rotor `v` to the elements of `[first, last)` and store
+/// the results starting at `out`. Returns the end of the output range.
+template <typename InputIt, typename OutputIt, typename Versor>
+OutputIt transform(InputIt first,
+                   InputIt last,
+                   OutputIt out,
+                   Versor const& v) noexcept
+{
+    static_assert(detail::is_batch_transform_v<InputIt, OutputIt, Versor>,
+                  "kln::transform requires a versor with a batch operator for "
+                  "the element type of the ranges");
+    auto r = detail::batch_ranges(first, last, out);
+    if (r.count != 0)
+    {
+        v(r.in, r.out, r.count);
+    }
+    return std::next(out, static_cast<std::ptrdiff_t>(r.count));
+}
+
+/// Apply the motor or rotor `v` to the elements of `[first, last)` and store
+/// the results starting at `out`, distributing the work according to the
+/// execution `policy`. Returns the end of the output range.
+template <typename ExecutionPolicy,
+          typename InputIt,
+          typename OutputIt,
+          typename Versor,
+          typename = std::enable_if_t<
+              std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+OutputIt transform(ExecutionPolicy&& policy,
+                   InputIt first,
+                   InputIt last,
+                   OutputIt out,
+                   Versor const& v) noexcept
+{
+    static_assert(detail::is_batch_transform_v<InputIt, OutputIt, Versor>,
+                  "kln::transform requires a versor with a batch operator for "
+                  "the element type of the ranges");
+    using T            = detail::iterator_value_t<InputIt>;
+    constexpr size_t n = detail::transform_chunk_bytes / sizeof(T);
+
+    auto r        = detail::batch_ranges(first, last, out);
+    size_t chunks = (r.count + n - 1) / n;
+    std::for_each(std::forward<ExecutionPolicy>(policy),
+                  detail::chunk_iterator{0},
+                  detail::chunk_iterator{chunks},
+                  [&v, r](size_t chunk) {
+                      size_t begin = chunk * n;
+                      size_t end   = begin + n < r.count ? begin + n : r.count;
+                      v(r.in + begin, r.out + begin, end - begin);
+                  });
+    return std::next(out, static_cast<std::ptrdiff_t>(r.count));
+}
+/// @}
+} // namespace kln
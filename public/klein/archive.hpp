@@ -0,0 +1,843 @@
+#pragma once
+
+#include "direction.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+#include "rotor.hpp"
+#include "translator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#    include "detail/windows.hpp"
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+// Archives are read and written in native byte order
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#    error "Klein archives require a little endian target"
+#endif
+
+namespace kln
+{
+/// \defgroup archive Archives
+///
+/// A versioned binary container for arrays of Klein entities which can be
+/// used in place once the file is memory mapped. Loading an archive consists
+/// of mapping the file and validating its header, so the cost of loading
+/// large scenes and animations is that of the page faults incurred when the
+/// data is first accessed.
+///
+/// An archive holds up to `archive_max_sections` named sections. Each
+/// section stores `count` entities of a single type in one of two layouts:
+///
+/// - `archive_layout::aos`: an array of entities exactly as they are laid out
+///   in memory (`kln::point[]`, `kln::motor[]`, ...), which may be passed
+///   directly to the batch sandwich operators,
+/// - `archive_layout::soa`: blocks of four entities, where each `__m128` holds
+///   one component of all four entities in the order of the entity's
+///   partitions (the layout used by the SoA kernels). The last block is
+///   padded with zeros.
+///
+/// The data of every section starts at a file offset that is a multiple of
+/// its alignment (64 bytes by default, at most 4096), so it is equally
+/// aligned in a mapping of the file. Sections may optionally carry a CRC32C
+/// checksum per chunk of data, which can be verified on demand as a whole or
+/// chunk by chunk (to check only the pages actually used, for example).
+///
+/// The file starts with a 64 byte `archive_header` followed by the
+/// `archive_section` table. All integers are little endian, which is the
+/// byte order of every target Klein supports (this is checked at compile
+/// time). The header and table are protected by a checksum which is verified
+/// when the archive is opened. Offsets are 64 bit, so archives may exceed
+/// 2 GiB on every platform.
+///
+/// !!! example
+///
+///     ```c++
+///         // Writing
+///         std::FILE* file = std::fopen("scene.kln", "wb");
+///         kln::archive_writer writer{file, 2};
+///         writer.add("vertices", points.data(), points.size(),
+///                    {kln::archive_layout::aos, 64, 1 << 16});
+///         writer.add("bones", motors.data(), motors.size());
+///         writer.finish();
+///         std::fclose(file);
+///
+///         // Reading
+///         kln::mapped_file mapping;
+///         kln::archive_view archive;
+///         kln::archive_span<kln::point> vertices;
+///         if (mapping.open("scene.kln") == kln::archive_status::ok
+///             && archive.open(mapping.data(), mapping.size())
+///                    == kln::archive_status::ok
+///             && archive.get("vertices", vertices) == kln::archive_status::ok)
+///         {
+///             m(vertices.data, vertices.data, vertices.count);
+///         }
+///     ```
+///
+/// !!! tip
+///
+///     `mapped_file` maps the file copy-on-write. Entities may be transformed
+///     in place in the mapping without modifying the file, and only the pages
+///     written to are copied.
+
+/// \addtogroup archive
+/// @{
+
+constexpr uint32_t archive_version      = 1;
+constexpr uint32_t archive_max_sections = 64;
+
+enum class archive_type : uint16_t
+{
+    plane = 1,
+    point,
+    direction,
+    line,
+    ideal_line,
+    branch,
+    rotor,
+    translator,
+    motor,
+};
+
+enum class archive_layout : uint16_t
+{
+    aos,
+    soa,
+};
+
+enum class archive_status
+{
+    ok,
+    /// The file could not be opened, mapped, read, or written
+    io_error,
+    /// The data does not start with the archive magic
+    bad_magic,
+    unsupported_version,
+    /// The data ends before a structure or section it describes
+    truncated,
+    /// The header or section table fails its checksum or describes an
+    /// inconsistent section
+    corrupt,
+    /// A section does not have the requested alignment in memory (or the
+    /// requested alignment is invalid)
+    misaligned,
+    /// The writer has no room left in its section table
+    full,
+    not_found,
+    type_mismatch,
+    /// The section data fails its checksum
+    checksum_mismatch,
+};
+
+struct archive_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+    uint64_t file_size;
+    /// CRC32C of the header (with this field set to zero) and section table
+    uint32_t checksum;
+    uint32_t reserved[9];
+};
+
+struct archive_section
+{
+    /// Zero terminated name
+    char name[24];
+    archive_type type;
+    archive_layout layout;
+    /// Alignment of the data in bytes
+    uint16_t alignment;
+    /// Size of a single entity in bytes
+    uint16_t element_size;
+    /// Number of entities
+    uint64_t count;
+    /// Location of the data relative to the start of the file
+    uint64_t offset;
+    /// Location of the chunk checksums, or zero if there are none
+    uint64_t checksum_offset;
+    /// Bytes of data covered by each checksum
+    uint32_t checksum_chunk;
+    uint32_t reserved;
+
+    /// Size of the data in bytes
+    [[nodiscard]] uint64_t size() const noexcept
+    {
+        uint64_t elements = layout == archive_layout::soa
+                                ? (count + 3) / 4 * 4
+                                : count;
+        return elements * element_size;
+    }
+
+    [[nodiscard]] uint64_t checksum_count() const noexcept
+    {
+        return checksum_chunk == 0
+                   ? 0
+                   : (size() + checksum_chunk - 1) / checksum_chunk;
+    }
+};
+
+static_assert(sizeof(archive_header) == 64, "Unexpected archive header size");
+static_assert(sizeof(archive_section) == 64,
+              "Unexpected archive section size");
+
+template <typename T>
+struct archive_traits;
+
+#define KLN_ARCHIVE_TRAITS(T)                                                  \
+    template <>                                                                \
+    struct archive_traits<T>                                                   \
+    {                                                                          \
+        static constexpr archive_type type = archive_type::T;                  \
+    };
+
+KLN_ARCHIVE_TRAITS(plane)
+KLN_ARCHIVE_TRAITS(point)
+KLN_ARCHIVE_TRAITS(direction)
+KLN_ARCHIVE_TRAITS(line)
+KLN_ARCHIVE_TRAITS(ideal_line)
+KLN_ARCHIVE_TRAITS(branch)
+KLN_ARCHIVE_TRAITS(rotor)
+KLN_ARCHIVE_TRAITS(translator)
+KLN_ARCHIVE_TRAITS(motor)
+#undef KLN_ARCHIVE_TRAITS
+
+/// Size in bytes of a single entity of the given type, or zero if the type is
+/// unknown
+[[nodiscard]] constexpr uint16_t archive_element_size(archive_type t) noexcept
+{
+    switch (t)
+    {
+    case archive_type::plane:
+    case archive_type::point:
+    case archive_type::direction:
+    case archive_type::ideal_line:
+    case archive_type::branch:
+    case archive_type::rotor:
+    case archive_type::translator:
+        return 16;
+    case archive_type::line:
+    case archive_type::motor:
+        return 32;
+    default:
+        return 0;
+    }
+}
+
+/// An array of entities within a mapped archive
+template <typename T>
+struct archive_span
+{
+    T* data      = nullptr;
+    size_t count = 0;
+};
+
+/// The blocks of four entities of an SoA section. There are `(count + 3) / 4`
+/// blocks of `archive_element_size(type) / 4` registers each.
+struct archive_soa_span
+{
+    __m128* data = nullptr;
+    size_t count = 0;
+};
+
+/// Options for a single section
+struct archive_options
+{
+    archive_layout layout = archive_layout::aos;
+    /// Power of two between 16 and 4096
+    uint16_t alignment = 64;
+    /// Bytes of data covered by each checksum, or zero for no checksums
+    uint32_t checksum_chunk = 0;
+};
+
+namespace detail
+{
+    constexpr char archive_magic[8] = {'K', 'L', 'E', 'I', 'N', 'A', 'R', 0};
+
+    // CRC32C (Castagnoli) lookup tables for slicing by 8 bytes
+    struct crc32c_tables
+    {
+        uint32_t t[8][256];
+
+        constexpr crc32c_tables() noexcept
+            : t{}
+        {
+            for (uint32_t i = 0; i != 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k != 8; ++k)
+                {
+                    c = (c >> 1) ^ (0x82f63b78u & (0u - (c & 1u)));
+                }
+                t[0][i] = c;
+            }
+            for (uint32_t i = 0; i != 256; ++i)
+            {
+                for (int s = 1; s != 8; ++s)
+                {
+                    uint32_t prev = t[s - 1][i];
+                    t[s][i]       = (prev >> 8) ^ t[0][prev & 0xff];
+                }
+            }
+        }
+    };
+
+    inline constexpr crc32c_tables crc32c_table{};
+
+    [[nodiscard]] inline uint32_t crc32c(uint32_t crc,
+                                         void const* data,
+                                         size_t size) noexcept
+    {
+        auto const* bytes = static_cast<unsigned char const*>(data);
+        auto const& t     = crc32c_table.t;
+        crc               = ~crc;
+        for (; size >= 8; size -= 8, bytes += 8)
+        {
+            uint32_t lo;
+            uint32_t hi;
+            std::memcpy(&lo, bytes, 4);
+            std::memcpy(&hi, bytes + 4, 4);
+            lo ^= crc;
+            crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff]
+                  ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24]
+                  ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff]
+                  ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        }
+        for (; size != 0; --size, ++bytes)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *bytes) & 0xff];
+        }
+        return ~crc;
+    }
+
+    [[nodiscard]] inline uint32_t
+    archive_checksum(archive_header header,
+                     archive_section const* sections) noexcept
+    {
+        header.checksum = 0;
+        uint32_t crc    = crc32c(0, &header, sizeof(header));
+        return crc32c(
+            crc, sections, sizeof(archive_section) * header.section_count);
+    }
+
+    [[nodiscard]] constexpr bool valid_alignment(uint64_t alignment) noexcept
+    {
+        return alignment >= 16 && alignment <= 4096
+               && (alignment & (alignment - 1)) == 0;
+    }
+
+    // std::ftell and std::fseek take a long, which is 32 bit on Windows
+    inline int64_t archive_tell(std::FILE* file) noexcept
+    {
+#ifdef _WIN32
+        return _ftelli64(file);
+#else
+        return ::ftello(file);
+#endif
+    }
+
+    inline bool archive_seek(std::FILE* file, int64_t offset) noexcept
+    {
+#ifdef _WIN32
+        return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+        return ::fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+} // namespace detail
+
+/// Writes an archive to a binary file opened for writing. The file must be
+/// seekable since the header is written last.
+class archive_writer
+{
+public:
+    /// Reserve room for `section_count` sections (at most
+    /// `archive_max_sections`) at the current position of `file`, which
+    /// becomes the start of the archive
+    archive_writer(std::FILE* file, uint32_t section_count) noexcept
+        : file_{file}
+        , capacity_{section_count < archive_max_sections ? section_count
+                                                         : archive_max_sections}
+    {
+        start_ = detail::archive_tell(file_);
+        if (start_ < 0)
+        {
+            status_ = archive_status::io_error;
+            return;
+        }
+        pad(sizeof(archive_header) + sizeof(archive_section) * capacity_);
+    }
+
+    /// Append `count` entities stored in the given layout. For SoA sections,
+    /// `data` points to `(count + 3) / 4` blocks of four entities.
+    archive_status add(char const* name,
+                       archive_type type,
+                       void const* data,
+                       size_t count,
+                       archive_options const& options = {}) noexcept
+    {
+        if (status_ != archive_status::ok)
+        {
+            return status_;
+        }
+        if (section_count_ == capacity_)
+        {
+            return archive_status::full;
+        }
+        if (!detail::valid_alignment(options.alignment)
+            || options.checksum_chunk % 64 != 0)
+        {
+            return archive_status::misaligned;
+        }
+
+        archive_section& s = sections_[section_count_];
+        s                  = archive_section{};
+        std::strncpy(s.name, name, sizeof(s.name) - 1);
+        s.type           = type;
+        s.layout         = options.layout;
+        s.alignment      = options.alignment;
+        s.element_size   = archive_element_size(type);
+        s.count          = count;
+        s.checksum_chunk = options.checksum_chunk;
+
+        pad_to(options.alignment);
+        s.offset = offset_;
+        write(data, s.size());
+
+        if (s.checksum_chunk != 0)
+        {
+            pad_to(16);
+            s.checksum_offset = offset_;
+            auto const* bytes = static_cast<unsigned char const*>(data);
+            uint64_t size     = s.size();
+            uint64_t chunks   = s.checksum_count();
+            for (uint64_t i = 0; i != chunks; ++i)
+            {
+                uint64_t begin = i * s.checksum_chunk;
+                uint64_t end   = begin + s.checksum_chunk;
+                end            = end < size ? end : size;
+                uint32_t crc   = detail::crc32c(0, bytes + begin, end - begin);
+                write(&crc, sizeof(crc));
+            }
+        }
+
+        if (status_ == archive_status::ok)
+        {
+            ++section_count_;
+        }
+        return status_;
+    }
+
+    /// Append an array of `count` entities
+    template <typename T>
+    archive_status add(char const* name,
+                       T const* data,
+                       size_t count,
+                       archive_options const& options = {}) noexcept
+    {
+        archive_options aos = options;
+        aos.layout          = archive_layout::aos;
+        return add(name, archive_traits<T>::type, data, count, aos);
+    }
+
+    /// Write the header and section table. The file position is left at the
+    /// end of the archive.
+    archive_status finish() noexcept
+    {
+        if (status_ != archive_status::ok)
+        {
+            return status_;
+        }
+        pad_to(64);
+
+        archive_header header{};
+        std::memcpy(header.magic, detail::archive_magic, sizeof(header.magic));
+        header.version       = archive_version;
+        header.section_count = section_count_;
+        header.file_size     = offset_;
+        header.checksum      = detail::archive_checksum(header, sections_);
+
+        // Unused slots of the reserved table remain zero
+        if (!detail::archive_seek(file_, start_)
+            || std::fwrite(&header, sizeof(header), 1, file_) != 1
+            || (section_count_ != 0
+                && std::fwrite(sections_,
+                               sizeof(archive_section),
+                               section_count_,
+                               file_)
+                       != section_count_)
+            || !detail::archive_seek(file_,
+                                     start_ + static_cast<int64_t>(offset_))
+            || std::fflush(file_) != 0)
+        {
+            status_ = archive_status::io_error;
+        }
+        return status_;
+    }
+
+private:
+    void write(void const* data, uint64_t size) noexcept
+    {
+        if (status_ == archive_status::ok && size != 0
+            && std::fwrite(data, 1, size, file_) != size)
+        {
+            status_ = archive_status::io_error;
+        }
+        offset_ += size;
+    }
+
+    void pad(uint64_t size) noexcept
+    {
+        static constexpr unsigned char zeros[256] = {};
+        while (size != 0)
+        {
+            uint64_t n = size < sizeof(zeros) ? size : sizeof(zeros);
+            write(zeros, n);
+            size -= n;
+        }
+    }
+
+    void pad_to(uint64_t alignment) noexcept
+    {
+        pad((alignment - offset_ % alignment) % alignment);
+    }
+
+    std::FILE* file_;
+    int64_t start_          = 0;
+    uint64_t offset_        = 0;
+    uint32_t capacity_      = 0;
+    uint32_t section_count_ = 0;
+    archive_status status_  = archive_status::ok;
+    archive_section sections_[archive_max_sections];
+};
+
+/// A read-only view of an archive in memory (normally a `mapped_file`). The
+/// view does not copy anything; the spans it returns point into the memory
+/// passed to `open`, which must outlive them.
+class archive_view
+{
+public:
+    /// Validate the header and section table of the archive occupying `size`
+    /// bytes at `data`
+    archive_status open(void* data, size_t size) noexcept
+    {
+        data_ = nullptr;
+        size_ = 0;
+        if (size < sizeof(archive_header))
+        {
+            return archive_status::truncated;
+        }
+        archive_header header;
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(
+                header.magic, detail::archive_magic, sizeof(header.magic))
+            != 0)
+        {
+            return archive_status::bad_magic;
+        }
+        if (header.version != archive_version)
+        {
+            return archive_status::unsupported_version;
+        }
+        if (header.section_count > archive_max_sections)
+        {
+            return archive_status::corrupt;
+        }
+        uint64_t table_end = sizeof(archive_header)
+                             + sizeof(archive_section) * header.section_count;
+        if (header.file_size > size || table_end > size)
+        {
+            return archive_status::truncated;
+        }
+
+        auto* bytes = static_cast<unsigned char*>(data);
+        auto const* sections
+            = reinterpret_cast<archive_section const*>(bytes + sizeof(header));
+        if (detail::archive_checksum(header, sections) != header.checksum)
+        {
+            return archive_status::corrupt;
+        }
+        for (uint32_t i = 0; i != header.section_count; ++i)
+        {
+            archive_status status = validate(sections[i], header.file_size);
+            if (status != archive_status::ok)
+            {
+                return status;
+            }
+        }
+
+        data_     = bytes;
+        size_     = header.file_size;
+        header_   = header;
+        sections_ = sections;
+        return archive_status::ok;
+    }
+
+    [[nodiscard]] uint32_t section_count() const noexcept
+    {
+        return data_ ? header_.section_count : 0;
+    }
+
+    [[nodiscard]] archive_section const& section(uint32_t i) const noexcept
+    {
+        return sections_[i];
+    }
+
+    /// The section with the given name, or `nullptr`
+    [[nodiscard]] archive_section const* find(char const* name) const noexcept
+    {
+        for (uint32_t i = 0; i != section_count(); ++i)
+        {
+            if (std::strncmp(sections_[i].name, name, sizeof(sections_[i].name))
+                == 0)
+            {
+                return sections_ + i;
+            }
+        }
+        return nullptr;
+    }
+
+    /// The entities of an AoS section of type `T`
+    template <typename T>
+    archive_status get(char const* name, archive_span<T>& out) const noexcept
+    {
+        archive_section const* s = find(name);
+        if (s == nullptr)
+        {
+            return archive_status::not_found;
+        }
+        if (s->type != archive_traits<T>::type
+            || s->layout != archive_layout::aos)
+        {
+            return archive_status::type_mismatch;
+        }
+        unsigned char* data = data_ + s->offset;
+        if (reinterpret_cast<uintptr_t>(data) % alignof(T) != 0)
+        {
+            return archive_status::misaligned;
+        }
+        out.data  = reinterpret_cast<T*>(data);
+        out.count = static_cast<size_t>(s->count);
+        return archive_status::ok;
+    }
+
+    /// The blocks of an SoA section of the given type
+    archive_status get(char const* name,
+                       archive_type type,
+                       archive_soa_span& out) const noexcept
+    {
+        archive_section const* s = find(name);
+        if (s == nullptr)
+        {
+            return archive_status::not_found;
+        }
+        if (s->type != type || s->layout != archive_layout::soa)
+        {
+            return archive_status::type_mismatch;
+        }
+        unsigned char* data = data_ + s->offset;
+        if (reinterpret_cast<uintptr_t>(data) % alignof(__m128) != 0)
+        {
+            return archive_status::misaligned;
+        }
+        out.data  = reinterpret_cast<__m128*>(data);
+        out.count = static_cast<size_t>(s->count);
+        return archive_status::ok;
+    }
+
+    /// Verify the checksum of a single chunk of a section. Sections without
+    /// checksums always verify.
+    [[nodiscard]] archive_status verify(archive_section const& s,
+                                        uint64_t chunk) const noexcept
+    {
+        if (s.checksum_chunk == 0)
+        {
+            return archive_status::ok;
+        }
+        if (chunk >= s.checksum_count())
+        {
+            return archive_status::not_found;
+        }
+        uint64_t begin = chunk * s.checksum_chunk;
+        uint64_t end   = begin + s.checksum_chunk;
+        end            = end < s.size() ? end : s.size();
+        uint32_t expected;
+        std::memcpy(&expected,
+                    data_ + s.checksum_offset + chunk * sizeof(uint32_t),
+                    sizeof(expected));
+        return detail::crc32c(0, data_ + s.offset + begin, end - begin)
+                       == expected
+                   ? archive_status::ok
+                   : archive_status::checksum_mismatch;
+    }
+
+    /// Verify every chunk of a section
+    [[nodiscard]] archive_status verify(archive_section const& s) const
+        noexcept
+    {
+        for (uint64_t i = 0; i != s.checksum_count(); ++i)
+        {
+            archive_status status = verify(s, i);
+            if (status != archive_status::ok)
+            {
+                return status;
+            }
+        }
+        return archive_status::ok;
+    }
+
+private:
+    [[nodiscard]] archive_status validate(archive_section const& s,
+                                          uint64_t file_size) const noexcept
+    {
+        uint16_t element_size = archive_element_size(s.type);
+        if (element_size == 0 || element_size != s.element_size
+            || (s.layout != archive_layout::aos
+                && s.layout != archive_layout::soa)
+            || !detail::valid_alignment(s.alignment)
+            || s.offset % s.alignment != 0
+            || s.checksum_chunk % 64 != 0 || s.name[sizeof(s.name) - 1] != 0)
+        {
+            return archive_status::corrupt;
+        }
+        // Bound the count before computing sizes to rule out overflow
+        if (s.count > file_size || s.offset > file_size
+            || s.size() > file_size - s.offset)
+        {
+            return archive_status::truncated;
+        }
+        if (s.checksum_chunk != 0
+            && (s.checksum_offset > file_size
+                || s.checksum_count() * sizeof(uint32_t)
+                       > file_size - s.checksum_offset))
+        {
+            return archive_status::truncated;
+        }
+        return archive_status::ok;
+    }
+
+    unsigned char* data_             = nullptr;
+    size_t size_                     = 0;
+    archive_header header_           = {};
+    archive_section const* sections_ = nullptr;
+};
+
+/// A file mapped into memory copy-on-write. Writes to the mapping are private
+/// to the process and never reach the file.
+class mapped_file
+{
+public:
+    mapped_file() noexcept = default;
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    ~mapped_file() noexcept
+    {
+        close();
+    }
+
+    archive_status open(char const* path) noexcept
+    {
+        close();
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path,
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ,
+                                  nullptr,
+                                  OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return archive_status::io_error;
+        }
+        LARGE_INTEGER size;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &size) && size.QuadPart != 0)
+        {
+            mapping = CreateFileMappingA(
+                file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        }
+        CloseHandle(file);
+        if (mapping == nullptr)
+        {
+            return archive_status::io_error;
+        }
+        data_ = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(mapping);
+        if (data_ == nullptr)
+        {
+            return archive_status::io_error;
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return archive_status::io_error;
+        }
+        struct stat info;
+        void* data = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && info.st_size != 0)
+        {
+            data = ::mmap(nullptr,
+                          static_cast<size_t>(info.st_size),
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE,
+                          fd,
+                          0);
+        }
+        ::close(fd);
+        if (data == MAP_FAILED)
+        {
+            return archive_status::io_error;
+        }
+        data_ = data;
+        size_ = static_cast<size_t>(info.st_size);
+#endif
+        return archive_status::ok;
+    }
+
+    void close() noexcept
+    {
+        if (data_ != nullptr)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(data_);
+#else
+            ::munmap(data_, size_);
+#endif
+        }
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    [[nodiscard]] void* data() const noexcept
+    {
+        return data_;
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return size_;
+    }
+
+private:
+    void* data_  = nullptr;
+    size_t size_ = 0;
+};
+/// @}
+} // namespace kln
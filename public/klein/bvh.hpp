@@ -0,0 +1,534 @@
+#pragma once
+
+#include "detail/sse.hpp"
+#include "executor.hpp"
+#include "join.hpp"
+#include "line.hpp"
+#include "meet.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+#include "projection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace kln
+{
+/// \defgroup bvh Bounding Volume Hierarchy
+///
+/// A static bounding volume hierarchy over bounded primitives. Two primitive
+/// types are supported out of the box: `segment` (a line bounded by two
+/// points) and `disc` (a plane bounded by a circle). Any other type may be
+/// indexed by providing the free functions `bounds`, `centroid`, and
+/// `squared_distance` for it in the `kln` namespace with the same signatures
+/// as those provided for `segment` and `disc`.
+///
+/// Like the `kd_tree`, the hierarchy never allocates. The caller provides
+/// `bvh<T>::node_count(count)` nodes and `count` indices. Nodes are stored in
+/// depth-first order so the left child of an interior node immediately
+/// follows it in memory and each leaf references a contiguous range of
+/// primitive indices. Because the node layout depends only on the primitive
+/// count, disjoint subtrees can be built concurrently by passing an executor
+/// (see [Executors](#executor)) to `build`.
+///
+/// !!! example
+///
+///     ```c++
+///         std::vector<kln::segment> segments = load_segments();
+///         std::vector<kln::bvh<kln::segment>::node> nodes(
+///             kln::bvh<kln::segment>::node_count(segments.size()));
+///         std::vector<uint32_t> indices(segments.size());
+///
+///         kln::bvh<kln::segment> tree{
+///             segments.data(), segments.size(), nodes.data(), indices.data()};
+///
+///         kln::bvh_hit hit = tree.nearest(kln::point{1.f, 2.f, 3.f});
+///         // segments[hit.index] is the segment closest to (1, 2, 3)
+///     ```
+
+/// \addtogroup bvh
+/// @{
+
+/// The portion of the line through `a` and `b` between the two points. Both
+/// points are expected to be normalized.
+struct segment
+{
+    point a;
+    point b;
+};
+
+/// The portion of plane `p` within `radius` of `center`. The plane is expected
+/// to be normalized and the center is expected to be a normalized point on the
+/// plane.
+struct disc
+{
+    plane p;
+    point center;
+    float radius;
+};
+
+/// Compute the axis-aligned bounds of a segment. The bounds are stored in the
+/// `(w, x, y, z)` layout of a point.
+inline void bounds(segment const& s, __m128& lower, __m128& upper) noexcept
+{
+    lower = _mm_min_ps(s.a.p3_, s.b.p3_);
+    upper = _mm_max_ps(s.a.p3_, s.b.p3_);
+}
+
+/// Compute the axis-aligned bounds of a disc. The extent of a disc with unit
+/// normal $n$ along axis $i$ is $r\sqrt{1 - n_i^2}$.
+inline void bounds(disc const& d, __m128& lower, __m128& upper) noexcept
+{
+    __m128 n2     = _mm_mul_ps(d.p.p0_, d.p.p0_);
+    __m128 extent = _mm_sqrt_ps(
+        _mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.f), n2), _mm_setzero_ps()));
+    extent = _mm_mul_ps(extent, _mm_set_ps(d.radius, d.radius, d.radius, 0.f));
+    lower  = _mm_sub_ps(d.center.p3_, extent);
+    upper  = _mm_add_ps(d.center.p3_, extent);
+}
+
+[[nodiscard]] inline __m128 centroid(segment const& s) noexcept
+{
+    return _mm_mul_ps(_mm_add_ps(s.a.p3_, s.b.p3_), _mm_set1_ps(0.5f));
+}
+
+[[nodiscard]] inline __m128 centroid(disc const& d) noexcept
+{
+    return d.center.p3_;
+}
+
+/// Squared distance between a normalized point and a segment. The point is
+/// first projected onto the line joining the segment endpoints. If the
+/// projection lies outside the segment, the distance to the nearer endpoint
+/// is returned instead.
+[[nodiscard]] inline float KLN_VEC_CALL squared_distance(segment const& s,
+                                                         point q) noexcept
+{
+    // Divide out the homogeneous coordinate exactly rather than with the
+    // approximate reciprocal used by point::normalize
+    point foot = project(q, s.a & s.b);
+    foot.p3_   = _mm_div_ps(foot.p3_, KLN_SWIZZLE(foot.p3_, 0, 0, 0, 0));
+
+    __m128 ab = _mm_sub_ps(s.b.p3_, s.a.p3_);
+    float length2;
+    float t;
+    _mm_store_ss(&length2, detail::hi_dp(ab, ab));
+    _mm_store_ss(&t, detail::hi_dp(_mm_sub_ps(foot.p3_, s.a.p3_), ab));
+
+    __m128 nearest;
+    if (t <= 0.f || length2 == 0.f)
+    {
+        nearest = s.a.p3_;
+    }
+    else if (t >= length2)
+    {
+        nearest = s.b.p3_;
+    }
+    else
+    {
+        nearest = foot.p3_;
+    }
+
+    __m128 delta = _mm_sub_ps(q.p3_, nearest);
+    float out;
+    _mm_store_ss(&out, detail::hi_dp(delta, delta));
+    return out;
+}
+
+/// Squared distance between a normalized point and a disc. The signed
+/// distance to the supporting plane is given by the meet $p\wedge q$. If the
+/// projection of the point onto the plane lies outside the disc, the distance
+/// within the plane to the rim is accounted for as well.
+[[nodiscard]] inline float KLN_VEC_CALL squared_distance(disc const& d,
+                                                         point q) noexcept
+{
+    float normal = (d.p ^ q).e0123();
+    point foot   = project(q, d.p);
+    foot.p3_     = _mm_div_ps(foot.p3_, KLN_SWIZZLE(foot.p3_, 0, 0, 0, 0));
+
+    __m128 delta = _mm_sub_ps(foot.p3_, d.center.p3_);
+    float radial2;
+    _mm_store_ss(&radial2, detail::hi_dp(delta, delta));
+    float out = normal * normal;
+    if (radial2 > d.radius * d.radius)
+    {
+        float rim = std::sqrt(radial2) - d.radius;
+        out += rim * rim;
+    }
+    return out;
+}
+
+/// Result of a nearest-primitive query. If no primitive was found within the
+/// requested distance, `index` is `bvh_hit::npos`.
+struct bvh_hit
+{
+    static constexpr uint32_t npos = ~uint32_t{0};
+
+    uint32_t index;
+    float distance2;
+};
+
+template <typename T>
+class bvh final
+{
+public:
+    /// Subtrees with this many primitives or fewer are stored as leaves.
+    static constexpr size_t leaf_size = 4;
+
+    /// For interior nodes, `count` is zero and `first` is the index of the
+    /// right child (the left child is the next node). For leaves, `first` is
+    /// the offset of the leaf's first entry in the index array and `count` is
+    /// the number of entries.
+    struct node
+    {
+        __m128 lower;
+        __m128 upper;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    /// The number of nodes needed to index `count` primitives
+    [[nodiscard]] static constexpr size_t node_count(size_t count) noexcept
+    {
+        // Every interior node has two children
+        return 2 * leaf_count(count) - 1;
+    }
+
+    bvh() noexcept = default;
+
+    /// Build a hierarchy over `count` primitives. The `nodes` argument must
+    /// point to an array of `node_count(count)` nodes and `indices` must point
+    /// to an array of `count` indices. The primitives and both arrays must
+    /// outlive the hierarchy.
+    bvh(T const* primitives,
+        size_t count,
+        node* nodes,
+        uint32_t* indices) noexcept
+    {
+        build(primitives, count, nodes, indices);
+    }
+
+    /// (Re)build the hierarchy. The subtrees below the first few levels are
+    /// built as independent tasks submitted to `exec`.
+    template <typename Executor = serial_executor>
+    void build(T const* primitives,
+               size_t count,
+               node* nodes,
+               uint32_t* indices,
+               Executor&& exec = {}) noexcept
+    {
+        primitives_ = primitives;
+        nodes_      = nodes;
+        indices_    = indices;
+        count_      = count;
+        for (size_t i = 0; i != count; ++i)
+        {
+            indices_[i] = static_cast<uint32_t>(i);
+        }
+        if (count == 0)
+        {
+            return;
+        }
+
+        task tasks[max_tasks];
+        size_t task_count = 0;
+        split_range(0, count, 0, tasks, task_count);
+        exec(task_count, [this, &tasks](size_t i) {
+            build_range(tasks[i].lo, tasks[i].hi, tasks[i].node);
+        });
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return count_;
+    }
+
+    [[nodiscard]] node const* nodes() const noexcept
+    {
+        return nodes_;
+    }
+
+    [[nodiscard]] uint32_t const* indices() const noexcept
+    {
+        return indices_;
+    }
+
+    /// Return the index of the primitive nearest to `p` along with its squared
+    /// distance. The query point must be normalized.
+    [[nodiscard]] bvh_hit KLN_VEC_CALL nearest(point p) const noexcept
+    {
+        return nearest(p, std::numeric_limits<float>::max());
+    }
+
+    /// Return the primitive nearest to `p` provided it lies strictly within a
+    /// squared distance of `max_distance2`.
+    [[nodiscard]] bvh_hit KLN_VEC_CALL nearest(point p,
+                                               float max_distance2) const
+        noexcept
+    {
+        bvh_hit best{bvh_hit::npos, max_distance2};
+        if (count_ == 0)
+        {
+            return best;
+        }
+
+        struct entry
+        {
+            uint32_t node;
+            float bound2;
+        };
+        entry stack[64];
+        size_t top   = 0;
+        stack[top++] = {0, box_distance2(nodes_[0], p.p3_)};
+
+        while (top != 0)
+        {
+            entry e = stack[--top];
+            if (e.bound2 >= best.distance2)
+            {
+                continue;
+            }
+
+            node const& n = nodes_[e.node];
+            if (n.count != 0)
+            {
+                for (uint32_t i = n.first; i != n.first + n.count; ++i)
+                {
+                    float d2 = squared_distance(primitives_[indices_[i]], p);
+                    if (d2 < best.distance2)
+                    {
+                        best.index     = indices_[i];
+                        best.distance2 = d2;
+                    }
+                }
+                continue;
+            }
+
+            // Push the farther child first so the nearer child is visited
+            // first
+            entry left{e.node + 1, box_distance2(nodes_[e.node + 1], p.p3_)};
+            entry right{n.first, box_distance2(nodes_[n.first], p.p3_)};
+            if (left.bound2 < right.bound2)
+            {
+                stack[top++] = right;
+                stack[top++] = left;
+            }
+            else
+            {
+                stack[top++] = left;
+                stack[top++] = right;
+            }
+        }
+
+        return best;
+    }
+
+    /// Invoke `f(index)` for every primitive whose bounding box lies within
+    /// `radius` of the line `l`. The test is conservative; the callback is
+    /// expected to perform an exact test (for example, via the meet of the
+    /// line with the primitive) if needed.
+    ///
+    /// The distance from the line to each box center $c$ is computed with the
+    /// join $\ell\vee c$ whose norm is the distance between the two scaled by
+    /// the norm of the line.
+    template <typename F>
+    void KLN_VEC_CALL for_each_near(line l, float radius, F&& f) const noexcept
+    {
+        if (count_ == 0)
+        {
+            return;
+        }
+
+        float line_norm;
+        _mm_store_ss(&line_norm,
+                     _mm_sqrt_ss(detail::hi_dp_ss(l.p1_, l.p1_)));
+
+        uint32_t stack[64];
+        size_t top   = 0;
+        stack[top++] = 0;
+
+        while (top != 0)
+        {
+            node const& n = nodes_[stack[--top]];
+
+            __m128 center = _mm_mul_ps(_mm_add_ps(n.lower, n.upper),
+                                       _mm_set1_ps(0.5f));
+            __m128 half   = _mm_sub_ps(n.upper, center);
+            plane p       = l & point{center};
+            float distance2;
+            float extent2;
+            _mm_store_ss(&distance2, detail::hi_dp(p.p0_, p.p0_));
+            _mm_store_ss(&extent2, detail::hi_dp(half, half));
+            float reach = (radius + std::sqrt(extent2)) * line_norm;
+            if (distance2 > reach * reach)
+            {
+                continue;
+            }
+
+            if (n.count != 0)
+            {
+                for (uint32_t i = n.first; i != n.first + n.count; ++i)
+                {
+                    f(indices_[i]);
+                }
+                continue;
+            }
+
+            stack[top++] = n.first;
+            stack[top++] = static_cast<uint32_t>(&n - nodes_) + 1;
+        }
+    }
+
+private:
+    // Upper bound on the number of subtrees handed to an executor
+    static constexpr size_t max_tasks = 64;
+
+    struct task
+    {
+        size_t lo;
+        size_t hi;
+        size_t node;
+    };
+
+    [[nodiscard]] static float KLN_VEC_CALL box_distance2(node const& n,
+                                                          __m128 p) noexcept
+    {
+        __m128 delta = _mm_max_ps(_mm_sub_ps(n.lower, p),
+                                  _mm_max_ps(_mm_sub_ps(p, n.upper),
+                                             _mm_setzero_ps()));
+        float out;
+        _mm_store_ss(&out, detail::hi_dp(delta, delta));
+        return out;
+    }
+
+    [[nodiscard]] static float component(__m128 const& xmm,
+                                         uint32_t i) noexcept
+    {
+        return reinterpret_cast<float const*>(&xmm)[i];
+    }
+
+    // Compute the bounds of the range and write them to the node at `index`.
+    // For ranges too large to be a leaf, the indices are partitioned about the
+    // median centroid along the axis of greatest centroid extent and the
+    // index of the median is returned.
+    size_t partition(size_t lo, size_t hi, size_t index) noexcept
+    {
+        node& n = nodes_[index];
+        bounds(primitives_[indices_[lo]], n.lower, n.upper);
+        __m128 c_lower = centroid(primitives_[indices_[lo]]);
+        __m128 c_upper = c_lower;
+        for (size_t i = lo + 1; i != hi; ++i)
+        {
+            __m128 lower;
+            __m128 upper;
+            bounds(primitives_[indices_[i]], lower, upper);
+            n.lower = _mm_min_ps(n.lower, lower);
+            n.upper = _mm_max_ps(n.upper, upper);
+
+            __m128 c = centroid(primitives_[indices_[i]]);
+            c_lower  = _mm_min_ps(c_lower, c);
+            c_upper  = _mm_max_ps(c_upper, c);
+        }
+
+        if (hi - lo <= leaf_size)
+        {
+            n.first = static_cast<uint32_t>(lo);
+            n.count = static_cast<uint32_t>(hi - lo);
+            return hi;
+        }
+
+        float extent[4];
+        _mm_storeu_ps(extent, _mm_sub_ps(c_upper, c_lower));
+        uint32_t axis = 1;
+        if (extent[2] > extent[axis])
+        {
+            axis = 2;
+        }
+        if (extent[3] > extent[axis])
+        {
+            axis = 3;
+        }
+
+        size_t mid = lo + (hi - lo) / 2;
+        std::nth_element(indices_ + lo,
+                         indices_ + mid,
+                         indices_ + hi,
+                         [this, axis](uint32_t a, uint32_t b) {
+                             return component(centroid(primitives_[a]), axis)
+                                    < component(centroid(primitives_[b]), axis);
+                         });
+
+        // The left subtree immediately follows this node
+        n.first = static_cast<uint32_t>(index + 1 + node_count(mid - lo));
+        n.count = 0;
+        return mid;
+    }
+
+    // Ranges are halved until they hold at most leaf_size primitives. The
+    // 2^j ranges at depth j hold either floor(count / 2^j) primitives or one
+    // more, so the leaves can be counted from the deepest level at which
+    // some range is still split, without visiting the tree.
+    static constexpr size_t leaf_count(size_t count) noexcept
+    {
+        if (count <= leaf_size)
+        {
+            return 1;
+        }
+        // The ranges at depth j + 1 would still exceed leaf_size
+        auto splits = [count](size_t j) {
+            size_t q = count >> (j + 1);
+            return q + (count - (q << (j + 1)) != 0) > leaf_size;
+        };
+        size_t j = 0;
+        while (splits(j))
+        {
+            ++j;
+        }
+        // At depth j, the r larger ranges split while the smaller ones are
+        // leaves unless they exceed leaf_size as well
+        size_t q = count >> j;
+        size_t r = count - (q << j);
+        return q <= leaf_size ? (size_t{1} << j) + r : size_t{2} << j;
+    }
+
+    void build_range(size_t lo, size_t hi, size_t index) noexcept
+    {
+        size_t mid = partition(lo, hi, index);
+        if (mid == hi)
+        {
+            return;
+        }
+        build_range(lo, mid, index + 1);
+        build_range(mid, hi, nodes_[index].first);
+    }
+
+    // Build the upper levels of the hierarchy until there are enough subtrees
+    // to distribute as tasks.
+    void split_range(size_t lo,
+                     size_t hi,
+                     size_t index,
+                     task* tasks,
+                     size_t& task_count,
+                     size_t depth = 0) noexcept
+    {
+        if (hi - lo <= leaf_size || (size_t{2} << depth) > max_tasks)
+        {
+            tasks[task_count++] = {lo, hi, index};
+            return;
+        }
+
+        size_t mid = partition(lo, hi, index);
+        split_range(lo, mid, index + 1, tasks, task_count, depth + 1);
+        split_range(mid, hi, nodes_[index].first, tasks, task_count, depth + 1);
+    }
+
+    T const* primitives_ = nullptr;
+    node* nodes_         = nullptr;
+    uint32_t* indices_   = nullptr;
+    size_t count_        = 0;
+};
+/// @}
+} // namespace kln
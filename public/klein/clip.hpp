@@ -0,0 +1,137 @@
+#pragma once
+
+#include "detail/clip.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+
+#include <cstddef>
+
+namespace kln
+{
+/// \defgroup clip Clipping
+///
+/// Clipping geometry against a set of planes (a view frustum, a section box,
+/// or the cutting planes of a CAD model) keeps the parts of it on the
+/// positive side of every plane, that is, the points $x$ for which
+/// $p \wedge x \geq 0$. For a plane constructed as `plane{a, b, c, d}`, these
+/// are the points with $ax + by + cz + d \geq 0$. Points on a plane are kept.
+///
+/// - `clip_segments` clips line segments given as pairs of points.
+/// - `clip_polygon` clips a convex polygon with the Sutherland-Hodgman
+///   algorithm.
+/// - `clip_triangles` clips a triangle soup, triangulating every clipped
+///   triangle as a fan.
+///
+/// Vertices are classified against the planes four at a time with the
+/// distances $p \wedge x$ computed in SoA form. Segments and triangles that
+/// are not cut by any plane are copied or dropped without computing an
+/// intersection. New vertices are placed on the plane by interpolating the
+/// endpoints of the cut edge by their distances, which agrees with the meet
+/// $p \wedge (a \vee b)$ of the plane with the line through the edge.
+///
+/// Input points are expected to be normalized ($w = 1$) and the output points
+/// are normalized as well. Nothing is allocated: the output is written to
+/// arrays provided by the caller, compacted and in input order, and the
+/// number of elements written is returned. The `*_capacity` functions give
+/// the sizes these arrays need.
+///
+/// !!! example
+///
+///     ```c++
+///         #include <klein/clip.hpp>
+///
+///         // Keep the part of a mesh below the plane z = 2
+///         kln::plane cut{0.f, 0.f, -1.f, 2.f};
+///         std::vector<kln::point> out(
+///             kln::clip_triangles_capacity(triangle_count, 1));
+///         size_t n = kln::clip_triangles(
+///             &cut, 1, mesh.data(), triangle_count, out.data());
+///     ```
+
+/// \addtogroup clip
+/// @{
+
+/// The largest number of planes accepted by `clip_triangles`
+constexpr size_t clip_max_planes = 32;
+
+/// The number of points `clip_segments` may write for `segment_count`
+/// segments
+[[nodiscard]] constexpr size_t
+clip_segments_capacity(size_t segment_count) noexcept
+{
+    return 2 * segment_count;
+}
+
+/// The number of points `clip_polygon` may write, and its scratch array must
+/// hold, for a convex polygon with `vertex_count` vertices
+[[nodiscard]] constexpr size_t
+clip_polygon_capacity(size_t vertex_count, size_t plane_count) noexcept
+{
+    return vertex_count + plane_count;
+}
+
+/// The number of points `clip_triangles` may write for `triangle_count`
+/// triangles. A triangle is split into at most `plane_count + 1` triangles.
+[[nodiscard]] constexpr size_t
+clip_triangles_capacity(size_t triangle_count, size_t plane_count) noexcept
+{
+    return 3 * triangle_count * (plane_count + 1);
+}
+
+/// Clip `segment_count` line segments, stored as consecutive pairs of points
+/// in `in`, against `plane_count` planes. The clipped segments are written as
+/// pairs to `out`, which may be the same array as `in`. Returns the number of
+/// segments written.
+inline size_t clip_segments(plane const* planes,
+                            size_t plane_count,
+                            point const* in,
+                            size_t segment_count,
+                            point* out) noexcept
+{
+    return detail::clip_segments(
+        &planes->p0_, plane_count, &in->p3_, segment_count, &out->p3_);
+}
+
+/// Clip the convex polygon `in` with `vertex_count` vertices against
+/// `plane_count` planes. The vertices of the clipped polygon are written to
+/// `out` in the winding order of `in` and their number is returned, which is
+/// zero if the polygon lies outside any plane. `out` and `scratch` must each
+/// hold `clip_polygon_capacity(vertex_count, plane_count)` points and
+/// neither may overlap `in`.
+///
+/// Concave polygons are clipped as well, but pieces separated by a plane
+/// remain connected by edges along that plane and the output may exceed the
+/// capacity above.
+inline size_t clip_polygon(plane const* planes,
+                           size_t plane_count,
+                           point const* in,
+                           size_t vertex_count,
+                           point* out,
+                           point* scratch) noexcept
+{
+    return detail::clip_polygon(&planes->p0_,
+                                plane_count,
+                                &in->p3_,
+                                vertex_count,
+                                &out->p3_,
+                                &scratch->p3_);
+}
+
+/// Clip `triangle_count` triangles, stored as consecutive triples of points
+/// in `in`, against at most `clip_max_planes` planes. The clipped triangles
+/// keep the winding of their source triangles and are written as triples to
+/// `out`, which must hold
+/// `clip_triangles_capacity(triangle_count, plane_count)` points and may not
+/// overlap `in`. Returns the number of triangles written, or zero without
+/// writing anything if `plane_count` exceeds `clip_max_planes`.
+inline size_t clip_triangles(plane const* planes,
+                             size_t plane_count,
+                             point const* in,
+                             size_t triangle_count,
+                             point* out) noexcept
+{
+    return detail::clip_triangles<clip_max_planes>(
+        &planes->p0_, plane_count, &in->p3_, triangle_count, &out->p3_);
+}
+/// @}
+} // namespace kln
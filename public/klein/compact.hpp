@@ -0,0 +1,344 @@
+#pragma once
+
+#include "detail/compact.hpp"
+#include "detail/profile.hpp"
+#include "direction.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace kln
+{
+/// \defgroup compact Compact Storage
+///
+/// Entities hold four single precision floats. Large meshes and point clouds
+/// are often stored with half the precision (and half the size), either as
+/// IEEE half precision floats (FP16) or as signed normalized 16-bit integers
+/// (snorm16), which is also what GPUs consume. The types in this header store
+/// an entity in 8 bytes, in the `(x, y, z, w)` order of such buffers:
+///
+/// | Type            | Components            | Encoding                  |
+/// |-----------------|-----------------------|---------------------------|
+/// | `point_h`       | $(x, y, z, w)$        | FP16                      |
+/// | `direction_h`   | $(x, y, z, 0)$        | FP16                      |
+/// | `plane_h`       | $(a, b, c, d)$        | FP16                      |
+/// | `point_n16`     | $(x, y, z, \_)$       | snorm16 in a bounding box |
+/// | `direction_n16` | $(x, y, z, \_)$       | snorm16 in $[-1, 1]$      |
+///
+/// `encode` and `decode` convert arrays in bulk, and `apply` transforms
+/// compact arrays with a motor or rotor directly. Elements are decoded in
+/// blocks small enough to stay in L1, transformed by the regular batch
+/// operator, and encoded again, so the full precision entities never reach
+/// memory and a transform streams 16 bytes per element instead of 32.
+///
+/// Half precision conversions use F16C instructions if `KLN_ENABLE_ISE_F16C`
+/// is defined (compile with `-mf16c` or configure with the
+/// `KLEIN_ENABLE_ISE_F16C` CMake option) and an SSE2 emulation otherwise. The
+/// emulation rounds identically. Snorm16 points are quantized within a
+/// `snorm16_range` box. Encoding rounds to nearest and clamps to the box, and
+/// the $w$ coordinate is not stored (points are assumed normalized, which
+/// normalized motors preserve).
+///
+/// !!! example
+///
+///     ```c++
+///         #include <klein/compact.hpp>
+///
+///         std::vector<kln::point_h> cloud = load_cloud();
+///         kln::apply(m, cloud.data(), cloud.data(), cloud.size());
+///     ```
+
+/// \addtogroup compact
+/// @{
+
+struct point_h
+{
+    uint16_t data[4];
+};
+
+struct direction_h
+{
+    uint16_t data[4];
+};
+
+struct plane_h
+{
+    uint16_t data[4];
+};
+
+struct point_n16
+{
+    int16_t data[4];
+};
+
+struct direction_n16
+{
+    int16_t data[4];
+};
+
+/// Box in which snorm16 points are quantized. A stored integer $q$ of axis
+/// $i$ decodes to $\mathrm{offset}_i + \mathrm{extent}_i q / 32767$. The
+/// default is the box $[-1, 1]^3$.
+struct snorm16_range
+{
+    float offset[3] = {0.f, 0.f, 0.f};
+    float extent[3] = {1.f, 1.f, 1.f};
+};
+
+namespace detail
+{
+    // Elements decoded at a time by the fused kernels (1 KiB of entities)
+    constexpr size_t compact_block = 64;
+
+    // External (x, y, z, w) order to the partition order (w, x, y, z) shared
+    // by points, directions (w = 0), and planes (w = d), and back
+    KLN_INLINE __m128 KLN_VEC_CALL xyzw_to_partition(__m128 xyzw) noexcept
+    {
+        return KLN_SWIZZLE(xyzw, 2, 1, 0, 3);
+    }
+
+    KLN_INLINE __m128 KLN_VEC_CALL partition_to_xyzw(__m128 p) noexcept
+    {
+        return KLN_SWIZZLE(p, 0, 3, 2, 1);
+    }
+
+    inline __m128& partition(point& p) noexcept
+    {
+        return p.p3_;
+    }
+
+    inline __m128& partition(direction& d) noexcept
+    {
+        return d.p3_;
+    }
+
+    inline __m128& partition(plane& p) noexcept
+    {
+        return p.p0_;
+    }
+
+    struct half_codec
+    {
+        [[nodiscard]] __m128 decode(void const* in) const noexcept
+        {
+            return half4_to_ps(
+                _mm_loadl_epi64(reinterpret_cast<__m128i const*>(in)));
+        }
+
+        void KLN_VEC_CALL encode(__m128 xyzw, void* out) const noexcept
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                             ps_to_half4(xyzw));
+        }
+    };
+
+    struct snorm_codec
+    {
+        // Points decode to w = 1 and directions to w = 0
+        snorm_codec(snorm16_range const& range, float w) noexcept
+        {
+            float s   = 1.f / 32767.f;
+            scale     = _mm_set_ps(0.f,
+                                   range.extent[2] * s,
+                                   range.extent[1] * s,
+                                   range.extent[0] * s);
+            inv_scale = _mm_set_ps(0.f,
+                                   32767.f / range.extent[2],
+                                   32767.f / range.extent[1],
+                                   32767.f / range.extent[0]);
+            offset    = _mm_set_ps(
+                w, range.offset[2], range.offset[1], range.offset[0]);
+        }
+
+        [[nodiscard]] __m128 decode(void const* in) const noexcept
+        {
+            return snorm4_to_ps(
+                _mm_loadl_epi64(reinterpret_cast<__m128i const*>(in)),
+                scale,
+                offset);
+        }
+
+        void KLN_VEC_CALL encode(__m128 xyzw, void* out) const noexcept
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                             ps_to_snorm4(xyzw, inv_scale, offset));
+        }
+
+        __m128 scale;
+        __m128 inv_scale;
+        __m128 offset;
+    };
+
+    template <typename E, typename C, typename Codec>
+    void compact_decode(C const* in,
+                        E* out,
+                        size_t count,
+                        Codec const& codec) noexcept
+    {
+        for (size_t i = 0; i != count; ++i)
+        {
+            partition(out[i]) = xyzw_to_partition(codec.decode(in + i));
+        }
+    }
+
+    template <typename E, typename C, typename Codec>
+    void compact_encode(E const* in,
+                        C* out,
+                        size_t count,
+                        Codec const& codec) noexcept
+    {
+        for (size_t i = 0; i != count; ++i)
+        {
+            E e = in[i];
+            codec.encode(partition_to_xyzw(partition(e)), out + i);
+        }
+    }
+
+    template <typename E, typename V, typename C, typename Codec>
+    void compact_apply(V const& v,
+                       C const* in,
+                       C* out,
+                       size_t count,
+                       Codec const& in_codec,
+                       Codec const& out_codec) noexcept
+    {
+        static_assert(std::is_invocable_v<V const&, E*, E*, size_t>,
+                      "The versor must provide a batch operator for the "
+                      "entity");
+        KLN_PROFILE_SCOPE(compact_apply, count);
+        E block[compact_block];
+        for (size_t i = 0; i < count; i += compact_block)
+        {
+            size_t n = count - i < compact_block ? count - i : compact_block;
+            compact_decode(in + i, block, n, in_codec);
+            v(block, block, n);
+            compact_encode(block, out + i, n, out_codec);
+        }
+    }
+} // namespace detail
+
+inline void encode(point const* in, point_h* out, size_t count) noexcept
+{
+    detail::compact_encode(in, out, count, detail::half_codec{});
+}
+
+inline void decode(point_h const* in, point* out, size_t count) noexcept
+{
+    detail::compact_decode(in, out, count, detail::half_codec{});
+}
+
+inline void
+encode(direction const* in, direction_h* out, size_t count) noexcept
+{
+    detail::compact_encode(in, out, count, detail::half_codec{});
+}
+
+inline void
+decode(direction_h const* in, direction* out, size_t count) noexcept
+{
+    detail::compact_decode(in, out, count, detail::half_codec{});
+}
+
+inline void encode(plane const* in, plane_h* out, size_t count) noexcept
+{
+    detail::compact_encode(in, out, count, detail::half_codec{});
+}
+
+inline void decode(plane_h const* in, plane* out, size_t count) noexcept
+{
+    detail::compact_decode(in, out, count, detail::half_codec{});
+}
+
+inline void encode(point const* in,
+                   point_n16* out,
+                   size_t count,
+                   snorm16_range const& range = {}) noexcept
+{
+    detail::compact_encode(in, out, count, detail::snorm_codec{range, 1.f});
+}
+
+inline void decode(point_n16 const* in,
+                   point* out,
+                   size_t count,
+                   snorm16_range const& range = {}) noexcept
+{
+    detail::compact_decode(in, out, count, detail::snorm_codec{range, 1.f});
+}
+
+inline void
+encode(direction const* in, direction_n16* out, size_t count) noexcept
+{
+    detail::compact_encode(in, out, count, detail::snorm_codec{{}, 0.f});
+}
+
+inline void
+decode(direction_n16 const* in, direction* out, size_t count) noexcept
+{
+    detail::compact_decode(in, out, count, detail::snorm_codec{{}, 0.f});
+}
+
+/// Transform `count` FP16 points with the motor or rotor `v`. The input and
+/// output may alias exactly.
+template <typename V>
+void apply(V const& v, point_h const* in, point_h* out, size_t count) noexcept
+{
+    detail::half_codec codec;
+    detail::compact_apply<point>(v, in, out, count, codec, codec);
+}
+
+/// Transform `count` FP16 directions with the motor or rotor `v`. The input
+/// and output may alias exactly.
+template <typename V>
+void apply(V const& v,
+           direction_h const* in,
+           direction_h* out,
+           size_t count) noexcept
+{
+    detail::half_codec codec;
+    detail::compact_apply<direction>(v, in, out, count, codec, codec);
+}
+
+/// Transform `count` FP16 planes with the motor or rotor `v`. The input and
+/// output may alias exactly.
+template <typename V>
+void apply(V const& v, plane_h const* in, plane_h* out, size_t count) noexcept
+{
+    detail::half_codec codec;
+    detail::compact_apply<plane>(v, in, out, count, codec, codec);
+}
+
+/// Transform `count` snorm16 points quantized in `in_range` with the motor or
+/// rotor `v`, and quantize the results in `out_range`. The input and output
+/// may alias exactly.
+template <typename V>
+void apply(V const& v,
+           point_n16 const* in,
+           point_n16* out,
+           size_t count,
+           snorm16_range const& in_range,
+           snorm16_range const& out_range) noexcept
+{
+    detail::compact_apply<point>(v,
+                                 in,
+                                 out,
+                                 count,
+                                 detail::snorm_codec{in_range, 1.f},
+                                 detail::snorm_codec{out_range, 1.f});
+}
+
+/// Transform `count` snorm16 directions with the motor or rotor `v`. The
+/// input and output may alias exactly.
+template <typename V>
+void apply(V const& v,
+           direction_n16 const* in,
+           direction_n16* out,
+           size_t count) noexcept
+{
+    detail::snorm_codec codec{{}, 0.f};
+    detail::compact_apply<direction>(v, in, out, count, codec, codec);
+}
+/// @}
+} // namespace kln
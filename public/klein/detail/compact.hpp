@@ -0,0 +1,3 @@
+#pragma once
+
+#include "x86/x86_compact.hpp"
\ No newline at end of file
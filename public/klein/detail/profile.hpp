@@ -0,0 +1,263 @@
+#pragma once
+
+// Scoped probes around the batch kernels. When KLEIN_PROFILE is not defined,
+// KLN_PROFILE_SCOPE expands to nothing and only the kernel enumeration is
+// declared.
+//
+// When enabled, every probe accumulates its call count, element count, and
+// elapsed time into a process wide table. On Linux, each thread additionally
+// opens a group of hardware counters through perf_event_open (cycles,
+// instructions, L1 data cache read misses, and last level cache misses) the
+// first time it enters a probe. The group is read on entry and exit of the
+// probe and the differences are accumulated as well. Counters which can't be
+// opened (due to perf_event_paranoid or virtualization) read as zero.
+//
+// Probes do not nest. A probe entered while another probe is active on the
+// same thread is ignored so that the outer kernel is charged for all the work.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kln
+{
+namespace detail
+{
+    enum class profile_kernel : uint32_t
+    {
+        motor_planes,
+        motor_lines,
+        motor_points,
+        motor_directions,
+        rotor_planes,
+        rotor_lines,
+        rotor_points,
+        rotor_directions,
+        motor_spline_evaluate,
+        rigid_body_integrate,
+        soa_apply,
+        soa_apply_motors,
+        soa_multiply,
+        interop_apply,
+        compact_apply,
+        count
+    };
+} // namespace detail
+} // namespace kln
+
+#ifdef KLEIN_PROFILE
+
+#    include <atomic>
+#    include <chrono>
+
+#    if defined(__linux__)
+#        include <linux/perf_event.h>
+#        include <sys/ioctl.h>
+#        include <sys/syscall.h>
+#        include <unistd.h>
+#    endif
+
+#    define KLN_PROFILE_SCOPE(kernel, count)             \
+        ::kln::detail::profile_scope kln_profile_scope_{ \
+            ::kln::detail::profile_kernel::kernel, count}
+
+namespace kln
+{
+namespace detail
+{
+    constexpr size_t profile_kernel_count
+        = static_cast<size_t>(profile_kernel::count);
+
+    // Indices of the hardware counters within a sample
+    enum profile_counter : uint32_t
+    {
+        profile_cycles,
+        profile_instructions,
+        profile_l1d_misses,
+        profile_llc_misses,
+        profile_counter_count
+    };
+
+    struct profile_entry
+    {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> elements{0};
+        std::atomic<uint64_t> nanoseconds{0};
+        std::atomic<uint64_t> counters[profile_counter_count] = {};
+    };
+
+    inline profile_entry profile_table[profile_kernel_count];
+
+    // A perf_event_open counter group owned by a single thread
+    class profile_counters
+    {
+    public:
+        profile_counters() noexcept
+        {
+#    if defined(__linux__)
+            constexpr uint64_t l1d_read_miss
+                = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            uint32_t const types[profile_counter_count]
+                = {PERF_TYPE_HARDWARE,
+                   PERF_TYPE_HARDWARE,
+                   PERF_TYPE_HW_CACHE,
+                   PERF_TYPE_HARDWARE};
+            uint64_t const configs[profile_counter_count]
+                = {PERF_COUNT_HW_CPU_CYCLES,
+                   PERF_COUNT_HW_INSTRUCTIONS,
+                   l1d_read_miss,
+                   PERF_COUNT_HW_CACHE_MISSES};
+
+            for (uint32_t i = 0; i != profile_counter_count; ++i)
+            {
+                perf_event_attr attr{};
+                attr.size           = sizeof(attr);
+                attr.type           = types[i];
+                attr.config         = configs[i];
+                attr.read_format    = PERF_FORMAT_GROUP;
+                attr.disabled       = leader_ < 0;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv     = 1;
+
+                int fd = static_cast<int>(
+                    syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+                if (fd < 0)
+                {
+                    if (leader_ < 0)
+                    {
+                        // Without cycles there is no group to join
+                        return;
+                    }
+                    continue;
+                }
+                if (leader_ < 0)
+                {
+                    leader_ = fd;
+                }
+                fds_[i]   = fd;
+                slots_[i] = opened_++;
+            }
+            ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#    endif
+        }
+
+        ~profile_counters() noexcept
+        {
+#    if defined(__linux__)
+            for (int fd : fds_)
+            {
+                if (fd >= 0)
+                {
+                    close(fd);
+                }
+            }
+#    endif
+        }
+
+        profile_counters(profile_counters const&) = delete;
+        profile_counters& operator=(profile_counters const&) = delete;
+
+        [[nodiscard]] bool available() const noexcept
+        {
+            return leader_ >= 0;
+        }
+
+        // Returns false if nothing could be read
+        bool read(uint64_t (&out)[profile_counter_count]) const noexcept
+        {
+#    if defined(__linux__)
+            if (leader_ >= 0)
+            {
+                // PERF_FORMAT_GROUP layout: the count followed by the values
+                uint64_t buffer[1 + profile_counter_count];
+                if (::read(leader_, buffer, sizeof(buffer)) > 0)
+                {
+                    for (uint32_t i = 0; i != profile_counter_count; ++i)
+                    {
+                        out[i] = fds_[i] >= 0 ? buffer[1 + slots_[i]] : 0;
+                    }
+                    return true;
+                }
+            }
+#    endif
+            for (uint64_t& value : out)
+            {
+                value = 0;
+            }
+            return false;
+        }
+
+    private:
+        int leader_                            = -1;
+        int fds_[profile_counter_count]        = {-1, -1, -1, -1};
+        uint32_t slots_[profile_counter_count] = {};
+        uint32_t opened_                       = 0;
+    };
+
+    [[nodiscard]] inline profile_counters& thread_profile_counters() noexcept
+    {
+        thread_local profile_counters counters;
+        return counters;
+    }
+
+    inline thread_local bool profile_active = false;
+
+    class profile_scope
+    {
+    public:
+        profile_scope(profile_kernel kernel, size_t elements) noexcept
+        {
+            if (profile_active)
+            {
+                return;
+            }
+            profile_active = true;
+            entry_         = &profile_table[static_cast<size_t>(kernel)];
+            elements_      = elements;
+            thread_profile_counters().read(counters_);
+            start_ = std::chrono::steady_clock::now();
+        }
+
+        ~profile_scope() noexcept
+        {
+            if (entry_ == nullptr)
+            {
+                return;
+            }
+            auto stop = std::chrono::steady_clock::now();
+            uint64_t counters[profile_counter_count];
+            thread_profile_counters().read(counters);
+
+            entry_->calls.fetch_add(1, std::memory_order_relaxed);
+            entry_->elements.fetch_add(elements_, std::memory_order_relaxed);
+            entry_->nanoseconds.fetch_add(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    stop - start_)
+                    .count(),
+                std::memory_order_relaxed);
+            for (uint32_t i = 0; i != profile_counter_count; ++i)
+            {
+                entry_->counters[i].fetch_add(counters[i] - counters_[i],
+                                              std::memory_order_relaxed);
+            }
+            profile_active = false;
+        }
+
+        profile_scope(profile_scope const&) = delete;
+        profile_scope& operator=(profile_scope const&) = delete;
+
+    private:
+        profile_entry* entry_ = nullptr;
+        size_t elements_      = 0;
+        uint64_t counters_[profile_counter_count];
+        std::chrono::steady_clock::time_point start_;
+    };
+} // namespace detail
+} // namespace kln
+
+#else
+
+#    define KLN_PROFILE_SCOPE(kernel, count)
+
+#endif
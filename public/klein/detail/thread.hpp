@@ -0,0 +1,39 @@
+#pragma once
+
+// Starts a std::thread without letting a failure to create it escape as an
+// exception, so that the noexcept callers can fall back or report an error
+// instead of terminating. When exceptions are disabled, a failure to create
+// the thread aborts as usual.
+
+#include <thread>
+#include <utility>
+
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+#    include <system_error>
+#endif
+
+namespace kln
+{
+namespace detail
+{
+    // Returns false, leaving `out` untouched, if the thread could not be
+    // created
+    template <typename F>
+    [[nodiscard]] bool start_thread(std::thread& out, F&& f) noexcept
+    {
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+        try
+        {
+            out = std::thread{std::forward<F>(f)};
+        }
+        catch (std::system_error const&)
+        {
+            return false;
+        }
+#else
+        out = std::thread{std::forward<F>(f)};
+#endif
+        return true;
+    }
+} // namespace detail
+} // namespace kln
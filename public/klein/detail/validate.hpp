@@ -0,0 +1,371 @@
+#pragma once
+
+// Runtime validation of products and sandwiches. When KLEIN_VALIDATE is not
+// defined, the KLN_VALIDATE_* macros expand to nothing and only the check
+// enumeration and the error measures are declared.
+//
+// When enabled, the instrumented operations check that their operands and
+// results are finite, that the rotors and motors they apply are normalized,
+// and that lines which must be simple (axes) are. Operations on arrays scan
+// their inputs on entry and their outputs on exit of a scope, so that in
+// place operations are classified correctly. Every check bumps a thread
+// local counter. The fast path of a check is a handful of vector
+// instructions and a predictable branch. Violations take a separate out of
+// line path which records them in the thread local statistics and invokes the
+// process wide callback, if any.
+
+#include "sse.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace kln
+{
+namespace detail
+{
+    enum class validate_check : uint32_t
+    {
+        // An operand of a product or sandwich is NaN or infinite
+        non_finite_input,
+        // All operands are finite but the result is not (overflow)
+        non_finite_output,
+        // A rotor r applied as a sandwich does not satisfy r * ~r = 1
+        rotor_norm,
+        // A motor m applied as a sandwich does not satisfy m * ~m = 1
+        motor_norm,
+        // A line used as an axis does not satisfy l ^ l = 0
+        non_simple_line,
+        count
+    };
+
+    struct validate_event
+    {
+        validate_check check;
+        // The instrumented operation, for example "motor(point)"
+        char const* site;
+        // The measured error. Infinite for non-finite checks.
+        float error;
+    };
+
+    using validate_callback = void (*)(validate_event const&, void*);
+
+    // |r * ~r - 1| where p1 holds the rotor
+    [[nodiscard]] inline float KLN_VEC_CALL rotor_norm_error(__m128 p1) noexcept
+    {
+        float out;
+        _mm_store_ss(&out, _mm_sub_ss(dp(p1, p1), _mm_set_ss(1.f)));
+        return std::abs(out);
+    }
+
+    // Largest of the scalar and pseudoscalar deviations of m * ~m from 1
+    [[nodiscard]] inline float KLN_VEC_CALL motor_norm_error(__m128 p1,
+                                                             __m128 p2) noexcept
+    {
+        // The pseudoscalar part of m * ~m is
+        // 2 (a h - b e - c f - d g) for m = a + b e23 + c e31 + d e12
+        //                                   + e e01 + f e02 + g e03 + h e0123
+        __m128 ideal = _mm_sub_ss(_mm_mul_ss(p1, p2), hi_dp(p1, p2));
+        ideal        = _mm_add_ss(ideal, ideal);
+        float pseudo;
+        _mm_store_ss(&pseudo, ideal);
+        pseudo       = std::abs(pseudo);
+        float scalar = rotor_norm_error(p1);
+        return scalar > pseudo || scalar != scalar ? scalar : pseudo;
+    }
+
+    // |l ^ l| relative to the product of the Euclidean and ideal norms. Zero
+    // for simple lines. p1 and p2 hold the Euclidean and ideal parts.
+    [[nodiscard]] inline float KLN_VEC_CALL simple_line_error(__m128 p1,
+                                                              __m128 p2) noexcept
+    {
+        float cross;
+        float norm2;
+        _mm_store_ss(&cross, hi_dp(p1, p2));
+        _mm_store_ss(&norm2, _mm_mul_ss(hi_dp(p1, p1), hi_dp(p2, p2)));
+        if (norm2 == 0.f)
+        {
+            // Lines at infinity and lines through the origin are simple
+            return 0.f;
+        }
+        return std::abs(cross) / std::sqrt(norm2);
+    }
+} // namespace detail
+} // namespace kln
+
+#ifdef KLEIN_VALIDATE
+
+#    include <atomic>
+
+#    define KLN_VALIDATE_FINITE(site, ...) \
+        ::kln::detail::validate_finite(site, __VA_ARGS__)
+#    define KLN_VALIDATE_ROTOR(site, p1) \
+        ::kln::detail::validate_rotor(site, p1)
+#    define KLN_VALIDATE_MOTOR(site, p1, p2) \
+        ::kln::detail::validate_motor(site, p1, p2)
+#    define KLN_VALIDATE_SIMPLE(site, p1, p2) \
+        ::kln::detail::validate_simple(site, p1, p2)
+#    define KLN_VALIDATE_FINITE_ARRAY(site, in, out, count, ...) \
+        ::kln::detail::validate_finite_scope kln_validate_finite_scope{ \
+            site, in, out, count, __VA_ARGS__}
+
+namespace kln
+{
+namespace detail
+{
+    constexpr size_t validate_check_count
+        = static_cast<size_t>(validate_check::count);
+
+    struct validate_counters
+    {
+        uint64_t checks                           = 0;
+        uint64_t violations[validate_check_count] = {};
+        float max_error[validate_check_count]     = {};
+    };
+
+    inline thread_local validate_counters validate_thread;
+
+    inline std::atomic<validate_callback> validate_handler{nullptr};
+    inline std::atomic<void*> validate_user{nullptr};
+    inline std::atomic<float> validate_tolerance{1e-3f};
+
+    // The slow path, kept out of line so that the checks inline cheaply
+#    if defined(_MSC_VER)
+    __declspec(noinline)
+#    else
+    __attribute__((noinline, cold))
+#    endif
+    inline void validate_report(validate_check check,
+                                char const* site,
+                                float error) noexcept
+    {
+        size_t index = static_cast<size_t>(check);
+        ++validate_thread.violations[index];
+        if (!(error <= validate_thread.max_error[index]))
+        {
+            validate_thread.max_error[index] = error;
+        }
+        validate_callback handler
+            = validate_handler.load(std::memory_order_acquire);
+        if (handler != nullptr)
+        {
+            handler(validate_event{check, site, error},
+                    validate_user.load(std::memory_order_relaxed));
+        }
+    }
+
+    template <typename T, typename = void>
+    struct has_p0 : std::false_type
+    {};
+    template <typename T>
+    struct has_p0<T, decltype(void(std::declval<T const&>().p0_))>
+        : std::true_type
+    {};
+
+    template <typename T, typename = void>
+    struct has_p1 : std::false_type
+    {};
+    template <typename T>
+    struct has_p1<T, decltype(void(std::declval<T const&>().p1_))>
+        : std::true_type
+    {};
+
+    template <typename T, typename = void>
+    struct has_p2 : std::false_type
+    {};
+    template <typename T>
+    struct has_p2<T, decltype(void(std::declval<T const&>().p2_))>
+        : std::true_type
+    {};
+
+    template <typename T, typename = void>
+    struct has_p3 : std::false_type
+    {};
+    template <typename T>
+    struct has_p3<T, decltype(void(std::declval<T const&>().p3_))>
+        : std::true_type
+    {};
+
+    // x - x is zero for finite x and NaN otherwise. Bitwise OR preserves the
+    // NaNs so the partitions of an entity reduce to a single register.
+    template <typename T>
+    KLN_INLINE __m128 KLN_VEC_CALL validate_bits(T const& t) noexcept
+    {
+        if constexpr (std::is_arithmetic_v<T>)
+        {
+            __m128 x = _mm_set_ss(static_cast<float>(t));
+            return _mm_sub_ps(x, x);
+        }
+        else if constexpr (!has_p0<T>::value && !has_p1<T>::value
+                           && !has_p2<T>::value && !has_p3<T>::value)
+        {
+            // kln::dual
+            __m128 x = _mm_set_ps(0.f, 0.f, t.q, t.p);
+            return _mm_sub_ps(x, x);
+        }
+        else
+        {
+            __m128 out = _mm_setzero_ps();
+            if constexpr (has_p0<T>::value)
+            {
+                out = _mm_or_ps(out, _mm_sub_ps(t.p0_, t.p0_));
+            }
+            if constexpr (has_p1<T>::value)
+            {
+                out = _mm_or_ps(out, _mm_sub_ps(t.p1_, t.p1_));
+            }
+            if constexpr (has_p2<T>::value)
+            {
+                out = _mm_or_ps(out, _mm_sub_ps(t.p2_, t.p2_));
+            }
+            if constexpr (has_p3<T>::value)
+            {
+                out = _mm_or_ps(out, _mm_sub_ps(t.p3_, t.p3_));
+            }
+            return out;
+        }
+    }
+
+    template <typename Out, typename... In>
+    KLN_INLINE void validate_finite(char const* site,
+                                    Out const& out,
+                                    In const&... in) noexcept
+    {
+        ++validate_thread.checks;
+        __m128 in_bits = _mm_setzero_ps();
+        ((in_bits = _mm_or_ps(in_bits, validate_bits(in))), ...);
+        __m128 out_bits = validate_bits(out);
+        int in_mask     = _mm_movemask_ps(_mm_cmpunord_ps(in_bits, in_bits));
+        int out_mask = _mm_movemask_ps(_mm_cmpunord_ps(out_bits, out_bits));
+        if ((in_mask | out_mask) != 0)
+        {
+            validate_report(in_mask != 0 ? validate_check::non_finite_input
+                                         : validate_check::non_finite_output,
+                            site,
+                            std::numeric_limits<float>::infinity());
+        }
+    }
+
+    template <typename T>
+    KLN_INLINE __m128 KLN_VEC_CALL validate_bits(T const* t,
+                                                 size_t count) noexcept
+    {
+        __m128 out = _mm_setzero_ps();
+        for (size_t i = 0; i != count; ++i)
+        {
+            out = _mm_or_ps(out, validate_bits(t[i]));
+        }
+        return out;
+    }
+
+    // Checks that count entities in and the additional operands are finite
+    // on construction, and that count entities out are on destruction. The
+    // output is only scanned if the input was finite, since non-finite
+    // inputs propagate.
+    template <typename T>
+    class validate_finite_scope
+    {
+    public:
+        template <typename... In>
+        validate_finite_scope(char const* site,
+                              T const* in,
+                              T const* out,
+                              size_t count,
+                              In const&... operands) noexcept
+            : site_{site}
+            , out_{out}
+            , count_{count}
+        {
+            ++validate_thread.checks;
+            __m128 bits = validate_bits(in, count);
+            ((bits = _mm_or_ps(bits, validate_bits(operands))), ...);
+            input_finite_ = _mm_movemask_ps(_mm_cmpunord_ps(bits, bits)) == 0;
+            if (!input_finite_)
+            {
+                validate_report(validate_check::non_finite_input,
+                                site_,
+                                std::numeric_limits<float>::infinity());
+            }
+        }
+
+        ~validate_finite_scope() noexcept
+        {
+            if (!input_finite_)
+            {
+                return;
+            }
+            __m128 bits = validate_bits(out_, count_);
+            if (_mm_movemask_ps(_mm_cmpunord_ps(bits, bits)) != 0)
+            {
+                validate_report(validate_check::non_finite_output,
+                                site_,
+                                std::numeric_limits<float>::infinity());
+            }
+        }
+
+        validate_finite_scope(validate_finite_scope const&) = delete;
+        validate_finite_scope&
+        operator=(validate_finite_scope const&) = delete;
+
+    private:
+        char const* site_;
+        T const* out_;
+        size_t count_;
+        bool input_finite_;
+    };
+
+    KLN_INLINE void KLN_VEC_CALL validate_error(validate_check check,
+                                                char const* site,
+                                                float error) noexcept
+    {
+        ++validate_thread.checks;
+        size_t index = static_cast<size_t>(check);
+        if (error <= validate_tolerance.load(std::memory_order_relaxed))
+        {
+            // Track drift below the tolerance as well
+            if (error > validate_thread.max_error[index])
+            {
+                validate_thread.max_error[index] = error;
+            }
+            return;
+        }
+        // Also reached for NaN errors
+        validate_report(check, site, error);
+    }
+
+    KLN_INLINE void KLN_VEC_CALL validate_rotor(char const* site,
+                                                __m128 p1) noexcept
+    {
+        validate_error(validate_check::rotor_norm, site, rotor_norm_error(p1));
+    }
+
+    KLN_INLINE void KLN_VEC_CALL validate_motor(char const* site,
+                                                __m128 p1,
+                                                __m128 p2) noexcept
+    {
+        validate_error(
+            validate_check::motor_norm, site, motor_norm_error(p1, p2));
+    }
+
+    KLN_INLINE void KLN_VEC_CALL validate_simple(char const* site,
+                                                 __m128 p1,
+                                                 __m128 p2) noexcept
+    {
+        validate_error(
+            validate_check::non_simple_line, site, simple_line_error(p1, p2));
+    }
+} // namespace detail
+} // namespace kln
+
+#else
+
+#    define KLN_VALIDATE_FINITE(site, ...)
+#    define KLN_VALIDATE_ROTOR(site, p1)
+#    define KLN_VALIDATE_MOTOR(site, p1, p2)
+#    define KLN_VALIDATE_SIMPLE(site, p1, p2)
+#    define KLN_VALIDATE_FINITE_ARRAY(site, in, out, count, ...)
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+// Includes windows.h without letting it define the min and max macros (which
+// break std::min and std::max in user code) or pull in unrelated APIs. The
+// configuration macros are restored afterwards so that the includer's own
+// choice of WIN32_LEAN_AND_MEAN and NOMINMAX is unaffected.
+
+#ifdef _WIN32
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#        define KLN_UNDEF_WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#        define KLN_UNDEF_NOMINMAX
+#    endif
+#    include <windows.h>
+#    ifdef KLN_UNDEF_WIN32_LEAN_AND_MEAN
+#        undef WIN32_LEAN_AND_MEAN
+#        undef KLN_UNDEF_WIN32_LEAN_AND_MEAN
+#    endif
+#    ifdef KLN_UNDEF_NOMINMAX
+#        undef NOMINMAX
+#        undef KLN_UNDEF_NOMINMAX
+#    endif
+#endif
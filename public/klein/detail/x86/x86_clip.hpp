@@ -0,0 +1,297 @@
+// File: x86_clip.hpp
+// Purpose: Clip line segments, convex polygons, and triangles against sets of
+// planes.
+//
+// Notes:
+// A point x is inside the plane p when the signed distance p ^ x (the
+// e0123 coefficient, see plane_distance4) is nonnegative. Intersections
+// with the plane are found by interpolating between the two endpoints of an
+// edge by their distances, which for normalized points agrees with the meet
+// of the plane with the line through the edge and avoids the join and the
+// division by the weight.
+//
+// Vertices are classified four at a time: a block of points is transposed
+// into SoA form once, after which each plane costs four multiplies and three
+// adds per block. Segments and triangles are clipped a block at a time, with
+// one segment or triangle per lane, and the survivors of a block are written
+// contiguously in input order. Polygons are clipped with Sutherland-Hodgman,
+// one plane per pass, and only the emission of vertices is scalar.
+
+#pragma once
+
+#include "x86_reduce.hpp"
+
+#include <cstddef>
+
+namespace kln
+{
+namespace detail
+{
+    // Lanes of b where mask is set and lanes of a elsewhere
+    KLN_INLINE __m128 KLN_VEC_CALL clip_select(__m128 a,
+                                               __m128 b,
+                                               __m128 mask) noexcept
+    {
+#ifdef KLEIN_SSE_4_1
+        return _mm_blendv_ps(a, b, mask);
+#else
+        return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+#endif
+    }
+
+    // The point a + t(b - a) for points in either AoS or SoA form
+    KLN_INLINE __m128 KLN_VEC_CALL clip_lerp(__m128 a,
+                                             __m128 b,
+                                             __m128 t) noexcept
+    {
+        return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+    }
+
+    // Transpose the first count of four points in[i * Stride] (w, x, y, z)
+    // into SoA form
+    template <size_t Stride>
+    KLN_INLINE void KLN_VEC_CALL clip_load4(__m128 const* in,
+                                            size_t count,
+                                            __m128* out) noexcept
+    {
+        for (size_t i = 0; i != 4; ++i)
+        {
+            out[i] = i < count ? in[i * Stride] : _mm_setzero_ps();
+        }
+        _MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+    }
+
+    // Clip count segments, given as pairs of normalized points, against
+    // plane_count planes. The surviving pieces are written as pairs to out,
+    // which may alias in, and their number is returned.
+    KLN_INLINE size_t KLN_VEC_CALL clip_segments(__m128 const* planes,
+                                                 size_t plane_count,
+                                                 __m128 const* in,
+                                                 size_t count,
+                                                 __m128* out) noexcept
+    {
+        __m128 zero    = _mm_setzero_ps();
+        size_t written = 0;
+        for (size_t i = 0; i < count; i += 4)
+        {
+            size_t valid = count - i < 4 ? count - i : 4;
+            __m128 a[4];
+            __m128 b[4];
+            clip_load4<2>(in + 2 * i, valid, a);
+            clip_load4<2>(in + 2 * i + 1, valid, b);
+
+            // The segment survives as a + t(b - a) for t0 <= t <= t1
+            __m128 t0     = zero;
+            __m128 t1     = _mm_set1_ps(1.f);
+            __m128 reject = zero;
+            for (size_t j = 0; j != plane_count; ++j)
+            {
+                __m128 pb[4];
+                broadcast4(planes[j], pb);
+                __m128 da    = plane_distance4(pb, a);
+                __m128 db    = plane_distance4(pb, b);
+                __m128 a_out = _mm_cmplt_ps(da, zero);
+                __m128 b_out = _mm_cmplt_ps(db, zero);
+                reject       = _mm_or_ps(reject, _mm_and_ps(a_out, b_out));
+
+                // Only used in lanes where exactly one endpoint is outside,
+                // so da - db does not vanish
+                __m128 t = _mm_div_ps(da, _mm_sub_ps(da, db));
+                t0       = clip_select(
+                    t0, _mm_max_ps(t0, t), _mm_andnot_ps(b_out, a_out));
+                t1 = clip_select(
+                    t1, _mm_min_ps(t1, t), _mm_andnot_ps(a_out, b_out));
+            }
+
+            __m128 keep = _mm_andnot_ps(reject, _mm_cmple_ps(t0, t1));
+            int mask    = _mm_movemask_ps(_mm_and_ps(keep, lane_mask(valid)));
+            if (mask == 0)
+            {
+                continue;
+            }
+
+            __m128 ca[4];
+            __m128 cb[4];
+            for (size_t k = 0; k != 4; ++k)
+            {
+                ca[k] = clip_lerp(a[k], b[k], t0);
+                cb[k] = clip_lerp(a[k], b[k], t1);
+            }
+            _MM_TRANSPOSE4_PS(ca[0], ca[1], ca[2], ca[3]);
+            _MM_TRANSPOSE4_PS(cb[0], cb[1], cb[2], cb[3]);
+            for (size_t k = 0; k != 4; ++k)
+            {
+                if (mask & (1 << k))
+                {
+                    out[2 * written]     = ca[k];
+                    out[2 * written + 1] = cb[k];
+                    ++written;
+                }
+            }
+        }
+        return written;
+    }
+
+    // One Sutherland-Hodgman pass: clip the polygon in of count vertices
+    // against the plane p and write the result to out, which must not alias
+    // in. Returns the number of vertices written, at most count + 1 for
+    // convex polygons.
+    KLN_INLINE size_t KLN_VEC_CALL clip_polygon_pass(__m128 p,
+                                                     __m128 const* in,
+                                                     size_t count,
+                                                     __m128* out) noexcept
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        __m128 pb[4];
+        broadcast4(p, pb);
+        __m128 x[4];
+        clip_load4<1>(in + count - 1, 1, x);
+
+        // The polygon is walked edge by edge starting with the closing edge
+        __m128 prev    = in[count - 1];
+        float d_prev   = _mm_cvtss_f32(plane_distance4(pb, x));
+        size_t written = 0;
+        for (size_t i = 0; i < count; i += 4)
+        {
+            size_t valid = count - i < 4 ? count - i : 4;
+            clip_load4<1>(in + i, valid, x);
+            float d[4];
+            _mm_storeu_ps(d, plane_distance4(pb, x));
+
+            for (size_t j = 0; j != valid; ++j)
+            {
+                __m128 cur  = in[i + j];
+                bool inside = d[j] >= 0.f;
+                if (inside != (d_prev >= 0.f))
+                {
+                    float t = d_prev / (d_prev - d[j]);
+                    out[written++] = clip_lerp(prev, cur, _mm_set1_ps(t));
+                }
+                if (inside)
+                {
+                    out[written++] = cur;
+                }
+                prev   = cur;
+                d_prev = d[j];
+            }
+        }
+        return written;
+    }
+
+    // Clip the convex polygon in of count vertices against plane_count
+    // planes, alternating between out and scratch such that the last pass
+    // writes out. Both must hold count + plane_count vertices.
+    KLN_INLINE size_t KLN_VEC_CALL clip_polygon(__m128 const* planes,
+                                                size_t plane_count,
+                                                __m128 const* in,
+                                                size_t count,
+                                                __m128* out,
+                                                __m128* scratch) noexcept
+    {
+        if (plane_count == 0)
+        {
+            for (size_t i = 0; i != count; ++i)
+            {
+                out[i] = in[i];
+            }
+            return count;
+        }
+
+        // An emptied polygon stays empty, so the passes may stop early
+        __m128* dst   = plane_count % 2 == 0 ? scratch : out;
+        __m128* other = plane_count % 2 == 0 ? out : scratch;
+        for (size_t j = 0; j != plane_count && count != 0; ++j)
+        {
+            count = clip_polygon_pass(planes[j], in, count, dst);
+            in           = dst;
+            __m128* next = other;
+            other        = dst;
+            dst          = next;
+        }
+        return count;
+    }
+
+    // Clip count triangles, given as triples of normalized points, against
+    // plane_count <= MaxPlanes planes. Triangles entirely inside every plane
+    // are copied and triangles entirely outside any plane are dropped
+    // without clipping. The others are clipped as polygons and the result
+    // written as a fan. Returns the number of triangles written to out, or
+    // zero without writing anything if plane_count exceeds MaxPlanes, which
+    // bounds the stack arrays the polygons are clipped in.
+    template <size_t MaxPlanes>
+    KLN_INLINE size_t KLN_VEC_CALL clip_triangles(__m128 const* planes,
+                                                  size_t plane_count,
+                                                  __m128 const* in,
+                                                  size_t count,
+                                                  __m128* out) noexcept
+    {
+        if (plane_count > MaxPlanes)
+        {
+            return 0;
+        }
+
+        __m128 zero    = _mm_setzero_ps();
+        size_t written = 0;
+        for (size_t i = 0; i < count; i += 4)
+        {
+            size_t valid = count - i < 4 ? count - i : 4;
+            __m128 v[3][4];
+            for (size_t k = 0; k != 3; ++k)
+            {
+                clip_load4<3>(in + 3 * i + k, valid, v[k]);
+            }
+
+            __m128 any_out = zero;
+            __m128 reject  = zero;
+            for (size_t j = 0; j != plane_count; ++j)
+            {
+                __m128 pb[4];
+                broadcast4(planes[j], pb);
+                __m128 out0 = _mm_cmplt_ps(plane_distance4(pb, v[0]), zero);
+                __m128 out1 = _mm_cmplt_ps(plane_distance4(pb, v[1]), zero);
+                __m128 out2 = _mm_cmplt_ps(plane_distance4(pb, v[2]), zero);
+                any_out     = _mm_or_ps(
+                    any_out, _mm_or_ps(out0, _mm_or_ps(out1, out2)));
+                reject = _mm_or_ps(
+                    reject, _mm_and_ps(out0, _mm_and_ps(out1, out2)));
+            }
+            int clipped  = _mm_movemask_ps(any_out);
+            int rejected = _mm_movemask_ps(reject);
+
+            for (size_t k = 0; k != valid; ++k)
+            {
+                __m128 const* tri = in + 3 * (i + k);
+                if (rejected & (1 << k))
+                {
+                    continue;
+                }
+                if (!(clipped & (1 << k)))
+                {
+                    out[3 * written]     = tri[0];
+                    out[3 * written + 1] = tri[1];
+                    out[3 * written + 2] = tri[2];
+                    ++written;
+                    continue;
+                }
+
+                __m128 polygon[3 + MaxPlanes];
+                __m128 scratch[3 + MaxPlanes];
+                size_t n = clip_polygon(
+                    planes, plane_count, tri, 3, polygon, scratch);
+                for (size_t f = 2; f < n; ++f)
+                {
+                    out[3 * written]     = polygon[0];
+                    out[3 * written + 1] = polygon[f - 1];
+                    out[3 * written + 2] = polygon[f];
+                    ++written;
+                }
+            }
+        }
+        return written;
+    }
+} // namespace detail
+} // namespace kln
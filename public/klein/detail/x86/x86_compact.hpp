@@ -0,0 +1,120 @@
+// File: x86_compact.hpp
+// Purpose: Conversions between four floats and four 16-bit values, either
+// IEEE half precision floats or signed normalized integers (snorm16).
+//
+// Notes:
+// The four 16-bit values occupy the low 64 bits of an __m128i. Half precision
+// conversions use the F16C instructions when KLN_ENABLE_ISE_F16C is defined
+// and are emulated with SSE2 integer arithmetic otherwise. Both round to
+// nearest even and handle denormals, infinities, and NaNs, and produce
+// identical results except for the payload of NaNs converted to half
+// precision (the emulation produces a canonical quiet NaN).
+
+#pragma once
+
+#include "x86_sse.hpp"
+
+#ifdef KLN_ENABLE_ISE_F16C
+#    include <immintrin.h>
+#endif
+
+namespace kln
+{
+namespace detail
+{
+    KLN_INLINE __m128 KLN_VEC_CALL half4_to_ps(__m128i h) noexcept
+    {
+#ifdef KLN_ENABLE_ISE_F16C
+        return _mm_cvtph_ps(h);
+#else
+        // Widen to 32 bits and move the exponent and mantissa into place. The
+        // multiplication by 2^112 rebiases the exponent (127 - 15) and
+        // normalizes denormals in a single step. Infinities and NaNs (an
+        // exponent of 31) are forced to the maximum exponent afterwards and
+        // NaNs are quieted as F16C does.
+        h                 = _mm_unpacklo_epi16(h, _mm_setzero_si128());
+        __m128i expmant   = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+        __m128i sign      = _mm_slli_epi32(_mm_xor_si128(h, expmant), 16);
+        __m128 scaled     = _mm_mul_ps(
+            _mm_castsi128_ps(_mm_slli_epi32(expmant, 13)),
+            _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+        __m128i is_infnan = _mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7bff));
+        __m128i is_nan    = _mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7c00));
+        __m128i high      = _mm_or_si128(
+            _mm_and_si128(is_infnan, _mm_set1_epi32(255 << 23)),
+            _mm_and_si128(is_nan, _mm_set1_epi32(1 << 22)));
+        high = _mm_or_si128(high, sign);
+        return _mm_or_ps(scaled, _mm_castsi128_ps(high));
+#endif
+    }
+
+    KLN_INLINE __m128i KLN_VEC_CALL ps_to_half4(__m128 f) noexcept
+    {
+#ifdef KLN_ENABLE_ISE_F16C
+        return _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+        __m128i u    = _mm_castps_si128(f);
+        __m128i sign = _mm_and_si128(u, _mm_set1_epi32(0x80000000));
+        u            = _mm_xor_si128(u, sign);
+
+        // Normal results: rebias the exponent and round the 13 dropped
+        // mantissa bits to nearest even
+        __m128i odd
+            = _mm_and_si128(_mm_srli_epi32(u, 13), _mm_set1_epi32(1));
+        __m128i normal = _mm_add_epi32(
+            u, _mm_set1_epi32(static_cast<int>((15u - 127u) << 23) + 0xfff));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, odd), 13);
+
+        // Denormal results (below 2^-14): adding 0.5 aligns the mantissa so
+        // that the float addition performs the rounding
+        __m128i magic    = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        __m128i denormal = _mm_sub_epi32(
+            _mm_castps_si128(
+                _mm_add_ps(_mm_castsi128_ps(u), _mm_castsi128_ps(magic))),
+            magic);
+
+        // Overflow to infinity, NaNs to a quiet NaN
+        __m128i infnan = _mm_or_si128(
+            _mm_set1_epi32(0x7c00),
+            _mm_and_si128(_mm_cmpgt_epi32(u, _mm_set1_epi32(255 << 23)),
+                          _mm_set1_epi32(0x200)));
+
+        __m128i is_denormal = _mm_cmplt_epi32(u, _mm_set1_epi32(113 << 23));
+        __m128i is_large
+            = _mm_cmpgt_epi32(u, _mm_set1_epi32(((127 + 16) << 23) - 1));
+        __m128i out = _mm_or_si128(_mm_and_si128(is_denormal, denormal),
+                                   _mm_andnot_si128(is_denormal, normal));
+        out         = _mm_or_si128(_mm_and_si128(is_large, infnan),
+                           _mm_andnot_si128(is_large, out));
+        out         = _mm_or_si128(out, _mm_srli_epi32(sign, 16));
+
+        // Sign extend so that the saturating pack leaves the bits untouched
+        out = _mm_srai_epi32(_mm_slli_epi32(out, 16), 16);
+        return _mm_packs_epi32(out, out);
+#endif
+    }
+
+    // Returns scale * q + offset where q holds four snorm16 values as
+    // integers in [-32767, 32767]
+    KLN_INLINE __m128 KLN_VEC_CALL snorm4_to_ps(__m128i q,
+                                                __m128 scale,
+                                                __m128 offset) noexcept
+    {
+        q = _mm_srai_epi32(_mm_unpacklo_epi16(q, q), 16);
+        return _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(q), scale), offset);
+    }
+
+    // Inverse of snorm4_to_ps where inv_scale holds the reciprocals of the
+    // scale. Values outside the representable range are clamped.
+    KLN_INLINE __m128i KLN_VEC_CALL ps_to_snorm4(__m128 f,
+                                                 __m128 inv_scale,
+                                                 __m128 offset) noexcept
+    {
+        f = _mm_mul_ps(_mm_sub_ps(f, offset), inv_scale);
+        f = _mm_min_ps(_mm_max_ps(f, _mm_set1_ps(-32767.f)),
+                       _mm_set1_ps(32767.f));
+        __m128i q = _mm_cvtps_epi32(f);
+        return _mm_packs_epi32(q, q);
+    }
+} // namespace detail
+} // namespace kln
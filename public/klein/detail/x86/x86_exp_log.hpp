@@ -51,6 +51,18 @@ namespace detail
         __m128 a2 = hi_dp_bc(a, a);
         __m128 ab = hi_dp_bc(a, b);
 
+        // If the Euclidean part vanishes, the bivector is (to first order) an
+        // ideal line and the normalization below would divide by zero. In
+        // that case, the exponential is simply 1 + a + b with the dot product
+        // of a and b contributing the e0123 component. The scalar lane of a
+        // is replaced rather than added to, so it needn't be zero.
+        if (_mm_comilt_ss(a2, _mm_set_ss(1e-12f)))
+        {
+            p1_out = _mm_move_ss(a, _mm_set_ss(1.f));
+            p2_out = _mm_add_ss(b, ab);
+            return;
+        }
+
         // Next, we need the sqrt of that quantity. Since e0123 squares to 0,
         // this has a closed form solution.
         //
@@ -151,8 +163,23 @@ namespace detail
 
         // Next, we need to compute the norm as in the exponential.
         __m128 a2 = hi_dp_bc(a, a);
-        // TODO: handle case when a2 is 0
         __m128 ab = hi_dp_bc(a, b);
+
+        // Store the scalar component
+        float p;
+        _mm_store_ss(&p, p1);
+
+        // A motor without a rotational part is a translator (up to the scalar
+        // p) and its logarithm is the ideal partition scaled by 1/p. This
+        // avoids the division by zero in the general case below.
+        if (_mm_comilt_ss(a2, _mm_set_ss(1e-12f)))
+        {
+            __m128 inv_p = _mm_set1_ps(1.f / p);
+            p1_out       = _mm_mul_ps(a, inv_p);
+            p2_out       = _mm_mul_ps(b, inv_p);
+            return;
+        }
+
 #ifdef KLEIN_PRECISE
         __m128 s           = _mm_sqrt_ps(a2);
         __m128 a2_sqrt_rcp = _mm_div_ps(_mm_set1_ps(1.f), s);
@@ -163,10 +190,6 @@ namespace detail
         __m128 minus_t = _mm_mul_ps(ab, a2_sqrt_rcp);
         // s + t e0123 is the norm of our bivector.
 
-        // Store the scalar component
-        float p;
-        _mm_store_ss(&p, p1);
-
         // Store the pseudoscalar component
         float q;
         _mm_store_ss(&q, p2);
@@ -0,0 +1,366 @@
+// File: x86_interop.hpp
+// Purpose: Kernels transforming entities stored in external layouts, either
+// tightly packed (x, y, z) triples, (x, y, z, w) quadruples, or attributes of
+// interleaved vertices, without first repacking them into the partitions used
+// by the library.
+//
+// Notes:
+// Four entities are processed at a time. Each block is transposed into SoA
+// form on load (one __m128 per coordinate), transformed by the affine form of
+// a normalized versor, and transposed back on store. The rotation and
+// translation are read off the column-major matrix produced by mat4x4_12 and
+// broadcast once per call, so the transform of a block costs 9 multiplies
+// and at most 12 adds in addition to the shuffles.
+
+#pragma once
+
+#include "x86_sse.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+namespace kln
+{
+namespace detail
+{
+    enum class interop_kind
+    {
+        point,
+        direction,
+        plane,
+    };
+
+    // Rotation coefficients r[3i + j] (row i, column j) and translation t[i],
+    // each broadcast to all four lanes
+    struct interop_affine
+    {
+        __m128 r[9];
+        __m128 t[3];
+    };
+
+    // Read the affine form of a normalized versor off the columns of its
+    // matrix (see mat4x4_12)
+    KLN_INLINE void KLN_VEC_CALL interop_load_affine(
+        __m128 const* cols, interop_affine& out) noexcept
+    {
+        float m[16];
+        for (int j = 0; j != 4; ++j)
+        {
+            _mm_storeu_ps(m + 4 * j, cols[j]);
+        }
+        for (int i = 0; i != 3; ++i)
+        {
+            for (int j = 0; j != 3; ++j)
+            {
+                out.r[3 * i + j] = _mm_set1_ps(m[4 * j + i]);
+            }
+            out.t[i] = _mm_set1_ps(m[12 + i]);
+        }
+    }
+
+    // Transpose four packed (x, y, z) triples held in three registers
+    //
+    // r0: (x0, y0, z0, x1)
+    // r1: (y1, z1, x2, y2)
+    // r2: (z2, x3, y3, z3)
+    KLN_INLINE void KLN_VEC_CALL load_xyz4(float const* in,
+                                           __m128& x,
+                                           __m128& y,
+                                           __m128& z) noexcept
+    {
+        __m128 r0 = _mm_loadu_ps(in);
+        __m128 r1 = _mm_loadu_ps(in + 4);
+        __m128 r2 = _mm_loadu_ps(in + 8);
+
+        // (x2, y1, x3, z2)
+        __m128 tx = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(0, 1, 0, 2));
+        x         = _mm_shuffle_ps(r0, tx, _MM_SHUFFLE(2, 0, 3, 0));
+
+        // (y0, z0, y1, y2) and (z1, y2, y3, z3)
+        __m128 ty0 = _mm_shuffle_ps(r0, r1, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 ty1 = _mm_shuffle_ps(r1, r2, _MM_SHUFFLE(3, 2, 3, 1));
+        y          = _mm_shuffle_ps(ty0, ty1, _MM_SHUFFLE(2, 1, 2, 0));
+
+        // (z0, x0, z1, y1)
+        __m128 tz = _mm_shuffle_ps(r0, r1, _MM_SHUFFLE(0, 1, 0, 2));
+        z         = _mm_shuffle_ps(tz, r2, _MM_SHUFFLE(3, 0, 2, 0));
+    }
+
+    // Inverse of load_xyz4
+    KLN_INLINE void KLN_VEC_CALL store_xyz4(__m128 x,
+                                            __m128 y,
+                                            __m128 z,
+                                            float* out) noexcept
+    {
+        // (x0, y0, x1, y1) and (x2, y2, x3, y3)
+        __m128 xy_lo = _mm_unpacklo_ps(x, y);
+        __m128 xy_hi = _mm_unpackhi_ps(x, y);
+
+        // (z0, z0, x1, x1)
+        __m128 t0 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+        // (y1, y1, z1, z1)
+        __m128 t1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+        // (z2, z2, x3, x3) and (y3, y3, z3, z3)
+        __m128 t2 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+        __m128 t3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+
+        _mm_storeu_ps(out, _mm_shuffle_ps(xy_lo, t0, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(out + 4,
+                      _mm_shuffle_ps(t1, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+        _mm_storeu_ps(out + 8, _mm_shuffle_ps(t2, t3, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+
+    // Rotate the vectors (x, y, z) in place
+    KLN_INLINE void KLN_VEC_CALL interop_rotate4(interop_affine const& a,
+                                                 __m128& x,
+                                                 __m128& y,
+                                                 __m128& z) noexcept
+    {
+        __m128 x_out = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a.r[0], x), _mm_mul_ps(a.r[1], y)),
+            _mm_mul_ps(a.r[2], z));
+        __m128 y_out = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a.r[3], x), _mm_mul_ps(a.r[4], y)),
+            _mm_mul_ps(a.r[5], z));
+        z = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a.r[6], x), _mm_mul_ps(a.r[7], y)),
+            _mm_mul_ps(a.r[8], z));
+        x = x_out;
+        y = y_out;
+    }
+
+    // Transform four entities in SoA form. For points, w is the homogeneous
+    // coordinate (HasW false means w = 1) and is unchanged. For directions,
+    // w is ignored. For planes (a x + b y + c z + d = 0), w holds d. A
+    // rotation (n' = R n) followed by a translation t moves the plane to
+    // n'.x + d - n'.t = 0.
+    template <interop_kind Kind, bool Translate, bool HasW>
+    KLN_INLINE void KLN_VEC_CALL interop_transform4(interop_affine const& a,
+                                                    __m128& x,
+                                                    __m128& y,
+                                                    __m128& z,
+                                                    __m128& w) noexcept
+    {
+        interop_rotate4(a, x, y, z);
+
+        if constexpr (Translate && Kind == interop_kind::point)
+        {
+            if constexpr (HasW)
+            {
+                x = _mm_add_ps(x, _mm_mul_ps(a.t[0], w));
+                y = _mm_add_ps(y, _mm_mul_ps(a.t[1], w));
+                z = _mm_add_ps(z, _mm_mul_ps(a.t[2], w));
+            }
+            else
+            {
+                x = _mm_add_ps(x, a.t[0]);
+                y = _mm_add_ps(y, a.t[1]);
+                z = _mm_add_ps(z, a.t[2]);
+            }
+        }
+        else if constexpr (Translate && Kind == interop_kind::plane)
+        {
+            __m128 nt = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a.t[0], x), _mm_mul_ps(a.t[1], y)),
+                _mm_mul_ps(a.t[2], z));
+            w = _mm_sub_ps(w, nt);
+        }
+    }
+
+    // Transform count packed (x, y, z) triples. The input and output may
+    // alias exactly. The last partial block goes through a stack copy so that
+    // no access strays past either array.
+    template <interop_kind Kind, bool Translate>
+    void KLN_VEC_CALL apply_xyz(interop_affine const& a,
+                                float const* in,
+                                float* out,
+                                size_t count) noexcept
+    {
+        __m128 x;
+        __m128 y;
+        __m128 z;
+        __m128 w = _mm_set1_ps(1.f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            load_xyz4(in + 3 * i, x, y, z);
+            interop_transform4<Kind, Translate, false>(a, x, y, z, w);
+            store_xyz4(x, y, z, out + 3 * i);
+        }
+
+        if (size_t rest = count - i)
+        {
+            float tail[12] = {};
+            std::memcpy(tail, in + 3 * i, 3 * rest * sizeof(float));
+            load_xyz4(tail, x, y, z);
+            interop_transform4<Kind, Translate, false>(a, x, y, z, w);
+            store_xyz4(x, y, z, tail);
+            std::memcpy(out + 3 * i, tail, 3 * rest * sizeof(float));
+        }
+    }
+
+    // Transpose four (x, y, z, w) quadruples
+    KLN_INLINE void KLN_VEC_CALL load_xyzw4(float const* in,
+                                            __m128& x,
+                                            __m128& y,
+                                            __m128& z,
+                                            __m128& w) noexcept
+    {
+        x = _mm_loadu_ps(in);
+        y = _mm_loadu_ps(in + 4);
+        z = _mm_loadu_ps(in + 8);
+        w = _mm_loadu_ps(in + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+    }
+
+    // Inverse of load_xyzw4
+    KLN_INLINE void KLN_VEC_CALL
+    store_xyzw4(__m128 x, __m128 y, __m128 z, __m128 w, float* out) noexcept
+    {
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(out, x);
+        _mm_storeu_ps(out + 4, y);
+        _mm_storeu_ps(out + 8, z);
+        _mm_storeu_ps(out + 12, w);
+    }
+
+    // Transform count (x, y, z, w) quadruples. The input and output may alias
+    // exactly.
+    template <interop_kind Kind, bool Translate>
+    void KLN_VEC_CALL apply_xyzw(interop_affine const& a,
+                                 float const* in,
+                                 float* out,
+                                 size_t count) noexcept
+    {
+        __m128 x;
+        __m128 y;
+        __m128 z;
+        __m128 w;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            load_xyzw4(in + 4 * i, x, y, z, w);
+            interop_transform4<Kind, Translate, true>(a, x, y, z, w);
+            store_xyzw4(x, y, z, w, out + 4 * i);
+        }
+
+        if (size_t rest = count - i)
+        {
+            float tail[16] = {};
+            std::memcpy(tail, in + 4 * i, 4 * rest * sizeof(float));
+            load_xyzw4(tail, x, y, z, w);
+            interop_transform4<Kind, Translate, true>(a, x, y, z, w);
+            store_xyzw4(x, y, z, w, tail);
+            std::memcpy(out + 4 * i, tail, 4 * rest * sizeof(float));
+        }
+    }
+
+    // Load the (x, y, z) triple at p as (x, y, z, 0) without reading past it
+    KLN_INLINE __m128 KLN_VEC_CALL load_xyz1(unsigned char const* p) noexcept
+    {
+        __m128 xy = _mm_loadl_pi(_mm_setzero_ps(),
+                                 reinterpret_cast<__m64 const*>(p));
+        return _mm_movelh_ps(
+            xy, _mm_load_ss(reinterpret_cast<float const*>(p) + 2));
+    }
+
+    // Store the first three components of v to p
+    KLN_INLINE void KLN_VEC_CALL store_xyz1(__m128 v,
+                                            unsigned char* p) noexcept
+    {
+        _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+        _mm_store_ss(reinterpret_cast<float*>(p) + 2, _mm_movehl_ps(v, v));
+    }
+
+    // Transpose the (x, y, z) triples of count <= 4 vertices found offset
+    // bytes into each vertex. Missing vertices read as zero.
+    KLN_INLINE void KLN_VEC_CALL load_strided4(unsigned char const* base,
+                                               size_t stride,
+                                               size_t count,
+                                               __m128& x,
+                                               __m128& y,
+                                               __m128& z) noexcept
+    {
+        __m128 rows[4];
+        for (size_t i = 0; i != 4; ++i)
+        {
+            rows[i] = i < count ? load_xyz1(base + i * stride)
+                                : _mm_setzero_ps();
+        }
+        _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+        x = rows[0];
+        y = rows[1];
+        z = rows[2];
+    }
+
+    // Inverse of load_strided4
+    KLN_INLINE void KLN_VEC_CALL store_strided4(__m128 x,
+                                                __m128 y,
+                                                __m128 z,
+                                                unsigned char* base,
+                                                size_t stride,
+                                                size_t count) noexcept
+    {
+        __m128 w = _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        __m128 rows[4] = {x, y, z, w};
+        for (size_t i = 0; i != count; ++i)
+        {
+            store_xyz1(rows[i], base + i * stride);
+        }
+    }
+
+    // Transform the (x, y, z) attributes of four vertices in place. A
+    // position is transformed as a point (w = 1) and a normal as a direction.
+    // Both reuse the same broadcast rotation.
+    template <bool Translate, bool Positions, bool Normals>
+    KLN_INLINE void KLN_VEC_CALL apply_vertices4(interop_affine const& a,
+                                                 unsigned char* vertices,
+                                                 size_t stride,
+                                                 size_t position,
+                                                 size_t normal,
+                                                 size_t count) noexcept
+    {
+        __m128 x;
+        __m128 y;
+        __m128 z;
+        __m128 w = _mm_set1_ps(1.f);
+        if constexpr (Positions)
+        {
+            load_strided4(vertices + position, stride, count, x, y, z);
+            interop_transform4<interop_kind::point, Translate, false>(
+                a, x, y, z, w);
+            store_strided4(x, y, z, vertices + position, stride, count);
+        }
+        if constexpr (Normals)
+        {
+            load_strided4(vertices + normal, stride, count, x, y, z);
+            interop_rotate4(a, x, y, z);
+            store_strided4(x, y, z, vertices + normal, stride, count);
+        }
+    }
+
+    // Transform count interleaved vertices in a single pass over the buffer
+    template <bool Translate, bool Positions, bool Normals>
+    void KLN_VEC_CALL apply_vertices(interop_affine const& a,
+                                     unsigned char* vertices,
+                                     size_t stride,
+                                     size_t position,
+                                     size_t normal,
+                                     size_t count) noexcept
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            apply_vertices4<Translate, Positions, Normals>(
+                a, vertices + i * stride, stride, position, normal, 4);
+        }
+
+        if (size_t rest = count - i)
+        {
+            apply_vertices4<Translate, Positions, Normals>(
+                a, vertices + i * stride, stride, position, normal, rest);
+        }
+    }
+} // namespace detail
+} // namespace kln
@@ -0,0 +1,267 @@
+// File: x86_reduce.hpp
+// Purpose: Reductions (sums and maxima) of inner products, distances, and
+// moments over arrays of entities.
+//
+// Notes:
+// Every kernel accumulates in full registers and defers the horizontal
+// reduction to the end. Products of partitions in AoS form (the inner
+// products) are accumulated componentwise, so each element costs a multiply
+// and an add. Quantities which combine the components of an element (the
+// distances and moments) are computed on blocks of four elements transposed
+// into SoA form, one element per lane. Lanes past the end of an array are
+// masked out of the last block.
+//
+// Sums are either plain or compensated (Kahan). Compensation keeps the error
+// of a sum of n terms independent of n at the cost of three more adds per
+// accumulation. It relies on strict IEEE semantics and is defeated by
+// -ffast-math and similar flags.
+
+#pragma once
+
+#include "x86_sse.hpp"
+
+#include <cstddef>
+
+namespace kln
+{
+namespace detail
+{
+    // Four sums accumulated lane by lane
+    template <bool Compensated>
+    struct reduce_sum
+    {
+        __m128 sum = _mm_setzero_ps();
+        // Low order bits lost by the last accumulation, negated
+        __m128 carry = _mm_setzero_ps();
+
+        KLN_INLINE void KLN_VEC_CALL add(__m128 x) noexcept
+        {
+            if constexpr (Compensated)
+            {
+                __m128 y = _mm_sub_ps(x, carry);
+                __m128 t = _mm_add_ps(sum, y);
+                carry    = _mm_sub_ps(_mm_sub_ps(t, sum), y);
+                sum      = t;
+            }
+            else
+            {
+                sum = _mm_add_ps(sum, x);
+            }
+        }
+
+        // Discard the lanes cleared in mask
+        [[nodiscard]] reduce_sum KLN_VEC_CALL
+        masked(__m128 mask) const noexcept
+        {
+            return {_mm_and_ps(sum, mask), _mm_and_ps(carry, mask)};
+        }
+
+        // The total of all four lanes. The compensated lanes are combined
+        // in double precision.
+        [[nodiscard]] float total() const noexcept
+        {
+            if constexpr (Compensated)
+            {
+                float s[4];
+                float c[4];
+                _mm_storeu_ps(s, sum);
+                _mm_storeu_ps(c, carry);
+                double out = 0.0;
+                for (size_t i = 0; i != 4; ++i)
+                {
+                    out += static_cast<double>(s[i]);
+                    out -= static_cast<double>(c[i]);
+                }
+                return static_cast<float>(out);
+            }
+            else
+            {
+                __m128 x = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+                x        = _mm_add_ss(x, _mm_movehdup_ps(x));
+                return _mm_cvtss_f32(x);
+            }
+        }
+    };
+
+    // The largest of four lanes
+    KLN_INLINE float KLN_VEC_CALL hmax_ps(__m128 x) noexcept
+    {
+        x = _mm_max_ps(x, _mm_movehl_ps(x, x));
+        x = _mm_max_ss(x, _mm_movehdup_ps(x));
+        return _mm_cvtss_f32(x);
+    }
+
+    // All bits set in the first count lanes
+    KLN_INLINE __m128 KLN_VEC_CALL lane_mask(size_t count) noexcept
+    {
+        __m128i lanes = _mm_set_epi32(3, 2, 1, 0);
+        return _mm_castsi128_ps(_mm_cmpgt_epi32(
+            _mm_set1_epi32(static_cast<int>(count)), lanes));
+    }
+
+    // Sum the componentwise products of the partitions a[i * Stride] and
+    // b[i * Stride] for i < count. The caller reduces the lanes it needs.
+    template <bool Compensated, size_t Stride>
+    KLN_INLINE reduce_sum<Compensated> KLN_VEC_CALL
+    reduce_products(__m128 const* a, __m128 const* b, size_t count) noexcept
+    {
+        // Two accumulators hide the latency of the adds
+        reduce_sum<Compensated> even;
+        reduce_sum<Compensated> odd;
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            even.add(_mm_mul_ps(a[i * Stride], b[i * Stride]));
+            odd.add(_mm_mul_ps(a[(i + 1) * Stride], b[(i + 1) * Stride]));
+        }
+        if (i != count)
+        {
+            even.add(_mm_mul_ps(a[i * Stride], b[i * Stride]));
+        }
+        even.add(odd.sum);
+        if constexpr (Compensated)
+        {
+            even.add(_mm_sub_ps(_mm_setzero_ps(), odd.carry));
+        }
+        return even;
+    }
+
+    // Transpose count <= 4 partitions (p0, p1, p2, p3) so that lane i of
+    // out[j] holds component j of partition i. Missing partitions read as
+    // zero.
+    KLN_INLINE void KLN_VEC_CALL reduce_load4(__m128 const* in,
+                                              size_t count,
+                                              __m128* out) noexcept
+    {
+        for (size_t i = 0; i != 4; ++i)
+        {
+            out[i] = i < count ? in[i] : _mm_setzero_ps();
+        }
+        _MM_TRANSPOSE4_PS(out[0], out[1], out[2], out[3]);
+    }
+
+    // Signed distances of four points (w, x, y, z) in SoA form from the
+    // plane p = (d, a, b, c), each component broadcast, as in ext03
+    KLN_INLINE __m128 KLN_VEC_CALL plane_distance4(__m128 const* p,
+                                                   __m128 const* x) noexcept
+    {
+        return _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(p[0], x[0]), _mm_mul_ps(p[1], x[1])),
+            _mm_add_ps(_mm_mul_ps(p[2], x[2]), _mm_mul_ps(p[3], x[3])));
+    }
+
+    // Squared Euclidean distances of four normalized points (w, x, y, z) in
+    // SoA form from the normalized point c, each component broadcast
+    KLN_INLINE __m128 KLN_VEC_CALL point_distance4(__m128 const* c,
+                                                   __m128 const* x) noexcept
+    {
+        __m128 dx = _mm_sub_ps(x[1], c[1]);
+        __m128 dy = _mm_sub_ps(x[2], c[2]);
+        __m128 dz = _mm_sub_ps(x[3], c[3]);
+        return _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+            _mm_mul_ps(dz, dz));
+    }
+
+    KLN_INLINE void KLN_VEC_CALL broadcast4(__m128 a, __m128* out) noexcept
+    {
+        out[0] = KLN_SWIZZLE(a, 0, 0, 0, 0);
+        out[1] = KLN_SWIZZLE(a, 1, 1, 1, 1);
+        out[2] = KLN_SWIZZLE(a, 2, 2, 2, 2);
+        out[3] = KLN_SWIZZLE(a, 3, 3, 3, 3);
+    }
+
+    // Sum (Max false) or maximum (Max true) of Distance(q, x) over count
+    // points, where Distance maps four points in SoA form to four
+    // nonnegative values and q is a broadcast entity
+    template <bool Compensated, bool Max, typename Distance>
+    KLN_INLINE float KLN_VEC_CALL reduce_points(Distance distance,
+                                                __m128 q,
+                                                __m128 const* points,
+                                                size_t count) noexcept
+    {
+        __m128 qb[4];
+        broadcast4(q, qb);
+        reduce_sum<Compensated> sum;
+        __m128 max = _mm_setzero_ps();
+        for (size_t i = 0; i < count; i += 4)
+        {
+            size_t valid = count - i < 4 ? count - i : 4;
+            __m128 x[4];
+            reduce_load4(points + i, valid, x);
+            __m128 d = _mm_and_ps(distance(qb, x), lane_mask(valid));
+            if constexpr (Max)
+            {
+                max = _mm_max_ps(max, d);
+            }
+            else
+            {
+                sum.add(d);
+            }
+        }
+        if constexpr (Max)
+        {
+            return hmax_ps(max);
+        }
+        else
+        {
+            return sum.total();
+        }
+    }
+
+    // Weighted sums of 1, x, y, z, xx, xy, xz, yy, yz, zz over count
+    // normalized points. weights may be null, in which case every weight is
+    // one.
+    template <bool Compensated>
+    KLN_INLINE void KLN_VEC_CALL reduce_moments(__m128 const* points,
+                                                float const* weights,
+                                                size_t count,
+                                                float* out) noexcept
+    {
+        reduce_sum<Compensated> sums[10];
+        for (size_t i = 0; i < count; i += 4)
+        {
+            size_t valid = count - i < 4 ? count - i : 4;
+            __m128 mask  = lane_mask(valid);
+            __m128 w;
+            if (weights == nullptr)
+            {
+                w = _mm_and_ps(_mm_set1_ps(1.f), mask);
+            }
+            else if (valid == 4)
+            {
+                w = _mm_loadu_ps(weights + i);
+            }
+            else
+            {
+                float tail[4] = {};
+                for (size_t j = 0; j != valid; ++j)
+                {
+                    tail[j] = weights[i + j];
+                }
+                w = _mm_loadu_ps(tail);
+            }
+
+            __m128 p[4];
+            reduce_load4(points + i, valid, p);
+            __m128 wx = _mm_mul_ps(w, p[1]);
+            __m128 wy = _mm_mul_ps(w, p[2]);
+            __m128 wz = _mm_mul_ps(w, p[3]);
+            sums[0].add(w);
+            sums[1].add(wx);
+            sums[2].add(wy);
+            sums[3].add(wz);
+            sums[4].add(_mm_mul_ps(wx, p[1]));
+            sums[5].add(_mm_mul_ps(wx, p[2]));
+            sums[6].add(_mm_mul_ps(wx, p[3]));
+            sums[7].add(_mm_mul_ps(wy, p[2]));
+            sums[8].add(_mm_mul_ps(wy, p[3]));
+            sums[9].add(_mm_mul_ps(wz, p[3]));
+        }
+        for (size_t j = 0; j != 10; ++j)
+        {
+            out[j] = sums[j].total();
+        }
+    }
+} // namespace detail
+} // namespace kln
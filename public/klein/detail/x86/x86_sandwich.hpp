@@ -27,6 +27,64 @@ namespace detail
     // p2: (e0123, e01, e02, e03)
     // p3: (e123, e032, e013, e021)
 
+    // Memory access of the variadic loops (swMM, sw012, and sw312). With
+    // Prefetch, the input `distance` elements ahead of the current one is
+    // prefetched. With Stream, results are written with non-temporal stores
+    // which bypass the caches. The policy defaults to plain loads and stores.
+    template <bool Prefetch, bool Stream>
+    struct access_policy
+    {
+        static constexpr bool prefetch = Prefetch;
+        static constexpr bool stream   = Stream;
+        size_t distance                = 0;
+    };
+
+    using cached_access = access_policy<false, false>;
+
+    // Prefetch element i + distance of count elements, each spanning Stride
+    // partitions of in
+    template <size_t Stride, typename Access>
+    KLN_INLINE void access_prefetch(Access const& access,
+                                    __m128 const* in,
+                                    size_t i,
+                                    size_t count) noexcept
+    {
+        if constexpr (Access::prefetch)
+        {
+            // Streamed runs keep their input out of the outer caches as well
+            if (i + access.distance < count)
+            {
+                _mm_prefetch(reinterpret_cast<char const*>(
+                                 in + Stride * (i + access.distance)),
+                             Access::stream ? _MM_HINT_NTA : _MM_HINT_T0);
+            }
+        }
+    }
+
+    template <typename Access>
+    KLN_INLINE void KLN_VEC_CALL access_store(__m128* out, __m128 p) noexcept
+    {
+        if constexpr (Access::stream)
+        {
+            _mm_stream_ps(reinterpret_cast<float*>(out), p);
+        }
+        else
+        {
+            *out = p;
+        }
+    }
+
+    // Non-temporal stores are weakly ordered and must be fenced before the
+    // results are published to other threads
+    template <typename Access>
+    KLN_INLINE void access_finish() noexcept
+    {
+        if constexpr (Access::stream)
+        {
+            _mm_sfence();
+        }
+    }
+
     // Reflect a plane through another plane
     // b * a * b
     KLN_INLINE void KLN_VEC_CALL sw00(__m128 a, __m128 b, __m128& p0_out)
@@ -235,12 +293,16 @@ namespace detail
     // and p2)
     //
     // Note: in and out are permitted to alias iff a == out.
-    template <bool Variadic, bool Translate, bool InputP2>
+    template <bool Variadic,
+              bool Translate,
+              bool InputP2,
+              typename Access = cached_access>
     KLN_INLINE void KLN_VEC_CALL swMM(__m128 const* KLN_RESTRICT in,
                                       __m128 const& KLN_RESTRICT b,
                                       [[maybe_unused]] __m128 const* KLN_RESTRICT c,
                                       __m128* out,
-                                      size_t count = 0) noexcept
+                                      size_t count                   = 0,
+                                      [[maybe_unused]] Access access = {}) noexcept
     {
         // p1 block
         // a0(b0^2 + b1^2 + b2^2 + b3^2) +
@@ -368,40 +430,61 @@ namespace detail
 
         size_t limit            = Variadic ? count : 1;
         constexpr size_t stride = InputP2 ? 2 : 1;
+        // Translations produce an ideal partition even without one as input
+        constexpr size_t out_stride = InputP2 || Translate ? 2 : 1;
         for (size_t i = 0; i != limit; ++i)
         {
-            __m128 const& p1_in = in[stride * i]; // a
-            __m128& p1_out      = out[stride * i];
+            access_prefetch<stride>(access, in, i, limit);
 
-            p1_out = _mm_mul_ps(tmp, p1_in);
-            p1_out = _mm_add_ps(
+            // The inputs are copied and the outputs accumulated in registers
+            // so that the arrays may alias (in == out)
+            __m128 const p1_in = in[stride * i]; // a
+            __m128 p1_out      = _mm_mul_ps(tmp, p1_in);
+            p1_out             = _mm_add_ps(
                 p1_out, _mm_mul_ps(tmp2, KLN_SWIZZLE(p1_in, 1, 3, 2, 0)));
             p1_out = _mm_add_ps(
                 p1_out, _mm_mul_ps(tmp3, KLN_SWIZZLE(p1_in, 2, 1, 3, 0)));
 
             if constexpr (InputP2)
             {
-                __m128 const& p2_in = in[2 * i + 1]; // d
-                __m128& p2_out      = out[2 * i + 1];
-                p2_out              = _mm_mul_ps(tmp4, p2_in);
-                p2_out              = _mm_add_ps(
+                __m128 const p2_in = in[2 * i + 1]; // d
+                __m128 p2_out      = _mm_mul_ps(tmp4, p2_in);
+                p2_out             = _mm_add_ps(
                     p2_out, _mm_mul_ps(tmp5, KLN_SWIZZLE(p2_in, 1, 3, 2, 0)));
                 p2_out = _mm_add_ps(
                     p2_out, _mm_mul_ps(tmp6, KLN_SWIZZLE(p2_in, 2, 1, 3, 0)));
-            }
 
-            // If what is being applied is a rotor, the non-directional
-            // components of the line are left untouched
-            if constexpr (Translate)
+                // If what is being applied is a rotor, the non-directional
+                // components of the line are left untouched
+                if constexpr (Translate)
+                {
+                    p2_out = _mm_add_ps(p2_out, _mm_mul_ps(tmp7, p1_in));
+                    p2_out = _mm_add_ps(
+                        p2_out,
+                        _mm_mul_ps(tmp8, KLN_SWIZZLE(p1_in, 2, 1, 3, 0)));
+                    p2_out = _mm_add_ps(
+                        p2_out,
+                        _mm_mul_ps(tmp9, KLN_SWIZZLE(p1_in, 1, 3, 2, 0)));
+                }
+                access_store<Access>(out + 2 * i + 1, p2_out);
+            }
+            else if constexpr (Translate)
             {
-                __m128& p2_out = out[2 * i + 1];
-                p2_out         = _mm_add_ps(p2_out, _mm_mul_ps(tmp7, p1_in));
-                p2_out         = _mm_add_ps(
+                // The translation terms are added to the ideal partition
+                // already in out. It is accumulated in a register and
+                // written with the same kind of store as p1 so that streamed
+                // runs don't mix cached and non-temporal stores to a line.
+                __m128 p2_out = out[2 * i + 1];
+                p2_out        = _mm_add_ps(p2_out, _mm_mul_ps(tmp7, p1_in));
+                p2_out        = _mm_add_ps(
                     p2_out, _mm_mul_ps(tmp8, KLN_SWIZZLE(p1_in, 2, 1, 3, 0)));
                 p2_out = _mm_add_ps(
                     p2_out, _mm_mul_ps(tmp9, KLN_SWIZZLE(p1_in, 1, 3, 2, 0)));
+                access_store<Access>(out + 2 * i + 1, p2_out);
             }
+            access_store<Access>(out + out_stride * i, p1_out);
         }
+        access_finish<Access>();
     }
 
     // Apply a motor to a plane
@@ -411,12 +494,15 @@ namespace detail
     // If Translate is false, c is ignored (rotor application).
     // If Variadic is true, a and out must point to a contiguous block of memory
     // equivalent to __m128[count]
-    template <bool Variadic = false, bool Translate = true>
+    template <bool Variadic   = false,
+              bool Translate  = true,
+              typename Access = cached_access>
     KLN_INLINE void KLN_VEC_CALL sw012(__m128 const* KLN_RESTRICT a,
                                        __m128 b,
                                        [[maybe_unused]] __m128 const* KLN_RESTRICT c,
                                        __m128* out,
-                                       size_t count = 0)
+                                       size_t count                   = 0,
+                                       [[maybe_unused]] Access access = {})
     {
         // LSB
         //
@@ -503,18 +589,24 @@ namespace detail
         size_t limit = Variadic ? count : 1;
         for (size_t i = 0; i != limit; ++i)
         {
-            // Compute the lower block for components e1, e2, and e3
-            __m128& p = out[i];
-            p         = _mm_mul_ps(tmp1, KLN_SWIZZLE(a[i], 1, 3, 2, 0));
-            p = _mm_add_ps(p, _mm_mul_ps(tmp2, KLN_SWIZZLE(a[i], 2, 1, 3, 0)));
-            p = _mm_add_ps(p, _mm_mul_ps(tmp3, a[i]));
+            access_prefetch<1>(access, a, i, limit);
+
+            // Compute the lower block for components e1, e2, and e3. The
+            // result is accumulated in a register so that a and out may alias
+            // (a == out).
+            __m128 const ai = a[i];
+            __m128 p        = _mm_mul_ps(tmp1, KLN_SWIZZLE(ai, 1, 3, 2, 0));
+            p = _mm_add_ps(p, _mm_mul_ps(tmp2, KLN_SWIZZLE(ai, 2, 1, 3, 0)));
+            p = _mm_add_ps(p, _mm_mul_ps(tmp3, ai));
 
             if constexpr (Translate)
             {
-                __m128 tmp5 = hi_dp(tmp4, a[i]);
+                __m128 tmp5 = hi_dp(tmp4, ai);
                 p           = _mm_add_ps(p, tmp5);
             }
+            access_store<Access>(out + i, p);
         }
+        access_finish<Access>();
     }
 
     // Apply a translator to a point.
@@ -536,12 +628,15 @@ namespace detail
     }
 
     // Apply a motor to a point
-    template <bool Variadic = false, bool Translate = true>
+    template <bool Variadic   = false,
+              bool Translate  = true,
+              typename Access = cached_access>
     KLN_INLINE void KLN_VEC_CALL sw312(__m128 const* KLN_RESTRICT a,
                                        __m128 b,
                                        [[maybe_unused]] __m128 const* KLN_RESTRICT c,
                                        __m128* out,
-                                       size_t count = 0) noexcept
+                                       size_t count                   = 0,
+                                       [[maybe_unused]] Access access = {}) noexcept
     {
         // LSB
         // a0(b1^2 + b0^2 + b2^2 + b3^2) e123 +
@@ -609,17 +704,22 @@ namespace detail
         size_t limit = Variadic ? count : 1;
         for (size_t i = 0; i != limit; ++i)
         {
-            __m128& p = out[i];
-            p         = _mm_mul_ps(tmp1, KLN_SWIZZLE(a[i], 2, 1, 3, 0));
-            p = _mm_add_ps(p, _mm_mul_ps(tmp2, KLN_SWIZZLE(a[i], 1, 3, 2, 0)));
-            p = _mm_add_ps(p, _mm_mul_ps(tmp3, a[i]));
+            access_prefetch<1>(access, a, i, limit);
+
+            // Accumulate in a register so that a and out may alias (a == out)
+            __m128 const ai = a[i];
+            __m128 p        = _mm_mul_ps(tmp1, KLN_SWIZZLE(ai, 2, 1, 3, 0));
+            p = _mm_add_ps(p, _mm_mul_ps(tmp2, KLN_SWIZZLE(ai, 1, 3, 2, 0)));
+            p = _mm_add_ps(p, _mm_mul_ps(tmp3, ai));
 
             if constexpr (Translate)
             {
                 p = _mm_add_ps(
-                    p, _mm_mul_ps(tmp4, KLN_SWIZZLE(a[i], 0, 0, 0, 0)));
+                    p, _mm_mul_ps(tmp4, KLN_SWIZZLE(ai, 0, 0, 0, 0)));
             }
+            access_store<Access>(out + i, p);
         }
+        access_finish<Access>();
     }
 
     // Conjugate origin with motor. Unlike other operations the motor MUST be
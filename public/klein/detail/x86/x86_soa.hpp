@@ -0,0 +1,544 @@
+// File: x86_soa.hpp
+// Purpose: Structure-of-arrays (SoA) kernels operating on four entities at a
+// time. Each __m128 holds a single component of four different entities as
+// opposed to the usual layout where an __m128 holds four components of a
+// single entity.
+
+#pragma once
+
+#include "x86_sse.hpp"
+
+namespace kln
+{
+namespace detail
+{
+    // SoA component orderings follow the partitions of the AoS layout
+    //
+    // line:  (e23, e31, e12, e01, e02, e03)
+    // motor: (1, e23, e31, e12, e0123, e01, e02, e03)
+
+    // Compute the sine and cosine of four angles simultaneously. The argument
+    // is reduced to [-pi/4, pi/4] by subtracting multiples of pi/2 (in three
+    // parts to preserve precision) after which minimax polynomials are used.
+    // The maximum absolute error is below 2^-23 for |x| < 8192.
+    KLN_INLINE void KLN_VEC_CALL
+    sincos_ps(__m128 x,
+              __m128& KLN_RESTRICT sin_out,
+              __m128& KLN_RESTRICT cos_out) noexcept
+    {
+        __m128 sign_mask = _mm_set1_ps(-0.f);
+        __m128 sin_sign  = _mm_and_ps(x, sign_mask);
+        x                = _mm_andnot_ps(sign_mask, x);
+
+        // j = round x / (pi/4) up to the nearest even integer
+        __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954f)));
+        j         = _mm_add_epi32(j, _mm_set1_epi32(1));
+        j         = _mm_and_si128(j, _mm_set1_epi32(~1));
+        __m128 y  = _mm_cvtepi32_ps(j);
+
+        // Octants 2 and 3 (mod 4) swap the sign of the sine, and octants 1
+        // and 2 (mod 4) swap the sign of the cosine. Octants 1 and 2 (mod 2)
+        // swap the sine and cosine polynomials.
+        __m128 swap_sin = _mm_castsi128_ps(
+            _mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+        __m128 cos_sign = _mm_castsi128_ps(_mm_slli_epi32(
+            _mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)),
+                             _mm_set1_epi32(4)),
+            29));
+        __m128 poly_mask = _mm_castsi128_ps(_mm_cmpeq_epi32(
+            _mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+        sin_sign         = _mm_xor_ps(sin_sign, swap_sin);
+
+        // Extended precision modular arithmetic
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.41875648e-4f)));
+        x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497e-8f)));
+
+        __m128 z = _mm_mul_ps(x, x);
+
+        // cos(x) ~ 1 - z/2 + z^2 (c0 + z (c1 + z c2))
+        __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+        c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765e-3f));
+        c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+        c = _mm_mul_ps(c, _mm_mul_ps(z, z));
+        c = _mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+        c = _mm_add_ps(c, _mm_set1_ps(1.f));
+
+        // sin(x) ~ x + x z (s0 + z (s1 + z s2))
+        __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+        s        = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736e-3f));
+        s        = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+        s        = _mm_add_ps(_mm_mul_ps(s, _mm_mul_ps(z, x)), x);
+
+        sin_out
+            = _mm_or_ps(_mm_and_ps(poly_mask, s), _mm_andnot_ps(poly_mask, c));
+        cos_out
+            = _mm_or_ps(_mm_and_ps(poly_mask, c), _mm_andnot_ps(poly_mask, s));
+        sin_out = _mm_xor_ps(sin_out, sin_sign);
+        cos_out = _mm_xor_ps(cos_out, cos_sign);
+    }
+
+    // Exponentiate four lines. This is the SoA analogue of exp in
+    // x86_exp_log.hpp. Writing u for the norm of the Euclidean part a and
+    // a.b for the dot product of the Euclidean and ideal parts, the result is
+    //
+    // cos u + sinc u a + (a.b) sinc u e0123 + sinc u b + (a.b) g(u) a
+    //
+    // where sinc u = sin u / u and g(u) = (cos u - sinc u) / u^2. Both
+    // functions are replaced by their Taylor expansions for small u to avoid
+    // the catastrophic cancellation in g and the division by zero as u
+    // vanishes.
+    KLN_INLINE void KLN_VEC_CALL exp4(__m128 const* KLN_RESTRICT l,
+                                      __m128* KLN_RESTRICT m) noexcept
+    {
+        __m128 a2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l[0], l[0]),
+                                          _mm_mul_ps(l[1], l[1])),
+                               _mm_mul_ps(l[2], l[2]));
+        __m128 ab = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l[0], l[3]),
+                                          _mm_mul_ps(l[1], l[4])),
+                               _mm_mul_ps(l[2], l[5]));
+        __m128 u  = _mm_sqrt_ps(a2);
+
+        __m128 sinu;
+        __m128 cosu;
+        sincos_ps(u, sinu, cosu);
+
+        // sinc u ~ 1 - u^2/6 + u^4/120 - u^6/5040
+        // g(u)   ~ -1/3 + u^2/30 - u^4/840 + u^6/45360
+        __m128 sinc_series = _mm_set1_ps(-1.f / 5040.f);
+        sinc_series        = _mm_add_ps(_mm_mul_ps(sinc_series, a2),
+                                 _mm_set1_ps(1.f / 120.f));
+        sinc_series        = _mm_add_ps(_mm_mul_ps(sinc_series, a2),
+                                 _mm_set1_ps(-1.f / 6.f));
+        sinc_series
+            = _mm_add_ps(_mm_mul_ps(sinc_series, a2), _mm_set1_ps(1.f));
+        __m128 g_series = _mm_set1_ps(1.f / 45360.f);
+        g_series        = _mm_add_ps(_mm_mul_ps(g_series, a2),
+                              _mm_set1_ps(-1.f / 840.f));
+        g_series        = _mm_add_ps(_mm_mul_ps(g_series, a2),
+                              _mm_set1_ps(1.f / 30.f));
+        g_series
+            = _mm_add_ps(_mm_mul_ps(g_series, a2), _mm_set1_ps(-1.f / 3.f));
+
+        // Lanes below the threshold take the series. The max guards the
+        // divisions in those lanes.
+        __m128 small  = _mm_cmplt_ps(a2, _mm_set1_ps(0.04f));
+        __m128 a2_div = _mm_max_ps(a2, _mm_set1_ps(0.04f));
+        __m128 sinc   = _mm_div_ps(sinu, _mm_sqrt_ps(a2_div));
+        __m128 g      = _mm_div_ps(_mm_sub_ps(cosu, sinc), a2_div);
+        sinc          = _mm_or_ps(_mm_and_ps(small, sinc_series),
+                         _mm_andnot_ps(small, sinc));
+        g             = _mm_or_ps(_mm_and_ps(small, g_series),
+                      _mm_andnot_ps(small, g));
+
+        __m128 abg = _mm_mul_ps(ab, g);
+        m[0]       = cosu;
+        m[1]       = _mm_mul_ps(sinc, l[0]);
+        m[2]       = _mm_mul_ps(sinc, l[1]);
+        m[3]       = _mm_mul_ps(sinc, l[2]);
+        m[4]       = _mm_mul_ps(ab, sinc);
+        m[5] = _mm_add_ps(_mm_mul_ps(sinc, l[3]), _mm_mul_ps(abg, l[0]));
+        m[6] = _mm_add_ps(_mm_mul_ps(sinc, l[4]), _mm_mul_ps(abg, l[1]));
+        m[7] = _mm_add_ps(_mm_mul_ps(sinc, l[5]), _mm_mul_ps(abg, l[2]));
+    }
+
+    // Geometric product of four pairs of motors. See gpMM in
+    // x86_geometric_product.hpp for the expansion.
+    KLN_INLINE void KLN_VEC_CALL gpMM4(__m128 const* KLN_RESTRICT m1,
+                                       __m128 const* KLN_RESTRICT m2,
+                                       __m128* KLN_RESTRICT out) noexcept
+    {
+        __m128 const* a = m1;
+        __m128 const* b = m1 + 4;
+        __m128 const* c = m2;
+        __m128 const* d = m2 + 4;
+
+        // (a0 c0 - a1 c1 - a2 c2 - a3 c3)
+        out[0] = _mm_sub_ps(
+            _mm_sub_ps(_mm_mul_ps(a[0], c[0]), _mm_mul_ps(a[1], c[1])),
+            _mm_add_ps(_mm_mul_ps(a[2], c[2]), _mm_mul_ps(a[3], c[3])));
+        // (a0 c1 + a3 c2 + a1 c0 - a2 c3) e23
+        out[1] = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0], c[1]), _mm_mul_ps(a[3], c[2])),
+                _mm_mul_ps(a[1], c[0])),
+            _mm_mul_ps(a[2], c[3]));
+        // (a0 c2 + a1 c3 + a2 c0 - a3 c1) e31
+        out[2] = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0], c[2]), _mm_mul_ps(a[1], c[3])),
+                _mm_mul_ps(a[2], c[0])),
+            _mm_mul_ps(a[3], c[1]));
+        // (a0 c3 + a2 c1 + a3 c0 - a1 c2) e12
+        out[3] = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0], c[3]), _mm_mul_ps(a[2], c[1])),
+                _mm_mul_ps(a[3], c[0])),
+            _mm_mul_ps(a[1], c[2]));
+
+        // (a0 d0 + b0 c0 + a1 d1 + b1 c1 + a2 d2 + a3 d3 + b2 c2 + b3 c3)
+        //  e0123
+        out[4] = _mm_add_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0], d[0]), _mm_mul_ps(b[0], c[0])),
+                _mm_add_ps(_mm_mul_ps(a[1], d[1]), _mm_mul_ps(b[1], c[1]))),
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[2], d[2]), _mm_mul_ps(a[3], d[3])),
+                _mm_add_ps(_mm_mul_ps(b[2], c[2]), _mm_mul_ps(b[3], c[3]))));
+        // (a0 d1 + b1 c0 + a3 d2 + b3 c2 - a1 d0 - a2 d3 - b0 c1 - b2 c3)
+        //  e01
+        out[5] = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0], d[1]), _mm_mul_ps(b[1], c[0])),
+                _mm_add_ps(_mm_mul_ps(a[3], d[2]), _mm_mul_ps(b[3], c[2]))),
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[1], d[0]), _mm_mul_ps(a[2], d[3])),
+                _mm_add_ps(_mm_mul_ps(b[0], c[1]), _mm_mul_ps(b[2], c[3]))));
+        // (a0 d2 + b2 c0 + a1 d3 + b1 c3 - a2 d0 - a3 d1 - b0 c2 - b3 c1)
+        //  e02
+        out[6] = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0], d[2]), _mm_mul_ps(b[2], c[0])),
+                _mm_add_ps(_mm_mul_ps(a[1], d[3]), _mm_mul_ps(b[1], c[3]))),
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[2], d[0]), _mm_mul_ps(a[3], d[1])),
+                _mm_add_ps(_mm_mul_ps(b[0], c[2]), _mm_mul_ps(b[3], c[1]))));
+        // (a0 d3 + b3 c0 + a2 d1 + b2 c1 - a3 d0 - a1 d2 - b0 c3 - b1 c2)
+        //  e03
+        out[7] = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[0], d[3]), _mm_mul_ps(b[3], c[0])),
+                _mm_add_ps(_mm_mul_ps(a[2], d[1]), _mm_mul_ps(b[2], c[1]))),
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(a[3], d[0]), _mm_mul_ps(a[1], d[2])),
+                _mm_add_ps(_mm_mul_ps(b[0], c[3]), _mm_mul_ps(b[1], c[2]))));
+    }
+
+    // Normalize four motors in place. See motor::normalize for the
+    // derivation. Full precision square roots and divisions are used since
+    // this is typically applied to motors accumulated over many steps.
+    KLN_INLINE void KLN_VEC_CALL normalize4(__m128* m) noexcept
+    {
+        __m128 b2 = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(m[0], m[0]), _mm_mul_ps(m[1], m[1])),
+            _mm_add_ps(_mm_mul_ps(m[2], m[2]), _mm_mul_ps(m[3], m[3])));
+        __m128 bc = _mm_sub_ps(
+            _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(m[1], m[5]), _mm_mul_ps(m[2], m[6])),
+                _mm_mul_ps(m[3], m[7])),
+            _mm_mul_ps(m[0], m[4]));
+        __m128 s = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(b2));
+        __m128 t = _mm_mul_ps(_mm_div_ps(bc, b2), s);
+
+        m[4] = _mm_add_ps(_mm_mul_ps(s, m[4]), _mm_mul_ps(t, m[0]));
+        m[5] = _mm_sub_ps(_mm_mul_ps(s, m[5]), _mm_mul_ps(t, m[1]));
+        m[6] = _mm_sub_ps(_mm_mul_ps(s, m[6]), _mm_mul_ps(t, m[2]));
+        m[7] = _mm_sub_ps(_mm_mul_ps(s, m[7]), _mm_mul_ps(t, m[3]));
+        m[0] = _mm_mul_ps(s, m[0]);
+        m[1] = _mm_mul_ps(s, m[1]);
+        m[2] = _mm_mul_ps(s, m[2]);
+        m[3] = _mm_mul_ps(s, m[3]);
+    }
+
+    // Normalize four lines in place. See line::normalize for the derivation.
+    // Full precision square roots and divisions are used.
+    KLN_INLINE void KLN_VEC_CALL normalize_lines4(__m128* l) noexcept
+    {
+        __m128 b2 = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(l[0], l[0]), _mm_mul_ps(l[1], l[1])),
+            _mm_mul_ps(l[2], l[2]));
+        __m128 bc = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(l[0], l[3]), _mm_mul_ps(l[1], l[4])),
+            _mm_mul_ps(l[2], l[5]));
+        __m128 s = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(b2));
+        __m128 t = _mm_mul_ps(_mm_div_ps(bc, b2), s);
+
+        l[3] = _mm_sub_ps(_mm_mul_ps(s, l[3]), _mm_mul_ps(t, l[0]));
+        l[4] = _mm_sub_ps(_mm_mul_ps(s, l[4]), _mm_mul_ps(t, l[1]));
+        l[5] = _mm_sub_ps(_mm_mul_ps(s, l[5]), _mm_mul_ps(t, l[2]));
+        l[0] = _mm_mul_ps(s, l[0]);
+        l[1] = _mm_mul_ps(s, l[1]);
+        l[2] = _mm_mul_ps(s, l[2]);
+    }
+
+    // Meet of the plane p = (d, a, b, c), each component broadcast, with four
+    // lines, producing four points (x, y, z, w). See extPB and ext02.
+    KLN_INLINE void KLN_VEC_CALL meet_lines4(__m128 const* KLN_RESTRICT p,
+                                             __m128 const* KLN_RESTRICT l,
+                                             __m128* KLN_RESTRICT out) noexcept
+    {
+        // (a2 c3 - a3 c2 - a0 b1) e032 +
+        // (a3 c1 - a1 c3 - a0 b2) e013 +
+        // (a1 c2 - a2 c1 - a0 b3) e021 +
+        // (a1 b1 + a2 b2 + a3 b3) e123
+        out[0] = _mm_sub_ps(
+            _mm_mul_ps(p[2], l[5]),
+            _mm_add_ps(_mm_mul_ps(p[3], l[4]), _mm_mul_ps(p[0], l[0])));
+        out[1] = _mm_sub_ps(
+            _mm_mul_ps(p[3], l[3]),
+            _mm_add_ps(_mm_mul_ps(p[1], l[5]), _mm_mul_ps(p[0], l[1])));
+        out[2] = _mm_sub_ps(
+            _mm_mul_ps(p[1], l[4]),
+            _mm_add_ps(_mm_mul_ps(p[2], l[3]), _mm_mul_ps(p[0], l[2])));
+        out[3] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(p[1], l[0]), _mm_mul_ps(p[2], l[1])),
+            _mm_mul_ps(p[3], l[2]));
+    }
+
+    // Terms of the sandwich with four motors m = (b0, b1, b2, b3, c0, c1, c2,
+    // c3) in the SoA motor order. The expansions are those of sw312, sw012,
+    // and swMM in x86_sandwich.hpp. The Euclidean components of every entity
+    // transform with the same rotation, and the motors enter the remaining
+    // terms only through the products collected here, so the terms are
+    // computed once per motor (or block of motors) and each entity costs a
+    // handful of multiply-adds without shuffles.
+    //
+    // r: row major 3x3 rotation followed by b0^2 + b1^2 + b2^2 + b3^2
+    KLN_INLINE void KLN_VEC_CALL soa_rotation(__m128 const* KLN_RESTRICT m,
+                                              __m128* KLN_RESTRICT r) noexcept
+    {
+        __m128 two = _mm_set1_ps(2.f);
+        __m128 b00 = _mm_mul_ps(m[0], m[0]);
+        __m128 b11 = _mm_mul_ps(m[1], m[1]);
+        __m128 b22 = _mm_mul_ps(m[2], m[2]);
+        __m128 b33 = _mm_mul_ps(m[3], m[3]);
+        __m128 b01 = _mm_mul_ps(m[0], m[1]);
+        __m128 b02 = _mm_mul_ps(m[0], m[2]);
+        __m128 b03 = _mm_mul_ps(m[0], m[3]);
+        __m128 b12 = _mm_mul_ps(m[1], m[2]);
+        __m128 b13 = _mm_mul_ps(m[1], m[3]);
+        __m128 b23 = _mm_mul_ps(m[2], m[3]);
+
+        r[0] = _mm_sub_ps(_mm_add_ps(b00, b11), _mm_add_ps(b22, b33));
+        r[1] = _mm_mul_ps(two, _mm_add_ps(b03, b12));
+        r[2] = _mm_mul_ps(two, _mm_sub_ps(b13, b02));
+        r[3] = _mm_mul_ps(two, _mm_sub_ps(b12, b03));
+        r[4] = _mm_sub_ps(_mm_add_ps(b00, b22), _mm_add_ps(b11, b33));
+        r[5] = _mm_mul_ps(two, _mm_add_ps(b01, b23));
+        r[6] = _mm_mul_ps(two, _mm_add_ps(b02, b13));
+        r[7] = _mm_mul_ps(two, _mm_sub_ps(b23, b01));
+        r[8] = _mm_sub_ps(_mm_add_ps(b00, b33), _mm_add_ps(b11, b22));
+        r[9] = _mm_add_ps(_mm_add_ps(b00, b11), _mm_add_ps(b22, b33));
+    }
+
+    // Returns a x + b y + c z
+    KLN_INLINE __m128 KLN_VEC_CALL
+    dot3_ps(__m128 a, __m128 b, __m128 c, __m128 x, __m128 y, __m128 z) noexcept
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)),
+                          _mm_mul_ps(c, z));
+    }
+
+    // Returns 2(x + y + z - w)
+    KLN_INLINE __m128 KLN_VEC_CALL
+    twice_sum_ps(__m128 x, __m128 y, __m128 z, __m128 w) noexcept
+    {
+        __m128 sum = _mm_sub_ps(_mm_add_ps(_mm_add_ps(x, y), z), w);
+        return _mm_add_ps(sum, sum);
+    }
+
+    // Points are stored (x, y, z, w). The translation is scaled by w.
+    struct soa_point_terms
+    {
+        __m128 r[10];
+        __m128 t[3];
+    };
+
+    template <bool Translate>
+    KLN_INLINE void KLN_VEC_CALL soa_terms(__m128 const* KLN_RESTRICT m,
+                                           soa_point_terms& out) noexcept
+    {
+        soa_rotation(m, out.r);
+        if constexpr (Translate)
+        {
+            __m128 const* b = m;
+            __m128 const* c = m + 4;
+            // 2(b2 c3 - b0 c1 - b3 c2 - b1 c0)
+            // 2(b3 c1 - b0 c2 - b1 c3 - b2 c0)
+            // 2(b1 c2 - b0 c3 - b2 c1 - b3 c0)
+            __m128 zero = _mm_setzero_ps();
+            out.t[0]    = twice_sum_ps(_mm_mul_ps(b[2], c[3]),
+                                    _mm_sub_ps(zero, _mm_mul_ps(b[0], c[1])),
+                                    _mm_sub_ps(zero, _mm_mul_ps(b[3], c[2])),
+                                    _mm_mul_ps(b[1], c[0]));
+            out.t[1] = twice_sum_ps(_mm_mul_ps(b[3], c[1]),
+                                    _mm_sub_ps(zero, _mm_mul_ps(b[0], c[2])),
+                                    _mm_sub_ps(zero, _mm_mul_ps(b[1], c[3])),
+                                    _mm_mul_ps(b[2], c[0]));
+            out.t[2] = twice_sum_ps(_mm_mul_ps(b[1], c[2]),
+                                    _mm_sub_ps(zero, _mm_mul_ps(b[0], c[3])),
+                                    _mm_sub_ps(zero, _mm_mul_ps(b[2], c[1])),
+                                    _mm_mul_ps(b[3], c[0]));
+        }
+    }
+
+    // Apply motors to four points (see sw312). in and out may alias.
+    template <bool Translate>
+    KLN_INLINE void KLN_VEC_CALL soa_sandwich(soa_point_terms const& k,
+                                              __m128 const* in,
+                                              __m128* out) noexcept
+    {
+        __m128 x = in[0];
+        __m128 y = in[1];
+        __m128 z = in[2];
+        __m128 w = in[3];
+
+        out[0] = dot3_ps(k.r[0], k.r[1], k.r[2], x, y, z);
+        out[1] = dot3_ps(k.r[3], k.r[4], k.r[5], x, y, z);
+        out[2] = dot3_ps(k.r[6], k.r[7], k.r[8], x, y, z);
+        out[3] = _mm_mul_ps(k.r[9], w);
+        if constexpr (Translate)
+        {
+            out[0] = _mm_add_ps(out[0], _mm_mul_ps(k.t[0], w));
+            out[1] = _mm_add_ps(out[1], _mm_mul_ps(k.t[1], w));
+            out[2] = _mm_add_ps(out[2], _mm_mul_ps(k.t[2], w));
+        }
+    }
+
+    // Planes are stored (x, y, z, d). The displacement of d is the dot
+    // product of the normal with u.
+    struct soa_plane_terms
+    {
+        __m128 r[10];
+        __m128 u[3];
+    };
+
+    template <bool Translate>
+    KLN_INLINE void KLN_VEC_CALL soa_terms(__m128 const* KLN_RESTRICT m,
+                                           soa_plane_terms& out) noexcept
+    {
+        soa_rotation(m, out.r);
+        if constexpr (Translate)
+        {
+            __m128 const* b = m;
+            __m128 const* c = m + 4;
+            // 2(b0 c1 + b2 c3 + b1 c0 - b3 c2)
+            // 2(b0 c2 + b3 c1 + b2 c0 - b1 c3)
+            // 2(b0 c3 + b1 c2 + b3 c0 - b2 c1)
+            out.u[0] = twice_sum_ps(_mm_mul_ps(b[0], c[1]),
+                                    _mm_mul_ps(b[2], c[3]),
+                                    _mm_mul_ps(b[1], c[0]),
+                                    _mm_mul_ps(b[3], c[2]));
+            out.u[1] = twice_sum_ps(_mm_mul_ps(b[0], c[2]),
+                                    _mm_mul_ps(b[3], c[1]),
+                                    _mm_mul_ps(b[2], c[0]),
+                                    _mm_mul_ps(b[1], c[3]));
+            out.u[2] = twice_sum_ps(_mm_mul_ps(b[0], c[3]),
+                                    _mm_mul_ps(b[1], c[2]),
+                                    _mm_mul_ps(b[3], c[0]),
+                                    _mm_mul_ps(b[2], c[1]));
+        }
+    }
+
+    // Apply motors to four planes (see sw012). in and out may alias.
+    template <bool Translate>
+    KLN_INLINE void KLN_VEC_CALL soa_sandwich(soa_plane_terms const& k,
+                                              __m128 const* in,
+                                              __m128* out) noexcept
+    {
+        __m128 x = in[0];
+        __m128 y = in[1];
+        __m128 z = in[2];
+        __m128 d = in[3];
+
+        out[0] = dot3_ps(k.r[0], k.r[1], k.r[2], x, y, z);
+        out[1] = dot3_ps(k.r[3], k.r[4], k.r[5], x, y, z);
+        out[2] = dot3_ps(k.r[6], k.r[7], k.r[8], x, y, z);
+        out[3] = _mm_mul_ps(k.r[9], d);
+        if constexpr (Translate)
+        {
+            out[3] = _mm_add_ps(out[3],
+                                dot3_ps(k.u[0], k.u[1], k.u[2], x, y, z));
+        }
+    }
+
+    // Lines are stored (e23, e31, e12, e01, e02, e03). The ideal part picks
+    // up the Euclidean part through the row major matrix k.
+    struct soa_line_terms
+    {
+        __m128 r[10];
+        __m128 k[9];
+    };
+
+    template <bool Translate>
+    KLN_INLINE void KLN_VEC_CALL soa_terms(__m128 const* KLN_RESTRICT m,
+                                           soa_line_terms& out) noexcept
+    {
+        soa_rotation(m, out.r);
+        if constexpr (Translate)
+        {
+            __m128 const* b = m;
+            __m128 const* c = m + 4;
+            __m128 bc[4][4];
+            for (size_t i = 0; i != 4; ++i)
+            {
+                for (size_t j = 0; j != 4; ++j)
+                {
+                    bc[i][j] = _mm_mul_ps(b[i], c[j]);
+                }
+            }
+            __m128 zero = _mm_setzero_ps();
+
+            // 2(b1 c1 - b0 c0 - b3 c3 - b2 c2)
+            // 2(b1 c2 + b0 c3 + b2 c1 - b3 c0)
+            // 2(b1 c3 + b2 c0 + b3 c1 - b0 c2)
+            out.k[0] = twice_sum_ps(bc[1][1],
+                                    _mm_sub_ps(zero, bc[0][0]),
+                                    _mm_sub_ps(zero, bc[3][3]),
+                                    bc[2][2]);
+            out.k[1] = twice_sum_ps(bc[1][2], bc[0][3], bc[2][1], bc[3][0]);
+            out.k[2] = twice_sum_ps(bc[1][3], bc[2][0], bc[3][1], bc[0][2]);
+
+            // 2(b2 c1 + b3 c0 + b1 c2 - b0 c3)
+            // 2(b2 c2 - b0 c0 - b3 c3 - b1 c1)
+            // 2(b2 c3 + b0 c1 + b3 c2 - b1 c0)
+            out.k[3] = twice_sum_ps(bc[2][1], bc[3][0], bc[1][2], bc[0][3]);
+            out.k[4] = twice_sum_ps(bc[2][2],
+                                    _mm_sub_ps(zero, bc[0][0]),
+                                    _mm_sub_ps(zero, bc[3][3]),
+                                    bc[1][1]);
+            out.k[5] = twice_sum_ps(bc[2][3], bc[0][1], bc[3][2], bc[1][0]);
+
+            // 2(b3 c1 + b0 c2 + b1 c3 - b2 c0)
+            // 2(b3 c2 + b1 c0 + b2 c3 - b0 c1)
+            // 2(b3 c3 - b0 c0 - b1 c1 - b2 c2)
+            out.k[6] = twice_sum_ps(bc[3][1], bc[0][2], bc[1][3], bc[2][0]);
+            out.k[7] = twice_sum_ps(bc[3][2], bc[1][0], bc[2][3], bc[0][1]);
+            out.k[8] = twice_sum_ps(bc[3][3],
+                                    _mm_sub_ps(zero, bc[0][0]),
+                                    _mm_sub_ps(zero, bc[1][1]),
+                                    bc[2][2]);
+        }
+    }
+
+    // Apply motors to four lines (see swMM). in and out may alias.
+    template <bool Translate>
+    KLN_INLINE void KLN_VEC_CALL soa_sandwich(soa_line_terms const& k,
+                                              __m128 const* in,
+                                              __m128* out) noexcept
+    {
+        __m128 a1 = in[0];
+        __m128 a2 = in[1];
+        __m128 a3 = in[2];
+        __m128 d1 = in[3];
+        __m128 d2 = in[4];
+        __m128 d3 = in[5];
+
+        out[0] = dot3_ps(k.r[0], k.r[1], k.r[2], a1, a2, a3);
+        out[1] = dot3_ps(k.r[3], k.r[4], k.r[5], a1, a2, a3);
+        out[2] = dot3_ps(k.r[6], k.r[7], k.r[8], a1, a2, a3);
+        out[3] = dot3_ps(k.r[0], k.r[1], k.r[2], d1, d2, d3);
+        out[4] = dot3_ps(k.r[3], k.r[4], k.r[5], d1, d2, d3);
+        out[5] = dot3_ps(k.r[6], k.r[7], k.r[8], d1, d2, d3);
+        if constexpr (Translate)
+        {
+            out[3] = _mm_add_ps(
+                out[3], dot3_ps(k.k[0], k.k[1], k.k[2], a1, a2, a3));
+            out[4] = _mm_add_ps(
+                out[4], dot3_ps(k.k[3], k.k[4], k.k[5], a1, a2, a3));
+            out[5] = _mm_add_ps(
+                out[5], dot3_ps(k.k[6], k.k[7], k.k[8], a1, a2, a3));
+        }
+    }
+} // namespace detail
+} // namespace kln
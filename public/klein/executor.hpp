@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+namespace kln
+{
+/// \defgroup executor Executors
+///
+/// Routines that can distribute work across threads (such as rebuilding a
+/// `kd_tree` or `bvh`) accept an _executor_ rather than spawning threads
+/// themselves. This keeps the library free of any threading dependency and
+/// lets the caller reuse whatever thread pool or task system it already has.
+///
+/// An executor is any callable `exec` such that `exec(count, task)` invokes
+/// `task(i)` exactly once for every `i` in `[0, count)` and returns only after
+/// all invocations have completed. The invocations may run concurrently and in
+/// any order. The tasks are guaranteed not to write to overlapping memory.
+///
+/// !!! example
+///
+///     ```c++
+///         // An executor backed by OpenMP
+///         auto omp = [](size_t count, auto&& task) {
+///     #pragma omp parallel for
+///             for (size_t i = 0; i < count; ++i)
+///             {
+///                 task(i);
+///             }
+///         };
+///         tree.build(points, count, storage, omp);
+///     ```
+
+/// \addtogroup executor
+/// @{
+
+/// The default executor which runs every task in order on the calling thread.
+struct serial_executor
+{
+    template <typename F>
+    void operator()(size_t count, F&& task) const
+    {
+        for (size_t i = 0; i != count; ++i)
+        {
+            task(i);
+        }
+    }
+};
+/// @}
+} // namespace kln
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "detail/geometric_product.hpp"
+#include "detail/validate.hpp"
 
 #include "dual.hpp"
 #include "line.hpp"
@@ -79,6 +80,7 @@ namespace kln
 {
     motor out;
     detail::gp00(a.p0_, b.p0_, out.p1_, out.p2_);
+    KLN_VALIDATE_FINITE("plane * plane", out, a, b);
     return out;
 }
 
@@ -86,6 +88,7 @@ namespace kln
 {
     motor out;
     detail::gp03<false>(a.p0_, b.p3_, out.p1_, out.p2_);
+    KLN_VALIDATE_FINITE("plane * point", out, a, b);
     return out;
 }
 
@@ -93,6 +96,7 @@ namespace kln
 {
     motor out;
     detail::gp03<true>(a.p0_, b.p3_, out.p1_, out.p2_);
+    KLN_VALIDATE_FINITE("point * plane", out, b, a);
     return out;
 }
 
@@ -102,6 +106,7 @@ namespace kln
 {
     rotor out;
     detail::gp11(a.p1_, b.p1_, out.p1_);
+    KLN_VALIDATE_FINITE("branch * branch", out, a, b);
     return out;
 }
 
@@ -112,6 +117,7 @@ namespace kln
 {
     motor out;
     detail::gpLL(a.p1_, b.p1_, &out.p1_);
+    KLN_VALIDATE_FINITE("line * line", out, a, b);
     return out;
 }
 
@@ -122,6 +128,7 @@ namespace kln
 {
     translator out;
     detail::gp33(a.p3_, b.p3_, out.p2_);
+    KLN_VALIDATE_FINITE("point * point", out, a, b);
     return out;
 }
 
@@ -131,6 +138,7 @@ namespace kln
 {
     rotor out;
     detail::gp11(a.p1_, b.p1_, out.p1_);
+    KLN_VALIDATE_FINITE("rotor * rotor", out, a, b);
     return out;
 }
 
@@ -143,6 +151,7 @@ namespace kln
 {
     line out;
     detail::gpDL(a.p, a.q, b.p1_, b.p2_, out.p1_, out.p2_);
+    KLN_VALIDATE_FINITE("dual * line", out, a, b);
     return out;
 }
 
@@ -157,6 +166,7 @@ namespace kln
     motor out;
     out.p1_ = a.p1_;
     detail::gpRT<false>(a.p1_, b.p2_, out.p2_);
+    KLN_VALIDATE_FINITE("rotor * translator", out, a, b);
     return out;
 }
 
@@ -166,6 +176,7 @@ namespace kln
     motor out;
     out.p1_ = a.p1_;
     detail::gpRT<true>(a.p1_, b.p2_, out.p2_);
+    KLN_VALIDATE_FINITE("translator * rotor", out, b, a);
     return out;
 }
 
@@ -183,6 +194,7 @@ namespace kln
     motor out;
     detail::gp11(a.p1_, b.p1_, out.p1_);
     detail::gp12<false>(a.p1_, b.p2_, out.p2_);
+    KLN_VALIDATE_FINITE("rotor * motor", out, a, b);
     return out;
 }
 
@@ -192,6 +204,7 @@ namespace kln
     motor out;
     detail::gp11(b.p1_, a.p1_, out.p1_);
     detail::gp12<true>(a.p1_, b.p2_, out.p2_);
+    KLN_VALIDATE_FINITE("motor * rotor", out, b, a);
     return out;
 }
 
@@ -202,6 +215,7 @@ namespace kln
     out.p1_ = b.p1_;
     detail::gpRT<true>(b.p1_, a.p2_, out.p2_);
     out.p2_ = _mm_add_ps(out.p2_, b.p2_);
+    KLN_VALIDATE_FINITE("translator * motor", out, a, b);
     return out;
 }
 
@@ -212,6 +226,7 @@ namespace kln
     out.p1_ = b.p1_;
     detail::gpRT<false>(b.p1_, a.p2_, out.p2_);
     out.p2_ = _mm_add_ps(out.p2_, b.p2_);
+    KLN_VALIDATE_FINITE("motor * translator", out, b, a);
     return out;
 }
 
@@ -220,6 +235,7 @@ namespace kln
 {
     motor out;
     detail::gpMM(a.p1_, b.p1_, &out.p1_);
+    KLN_VALIDATE_FINITE("motor * motor", out, a, b);
     return out;
 }
 /// @}
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "detail/sandwich.hpp"
+#include "exp_log.hpp"
+#include "geometric_product.hpp"
+#include "kd_tree.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace kln
+{
+/// \defgroup icp Iterative Closest Point
+///
+/// Iterative closest point (ICP) registration estimates the motor that best
+/// aligns a source point cloud to a target point cloud. Each iteration
+/// transforms the source points with the current motor estimate, pairs every
+/// transformed point with its nearest neighbor in the target (via a
+/// `kd_tree`), and solves a linearized least-squares problem for an
+/// incremental screw motion. The increment is a `line` (the infinitesimal
+/// generator of the screw) which is exponentiated and composed with the
+/// current estimate using the geometric product.
+///
+/// Two error metrics are provided. The point-to-point metric minimizes the
+/// squared distances between corresponding points. The point-to-plane metric
+/// minimizes the squared distances between each source point and the tangent
+/// plane at its corresponding target point and generally converges in far
+/// fewer iterations on surfaces.
+///
+/// !!! example
+///
+///     ```c++
+///         std::vector<kln::kd_tree::node> storage(target.size());
+///         kln::kd_tree tree{target.data(), target.size(), storage.data()};
+///
+///         // Scratch space for the transformed source points
+///         std::vector<kln::point> scratch(source.size());
+///
+///         kln::icp_options options;
+///         options.max_distance = 0.5f;
+///
+///         // m holds the initial guess on input and the estimate on output
+///         kln::motor m{1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+///         kln::icp_stats stats = kln::icp_point_to_point(
+///             m, source.data(), source.size(), tree, scratch.data(), options);
+///     ```
+///
+/// The solver performs no allocations. All points are expected to be
+/// normalized and the target planes (when used) are expected to be normalized
+/// such that $p \cdot p = 1$.
+
+/// \addtogroup icp
+/// @{
+struct icp_options
+{
+    /// Upper bound on the number of iterations performed
+    size_t max_iterations = 30;
+
+    /// Correspondences separated by this distance or more are rejected
+    float max_distance = std::numeric_limits<float>::infinity();
+
+    /// Iteration stops once the rotation angle (in radians) and displacement
+    /// of the incremental motor both fall below these thresholds.
+    float angular_tolerance = 1e-5f;
+    float linear_tolerance  = 1e-5f;
+};
+
+struct icp_stats
+{
+    /// Number of iterations performed
+    size_t iterations = 0;
+
+    /// Number of correspondences accepted in the final iteration
+    size_t correspondences = 0;
+
+    /// Root mean square residual of the first and last iterations. Residuals
+    /// are measured before the update of the corresponding iteration is
+    /// applied.
+    float initial_rms = 0.f;
+    float final_rms   = 0.f;
+
+    /// Rotation angle (in radians) and displacement of the final increment
+    float angular_update = 0.f;
+    float linear_update  = 0.f;
+
+    /// True if the tolerances were met before `max_iterations` was reached.
+    /// This is false if too few correspondences were found to constrain the
+    /// motion.
+    bool converged = false;
+};
+
+namespace detail
+{
+    // Accumulates the normal equations J^T J x = -J^T r for the six
+    // parameters (w1, w2, w3, u1, u2, u3) of the incremental twist. Only the
+    // upper triangle of the symmetric matrix is updated.
+    struct icp_system
+    {
+        double a[6][6];
+        double g[6];
+
+        void clear() noexcept
+        {
+            for (int i = 0; i != 6; ++i)
+            {
+                g[i] = 0.0;
+                for (int j = 0; j != 6; ++j)
+                {
+                    a[i][j] = 0.0;
+                }
+            }
+        }
+
+        void add(double const* row, double r) noexcept
+        {
+            for (int i = 0; i != 6; ++i)
+            {
+                g[i] += row[i] * r;
+                for (int j = i; j != 6; ++j)
+                {
+                    a[i][j] += row[i] * row[j];
+                }
+            }
+        }
+
+        // Solve via Cholesky decomposition. Returns false if the system is
+        // not positive definite (the correspondences do not constrain all six
+        // degrees of freedom).
+        [[nodiscard]] bool solve(double* x) noexcept
+        {
+            double l[6][6];
+            for (int i = 0; i != 6; ++i)
+            {
+                for (int j = 0; j <= i; ++j)
+                {
+                    double sum = a[j][i];
+                    for (int k = 0; k != j; ++k)
+                    {
+                        sum -= l[i][k] * l[j][k];
+                    }
+                    if (i == j)
+                    {
+                        if (!(sum > 1e-12 * (1.0 + a[i][i])))
+                        {
+                            return false;
+                        }
+                        l[i][i] = std::sqrt(sum);
+                    }
+                    else
+                    {
+                        l[i][j] = sum / l[j][j];
+                    }
+                }
+            }
+
+            double y[6];
+            for (int i = 0; i != 6; ++i)
+            {
+                double sum = -g[i];
+                for (int k = 0; k != i; ++k)
+                {
+                    sum -= l[i][k] * y[k];
+                }
+                y[i] = sum / l[i][i];
+            }
+            for (int i = 5; i >= 0; --i)
+            {
+                double sum = y[i];
+                for (int k = i + 1; k != 6; ++k)
+                {
+                    sum -= l[k][i] * x[k];
+                }
+                x[i] = sum / l[i][i];
+            }
+            return true;
+        }
+    };
+
+    template <bool PointToPlane>
+    [[nodiscard]] icp_stats icp(motor& m,
+                                point const* source,
+                                size_t count,
+                                kd_tree const& target,
+                                [[maybe_unused]] plane const* target_planes,
+                                point* scratch,
+                                icp_options const& options) noexcept
+    {
+        icp_stats stats;
+        icp_system system;
+        float max_distance2 = options.max_distance * options.max_distance;
+
+        for (size_t iteration = 0; iteration != options.max_iterations;
+             ++iteration)
+        {
+            // Transform the source cloud with the current estimate
+            sw312<true, true>(
+                &source->p3_, m.p1_, &m.p2_, &scratch->p3_, count);
+
+            system.clear();
+            double error           = 0.0;
+            size_t correspondences = 0;
+
+            for (size_t i = 0; i != count; ++i)
+            {
+                kd_tree::neighbor n
+                    = target.nearest(scratch[i], max_distance2);
+                if (n.index == kd_tree::npos)
+                {
+                    continue;
+                }
+                ++correspondences;
+
+                float s[4];
+                _mm_storeu_ps(s, scratch[i].p3_);
+                double x = s[1];
+                double y = s[2];
+                double z = s[3];
+
+                // The motion of a point p under the twist (w, u) is w x p + u
+                if constexpr (PointToPlane)
+                {
+                    // The residual is the signed distance to the tangent plane
+                    // d + n.p with Jacobian (p x n, n).
+                    float t[4];
+                    _mm_storeu_ps(t, target_planes[n.index].p0_);
+                    double r = t[0] + t[1] * x + t[2] * y + t[3] * z;
+                    double row[6]
+                        = {y * t[3] - z * t[2],
+                           z * t[1] - x * t[3],
+                           x * t[2] - y * t[1],
+                           t[1],
+                           t[2],
+                           t[3]};
+                    system.add(row, r);
+                    error += r * r;
+                }
+                else
+                {
+                    float t[4];
+                    _mm_storeu_ps(t, n.p.p3_);
+                    double row_x[6] = {0.0, z, -y, 1.0, 0.0, 0.0};
+                    double row_y[6] = {-z, 0.0, x, 0.0, 1.0, 0.0};
+                    double row_z[6] = {y, -x, 0.0, 0.0, 0.0, 1.0};
+                    system.add(row_x, x - t[1]);
+                    system.add(row_y, y - t[2]);
+                    system.add(row_z, z - t[3]);
+                    error += n.distance2;
+                }
+            }
+
+            stats.iterations      = iteration + 1;
+            stats.correspondences = correspondences;
+            if (correspondences == 0)
+            {
+                break;
+            }
+
+            stats.final_rms = static_cast<float>(
+                std::sqrt(error / static_cast<double>(correspondences)));
+            if (iteration == 0)
+            {
+                stats.initial_rms = stats.final_rms;
+            }
+
+            double xi[6];
+            if (!system.solve(xi))
+            {
+                break;
+            }
+
+            // The twist (w, u) is generated by the line
+            // u1 e01 + u2 e02 + u3 e03 + w1 e23 + w2 e31 + w3 e12 and the
+            // corresponding motor is exp(-line / 2).
+            line l{static_cast<float>(-0.5 * xi[3]),
+                   static_cast<float>(-0.5 * xi[4]),
+                   static_cast<float>(-0.5 * xi[5]),
+                   static_cast<float>(-0.5 * xi[0]),
+                   static_cast<float>(-0.5 * xi[1]),
+                   static_cast<float>(-0.5 * xi[2])};
+            m = exp(l) * m;
+            m.normalize_precise();
+
+            stats.angular_update = static_cast<float>(
+                std::sqrt(xi[0] * xi[0] + xi[1] * xi[1] + xi[2] * xi[2]));
+            stats.linear_update = static_cast<float>(
+                std::sqrt(xi[3] * xi[3] + xi[4] * xi[4] + xi[5] * xi[5]));
+            if (stats.angular_update < options.angular_tolerance
+                && stats.linear_update < options.linear_tolerance)
+            {
+                stats.converged = true;
+                break;
+            }
+        }
+
+        return stats;
+    }
+} // namespace detail
+
+/// Register the `count` points at `source` against the points indexed by
+/// `target` by minimizing the point-to-point distance between
+/// correspondences. On input, `m` is the initial estimate of the motor taking
+/// the source to the target. On output, it holds the refined estimate. The
+/// `scratch` argument must point to storage for `count` points and receives
+/// the source points transformed by the estimate of the final iteration.
+[[nodiscard]] inline icp_stats icp_point_to_point(motor& m,
+                                                  point const* source,
+                                                  size_t count,
+                                                  kd_tree const& target,
+                                                  point* scratch,
+                                                  icp_options const& options
+                                                  = {}) noexcept
+{
+    return detail::icp<false>(
+        m, source, count, target, nullptr, scratch, options);
+}
+
+/// Register the `count` points at `source` against the points indexed by
+/// `target` by minimizing the distance between each source point and the
+/// tangent plane of its corresponding target point. The array
+/// `target_planes` supplies the normalized tangent plane through each target
+/// point and is indexed identically to the points `target` was built from.
+/// The remaining arguments are as in `icp_point_to_point`.
+[[nodiscard]] inline icp_stats icp_point_to_plane(motor& m,
+                                                  point const* source,
+                                                  size_t count,
+                                                  kd_tree const& target,
+                                                  plane const* target_planes,
+                                                  point* scratch,
+                                                  icp_options const& options
+                                                  = {}) noexcept
+{
+    return detail::icp<true>(
+        m, source, count, target, target_planes, scratch, options);
+}
+/// @}
+} // namespace kln
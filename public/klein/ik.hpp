@@ -0,0 +1,456 @@
+#pragma once
+
+#include "detail/sse.hpp"
+#include "geometric_product.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+#include "point.hpp"
+#include "projection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace kln
+{
+/// \defgroup ik Inverse Kinematics
+///
+/// Solvers which adjust the joint angles of a serial chain so that its end
+/// effector reaches a target point.
+///
+/// A chain is a sequence of revolute joints. Each joint is positioned
+/// relative to its parent (or the chain root for the first joint) by a rest
+/// motor `offset` and rotates by `angle` about a line `axis` expressed in its
+/// own frame. The world frame of joint $i$ is thus
+///
+/// $$F_i = F_{i-1}\,O_i\,R_i(\theta_i)$$
+///
+/// where $F_{-1}$ is the chain root and $R_i(\theta)$ is the motor rotating
+/// by $\theta$ about the joint axis. Ball joints are modeled as three joints
+/// with identity offsets between them and orthogonal axes.
+///
+/// Three solvers are provided:
+///
+/// - `ik::ccd` (cyclic coordinate descent) sweeps from the tip to the root,
+///   rotating each joint to swing the end effector toward the target.
+/// - `ik::fabrik` (forward and backward reaching inverse kinematics) solves
+///   for joint positions directly, recovering the joint angles as it goes.
+///   It is best suited to chains of ball joints.
+/// - `ik::dls` (damped least squares) uses the screw-axis Jacobian. Column
+///   $j$ is the velocity $\omega\times p + u$ induced at the end effector $p$
+///   by the world space joint line with Euclidean part $\omega$ and ideal
+///   part $u$.
+///
+/// None of the solvers allocate. The caller provides an `ik::scratch` which
+/// may be reused across solves and chains (provided it is large enough).
+///
+/// !!! example
+///
+///     ```c++
+///         // A planar arm with three unit links rotating about z
+///         kln::line z_axis{0.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+///         kln::ik::joint joints[3];
+///         for (kln::ik::joint& j : joints)
+///         {
+///             j.offset = kln::translator{1.f, 1.f, 0.f, 0.f};
+///             j.axis   = z_axis;
+///         }
+///         joints[0].offset = kln::translator{0.f, 1.f, 0.f, 0.f};
+///
+///         kln::ik::chain arm{joints, 3, root, kln::point{1.f, 0.f, 0.f}};
+///
+///         kln::motor frames[3];
+///         kln::point positions[4];
+///         float lengths[3];
+///         kln::ik::scratch scratch{frames, positions, lengths};
+///
+///         kln::ik::result r = kln::ik::ccd(arm, target, scratch);
+///     ```
+
+namespace detail
+{
+    [[nodiscard]] inline float KLN_VEC_CALL ik_distance(point a,
+                                                        point b) noexcept
+    {
+        __m128 delta = _mm_sub_ps(a.p3_, b.p3_);
+        float out;
+        _mm_store_ss(&out, _mm_sqrt_ss(hi_dp(delta, delta)));
+        return out;
+    }
+
+    // The cross product of the x, y, and z components (lanes 1 through 3)
+    [[nodiscard]] inline __m128 KLN_VEC_CALL ik_cross(__m128 a,
+                                                      __m128 b) noexcept
+    {
+        return _mm_sub_ps(
+            _mm_mul_ps(KLN_SWIZZLE(a, 1, 3, 2, 0), KLN_SWIZZLE(b, 2, 1, 3, 0)),
+            _mm_mul_ps(KLN_SWIZZLE(a, 2, 1, 3, 0), KLN_SWIZZLE(b, 1, 3, 2, 0)));
+    }
+
+    // Compute the angle by which a rotation about the normalized world line
+    // `axis` swings `from` closest to `to`. Both points are measured from
+    // their projections onto the axis. Returns false (and leaves the angle
+    // untouched) if either point lies on the axis (within roughly 1e-3 to
+    // absorb the rounding accumulated along the chain).
+    [[nodiscard]] inline bool KLN_VEC_CALL ik_swing(line axis,
+                                                    point from,
+                                                    point to,
+                                                    float& angle) noexcept
+    {
+        point from_foot = project(from, axis);
+        point to_foot   = project(to, axis);
+        __m128 r_from   = _mm_sub_ps(
+            from.p3_,
+            _mm_div_ps(from_foot.p3_, KLN_SWIZZLE(from_foot.p3_, 0, 0, 0, 0)));
+        __m128 r_to = _mm_sub_ps(
+            to.p3_,
+            _mm_div_ps(to_foot.p3_, KLN_SWIZZLE(to_foot.p3_, 0, 0, 0, 0)));
+
+        float from2;
+        float to2;
+        _mm_store_ss(&from2, hi_dp(r_from, r_from));
+        _mm_store_ss(&to2, hi_dp(r_to, r_to));
+        if (from2 < 1e-6f || to2 < 1e-6f)
+        {
+            return false;
+        }
+
+        // The Euclidean part of the line is the axis direction
+        float sin_part;
+        float cos_part;
+        _mm_store_ss(&sin_part, hi_dp(axis.p1_, ik_cross(r_from, r_to)));
+        _mm_store_ss(&cos_part, hi_dp(r_from, r_to));
+        angle = std::atan2(sin_part, cos_part);
+        return true;
+    }
+
+    // Rotate a joint by delta subject to its limits and return the rotation
+    // actually applied
+    template <typename Joint>
+    float ik_rotate(Joint& j, float delta) noexcept
+    {
+        float angle = std::clamp(j.angle + delta, j.min_angle, j.max_angle);
+        delta       = angle - j.angle;
+        j.angle     = angle;
+        return delta;
+    }
+} // namespace detail
+
+/// \addtogroup ik
+/// @{
+namespace ik
+{
+    struct joint
+    {
+        /// Rest transform from the parent frame to this joint's frame
+        motor offset{1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+
+        /// Normalized rotation axis expressed in this joint's frame
+        line axis{0.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+
+        /// Current rotation about the axis (radians)
+        float angle = 0.f;
+
+        /// Limits enforced by every solver
+        float min_angle = -std::numeric_limits<float>::infinity();
+        float max_angle = std::numeric_limits<float>::infinity();
+    };
+
+    struct chain
+    {
+        joint* joints;
+        size_t count;
+
+        /// World transform of the base of the chain
+        motor root;
+
+        /// End effector location in the frame of the last joint
+        point effector;
+    };
+
+    /// Storage used while solving a chain with `count` joints. The `frames`
+    /// array must hold `count` motors. The `positions` (`count + 1` points) and
+    /// `lengths` (`count` floats) arrays are only used by `fabrik` and may be
+    /// null otherwise.
+    struct scratch
+    {
+        motor* frames;
+        point* positions;
+        float* lengths;
+    };
+
+    struct options
+    {
+        /// Upper bound on the number of iterations (sweeps of the chain)
+        size_t max_iterations = 16;
+
+        /// Solving stops once the end effector is within this distance of the
+        /// target
+        float tolerance = 1e-3f;
+
+        /// Damping factor of the damped least squares solver. Larger values
+        /// trade convergence speed for stability near singularities.
+        float damping = 0.1f;
+    };
+
+    struct result
+    {
+        size_t iterations = 0;
+
+        /// Distance between the end effector and the target after solving
+        float distance = 0.f;
+
+        bool converged = false;
+    };
+
+    /// Compute the world frame of every joint and return the world space end
+    /// effector.
+    inline point forward(chain const& c, motor* frames) noexcept
+    {
+        motor parent = c.root;
+        for (size_t i = 0; i != c.count; ++i)
+        {
+            joint const& j = c.joints[i];
+            frames[i]      = parent * j.offset * motor{j.angle, 0.f, j.axis};
+            parent         = frames[i];
+        }
+        return c.count == 0 ? c.root(c.effector) : parent(c.effector);
+    }
+
+    /// Cyclic coordinate descent. Each iteration visits every joint from the
+    /// tip to the root and rotates it about its axis to bring the end effector
+    /// as close as possible to the target.
+    inline result KLN_VEC_CALL ccd(chain& c,
+                                   point target,
+                                   scratch& s,
+                                   options const& opts = {}) noexcept
+    {
+        result out;
+        point effector = forward(c, s.frames);
+        out.distance   = detail::ik_distance(effector, target);
+
+        while (out.distance > opts.tolerance
+               && out.iterations != opts.max_iterations)
+        {
+            ++out.iterations;
+            for (size_t i = c.count; i != 0; --i)
+            {
+                joint& j  = c.joints[i - 1];
+                line axis = s.frames[i - 1](j.axis);
+
+                float delta;
+                if (!detail::ik_swing(axis, effector, target, delta))
+                {
+                    continue;
+                }
+                delta = detail::ik_rotate(j, delta);
+
+                // The effector moves rigidly with the joint. The frames of
+                // the joints below are recomputed at the next iteration.
+                effector = motor{delta, 0.f, axis}(effector);
+            }
+            effector     = forward(c, s.frames);
+            out.distance = detail::ik_distance(effector, target);
+        }
+
+        out.converged = out.distance <= opts.tolerance;
+        return out;
+    }
+
+    /// Forward and backward reaching inverse kinematics. Each iteration drags
+    /// the joint positions from the target back to the root while preserving
+    /// the distances between successive joints. The forward pass then visits
+    /// the joints from the root and rotates each about its axis to swing the
+    /// next joint off the axis toward the point at the original distance from
+    /// its (already placed) parent in the direction of its backward position.
+    /// Unlike unconstrained FABRIK, every position reached by the forward pass
+    /// respects the joint axes and limits.
+    ///
+    /// FABRIK converges quickly on chains of ball joints. Chains with hinges
+    /// generally cannot realize the positions of the backward pass and may
+    /// stall short of the target, in which case `ccd` or `dls` is preferred.
+    inline result KLN_VEC_CALL fabrik(chain& c,
+                                      point target,
+                                      scratch& s,
+                                      options const& opts = {}) noexcept
+    {
+        result out;
+        point effector = forward(c, s.frames);
+        out.distance   = detail::ik_distance(effector, target);
+
+        point* p  = s.positions;
+        auto lerp = [](point a, point b, float t) {
+            return point{_mm_add_ps(
+                a.p3_, _mm_mul_ps(_mm_set1_ps(t), _mm_sub_ps(b.p3_, a.p3_)))};
+        };
+
+        while (out.distance > opts.tolerance
+               && out.iterations != opts.max_iterations)
+        {
+            ++out.iterations;
+
+            for (size_t i = 0; i != c.count; ++i)
+            {
+                p[i] = s.frames[i](origin{});
+            }
+            p[c.count] = effector;
+            for (size_t i = 0; i != c.count; ++i)
+            {
+                s.lengths[i] = detail::ik_distance(p[i], p[i + 1]);
+            }
+
+            // Backward pass from the target
+            p[c.count] = target;
+            for (size_t i = c.count; i != 0; --i)
+            {
+                float d = detail::ik_distance(p[i - 1], p[i]);
+                p[i - 1]
+                    = d == 0.f ? p[i]
+                               : lerp(p[i], p[i - 1], s.lengths[i - 1] / d);
+            }
+
+            // Forward pass from the root
+            motor parent = c.root;
+            for (size_t i = 0; i != c.count; ++i)
+            {
+                joint& j    = c.joints[i];
+                s.frames[i] = parent * j.offset * motor{j.angle, 0.f, j.axis};
+                line axis   = s.frames[i](j.axis);
+
+                // Find the first descendant (or the effector) off the axis.
+                // The descendants skipped along the way lie on the axis and
+                // are unaffected by the rotation.
+                motor descendant = s.frames[i];
+                point previous   = s.frames[i](origin{});
+                for (size_t k = i + 1; k <= c.count; ++k)
+                {
+                    point current;
+                    if (k == c.count)
+                    {
+                        current = descendant(c.effector);
+                    }
+                    else
+                    {
+                        joint const& jk = c.joints[k];
+                        descendant = descendant * jk.offset
+                                     * motor{jk.angle, 0.f, jk.axis};
+                        current = descendant(origin{});
+                    }
+
+                    float d    = detail::ik_distance(previous, p[k]);
+                    point goal = d == 0.f
+                                     ? p[k]
+                                     : lerp(previous, p[k], s.lengths[k - 1] / d);
+
+                    float delta;
+                    if (detail::ik_swing(axis, current, goal, delta))
+                    {
+                        detail::ik_rotate(j, delta);
+                        s.frames[i]
+                            = parent * j.offset * motor{j.angle, 0.f, j.axis};
+                        break;
+                    }
+                    previous = current;
+                }
+                parent = s.frames[i];
+            }
+
+            effector     = forward(c, s.frames);
+            out.distance = detail::ik_distance(effector, target);
+        }
+
+        out.converged = out.distance <= opts.tolerance;
+        return out;
+    }
+
+    /// Damped least squares. Each iteration solves
+    ///
+    /// $$\Delta\theta = J^T\left(JJ^T + \lambda^2 I\right)^{-1} e$$
+    ///
+    /// where $e$ is the displacement from the end effector to the target and
+    /// $\lambda$ is the damping factor. Only the $3\times 3$ matrix $JJ^T$ is
+    /// formed so the cost is linear in the number of joints.
+    inline result KLN_VEC_CALL dls(chain& c,
+                                   point target,
+                                   scratch& s,
+                                   options const& opts = {}) noexcept
+    {
+        result out;
+        point effector = forward(c, s.frames);
+        out.distance   = detail::ik_distance(effector, target);
+
+        // The velocity of p under the screw axis is w x p + u where w and u
+        // are the Euclidean and ideal parts of the axis respectively
+        auto column = [](line axis, point p) {
+            return _mm_add_ps(detail::ik_cross(axis.p1_, p.p3_), axis.p2_);
+        };
+
+        while (out.distance > opts.tolerance
+               && out.iterations != opts.max_iterations)
+        {
+            ++out.iterations;
+
+            // Accumulate the symmetric matrix J J^T + damping^2 I
+            float a[3][3] = {};
+            for (size_t i = 0; i != c.count; ++i)
+            {
+                float v[4];
+                _mm_storeu_ps(
+                    v, column(s.frames[i](c.joints[i].axis), effector));
+                for (int r = 0; r != 3; ++r)
+                {
+                    for (int k = 0; k != 3; ++k)
+                    {
+                        a[r][k] += v[r + 1] * v[k + 1];
+                    }
+                }
+            }
+            float damping2 = opts.damping * opts.damping;
+            a[0][0] += damping2;
+            a[1][1] += damping2;
+            a[2][2] += damping2;
+
+            float e[4];
+            _mm_storeu_ps(e, _mm_sub_ps(target.p3_, effector.p3_));
+
+            // Solve a y = e by Cramer's rule
+            float c00 = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+            float c01 = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+            float c02 = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+            float det = a[0][0] * c00 + a[0][1] * c01 + a[0][2] * c02;
+            if (det == 0.f)
+            {
+                break;
+            }
+            float inv_det = 1.f / det;
+            float y[3];
+            y[0] = (e[1] * c00 + a[0][1] * (a[1][2] * e[3] - e[2] * a[2][2])
+                    + a[0][2] * (e[2] * a[2][1] - a[1][1] * e[3]))
+                   * inv_det;
+            y[1] = (a[0][0] * (e[2] * a[2][2] - a[1][2] * e[3])
+                    + e[1] * c01 + a[0][2] * (a[1][0] * e[3] - e[2] * a[2][0]))
+                   * inv_det;
+            y[2] = (a[0][0] * (a[1][1] * e[3] - e[2] * a[2][1])
+                    + a[0][1] * (e[2] * a[2][0] - a[1][0] * e[3]) + e[1] * c02)
+                   * inv_det;
+
+            for (size_t i = 0; i != c.count; ++i)
+            {
+                float v[4];
+                _mm_storeu_ps(
+                    v, column(s.frames[i](c.joints[i].axis), effector));
+                detail::ik_rotate(c.joints[i],
+                                  v[1] * y[0] + v[2] * y[1] + v[3] * y[2]);
+            }
+
+            effector     = forward(c, s.frames);
+            out.distance = detail::ik_distance(effector, target);
+        }
+
+        out.converged = out.distance <= opts.tolerance;
+        return out;
+    }
+} // namespace ik
+/// @}
+} // namespace kln
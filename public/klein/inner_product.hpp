@@ -1,6 +1,7 @@
 #pragma once
 
 #include "detail/inner_product.hpp"
+#include "detail/validate.hpp"
 
 #include "line.hpp"
 #include "motor.hpp"
@@ -54,6 +55,7 @@ namespace kln
     __m128 s;
     detail::dot00(a.p0_, b.p0_, s);
     _mm_store_ss(&out, s);
+    KLN_VALIDATE_FINITE("plane | plane", out, a, b);
     return out;
 }
 
@@ -61,6 +63,7 @@ namespace kln
 {
     plane out;
     detail::dotPL<false>(a.p0_, b.p1_, b.p2_, out.p0_);
+    KLN_VALIDATE_FINITE("plane | line", out, a, b);
     return out;
 }
 
@@ -68,6 +71,7 @@ namespace kln
 {
     plane out;
     detail::dotPL<true>(a.p0_, b.p1_, b.p2_, out.p0_);
+    KLN_VALIDATE_FINITE("line | plane", out, b, a);
     return out;
 }
 
@@ -75,6 +79,7 @@ namespace kln
 {
     plane out;
     detail::dotPIL<false>(a.p0_, b.p2_, out.p0_);
+    KLN_VALIDATE_FINITE("plane | ideal_line", out, a, b);
     return out;
 }
 
@@ -82,6 +87,7 @@ namespace kln
 {
     plane out;
     detail::dotPIL<true>(a.p0_, b.p2_, out.p0_);
+    KLN_VALIDATE_FINITE("ideal_line | plane", out, b, a);
     return out;
 }
 
@@ -89,6 +95,7 @@ namespace kln
 {
     line out;
     detail::dot03(a.p0_, b.p3_, out.p1_, out.p2_);
+    KLN_VALIDATE_FINITE("plane | point", out, a, b);
     return out;
 }
 
@@ -103,6 +110,7 @@ namespace kln
     detail::dot11(a.p1_, b.p1_, s);
     float out;
     _mm_store_ss(&out, s);
+    KLN_VALIDATE_FINITE("line | line", out, a, b);
     return out;
 }
 
@@ -110,6 +118,7 @@ namespace kln
 {
     plane out;
     detail::dotPTL(a.p3_, b.p1_, out.p0_);
+    KLN_VALIDATE_FINITE("point | line", out, a, b);
     return out;
 }
 
@@ -124,6 +133,7 @@ namespace kln
     detail::dot33(a.p3_, b.p3_, s);
     float out;
     _mm_store_ss(&out, s);
+    KLN_VALIDATE_FINITE("point | point", out, a, b);
     return out;
 }
 /// @}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "detail/interop.hpp"
+#include "detail/profile.hpp"
+#include "direction.hpp"
+#include "motor.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+#include "rotor.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace kln
+{
+/// \defgroup interop Interop
+///
+/// Vertex buffers, physics engines, and file formats rarely store entities in
+/// Klein's partitioned layout (`(w, x, y, z)` in 16 byte slots, see
+/// `point::load`). `apply_xyz` and `apply_xyzw` transform arrays in the two
+/// most common external layouts directly, so no repacking pass is needed
+/// before or after the transform:
+///
+/// - `apply_xyz<T>`: tightly packed `(x, y, z)` triples (a 12 byte stride) of
+///   points (with an implied $w = 1$) or directions.
+/// - `apply_xyzw<T>`: `(x, y, z, w)` quadruples of points (where $w$ is the
+///   homogeneous coordinate and is preserved), directions (where $w$ is
+///   passed through), or planes $ax + by + cz + d = 0$ stored as
+///   `(a, b, c, d)`.
+///
+/// Interleaved vertex buffers, where each vertex holds a position and a
+/// normal among other attributes, are described by a `vertex_layout` and
+/// transformed in place by `apply_vertices`. Positions transform as points
+/// and normals as directions (see `motor::operator()(direction*, ...)`) in a
+/// single pass over the buffer.
+///
+/// The layout conversion is fused into the kernel: four entities are loaded
+/// and transposed in registers, transformed, and transposed back before being
+/// stored in the original layout. The versor is converted to its affine form
+/// once per call, so each block of four entities costs 9 multiplies and up to
+/// 12 adds in addition to the shuffles.
+///
+/// The arrays need no particular alignment and the input and output may
+/// alias exactly. The versor must be normalized (see `motor::as_mat3x4`).
+/// Results agree with the batch operators of `kln::motor` and `kln::rotor` up
+/// to rounding.
+///
+/// !!! example
+///
+///     ```c++
+///         // Positions and normals of a mesh, packed as float3
+///         std::vector<float> positions; // 3 * vertex_count
+///         std::vector<float> normals;   // 3 * vertex_count
+///
+///         kln::apply_xyz<kln::point>(
+///             m, positions.data(), positions.data(), vertex_count);
+///         kln::apply_xyz<kln::direction>(
+///             m, normals.data(), normals.data(), vertex_count);
+///
+///         // The same attributes interleaved with texture coordinates
+///         struct vertex
+///         {
+///             float position[3];
+///             float normal[3];
+///             float uv[2];
+///         };
+///         std::vector<vertex> vertices; // vertex_count
+///
+///         kln::apply_vertices(m,
+///                             vertices.data(),
+///                             {sizeof(vertex),
+///                              offsetof(vertex, position),
+///                              offsetof(vertex, normal)},
+///                             vertex_count);
+///     ```
+
+/// \addtogroup interop
+/// @{
+
+namespace detail
+{
+    template <typename T>
+    struct interop_traits;
+
+    template <>
+    struct interop_traits<point>
+    {
+        static constexpr interop_kind kind = interop_kind::point;
+    };
+
+    template <>
+    struct interop_traits<direction>
+    {
+        static constexpr interop_kind kind = interop_kind::direction;
+    };
+
+    template <>
+    struct interop_traits<plane>
+    {
+        static constexpr interop_kind kind = interop_kind::plane;
+    };
+
+    template <typename T>
+    constexpr void interop_check_xyz() noexcept
+    {
+        static_assert(!std::is_same_v<T, plane>,
+                      "Planes require four floats, use apply_xyzw");
+    }
+} // namespace detail
+
+/// Transform `count` packed `(x, y, z)` points or directions with the motor
+/// `m`. `in` and `out` point to `3 * count` floats.
+template <typename T>
+void apply_xyz(motor const& m,
+               float const* in,
+               float* out,
+               size_t count) noexcept
+{
+    detail::interop_check_xyz<T>();
+    KLN_PROFILE_SCOPE(interop_apply, count);
+    detail::interop_affine a;
+    detail::interop_load_affine(m.as_mat3x4().cols, a);
+    detail::apply_xyz<detail::interop_traits<T>::kind, true>(
+        a, in, out, count);
+}
+
+/// Rotate `count` packed `(x, y, z)` points or directions with the rotor `r`.
+/// `in` and `out` point to `3 * count` floats.
+template <typename T>
+void apply_xyz(rotor const& r,
+               float const* in,
+               float* out,
+               size_t count) noexcept
+{
+    detail::interop_check_xyz<T>();
+    KLN_PROFILE_SCOPE(interop_apply, count);
+    detail::interop_affine a;
+    detail::interop_load_affine(r.as_mat3x4().cols, a);
+    detail::apply_xyz<detail::interop_traits<T>::kind, false>(
+        a, in, out, count);
+}
+
+/// Transform `count` `(x, y, z, w)` points, directions, or planes with the
+/// motor `m`. `in` and `out` point to `4 * count` floats.
+template <typename T>
+void apply_xyzw(motor const& m,
+                float const* in,
+                float* out,
+                size_t count) noexcept
+{
+    KLN_PROFILE_SCOPE(interop_apply, count);
+    detail::interop_affine a;
+    detail::interop_load_affine(m.as_mat3x4().cols, a);
+    detail::apply_xyzw<detail::interop_traits<T>::kind, true>(
+        a, in, out, count);
+}
+
+/// Rotate `count` `(x, y, z, w)` points, directions, or planes with the rotor
+/// `r`. `in` and `out` point to `4 * count` floats.
+template <typename T>
+void apply_xyzw(rotor const& r,
+                float const* in,
+                float* out,
+                size_t count) noexcept
+{
+    KLN_PROFILE_SCOPE(interop_apply, count);
+    detail::interop_affine a;
+    detail::interop_load_affine(r.as_mat3x4().cols, a);
+    detail::apply_xyzw<detail::interop_traits<T>::kind, false>(
+        a, in, out, count);
+}
+
+/// Byte offset denoting an attribute absent from a `vertex_layout`
+constexpr size_t no_attribute = ~size_t{0};
+
+/// Location of the `(x, y, z)` position and normal within each vertex of an
+/// interleaved buffer. All quantities are in bytes. Either attribute may be
+/// `no_attribute`, in which case it is left untouched.
+struct vertex_layout
+{
+    size_t stride   = 0;
+    size_t position = 0;
+    size_t normal   = no_attribute;
+};
+
+namespace detail
+{
+    // Select the kernel for the attributes present in the layout
+    template <bool Translate>
+    void dispatch_vertices(interop_affine const& a,
+                           void* vertices,
+                           vertex_layout const& layout,
+                           size_t count) noexcept
+    {
+        auto* base     = static_cast<unsigned char*>(vertices);
+        bool positions = layout.position != no_attribute;
+        bool normals   = layout.normal != no_attribute;
+        if (positions && normals)
+        {
+            detail::apply_vertices<Translate, true, true>(
+                a, base, layout.stride, layout.position, layout.normal, count);
+        }
+        else if (positions)
+        {
+            detail::apply_vertices<Translate, true, false>(
+                a, base, layout.stride, layout.position, 0, count);
+        }
+        else if (normals)
+        {
+            detail::apply_vertices<Translate, false, true>(
+                a, base, layout.stride, 0, layout.normal, count);
+        }
+    }
+} // namespace detail
+
+/// Transform the positions and normals of `count` interleaved vertices in
+/// place with the motor `m`.
+inline void apply_vertices(motor const& m,
+                           void* vertices,
+                           vertex_layout const& layout,
+                           size_t count) noexcept
+{
+    KLN_PROFILE_SCOPE(interop_apply, count);
+    detail::interop_affine a;
+    detail::interop_load_affine(m.as_mat3x4().cols, a);
+    detail::dispatch_vertices<true>(a, vertices, layout, count);
+}
+
+/// Rotate the positions and normals of `count` interleaved vertices in place
+/// with the rotor `r`.
+inline void apply_vertices(rotor const& r,
+                           void* vertices,
+                           vertex_layout const& layout,
+                           size_t count) noexcept
+{
+    KLN_PROFILE_SCOPE(interop_apply, count);
+    detail::interop_affine a;
+    detail::interop_load_affine(r.as_mat3x4().cols, a);
+    detail::dispatch_vertices<false>(a, vertices, layout, count);
+}
+/// @}
+} // namespace kln
@@ -0,0 +1,299 @@
+#pragma once
+
+#include "detail/sse.hpp"
+#include "executor.hpp"
+#include "point.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace kln
+{
+/// \defgroup kd_tree K-d Tree
+///
+/// A static k-d tree over an array of normalized points used to answer
+/// nearest-neighbor queries (for example, to find correspondences between two
+/// point clouds).
+///
+/// In keeping with the rest of the library, the tree does not allocate. The
+/// caller provides storage for one `kd_tree::node` per point and the tree is
+/// built in place within that storage. The nodes are arranged such that every
+/// subtree occupies a contiguous range of the array with its splitting node at
+/// the center of the range. Ranges at or below `kd_tree::leaf_size` nodes are
+/// not subdivided further and are scanned linearly when queried.
+///
+/// Because disjoint subtrees occupy disjoint ranges, the tree can be rebuilt
+/// in parallel by passing an executor (see [Executors](#executor)) to `build`.
+/// The upper levels are partitioned on the calling thread after which each of
+/// the remaining subtrees is built as an independent task.
+///
+/// !!! example
+///
+///     ```c++
+///         std::vector<kln::point> cloud = load_cloud();
+///         std::vector<kln::kd_tree::node> storage(cloud.size());
+///
+///         kln::kd_tree tree{cloud.data(), cloud.size(), storage.data()};
+///
+///         kln::kd_tree::neighbor n = tree.nearest(kln::point{1.f, 2.f, 3.f});
+///         // cloud[n.index] is the point closest to (1, 2, 3) and
+///         // n.distance2 is the squared distance to it.
+///     ```
+
+/// \addtogroup kd_tree
+/// @{
+class kd_tree final
+{
+public:
+    /// Subtrees with this many nodes or fewer are scanned linearly.
+    static constexpr size_t leaf_size = 8;
+
+    /// A copy of an input point along with its index in the input array and
+    /// the axis it splits its subtree along. The axis corresponds to the
+    /// component of `p3_` compared against (1, 2, and 3 for x, y, and z
+    /// respectively).
+    struct node
+    {
+        __m128 p3_;
+        uint32_t index;
+        uint32_t axis;
+    };
+
+    /// Result of a nearest-neighbor query. If no point was found within the
+    /// requested distance, `index` is `kd_tree::npos` and `p` is undefined.
+    struct neighbor
+    {
+        point p;
+        uint32_t index;
+        float distance2;
+    };
+
+    static constexpr uint32_t npos = ~uint32_t{0};
+
+    kd_tree() noexcept = default;
+
+    /// Build a tree over `count` points. The `storage` argument must point to
+    /// an array of at least `count` nodes and must outlive the tree.
+    kd_tree(point const* points, size_t count, node* storage) noexcept
+    {
+        build(points, count, storage);
+    }
+
+    /// (Re)build the tree over `count` points using the provided node
+    /// storage. The points are expected to be normalized (homogeneous
+    /// coordinate of 1). The subtrees below the first few levels are built as
+    /// independent tasks submitted to `exec`.
+    template <typename Executor = serial_executor>
+    void build(point const* points,
+               size_t count,
+               node* storage,
+               Executor&& exec = {}) noexcept
+    {
+        nodes_ = storage;
+        count_ = count;
+        for (size_t i = 0; i != count; ++i)
+        {
+            nodes_[i].p3_   = points[i].p3_;
+            nodes_[i].index = static_cast<uint32_t>(i);
+            nodes_[i].axis  = 1;
+        }
+
+        range tasks[max_tasks];
+        size_t task_count = 0;
+        split_range(0, count, tasks, task_count);
+        exec(task_count, [this, &tasks](size_t i) {
+            build_range(tasks[i].lo, tasks[i].hi);
+        });
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return count_;
+    }
+
+    [[nodiscard]] node const* nodes() const noexcept
+    {
+        return nodes_;
+    }
+
+    /// Return the point nearest to `p` along with its squared distance. The
+    /// query point must be normalized.
+    [[nodiscard]] neighbor KLN_VEC_CALL nearest(point p) const noexcept
+    {
+        return nearest(p, std::numeric_limits<float>::max());
+    }
+
+    /// Return the point nearest to `p` provided it lies strictly within a
+    /// squared distance of `max_distance2`. Limiting the search radius allows
+    /// large portions of the tree to be culled early.
+    [[nodiscard]] neighbor KLN_VEC_CALL nearest(point p,
+                                                float max_distance2) const
+        noexcept
+    {
+        neighbor best{{}, npos, max_distance2};
+        if (count_ == 0)
+        {
+            return best;
+        }
+
+        float q[4];
+        _mm_storeu_ps(q, p.p3_);
+
+        // Each level of the tree pushes at most two ranges and pops one so the
+        // stack depth is bounded by twice the tree height.
+        range stack[128];
+        size_t top = 0;
+        stack[top++] = {0, count_, 0.f};
+
+        while (top != 0)
+        {
+            range r = stack[--top];
+            if (r.bound2 >= best.distance2)
+            {
+                continue;
+            }
+
+            if (r.hi - r.lo <= leaf_size)
+            {
+                for (size_t i = r.lo; i != r.hi; ++i)
+                {
+                    visit(p.p3_, nodes_[i], best);
+                }
+                continue;
+            }
+
+            size_t mid    = r.lo + (r.hi - r.lo) / 2;
+            node const& n = nodes_[mid];
+            visit(p.p3_, n, best);
+
+            float delta = q[n.axis] - component(n.p3_, n.axis);
+            range lower{r.lo, mid, r.bound2};
+            range upper{mid + 1, r.hi, r.bound2};
+            float split2 = std::max(r.bound2, delta * delta);
+
+            // Push the far side first so the near side is explored first
+            if (delta < 0.f)
+            {
+                upper.bound2 = split2;
+                stack[top++] = upper;
+                stack[top++] = lower;
+            }
+            else
+            {
+                lower.bound2 = split2;
+                stack[top++] = lower;
+                stack[top++] = upper;
+            }
+        }
+
+        return best;
+    }
+
+private:
+    // Upper bound on the number of subtrees handed to an executor
+    static constexpr size_t max_tasks = 64;
+
+    struct range
+    {
+        size_t lo;
+        size_t hi;
+        float bound2;
+    };
+
+    [[nodiscard]] static float component(__m128 const& xmm,
+                                         uint32_t i) noexcept
+    {
+        return reinterpret_cast<float const*>(&xmm)[i];
+    }
+
+    static void KLN_VEC_CALL visit(__m128 p,
+                                   node const& n,
+                                   neighbor& best) noexcept
+    {
+        // The squared Euclidean distance is the dot product of the difference
+        // with itself, ignoring the homogeneous coordinate.
+        __m128 delta = _mm_sub_ps(p, n.p3_);
+        float d2;
+        _mm_store_ss(&d2, detail::hi_dp(delta, delta));
+        if (d2 < best.distance2)
+        {
+            best.p.p3_     = n.p3_;
+            best.distance2 = d2;
+            best.index     = n.index;
+        }
+    }
+
+    // Partition the range about its median, storing the splitting axis in the
+    // median node, and return the index of the median.
+    size_t partition(size_t lo, size_t hi) noexcept
+    {
+        // Split along the axis of greatest extent
+        __m128 lower = nodes_[lo].p3_;
+        __m128 upper = lower;
+        for (size_t i = lo + 1; i != hi; ++i)
+        {
+            lower = _mm_min_ps(lower, nodes_[i].p3_);
+            upper = _mm_max_ps(upper, nodes_[i].p3_);
+        }
+        float extent[4];
+        _mm_storeu_ps(extent, _mm_sub_ps(upper, lower));
+        uint32_t axis = 1;
+        if (extent[2] > extent[axis])
+        {
+            axis = 2;
+        }
+        if (extent[3] > extent[axis])
+        {
+            axis = 3;
+        }
+
+        size_t mid = lo + (hi - lo) / 2;
+        std::nth_element(nodes_ + lo,
+                         nodes_ + mid,
+                         nodes_ + hi,
+                         [axis](node const& a, node const& b) {
+                             return component(a.p3_, axis)
+                                    < component(b.p3_, axis);
+                         });
+        nodes_[mid].axis = axis;
+        return mid;
+    }
+
+    void build_range(size_t lo, size_t hi) noexcept
+    {
+        if (hi - lo <= leaf_size)
+        {
+            return;
+        }
+
+        size_t mid = partition(lo, hi);
+        build_range(lo, mid);
+        build_range(mid + 1, hi);
+    }
+
+    // Partition the upper levels of the tree until there are enough subtrees
+    // to distribute as tasks.
+    void split_range(size_t lo,
+                     size_t hi,
+                     range* tasks,
+                     size_t& task_count,
+                     size_t depth = 0) noexcept
+    {
+        if (hi - lo <= leaf_size || (size_t{2} << depth) > max_tasks)
+        {
+            tasks[task_count++] = {lo, hi, 0.f};
+            return;
+        }
+
+        size_t mid = partition(lo, hi);
+        split_range(lo, mid, tasks, task_count, depth + 1);
+        split_range(mid + 1, hi, tasks, task_count, depth + 1);
+    }
+
+    node* nodes_  = nullptr;
+    size_t count_ = 0;
+};
+/// @}
+} // namespace kln
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "detail/exterior_product.hpp"
+#include "detail/validate.hpp"
 
 #include "dual.hpp"
 #include "line.hpp"
@@ -47,6 +48,7 @@ namespace kln
 {
     line out;
     detail::ext00(a.p0_, b.p0_, out.p1_, out.p2_);
+    KLN_VALIDATE_FINITE("plane ^ plane", out, a, b);
     return out;
 }
 
@@ -54,6 +56,7 @@ namespace kln
 {
     point out;
     detail::extPB(a.p0_, b.p1_, out.p3_);
+    KLN_VALIDATE_FINITE("plane ^ branch", out, a, b);
     return out;
 }
 
@@ -66,6 +69,7 @@ namespace kln
 {
     point out;
     detail::ext02(a.p0_, b.p2_, out.p3_);
+    KLN_VALIDATE_FINITE("plane ^ ideal_line", out, a, b);
     return out;
 }
 
@@ -81,6 +85,7 @@ namespace kln
     __m128 tmp;
     detail::ext02(a.p0_, b.p2_, tmp);
     out.p3_ = _mm_add_ps(tmp, out.p3_);
+    KLN_VALIDATE_FINITE("plane ^ line", out, a, b);
     return out;
 }
 
@@ -95,6 +100,7 @@ namespace kln
     detail::ext03<false>(a.p0_, b.p3_, tmp);
     dual out{0.f};
     _mm_store_ss(&out.q, tmp);
+    KLN_VALIDATE_FINITE("plane ^ point", out, a, b);
     return out;
 }
 
@@ -104,15 +110,18 @@ namespace kln
     detail::ext03<true>(a.p0_, b.p3_, tmp);
     dual out{0.f};
     _mm_store_ss(&out.q, tmp);
+    KLN_VALIDATE_FINITE("point ^ plane", out, b, a);
     return out;
 }
 
 [[nodiscard]] inline dual KLN_VEC_CALL operator^(branch a, ideal_line b) noexcept
 {
     __m128 dp = detail::hi_dp_ss(a.p1_, b.p2_);
-    float out;
-    _mm_store_ss(&out, dp);
-    return {0.f, out};
+    float q;
+    _mm_store_ss(&q, dp);
+    dual out{0.f, q};
+    KLN_VALIDATE_FINITE("branch ^ ideal_line", out, a, b);
+    return out;
 }
 
 [[nodiscard]] inline dual KLN_VEC_CALL operator^(ideal_line b, branch a) noexcept
@@ -123,11 +132,13 @@ namespace kln
 [[nodiscard]] inline dual KLN_VEC_CALL operator^(line a, line b) noexcept
 {
     __m128 dp = detail::hi_dp_ss(a.p1_, b.p2_);
-    float out[2];
-    _mm_store_ss(out, dp);
+    float q[2];
+    _mm_store_ss(q, dp);
     dp = detail::hi_dp_ss(b.p1_, a.p2_);
-    _mm_store_ss(out + 1, dp);
-    return {0.f, out[0] + out[1]};
+    _mm_store_ss(q + 1, dp);
+    dual out{0.f, q[0] + q[1]};
+    KLN_VALIDATE_FINITE("line ^ line", out, a, b);
+    return out;
 }
 
 [[nodiscard]] inline dual KLN_VEC_CALL operator^(line a, ideal_line b) noexcept
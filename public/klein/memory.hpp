@@ -0,0 +1,450 @@
+#pragma once
+
+#include "batch_policy.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#ifdef KLEIN_VALIDATE
+#    include <cassert>
+#endif
+
+#ifdef _WIN32
+#    include "detail/windows.hpp"
+#else
+#    include <sys/mman.h>
+#endif
+
+namespace kln
+{
+/// \defgroup memory Memory
+///
+/// Every entity holds `__m128` members and so requires 16 byte alignment.
+/// Since C++17, `std::allocator` honors this, but cache line alignment is
+/// still preferable for large arrays: no cache line is shared between two
+/// arrays (or two threads, see `kln::parallel::apply`), and a streaming
+/// store always fills whole lines. This header provides the pieces needed to
+/// allocate entity arrays explicitly with that guarantee.
+///
+/// - `kln::aligned_allocator` and `kln::aligned_vector` for standard
+///   containers.
+/// - `kln::arena`, a bump allocator handing out cache line aligned arrays
+///   from a single block, optionally backed by huge pages to reduce TLB
+///   misses when streaming through very large arrays.
+/// - `kln::aligned_span`, a pointer and count whose pointer is known to be
+///   cache line aligned, accepted by `kln::apply`.
+///
+/// The rest of the library never allocates, and this header is not included
+/// by `klein/klein.hpp`. Allocation failure in `aligned_allocator` throws
+/// `std::bad_alloc`, as standard containers expect of an allocator, while the
+/// arena (which never throws) returns an empty span.
+///
+/// !!! example
+///
+///     ```c++
+///         #include <klein/memory.hpp>
+///
+///         // 1 GiB arena, backed by 2 MiB pages if the system permits
+///         kln::arena a{1 << 30, kln::arena_pages::huge};
+///         kln::aligned_span<kln::point> points = a.allocate<kln::point>(n);
+///
+///         // ... fill points ...
+///
+///         kln::apply(m, points, points);
+///     ```
+
+/// \addtogroup memory
+/// @{
+
+constexpr size_t cache_line_size = 64;
+
+/// Size of the huge pages requested by an `arena` (2 MiB on x86-64)
+constexpr size_t huge_page_size = size_t{1} << 21;
+
+/// Standard allocator returning memory aligned to `Alignment` bytes (a cache
+/// line by default). Allocation failure throws `std::bad_alloc`.
+template <typename T, size_t Alignment = cache_line_size>
+struct aligned_allocator
+{
+    static_assert((Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of two");
+    static_assert(Alignment >= alignof(T),
+                  "Alignment must not be weaker than that of the type");
+
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() noexcept = default;
+
+    template <typename U>
+    aligned_allocator(aligned_allocator<U, Alignment> const&) noexcept
+    {}
+
+    /// Throws `std::bad_alloc` on failure, as containers expect of an
+    /// allocator
+    [[nodiscard]] T* allocate(size_t count)
+    {
+        return static_cast<T*>(
+            ::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* p, size_t) noexcept
+    {
+        ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    [[nodiscard]] bool
+    operator==(aligned_allocator<U, Alignment> const&) const noexcept
+    {
+        return true;
+    }
+
+    template <typename U>
+    [[nodiscard]] bool
+    operator!=(aligned_allocator<U, Alignment> const&) const noexcept
+    {
+        return false;
+    }
+};
+
+/// A `std::vector` whose storage is cache line aligned
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+/// A contiguous array of `count` elements starting at a cache line aligned
+/// address. Spans are obtained from an `aligned_vector` or an `arena`, or from
+/// any pointer known to be aligned (checked when `KLEIN_VALIDATE` is
+/// defined).
+template <typename T>
+struct aligned_span
+{
+    T* data      = nullptr;
+    size_t count = 0;
+
+    aligned_span() noexcept = default;
+
+    aligned_span(T* data_in, size_t count_in) noexcept
+        : data{data_in}
+        , count{count_in}
+    {
+#ifdef KLEIN_VALIDATE
+        assert(reinterpret_cast<uintptr_t>(data) % cache_line_size == 0
+               && "Span data must be cache line aligned");
+#endif
+    }
+
+    aligned_span(aligned_vector<T>& v) noexcept
+        : data{v.data()}
+        , count{v.size()}
+    {}
+
+    [[nodiscard]] T* begin() const noexcept
+    {
+        return data;
+    }
+
+    [[nodiscard]] T* end() const noexcept
+    {
+        return data + count;
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return count == 0;
+    }
+
+    [[nodiscard]] T& operator[](size_t i) const noexcept
+    {
+        return data[i];
+    }
+};
+
+enum class arena_pages
+{
+    /// Regular pages from the heap
+    normal,
+    /// Explicit huge pages where the system has them reserved (`MAP_HUGETLB`
+    /// on Linux, `MEM_LARGE_PAGES` on Windows), otherwise regular pages with
+    /// a hint to back them with transparent huge pages where supported
+    huge,
+};
+
+/// A bump allocator. Each allocation advances an offset into a single block,
+/// nothing is freed individually, and `reset` releases everything at once.
+/// Arrays handed out are cache line aligned. Since no destructors are run,
+/// only trivially destructible types (which includes all entities) may be
+/// allocated.
+class arena
+{
+public:
+    arena() noexcept = default;
+
+    /// Arena over caller provided storage which must outlive the arena. The
+    /// storage need not be aligned; any unaligned head is skipped.
+    arena(void* storage, size_t size) noexcept
+        : base_{static_cast<unsigned char*>(storage)}
+        , capacity_{size}
+    {}
+
+    /// Arena owning a block of `capacity` bytes. If the block could not be
+    /// allocated, the capacity of the arena is zero.
+    explicit arena(size_t capacity,
+                   arena_pages pages = arena_pages::normal) noexcept
+    {
+        if (capacity == 0)
+        {
+            return;
+        }
+
+        if (pages == arena_pages::huge)
+        {
+            // Huge page mappings must span whole pages
+            capacity = (capacity + huge_page_size - 1) & ~(huge_page_size - 1);
+#ifdef _WIN32
+            SIZE_T large = GetLargePageMinimum();
+            if (large != 0)
+            {
+                size_t size = (capacity + large - 1) & ~(large - 1);
+                base_       = static_cast<unsigned char*>(
+                    VirtualAlloc(nullptr,
+                                 size,
+                                 MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                 PAGE_READWRITE));
+                if (base_ != nullptr)
+                {
+                    capacity = size;
+                    huge_    = true;
+                }
+            }
+            if (base_ == nullptr)
+            {
+                base_ = static_cast<unsigned char*>(
+                    VirtualAlloc(nullptr,
+                                 capacity,
+                                 MEM_RESERVE | MEM_COMMIT,
+                                 PAGE_READWRITE));
+            }
+#else
+            void* data = MAP_FAILED;
+#    ifdef MAP_HUGETLB
+            data = ::mmap(nullptr,
+                          capacity,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                          -1,
+                          0);
+            huge_ = data != MAP_FAILED;
+#    endif
+            if (data == MAP_FAILED)
+            {
+                data = ::mmap(nullptr,
+                              capacity,
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS,
+                              -1,
+                              0);
+#    ifdef MADV_HUGEPAGE
+                if (data != MAP_FAILED)
+                {
+                    ::madvise(data, capacity, MADV_HUGEPAGE);
+                }
+#    endif
+            }
+            base_ = data == MAP_FAILED ? nullptr
+                                       : static_cast<unsigned char*>(data);
+#endif
+            owner_ = base_ == nullptr ? owner::none : owner::pages;
+        }
+        else
+        {
+            base_ = static_cast<unsigned char*>(
+                ::operator new(capacity,
+                               std::align_val_t{cache_line_size},
+                               std::nothrow));
+            owner_ = base_ == nullptr ? owner::none : owner::heap;
+        }
+        capacity_ = base_ == nullptr ? 0 : capacity;
+    }
+
+    arena(arena const&) = delete;
+    arena& operator=(arena const&) = delete;
+
+    arena(arena&& other) noexcept
+    {
+        *this = static_cast<arena&&>(other);
+    }
+
+    arena& operator=(arena&& other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            base_           = other.base_;
+            capacity_       = other.capacity_;
+            offset_         = other.offset_;
+            owner_          = other.owner_;
+            huge_           = other.huge_;
+            other.base_     = nullptr;
+            other.capacity_ = 0;
+            other.offset_   = 0;
+            other.owner_    = owner::none;
+            other.huge_     = false;
+        }
+        return *this;
+    }
+
+    ~arena() noexcept
+    {
+        release();
+    }
+
+    /// Allocate `size` bytes aligned to `alignment` (a power of two). Returns
+    /// `nullptr` if the arena is exhausted.
+    [[nodiscard]] void*
+    allocate_bytes(size_t size, size_t alignment = cache_line_size) noexcept
+    {
+        uintptr_t base  = reinterpret_cast<uintptr_t>(base_);
+        uintptr_t begin = (base + offset_ + alignment - 1) & ~(alignment - 1);
+        if (base_ == nullptr || begin - base > capacity_
+            || size > capacity_ - (begin - base))
+        {
+            return nullptr;
+        }
+        offset_ = begin - base + size;
+        return reinterpret_cast<void*>(begin);
+    }
+
+    /// Allocate a cache line aligned array of `count` default initialized
+    /// elements. Returns an empty span if the arena is exhausted.
+    template <typename T>
+    [[nodiscard]] aligned_span<T> allocate(size_t count) noexcept
+    {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "The arena does not run destructors");
+        if (count > capacity_ / sizeof(T))
+        {
+            return {};
+        }
+        void* data = allocate_bytes(count * sizeof(T));
+        if (data == nullptr)
+        {
+            return {};
+        }
+        T* out = static_cast<T*>(data);
+        std::uninitialized_default_construct_n(out, count);
+        return {out, count};
+    }
+
+    /// Release all allocations. The memory is retained for reuse.
+    void reset() noexcept
+    {
+        offset_ = 0;
+    }
+
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+        return capacity_;
+    }
+
+    /// Bytes consumed so far, including alignment padding
+    [[nodiscard]] size_t used() const noexcept
+    {
+        return offset_;
+    }
+
+    /// True if the arena is backed by explicit huge pages
+    [[nodiscard]] bool huge_pages() const noexcept
+    {
+        return huge_;
+    }
+
+private:
+    enum class owner
+    {
+        none,
+        heap,
+        pages,
+    };
+
+    void release() noexcept
+    {
+        if (owner_ == owner::heap)
+        {
+            ::operator delete(base_, std::align_val_t{cache_line_size});
+        }
+        else if (owner_ == owner::pages)
+        {
+#ifdef _WIN32
+            VirtualFree(base_, 0, MEM_RELEASE);
+#else
+            ::munmap(base_, capacity_);
+#endif
+        }
+        base_     = nullptr;
+        capacity_ = 0;
+        offset_   = 0;
+        owner_    = owner::none;
+        huge_     = false;
+    }
+
+    unsigned char* base_ = nullptr;
+    size_t capacity_     = 0;
+    size_t offset_       = 0;
+    owner owner_         = owner::none;
+    bool huge_           = false;
+};
+
+/// Apply the batch operator of `v` (a motor or rotor) to the elements of
+/// `in`, writing to the first `in.count` elements of `out`. The spans may be
+/// identical.
+template <typename V, typename T>
+auto apply(V const& v, aligned_span<T> in, aligned_span<T> out) noexcept
+    -> std::enable_if_t<std::is_invocable_v<V const&, T*, T*, size_t>>
+{
+#ifdef KLEIN_VALIDATE
+    assert(out.count >= in.count && "Output span is too small");
+#endif
+    v(in.data, out.data, in.count);
+}
+
+/// Apply the batch operator of `v` like the overload above, accessing memory
+/// as directed by `policy`. Aligned spans are the natural inputs of streaming
+/// transforms, whose non-temporal stores write whole cache lines at a time.
+template <typename V, typename T>
+auto apply(V const& v,
+           aligned_span<T> in,
+           aligned_span<T> out,
+           batch_policy policy) noexcept
+    -> std::enable_if_t<
+        std::is_invocable_v<V const&, T*, T*, size_t, batch_policy>>
+{
+#ifdef KLEIN_VALIDATE
+    assert(out.count >= in.count && "Output span is too small");
+#endif
+    v(in.data, out.data, in.count, policy);
+}
+
+/// Apply the batch operator of `v` to the elements of `data` in place
+template <typename V, typename T>
+auto apply(V const& v, aligned_span<T> data) noexcept
+    -> std::enable_if_t<std::is_invocable_v<V const&, T*, T*, size_t>>
+{
+    v(data.data, data.data, data.count);
+}
+/// @}
+} // namespace kln
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "batch_policy.hpp"
 #include "detail/exp_log.hpp"
 #include "detail/geometric_product.hpp"
 #include "detail/matrix.hpp"
+#include "detail/profile.hpp"
 #include "detail/sandwich.hpp"
 #include "detail/sse.hpp"
+#include "detail/validate.hpp"
 #include "direction.hpp"
 #include "line.hpp"
 #include "mat3x4.hpp"
@@ -97,6 +100,7 @@ public:
     /// provided Euclidean axis.
     motor(float ang_rad, float d, line l) noexcept
     {
+        KLN_VALIDATE_SIMPLE("motor(float, float, line)", l.p1_, l.p2_);
         line log_m;
         detail::gpDL(
             -ang_rad * 0.5f, d * 0.5f, l.p1_, l.p2_, log_m.p1_, log_m.p2_);
@@ -114,7 +118,7 @@ public:
     {}
 
     explicit KLN_VEC_CALL motor(translator t) noexcept
-        : p1_{_mm_setzero_ps()}
+        : p1_{_mm_set_ss(1.f)}
         , p2_{t.p2_}
     {}
 
@@ -127,7 +131,7 @@ public:
 
     motor& KLN_VEC_CALL operator=(translator t) noexcept
     {
-        p1_ = _mm_setzero_ps();
+        p1_ = _mm_set_ss(1.f);
         p2_ = t.p2_;
         return *this;
     }
@@ -191,6 +195,24 @@ public:
         return out;
     }
 
+    /// Normalizes this motor $m$ such that $m\widetilde{m} = 1$ using a full
+    /// precision square root and division. Prefer this over `normalize` for
+    /// motors that are repeatedly renormalized (for example, motors that are
+    /// incrementally updated by an iterative solver) so that the approximation
+    /// error of `rsqrtps` does not accumulate.
+    void normalize_precise() noexcept
+    {
+        // See normalize for the derivation
+        __m128 b2 = detail::dp_bc(p1_, p1_);
+        __m128 s  = _mm_div_ps(_mm_set1_ps(1.f), _mm_sqrt_ps(b2));
+        __m128 bc = detail::dp_bc(_mm_xor_ps(p1_, _mm_set_ss(-0.f)), p2_);
+        __m128 t  = _mm_mul_ps(_mm_div_ps(bc, b2), s);
+
+        __m128 tmp = _mm_mul_ps(p2_, s);
+        p2_ = _mm_sub_ps(tmp, _mm_xor_ps(_mm_mul_ps(p1_, t), _mm_set_ss(-0.f)));
+        p1_ = _mm_mul_ps(p1_, s);
+    }
+
     /// Bitwise comparison
     [[nodiscard]] bool KLN_VEC_CALL operator==(motor other) const noexcept
     {
@@ -237,8 +259,10 @@ public:
     /// $mp\widetilde{m}$.
     [[nodiscard]] plane KLN_VEC_CALL operator()(plane const& p) const noexcept
     {
+        KLN_VALIDATE_MOTOR("motor(plane)", p1_, p2_);
         plane out;
         detail::sw012<false, true>(&p.p0_, p1_, &p2_, &out.p0_);
+        KLN_VALIDATE_FINITE("motor(plane)", out, *this, p);
         return out;
     }
 
@@ -254,15 +278,36 @@ public:
     void KLN_VEC_CALL operator()(plane* in, plane* out, size_t count) const
         noexcept
     {
+        KLN_PROFILE_SCOPE(motor_planes, count);
+        KLN_VALIDATE_MOTOR("motor(plane*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(plane*)", in, out, count, *this);
         detail::sw012<true, true>(&in->p0_, p1_, &p2_, &out->p0_, count);
     }
 
+    /// Conjugates an array of planes like the operator above, accessing memory
+    /// as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(plane* in,
+                                 plane* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(motor_planes, count);
+        KLN_VALIDATE_MOTOR("motor(plane*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(plane*)", in, out, count, *this);
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::sw012<true, true>(
+                &in->p0_, p1_, &p2_, &out->p0_, count, access);
+        });
+    }
+
     /// Conjugates a line $\ell$ with this motor and returns the result
     /// $m\ell \widetilde{m}$.
     [[nodiscard]] line KLN_VEC_CALL operator()(line const& l) const noexcept
     {
+        KLN_VALIDATE_MOTOR("motor(line)", p1_, p2_);
         line out;
         detail::swMM<false, true, true>(&l.p1_, p1_, &p2_, &out.p1_);
+        KLN_VALIDATE_FINITE("motor(line)", out, *this, l);
         return out;
     }
 
@@ -277,15 +322,36 @@ public:
     ///     each line individually.
     void KLN_VEC_CALL operator()(line* in, line* out, size_t count) const noexcept
     {
+        KLN_PROFILE_SCOPE(motor_lines, count);
+        KLN_VALIDATE_MOTOR("motor(line*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(line*)", in, out, count, *this);
         detail::swMM<true, true, true>(&in->p1_, p1_, &p2_, &out->p1_, count);
     }
 
+    /// Conjugates an array of lines like the operator above, accessing memory
+    /// as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(line* in,
+                                 line* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(motor_lines, count);
+        KLN_VALIDATE_MOTOR("motor(line*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(line*)", in, out, count, *this);
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::swMM<true, true, true>(
+                &in->p1_, p1_, &p2_, &out->p1_, count, access);
+        });
+    }
+
     /// Conjugates a point $p$ with this motor and returns the result
     /// $mp\widetilde{m}$.
     [[nodiscard]] point KLN_VEC_CALL operator()(point const& p) const noexcept
     {
+        KLN_VALIDATE_MOTOR("motor(point)", p1_, p2_);
         point out;
         detail::sw312<false, true>(&p.p3_, p1_, &p2_, &out.p3_);
+        KLN_VALIDATE_FINITE("motor(point)", out, *this, p);
         return out;
     }
 
@@ -301,15 +367,36 @@ public:
     void KLN_VEC_CALL operator()(point* in, point* out, size_t count) const
         noexcept
     {
+        KLN_PROFILE_SCOPE(motor_points, count);
+        KLN_VALIDATE_MOTOR("motor(point*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(point*)", in, out, count, *this);
         detail::sw312<true, true>(&in->p3_, p1_, &p2_, &out->p3_, count);
     }
 
+    /// Conjugates an array of points like the operator above, accessing memory
+    /// as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(point* in,
+                                 point* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(motor_points, count);
+        KLN_VALIDATE_MOTOR("motor(point*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(point*)", in, out, count, *this);
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::sw312<true, true>(
+                &in->p3_, p1_, &p2_, &out->p3_, count, access);
+        });
+    }
+
     /// Conjugates the origin $O$ with this motor and returns the result
     /// $mO\widetilde{m}$.
     [[nodiscard]] point KLN_VEC_CALL operator()(origin) const noexcept
     {
+        KLN_VALIDATE_MOTOR("motor(origin)", p1_, p2_);
         point out;
         out.p3_ = detail::swo12(p1_, p2_);
+        KLN_VALIDATE_FINITE("motor(origin)", out, *this);
         return out;
     }
 
@@ -321,8 +408,10 @@ public:
     [[nodiscard]] direction KLN_VEC_CALL operator()(direction const& d) const
         noexcept
     {
+        KLN_VALIDATE_MOTOR("motor(direction)", p1_, p2_);
         direction out;
         detail::sw312<false, false>(&d.p3_, p1_, nullptr, &out.p3_);
+        KLN_VALIDATE_FINITE("motor(direction)", out, *this, d);
         return out;
     }
 
@@ -341,9 +430,28 @@ public:
     void KLN_VEC_CALL operator()(direction* in, direction* out, size_t count) const
         noexcept
     {
+        KLN_PROFILE_SCOPE(motor_directions, count);
+        KLN_VALIDATE_MOTOR("motor(direction*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(direction*)", in, out, count, *this);
         detail::sw312<true, false>(&in->p3_, p1_, nullptr, &out->p3_, count);
     }
 
+    /// Conjugates an array of directions like the operator above, accessing
+    /// memory as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(direction* in,
+                                 direction* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(motor_directions, count);
+        KLN_VALIDATE_MOTOR("motor(direction*)", p1_, p2_);
+        KLN_VALIDATE_FINITE_ARRAY("motor(direction*)", in, out, count, *this);
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::sw312<true, false>(
+                &in->p3_, p1_, nullptr, &out->p3_, count, access);
+        });
+    }
+
     /// Motor addition
     motor& KLN_VEC_CALL operator+=(motor b) noexcept
     {
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "soa.hpp"
+
+#include <cstddef>
+
+namespace kln
+{
+/// \defgroup packet Packets
+///
+/// Coherent rays (a camera tile or the beams of a sensor) are naturally
+/// `kln::line`s, but operating on them one at a time leaves a quarter of the
+/// lanes of every `__m128` unused and shuffles on every product. A
+/// `line_packet` instead holds a fixed number of lines in SoA form, one
+/// `__m128` per Plücker coordinate and block of four lines, ordered
+/// $\mathbf{e}_{23}$, $\mathbf{e}_{31}$, $\mathbf{e}_{12}$,
+/// $\mathbf{e}_{01}$, $\mathbf{e}_{02}$, $\mathbf{e}_{03}$. The operations
+/// below then run at full SIMD width:
+///
+/// - `apply(m, packet)` conjugates every line with a motor or rotor. The
+///   coefficients of the sandwich are computed once per call, after which
+///   each block of four lines costs 27 (or, for rotors, 18) multiplies.
+/// - `p ^ packet` meets every line with a plane, producing a `point_packet`.
+/// - `line_packet::normalize` normalizes every line with full precision.
+///
+/// Packets are 4 or 8 lines wide. Eight wide packets are processed as two
+/// independent blocks of four, which hides the latency of the multiplies.
+///
+/// !!! example
+///
+///     ```c++
+///         #include <klein/packet.hpp>
+///
+///         kln::line_packet<8> rays{tile_rays, 8};
+///         rays = kln::apply(camera, rays);
+///         kln::point_packet<8> hits = ground ^ rays;
+///         hits.normalize();
+///     ```
+
+/// \addtogroup packet
+/// @{
+
+namespace detail
+{
+    inline float packet_lane(__m128 v, size_t i) noexcept
+    {
+        float lanes[4];
+        _mm_storeu_ps(lanes, v);
+        return lanes[i];
+    }
+} // namespace detail
+
+/// `Width` points in SoA form, ordered $x$, $y$, $z$, $w$ in each block of
+/// four
+template <size_t Width>
+class point_packet
+{
+public:
+    static_assert(Width == 4 || Width == 8, "Packets are 4 or 8 wide");
+
+    static constexpr size_t width  = Width;
+    static constexpr size_t blocks = Width / 4;
+
+    [[nodiscard]] point get(size_t i) const noexcept
+    {
+        float c[4];
+        for (size_t j = 0; j != 4; ++j)
+        {
+            c[j] = detail::packet_lane(blocks_[i / 4][j], i % 4);
+        }
+        return {_mm_set_ps(c[2], c[1], c[0], c[3])};
+    }
+
+    /// Write the first `count` points of the packet to `out`
+    void store(point* out, size_t count = Width) const noexcept
+    {
+        for (size_t k = 0; k != blocks; ++k)
+        {
+            // Partition order (w, x, y, z)
+            __m128 rows[4]
+                = {blocks_[k][3], blocks_[k][0], blocks_[k][1], blocks_[k][2]};
+            detail::soa_scatter(rows, out, count, k, &point::p3_);
+        }
+    }
+
+    /// Divide every point by its weight. Points at infinity (for example the
+    /// meet of a plane with a parallel line) produce infinities or NaNs.
+    void normalize() noexcept
+    {
+        for (size_t k = 0; k != blocks; ++k)
+        {
+            __m128 inv    = _mm_div_ps(_mm_set1_ps(1.f), blocks_[k][3]);
+            blocks_[k][0] = _mm_mul_ps(blocks_[k][0], inv);
+            blocks_[k][1] = _mm_mul_ps(blocks_[k][1], inv);
+            blocks_[k][2] = _mm_mul_ps(blocks_[k][2], inv);
+            blocks_[k][3] = _mm_set1_ps(1.f);
+        }
+    }
+
+    __m128 blocks_[blocks][4];
+};
+
+/// `Width` lines in SoA form, ordered $\mathbf{e}_{23}$, $\mathbf{e}_{31}$,
+/// $\mathbf{e}_{12}$, $\mathbf{e}_{01}$, $\mathbf{e}_{02}$, $\mathbf{e}_{03}$
+/// in each block of four
+template <size_t Width>
+class line_packet
+{
+public:
+    static_assert(Width == 4 || Width == 8, "Packets are 4 or 8 wide");
+
+    static constexpr size_t width  = Width;
+    static constexpr size_t blocks = Width / 4;
+
+    line_packet() noexcept
+    {
+        for (size_t k = 0; k != blocks; ++k)
+        {
+            for (size_t j = 0; j != 6; ++j)
+            {
+                blocks_[k][j] = _mm_setzero_ps();
+            }
+        }
+    }
+
+    /// Gather the first `count` lines of `in`. The remaining lines are zero.
+    line_packet(line const* in, size_t count = Width) noexcept
+    {
+        load(in, count);
+    }
+
+    /// Gather the first `count` lines of `in`. The remaining lines are zero.
+    void load(line const* in, size_t count = Width) noexcept
+    {
+        for (size_t k = 0; k != blocks; ++k)
+        {
+            // The scalar and pseudoscalar lanes of a line are zero
+            __m128 rows[4];
+            detail::soa_gather(in, count, k, &line::p1_, rows);
+            blocks_[k][0] = rows[1];
+            blocks_[k][1] = rows[2];
+            blocks_[k][2] = rows[3];
+            detail::soa_gather(in, count, k, &line::p2_, rows);
+            blocks_[k][3] = rows[1];
+            blocks_[k][4] = rows[2];
+            blocks_[k][5] = rows[3];
+        }
+    }
+
+    /// Write the first `count` lines of the packet to `out`
+    void store(line* out, size_t count = Width) const noexcept
+    {
+        for (size_t k = 0; k != blocks; ++k)
+        {
+            __m128 rows[4] = {
+                _mm_setzero_ps(), blocks_[k][0], blocks_[k][1], blocks_[k][2]};
+            detail::soa_scatter(rows, out, count, k, &line::p1_);
+            rows[0] = _mm_setzero_ps();
+            rows[1] = blocks_[k][3];
+            rows[2] = blocks_[k][4];
+            rows[3] = blocks_[k][5];
+            detail::soa_scatter(rows, out, count, k, &line::p2_);
+        }
+    }
+
+    [[nodiscard]] line get(size_t i) const noexcept
+    {
+        float c[6];
+        for (size_t j = 0; j != 6; ++j)
+        {
+            c[j] = detail::packet_lane(blocks_[i / 4][j], i % 4);
+        }
+        // The line constructor takes the ideal components first
+        return {c[3], c[4], c[5], c[0], c[1], c[2]};
+    }
+
+    /// Normalize every line such that $\ell^2 = -1$ (see `line::normalize`).
+    /// Full precision square roots and divisions are used.
+    void normalize() noexcept
+    {
+        for (size_t k = 0; k != blocks; ++k)
+        {
+            detail::normalize_lines4(blocks_[k]);
+        }
+    }
+
+    [[nodiscard]] line_packet normalized() const noexcept
+    {
+        line_packet out = *this;
+        out.normalize();
+        return out;
+    }
+
+    __m128 blocks_[blocks][6];
+};
+
+namespace detail
+{
+    template <bool Translate, size_t Width>
+    line_packet<Width> apply_packet(__m128 p1,
+                                    __m128 p2,
+                                    line_packet<Width> const& in) noexcept
+    {
+        __m128 m[8];
+        soa_broadcast(p1, p2, m);
+        soa_line_terms terms;
+        soa_terms<Translate>(m, terms);
+
+        line_packet<Width> out;
+        for (size_t k = 0; k != line_packet<Width>::blocks; ++k)
+        {
+            soa_sandwich<Translate>(terms, in.blocks_[k], out.blocks_[k]);
+        }
+        return out;
+    }
+} // namespace detail
+
+/// Conjugate every line of the packet with the motor `m`
+template <size_t Width>
+[[nodiscard]] line_packet<Width> apply(motor const& m,
+                                       line_packet<Width> const& l) noexcept
+{
+    return detail::apply_packet<true>(m.p1_, m.p2_, l);
+}
+
+/// Conjugate every line of the packet with the rotor `r`
+template <size_t Width>
+[[nodiscard]] line_packet<Width> apply(rotor const& r,
+                                       line_packet<Width> const& l) noexcept
+{
+    return detail::apply_packet<false>(r.p1_, _mm_setzero_ps(), l);
+}
+
+/// Meet every line of the packet with the plane `p` (see
+/// `operator^(plane, line)`)
+template <size_t Width>
+[[nodiscard]] point_packet<Width>
+operator^(plane p, line_packet<Width> const& l) noexcept
+{
+    __m128 pb[4];
+    pb[0] = KLN_SWIZZLE(p.p0_, 0, 0, 0, 0);
+    pb[1] = KLN_SWIZZLE(p.p0_, 1, 1, 1, 1);
+    pb[2] = KLN_SWIZZLE(p.p0_, 2, 2, 2, 2);
+    pb[3] = KLN_SWIZZLE(p.p0_, 3, 3, 3, 3);
+
+    point_packet<Width> out;
+    for (size_t k = 0; k != point_packet<Width>::blocks; ++k)
+    {
+        detail::meet_lines4(pb, l.blocks_[k], out.blocks_[k]);
+    }
+    return out;
+}
+
+template <size_t Width>
+[[nodiscard]] point_packet<Width>
+operator^(line_packet<Width> const& l, plane p) noexcept
+{
+    return p ^ l;
+}
+/// @}
+} // namespace kln
@@ -0,0 +1,456 @@
+#pragma once
+
+#include "detail/thread.hpp"
+#include "direction.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+#include "rotor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace kln
+{
+/// \defgroup parallel Parallel
+///
+/// The batch sandwich operators (`motor::operator()(point*, point*, size_t)`
+/// and friends) run on the calling thread. For very large arrays,
+/// `kln::parallel::apply` splits the array into chunks and distributes them
+/// across the threads of a `kln::parallel::pool`.
+///
+/// The pool is a small work-stealing pool. Each call divides the chunks
+/// evenly among the workers (the calling thread being one of them) so that
+/// every worker streams through a contiguous range. A worker that runs out of
+/// chunks steals the remaining ones from the back of the other workers'
+/// ranges, which balances load without contending on a shared counter. Chunks
+/// span 64 KiB and thus a whole number of cache lines, so no two workers ever
+/// write to the same line of a cache-line aligned output array.
+///
+/// On NUMA systems, pages are placed on the node of the thread that first
+/// writes them. `parallel::first_touch` initializes a freshly allocated array
+/// with the exact partition used by `apply`, so that each worker subsequently
+/// finds most of its range in local memory. This only has an effect if the
+/// memory has not been written to before (memory from `std::malloc` or
+/// `new point[n]` rather than a value-initialized `std::vector`). Threads are
+/// not pinned to cores; pin the process (with `numactl`, for example) if the
+/// operating system migrates threads across nodes.
+///
+/// Batch transforms are bandwidth bound for arrays that exceed the last level
+/// cache (see the `klein_roofline` benchmark), so throughput scales with the
+/// number of threads until the memory bandwidth of the machine is saturated.
+///
+/// The pool also satisfies the requirements of an executor (see
+/// `kln::serial_executor`) and may be passed to `kd_tree::build` and
+/// `bvh::build`. Unlike the rest of the
+/// library, this header depends on `std::thread` and is not included by
+/// `klein/klein.hpp`.
+///
+/// !!! example
+///
+///     ```c++
+///         #include <klein/parallel.hpp>
+///
+///         kln::parallel::pool pool;
+///         kln::point* points = new kln::point[count];
+///         kln::parallel::first_touch(points, count, pool);
+///
+///         // ... fill points ...
+///
+///         kln::parallel::apply(m, points, points, count, pool);
+///     ```
+
+/// \addtogroup parallel
+/// @{
+namespace parallel
+{
+    /// A fixed size pool of worker threads. The thread calling into the pool
+    /// participates in the work, so a pool of size $n$ spawns $n - 1$
+    /// threads. Calls from different threads are serialized. Tasks must not
+    /// throw and must not call back into the pool that runs them.
+    class pool
+    {
+    public:
+        /// Create a pool of `threads` workers including the calling thread. A
+        /// count of zero uses `std::thread::hardware_concurrency()`. If the
+        /// system fails to create some of the threads, the pool makes do with
+        /// those it could create (down to running everything on the calling
+        /// thread), which `size` reflects.
+        explicit pool(size_t threads = 0) noexcept
+        {
+            if (threads == 0)
+            {
+                threads = std::thread::hardware_concurrency();
+            }
+            threads = threads == 0 ? 1 : threads;
+
+            ranges_ = std::make_unique<range[]>(threads);
+            threads_.reserve(threads - 1);
+            for (size_t i = 1; i != threads; ++i)
+            {
+                std::thread t;
+                if (!kln::detail::start_thread(t, [this, i] { worker(i); }))
+                {
+                    break;
+                }
+                threads_.push_back(std::move(t));
+            }
+            // Workers only read the size once a job is published under the
+            // mutex, after the constructor has returned
+            size_ = threads_.size() + 1;
+        }
+
+        pool(pool const&) = delete;
+        pool& operator=(pool const&) = delete;
+
+        ~pool() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (std::thread& t : threads_)
+            {
+                t.join();
+            }
+        }
+
+        /// Number of workers, including the calling thread
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return size_;
+        }
+
+        /// Invoke `body(begin, end)` for consecutive ranges of at most `chunk`
+        /// elements covering `[0, count)`, and return once all invocations
+        /// have completed. Worker $i$ of $n$ initially owns chunks
+        /// $[ic/n, (i + 1)c/n)$ of the $c$ chunks.
+        template <typename F>
+        void for_each_chunk(size_t count, size_t chunk, F&& body) noexcept
+        {
+            if (count == 0)
+            {
+                return;
+            }
+            chunk         = chunk == 0 ? 1 : chunk;
+            size_t chunks = (count + chunk - 1) / chunk;
+            if (size_ == 1 || chunks == 1)
+            {
+                body(size_t{0}, count);
+                return;
+            }
+            // Chunk indices are packed as 32 bit integers
+            if (chunks > UINT32_MAX)
+            {
+                chunk  = (count + UINT32_MAX - 1) / UINT32_MAX;
+                chunks = (count + chunk - 1) / chunk;
+            }
+
+            using body_t = std::remove_reference_t<F>;
+            job j;
+            j.invoke = [](void* context, size_t begin, size_t end) {
+                (*static_cast<body_t*>(context))(begin, end);
+            };
+            j.context = const_cast<void*>(static_cast<void const*>(&body));
+            j.count   = count;
+            j.chunk   = chunk;
+            run(j, chunks);
+        }
+
+        /// Executor interface. Invokes `task(i)` exactly once for every `i`
+        /// in `[0, count)`.
+        template <typename F>
+        void operator()(size_t count, F&& task) noexcept
+        {
+            for_each_chunk(count, 1, [&task](size_t begin, size_t end) {
+                for (size_t i = begin; i != end; ++i)
+                {
+                    task(i);
+                }
+            });
+        }
+
+    private:
+        struct job
+        {
+            void (*invoke)(void*, size_t, size_t) = nullptr;
+            void* context                         = nullptr;
+            size_t count                          = 0;
+            size_t chunk                          = 0;
+        };
+
+        // The chunks [begin, end) remaining in a worker's range, packed as
+        // (begin << 32) | end. The owner takes chunks from the front and
+        // thieves take them from the back. Each range occupies its own cache
+        // line.
+        struct alignas(64) range
+        {
+            std::atomic<uint64_t> bounds{0};
+        };
+
+        static bool pop_front(range& r, uint64_t& chunk) noexcept
+        {
+            uint64_t bounds = r.bounds.load(std::memory_order_relaxed);
+            while (true)
+            {
+                uint64_t begin = bounds >> 32;
+                uint64_t end   = bounds & UINT32_MAX;
+                if (begin >= end)
+                {
+                    return false;
+                }
+                if (r.bounds.compare_exchange_weak(bounds,
+                                                   ((begin + 1) << 32) | end,
+                                                   std::memory_order_relaxed))
+                {
+                    chunk = begin;
+                    return true;
+                }
+            }
+        }
+
+        static bool pop_back(range& r, uint64_t& chunk) noexcept
+        {
+            uint64_t bounds = r.bounds.load(std::memory_order_relaxed);
+            while (true)
+            {
+                uint64_t begin = bounds >> 32;
+                uint64_t end   = bounds & UINT32_MAX;
+                if (begin >= end)
+                {
+                    return false;
+                }
+                if (r.bounds.compare_exchange_weak(bounds,
+                                                   (begin << 32) | (end - 1),
+                                                   std::memory_order_relaxed))
+                {
+                    chunk = end - 1;
+                    return true;
+                }
+            }
+        }
+
+        void run(job const& j, size_t chunks) noexcept
+        {
+            std::lock_guard<std::mutex> submit{submit_};
+            for (size_t i = 0; i != size_; ++i)
+            {
+                uint64_t begin = i * chunks / size_;
+                uint64_t end   = (i + 1) * chunks / size_;
+                ranges_[i].bounds.store((begin << 32) | end,
+                                        std::memory_order_relaxed);
+            }
+
+            // Publishing the job under the mutex orders the ranges above
+            // before any worker reads them
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                job_     = j;
+                pending_ = size_ - 1;
+                ++generation_;
+            }
+            wake_.notify_all();
+
+            work(0, j);
+
+            std::unique_lock<std::mutex> lock{mutex_};
+            done_.wait(lock, [this] { return pending_ == 0; });
+        }
+
+        void work(size_t self, job const& j) noexcept
+        {
+            uint64_t chunk;
+            while (pop_front(ranges_[self], chunk))
+            {
+                execute(j, chunk);
+            }
+            for (size_t k = 1; k != size_; ++k)
+            {
+                range& victim = ranges_[(self + k) % size_];
+                while (pop_back(victim, chunk))
+                {
+                    execute(j, chunk);
+                }
+            }
+        }
+
+        static void execute(job const& j, uint64_t chunk) noexcept
+        {
+            size_t begin = static_cast<size_t>(chunk) * j.chunk;
+            size_t end   = std::min(begin + j.chunk, j.count);
+            j.invoke(j.context, begin, end);
+        }
+
+        void worker(size_t self) noexcept
+        {
+            uint64_t seen = 0;
+            while (true)
+            {
+                job j;
+                {
+                    std::unique_lock<std::mutex> lock{mutex_};
+                    wake_.wait(lock,
+                               [&] { return stop_ || generation_ != seen; });
+                    if (stop_)
+                    {
+                        return;
+                    }
+                    seen = generation_;
+                    j    = job_;
+                }
+
+                work(self, j);
+
+                bool last;
+                {
+                    std::lock_guard<std::mutex> lock{mutex_};
+                    last = --pending_ == 0;
+                }
+                if (last)
+                {
+                    done_.notify_one();
+                }
+            }
+        }
+
+        size_t size_ = 1;
+        std::unique_ptr<range[]> ranges_;
+        std::vector<std::thread> threads_;
+
+        std::mutex submit_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        job job_;
+        uint64_t generation_ = 0;
+        size_t pending_      = 0;
+        bool stop_           = false;
+    };
+
+    namespace detail
+    {
+        // Elements per 64 KiB chunk. Since the entities are 16 or 32 bytes,
+        // every chunk is a whole number of cache lines.
+        template <typename T>
+        constexpr size_t chunk_elements = (size_t{1} << 16) / sizeof(T);
+
+        template <typename V, typename T>
+        void apply(V const& v, T* in, T* out, size_t count, pool& p) noexcept
+        {
+            p.for_each_chunk(
+                count, chunk_elements<T>, [&](size_t begin, size_t end) {
+                    v(in + begin, out + begin, end - begin);
+                });
+        }
+    } // namespace detail
+
+    /// Write zeros to `count` elements of `data` using the partition of
+    /// `apply` such that, on NUMA systems, each page is placed on the node of
+    /// the worker that will later transform it. Call this right after
+    /// allocating the array.
+    template <typename T>
+    void first_touch(T* data, size_t count, pool& p) noexcept
+    {
+        p.for_each_chunk(
+            count, detail::chunk_elements<T>, [data](size_t begin, size_t end) {
+                std::memset(static_cast<void*>(data + begin),
+                            0,
+                            (end - begin) * sizeof(T));
+            });
+    }
+
+    /// Apply `m` to `count` planes in parallel. As with the serial batch
+    /// operators, `in` and `out` may be the same array.
+    inline void apply(motor const& m,
+                      plane* in,
+                      plane* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(m, in, out, count, p);
+    }
+
+    /// Apply `m` to `count` lines in parallel
+    inline void apply(motor const& m,
+                      line* in,
+                      line* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(m, in, out, count, p);
+    }
+
+    /// Apply `m` to `count` points in parallel
+    inline void apply(motor const& m,
+                      point* in,
+                      point* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(m, in, out, count, p);
+    }
+
+    /// Apply `m` to `count` directions in parallel. Directions are only
+    /// rotated.
+    inline void apply(motor const& m,
+                      direction* in,
+                      direction* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(m, in, out, count, p);
+    }
+
+    /// Apply `r` to `count` planes in parallel
+    inline void apply(rotor const& r,
+                      plane* in,
+                      plane* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(r, in, out, count, p);
+    }
+
+    /// Apply `r` to `count` lines in parallel
+    inline void apply(rotor const& r,
+                      line* in,
+                      line* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(r, in, out, count, p);
+    }
+
+    /// Apply `r` to `count` points in parallel
+    inline void apply(rotor const& r,
+                      point* in,
+                      point* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(r, in, out, count, p);
+    }
+
+    /// Apply `r` to `count` directions in parallel
+    inline void apply(rotor const& r,
+                      direction* in,
+                      direction* out,
+                      size_t count,
+                      pool& p) noexcept
+    {
+        detail::apply(r, in, out, count, p);
+    }
+} // namespace parallel
+/// @}
+} // namespace kln
@@ -2,6 +2,7 @@
 
 #include "detail/sandwich.hpp"
 #include "detail/sse.hpp"
+#include "detail/validate.hpp"
 
 #include "line.hpp"
 #include "point.hpp"
@@ -120,6 +121,7 @@ public:
     {
         plane out;
         detail::sw00(p0_, p.p0_, out.p0_);
+        KLN_VALIDATE_FINITE("plane(plane)", out, *this, p);
         return out;
     }
 
@@ -133,6 +135,7 @@ public:
         __m128 p2_tmp;
         detail::sw20(p0_, l.p2_, p2_tmp);
         out.p2_ = _mm_add_ps(out.p2_, p2_tmp);
+        KLN_VALIDATE_FINITE("plane(line)", out, *this, l);
         return out;
     }
 
@@ -143,6 +146,7 @@ public:
     {
         point out;
         detail::sw30(p0_, p.p3_, out.p3_);
+        KLN_VALIDATE_FINITE("plane(point)", out, *this, p);
         return out;
     }
 
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "detail/profile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kln
+{
+/// \defgroup profile Profiling
+///
+/// Defining `KLEIN_PROFILE` (or configuring with the `KLEIN_PROFILE` CMake
+/// option) wraps the batch kernels in scoped probes:
+///
+/// - the variadic sandwich operators of `motor` and `rotor` applied to
+///   arrays of planes, lines, points, and directions,
+/// - `motor_spline::evaluate`,
+/// - the `rigid_body` integrators,
+/// - the products of `soa.hpp`: `apply` with a single motor or rotor, `apply`
+///   with a `motor_soa`, and `multiply`,
+/// - the packed array and vertex buffer transforms of `interop.hpp`,
+/// - the FP16 and snorm16 transforms of `compact.hpp`, which charge the
+///   decoding and encoding to the same probe.
+///
+/// Each probe accumulates the number of calls, the number of elements
+/// processed, and the elapsed time of its kernel. On Linux, the probes also
+/// read hardware counters through `perf_event_open`: cycles, instructions
+/// retired, L1 data cache read misses, and last level cache misses. Together
+/// these distinguish front-end or port bound kernels (low instructions per
+/// cycle with few misses) from memory bound ones. Counters unavailable to the
+/// process (check `/proc/sys/kernel/perf_event_paranoid`) read as zero.
+///
+/// The statistics are process wide and safe to query from any thread. When
+/// `KLEIN_PROFILE` is not defined, the probes compile to nothing and the
+/// functions below report empty statistics.
+///
+/// !!! example
+///
+///     ```c++
+///         kln::profile::reset();
+///         motor(points, points, count);
+///
+///         kln::profile::stats s
+///             = kln::profile::get(kln::profile::kernel::motor_points);
+///         double ipc = double(s.instructions) / s.cycles;
+///         double misses_per_element = double(s.l1d_misses) / s.elements;
+///     ```
+
+/// \addtogroup profile
+/// @{
+namespace profile
+{
+    using kernel = detail::profile_kernel;
+
+    struct stats
+    {
+        uint64_t calls        = 0;
+        uint64_t elements     = 0;
+        uint64_t nanoseconds  = 0;
+        uint64_t cycles       = 0;
+        uint64_t instructions = 0;
+        uint64_t l1d_misses   = 0;
+        uint64_t llc_misses   = 0;
+    };
+
+    /// True if the probes are compiled in
+    [[nodiscard]] constexpr bool enabled() noexcept
+    {
+#ifdef KLEIN_PROFILE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /// True if hardware counters could be opened on the calling thread
+    [[nodiscard]] inline bool counters_available() noexcept
+    {
+#ifdef KLEIN_PROFILE
+        return detail::thread_profile_counters().available();
+#else
+        return false;
+#endif
+    }
+
+    [[nodiscard]] constexpr char const* name(kernel k) noexcept
+    {
+        switch (k)
+        {
+        case kernel::motor_planes:
+            return "motor_planes";
+        case kernel::motor_lines:
+            return "motor_lines";
+        case kernel::motor_points:
+            return "motor_points";
+        case kernel::motor_directions:
+            return "motor_directions";
+        case kernel::rotor_planes:
+            return "rotor_planes";
+        case kernel::rotor_lines:
+            return "rotor_lines";
+        case kernel::rotor_points:
+            return "rotor_points";
+        case kernel::rotor_directions:
+            return "rotor_directions";
+        case kernel::motor_spline_evaluate:
+            return "motor_spline_evaluate";
+        case kernel::rigid_body_integrate:
+            return "rigid_body_integrate";
+        case kernel::soa_apply:
+            return "soa_apply";
+        case kernel::soa_apply_motors:
+            return "soa_apply_motors";
+        case kernel::soa_multiply:
+            return "soa_multiply";
+        case kernel::interop_apply:
+            return "interop_apply";
+        case kernel::compact_apply:
+            return "compact_apply";
+        default:
+            return "unknown";
+        }
+    }
+
+    /// Statistics accumulated by a kernel since the last `reset`
+    [[nodiscard]] inline stats get([[maybe_unused]] kernel k) noexcept
+    {
+        stats out;
+#ifdef KLEIN_PROFILE
+        detail::profile_entry const& entry
+            = detail::profile_table[static_cast<size_t>(k)];
+        out.calls        = entry.calls.load(std::memory_order_relaxed);
+        out.elements     = entry.elements.load(std::memory_order_relaxed);
+        out.nanoseconds  = entry.nanoseconds.load(std::memory_order_relaxed);
+        out.cycles       = entry.counters[detail::profile_cycles].load(
+            std::memory_order_relaxed);
+        out.instructions = entry.counters[detail::profile_instructions].load(
+            std::memory_order_relaxed);
+        out.l1d_misses   = entry.counters[detail::profile_l1d_misses].load(
+            std::memory_order_relaxed);
+        out.llc_misses   = entry.counters[detail::profile_llc_misses].load(
+            std::memory_order_relaxed);
+#endif
+        return out;
+    }
+
+    /// Invoke `f(kernel, stats const&)` for every kernel called at least once
+    template <typename F>
+    void for_each(F&& f)
+    {
+        for (uint32_t i = 0; i != static_cast<uint32_t>(kernel::count); ++i)
+        {
+            kernel k = static_cast<kernel>(i);
+            stats s  = get(k);
+            if (s.calls != 0)
+            {
+                f(k, s);
+            }
+        }
+    }
+
+    /// Clear the statistics of every kernel
+    inline void reset() noexcept
+    {
+#ifdef KLEIN_PROFILE
+        for (detail::profile_entry& entry : detail::profile_table)
+        {
+            entry.calls.store(0, std::memory_order_relaxed);
+            entry.elements.store(0, std::memory_order_relaxed);
+            entry.nanoseconds.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint64_t>& counter : entry.counters)
+            {
+                counter.store(0, std::memory_order_relaxed);
+            }
+        }
+#endif
+    }
+} // namespace profile
+/// @}
+} // namespace kln
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "detail/reduce.hpp"
+#include "line.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+
+#include <cstddef>
+#include <type_traits>
+
+namespace kln
+{
+/// \defgroup reduce Reductions
+///
+/// Fitting and statistics code reduces inner products and distances over
+/// many entities. Calling `a | b` (or `p ^ x`) per element performs a
+/// horizontal add for every element, serializing the loop on the shuffles.
+/// The reductions in this header instead accumulate in full registers and
+/// reduce across lanes once at the end:
+///
+/// - `dot_sum`: $\sum_i a_i \cdot b_i$ over pairs of planes, points, or
+///   lines, agreeing with `operator|` elementwise.
+/// - `squared_distance_sum` and `max_distance`: the sum of squared and the
+///   largest distances of points from a plane (the $\mathbf{e}_{0123}$
+///   coefficient of `p ^ x`) or from a point.
+/// - `moments`: weighted zeroth, first, and second moments of points, from
+///   which centroids and covariances (and so least squares planes and
+///   principal axes) follow.
+///
+/// By default, sums accumulate in single precision with four (or eight)
+/// partial sums. Passing `summation::compensated` selects Kahan summation
+/// instead, whose error does not grow with the number of elements, at the
+/// cost of three additional adds per accumulation. Compensation is defeated
+/// by `-ffast-math` and equivalent flags.
+///
+/// Points are expected to be normalized ($w = 1$) wherever distances or
+/// moments are computed. Planes should be normalized for distances to be
+/// Euclidean.
+///
+/// !!! example
+///
+///     ```c++
+///         #include <klein/reduce.hpp>
+///
+///         // Root mean square residual of a plane fit
+///         float sum = kln::squared_distance_sum(
+///             fit, cloud.data(), cloud.size(), kln::summation::compensated);
+///         float rms = std::sqrt(sum / cloud.size());
+///     ```
+
+/// \addtogroup reduce
+/// @{
+
+/// Accumulation used by the sums of this header
+enum class summation
+{
+    /// Plain single precision sums
+    fast,
+    /// Kahan summation
+    compensated,
+};
+
+namespace detail
+{
+    template <typename F>
+    float dispatch_summation(summation s, F f) noexcept
+    {
+        return s == summation::compensated ? f(std::true_type{})
+                                           : f(std::false_type{});
+    }
+} // namespace detail
+
+/// $\sum_i a_i \cdot b_i$ for `count` pairs of planes (see
+/// `operator|(plane, plane)`)
+[[nodiscard]] inline float dot_sum(plane const* a,
+                                   plane const* b,
+                                   size_t count,
+                                   summation s = summation::fast) noexcept
+{
+    return detail::dispatch_summation(s, [&](auto compensated) {
+        return detail::reduce_products<decltype(compensated)::value, 1>(
+                   &a->p0_, &b->p0_, count)
+            .masked(_mm_castsi128_ps(_mm_set_epi32(-1, -1, -1, 0)))
+            .total();
+    });
+}
+
+/// $\sum_i a_i \cdot b_i$ for `count` pairs of points (see
+/// `operator|(point, point)`)
+[[nodiscard]] inline float dot_sum(point const* a,
+                                   point const* b,
+                                   size_t count,
+                                   summation s = summation::fast) noexcept
+{
+    return -detail::dispatch_summation(s, [&](auto compensated) {
+        return detail::reduce_products<decltype(compensated)::value, 1>(
+                   &a->p3_, &b->p3_, count)
+            .masked(_mm_castsi128_ps(_mm_set_epi32(0, 0, 0, -1)))
+            .total();
+    });
+}
+
+/// $\sum_i a_i \cdot b_i$ for `count` pairs of lines (see
+/// `operator|(line, line)`)
+[[nodiscard]] inline float dot_sum(line const* a,
+                                   line const* b,
+                                   size_t count,
+                                   summation s = summation::fast) noexcept
+{
+    // Only the Euclidean partition contributes and lines are two partitions
+    // wide
+    return -detail::dispatch_summation(s, [&](auto compensated) {
+        return detail::reduce_products<decltype(compensated)::value, 2>(
+                   &a->p1_, &b->p1_, count)
+            .masked(_mm_castsi128_ps(_mm_set_epi32(-1, -1, -1, 0)))
+            .total();
+    });
+}
+
+/// $\sum_i (p \wedge x_i)^2$, the sum of the squared distances of `count`
+/// points from the plane `p`
+[[nodiscard]] inline float
+squared_distance_sum(plane const& p,
+                     point const* points,
+                     size_t count,
+                     summation s = summation::fast) noexcept
+{
+    auto distance = [](__m128 const* q, __m128 const* x) {
+        __m128 d = detail::plane_distance4(q, x);
+        return _mm_mul_ps(d, d);
+    };
+    return detail::dispatch_summation(s, [&](auto compensated) {
+        return detail::reduce_points<decltype(compensated)::value, false>(
+            distance, p.p0_, &points->p3_, count);
+    });
+}
+
+/// The sum of the squared distances of `count` points from the point `c`
+[[nodiscard]] inline float
+squared_distance_sum(point const& c,
+                     point const* points,
+                     size_t count,
+                     summation s = summation::fast) noexcept
+{
+    return detail::dispatch_summation(s, [&](auto compensated) {
+        return detail::reduce_points<decltype(compensated)::value, false>(
+            detail::point_distance4, c.p3_, &points->p3_, count);
+    });
+}
+
+/// $\max_i |p \wedge x_i|$, the largest distance of `count` points from the
+/// plane `p`. Returns zero if `count` is zero.
+[[nodiscard]] inline float
+max_distance(plane const& p, point const* points, size_t count) noexcept
+{
+    auto distance = [](__m128 const* q, __m128 const* x) {
+        __m128 d = detail::plane_distance4(q, x);
+        return _mm_andnot_ps(_mm_set1_ps(-0.f), d);
+    };
+    return detail::reduce_points<false, true>(
+        distance, p.p0_, &points->p3_, count);
+}
+
+/// The largest distance of `count` points from the point `c`. Returns zero
+/// if `count` is zero.
+[[nodiscard]] inline float
+max_distance(point const& c, point const* points, size_t count) noexcept
+{
+    float squared = detail::reduce_points<false, true>(
+        detail::point_distance4, c.p3_, &points->p3_, count);
+    return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(squared)));
+}
+
+/// Weighted moments of a set of points
+struct point_moments
+{
+    /// $\sum_i w_i$
+    float weight = 0.f;
+    /// $\sum_i w_i x_i$, $\sum_i w_i y_i$, $\sum_i w_i z_i$
+    float first[3] = {};
+    /// $\sum_i w_i x_i x_i$, $\sum_i w_i x_i y_i$, $\sum_i w_i x_i z_i$,
+    /// $\sum_i w_i y_i y_i$, $\sum_i w_i y_i z_i$, $\sum_i w_i z_i z_i$
+    float second[6] = {};
+
+    /// The weighted mean of the points
+    [[nodiscard]] point centroid() const noexcept
+    {
+        float inv = 1.f / weight;
+        return {first[0] * inv, first[1] * inv, first[2] * inv};
+    }
+
+    /// The weighted covariance about the centroid as the upper triangle of
+    /// a symmetric matrix, in the order of `second`
+    void covariance(float* out) const noexcept
+    {
+        float inv     = 1.f / weight;
+        float mean[3] = {first[0] * inv, first[1] * inv, first[2] * inv};
+        size_t k      = 0;
+        for (size_t i = 0; i != 3; ++i)
+        {
+            for (size_t j = i; j != 3; ++j, ++k)
+            {
+                out[k] = second[k] * inv - mean[i] * mean[j];
+            }
+        }
+    }
+};
+
+/// Weighted moments of `count` normalized points. `weights` holds `count`
+/// weights, or is null to weigh every point by one.
+[[nodiscard]] inline point_moments
+moments(point const* points,
+        float const* weights,
+        size_t count,
+        summation s = summation::fast) noexcept
+{
+    float sums[10];
+    if (s == summation::compensated)
+    {
+        detail::reduce_moments<true>(&points->p3_, weights, count, sums);
+    }
+    else
+    {
+        detail::reduce_moments<false>(&points->p3_, weights, count, sums);
+    }
+
+    point_moments out;
+    out.weight = sums[0];
+    for (size_t i = 0; i != 3; ++i)
+    {
+        out.first[i] = sums[1 + i];
+    }
+    for (size_t i = 0; i != 6; ++i)
+    {
+        out.second[i] = sums[4 + i];
+    }
+    return out;
+}
+/// @}
+} // namespace kln
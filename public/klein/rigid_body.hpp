@@ -0,0 +1,335 @@
+#pragma once
+
+#include "detail/profile.hpp"
+#include "detail/soa.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+
+#include <cstddef>
+
+namespace kln
+{
+/// \defgroup rigid_body Rigid Body Integration
+///
+/// In PGA, the state of a rigid body is naturally described by a motor $M$
+/// taking the body frame to the world frame along with a velocity expressed
+/// as a line $B$ in the body frame. The Euclidean part of the line
+/// ($\mathbf{e}_{23}$, $\mathbf{e}_{31}$, $\mathbf{e}_{12}$) holds the angular
+/// velocity $\omega$ and the ideal part ($\mathbf{e}_{01}$,
+/// $\mathbf{e}_{02}$, $\mathbf{e}_{03}$) holds the linear velocity $v$ of the
+/// body origin such that the velocity of a body point $p$ is
+/// $\omega\times p + v$. The motor evolves according to
+///
+/// $$\dot{M} = -\frac{1}{2}MB$$
+///
+/// and over a step $\Delta t$ in which $B$ is constant, the motor is updated
+/// as $M \leftarrow M\exp{\left(-\frac{1}{2}\Delta t B\right)}$.
+///
+/// The `rigid_body` integrator advances many bodies at once. Bodies are
+/// stored in blocks of four with each component of the motor and velocity of
+/// the four bodies held in a single register (structure-of-arrays) so that
+/// the exponential, the geometric product, and the renormalization of four
+/// bodies proceed entirely in SIMD registers without shuffles or scalar
+/// transcendental calls. As elsewhere, the storage is provided by the caller.
+///
+/// Three steppers are provided:
+///
+/// - `integrate_kinematic` holds the velocity fixed (prescribed motion).
+/// - `integrate_symplectic` performs a semi-implicit Euler step of the torque
+///   free Euler equations, updating the velocity before the motor.
+/// - `integrate_rk4` advances the velocity with classical fourth order
+///   Runge-Kutta and the motor with the exponential of the Runge-Kutta
+///   weighted average velocity.
+///
+/// The dynamic steppers assume the body origin is the center of mass and the
+/// body axes are the principal axes of inertia. External forces and torques
+/// may be applied by updating the velocity between steps.
+///
+/// !!! example
+///
+///     ```c++
+///         std::vector<kln::rigid_body::block> storage(
+///             kln::rigid_body::block_count(count));
+///         kln::rigid_body bodies{storage.data(), count};
+///
+///         bodies.set_motor(0, kln::translator{1.f, 0.f, 0.f, 1.f});
+///         // Spin about the body z-axis while moving along the body x-axis
+///         bodies.set_rate(0, kln::line{2.f, 0.f, 0.f, 0.f, 0.f, 1.f});
+///         bodies.set_inertia(0, 1.f, 2.f, 3.f);
+///
+///         for (int i = 0; i != 60; ++i)
+///         {
+///             bodies.integrate_rk4(1.f / 60.f);
+///         }
+///         kln::motor m = bodies.get_motor(0);
+///     ```
+
+/// \addtogroup rigid_body
+/// @{
+class rigid_body final
+{
+public:
+    /// Four bodies stored component-wise. The motor components are ordered
+    /// `(1, e23, e31, e12, e0123, e01, e02, e03)` and the velocity components
+    /// `(e23, e31, e12, e01, e02, e03)`. The three Euler coefficients of a
+    /// body with principal moments $I_x$, $I_y$, and $I_z$ are
+    /// $(I_y - I_z)/I_x$, $(I_z - I_x)/I_y$, and $(I_x - I_y)/I_z$.
+    struct block
+    {
+        __m128 motor[8];
+        __m128 rate[6];
+        __m128 euler[3];
+    };
+
+    /// The number of blocks needed to store `count` bodies
+    [[nodiscard]] static constexpr size_t block_count(size_t count) noexcept
+    {
+        return (count + 3) / 4;
+    }
+
+    rigid_body() noexcept = default;
+
+    /// Manage `count` bodies stored in `storage`, which must point to
+    /// `block_count(count)` blocks that outlive the integrator. Every body is
+    /// reset to the identity motor at rest with isotropic inertia.
+    rigid_body(block* storage, size_t count) noexcept
+        : blocks_{storage}
+        , count_{count}
+    {
+        for (size_t i = 0; i != block_count(count); ++i)
+        {
+            block& b   = blocks_[i];
+            b.motor[0] = _mm_set1_ps(1.f);
+            for (size_t j = 1; j != 8; ++j)
+            {
+                b.motor[j] = _mm_setzero_ps();
+            }
+            for (size_t j = 0; j != 6; ++j)
+            {
+                b.rate[j] = _mm_setzero_ps();
+            }
+            for (size_t j = 0; j != 3; ++j)
+            {
+                b.euler[j] = _mm_setzero_ps();
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const noexcept
+    {
+        return count_;
+    }
+
+    [[nodiscard]] block* blocks() noexcept
+    {
+        return blocks_;
+    }
+
+    [[nodiscard]] motor get_motor(size_t i) const noexcept
+    {
+        float m[8];
+        for (size_t j = 0; j != 8; ++j)
+        {
+            m[j] = lane(blocks_[i / 4].motor[j], i % 4);
+        }
+        return {_mm_set_ps(m[3], m[2], m[1], m[0]),
+                _mm_set_ps(m[7], m[6], m[5], m[4])};
+    }
+
+    void KLN_VEC_CALL set_motor(size_t i, motor m) noexcept
+    {
+        float m1[4];
+        float m2[4];
+        _mm_storeu_ps(m1, m.p1_);
+        _mm_storeu_ps(m2, m.p2_);
+        block& b = blocks_[i / 4];
+        for (size_t j = 0; j != 4; ++j)
+        {
+            lane(b.motor[j], i % 4)     = m1[j];
+            lane(b.motor[j + 4], i % 4) = m2[j];
+        }
+    }
+
+    /// Return the body frame velocity of body `i`
+    [[nodiscard]] line get_rate(size_t i) const noexcept
+    {
+        block const& b = blocks_[i / 4];
+        return {lane(b.rate[3], i % 4),
+                lane(b.rate[4], i % 4),
+                lane(b.rate[5], i % 4),
+                lane(b.rate[0], i % 4),
+                lane(b.rate[1], i % 4),
+                lane(b.rate[2], i % 4)};
+    }
+
+    /// Set the body frame velocity of body `i`
+    void KLN_VEC_CALL set_rate(size_t i, line l) noexcept
+    {
+        float a[4];
+        float b[4];
+        _mm_storeu_ps(a, l.p1_);
+        _mm_storeu_ps(b, l.p2_);
+        block& blk = blocks_[i / 4];
+        for (size_t j = 0; j != 3; ++j)
+        {
+            lane(blk.rate[j], i % 4)     = a[j + 1];
+            lane(blk.rate[j + 3], i % 4) = b[j + 1];
+        }
+    }
+
+    /// Set the principal moments of inertia of body `i`. Only the ratios of
+    /// the moments affect the motion.
+    void set_inertia(size_t i, float ix, float iy, float iz) noexcept
+    {
+        block& b                = blocks_[i / 4];
+        lane(b.euler[0], i % 4) = (iy - iz) / ix;
+        lane(b.euler[1], i % 4) = (iz - ix) / iy;
+        lane(b.euler[2], i % 4) = (ix - iy) / iz;
+    }
+
+    /// Advance every motor by `dt` holding the velocities fixed.
+    void integrate_kinematic(float dt) noexcept
+    {
+        KLN_PROFILE_SCOPE(rigid_body_integrate, count_);
+        __m128 h = _mm_set1_ps(-0.5f * dt);
+        for (size_t i = 0; i != block_count(count_); ++i)
+        {
+            block& b = blocks_[i];
+            __m128 l[6];
+            for (size_t j = 0; j != 6; ++j)
+            {
+                l[j] = _mm_mul_ps(h, b.rate[j]);
+            }
+            advance(b, l);
+        }
+    }
+
+    /// Advance every body by `dt` with a semi-implicit Euler step. The
+    /// velocity is updated from the torque free Euler equations first, and
+    /// the motor is then advanced with the updated velocity.
+    void integrate_symplectic(float dt) noexcept
+    {
+        KLN_PROFILE_SCOPE(rigid_body_integrate, count_);
+        __m128 step = _mm_set1_ps(dt);
+        __m128 h    = _mm_set1_ps(-0.5f * dt);
+        for (size_t i = 0; i != block_count(count_); ++i)
+        {
+            block& b = blocks_[i];
+            __m128 k[6];
+            derivative(b.euler, b.rate, k);
+            __m128 l[6];
+            for (size_t j = 0; j != 6; ++j)
+            {
+                b.rate[j] = _mm_add_ps(b.rate[j], _mm_mul_ps(step, k[j]));
+                l[j]      = _mm_mul_ps(h, b.rate[j]);
+            }
+            advance(b, l);
+        }
+    }
+
+    /// Advance every body by `dt` with a fourth order Runge-Kutta step of the
+    /// torque free Euler equations. The motor is advanced with the
+    /// exponential of the weighted average of the four stage velocities.
+    void integrate_rk4(float dt) noexcept
+    {
+        KLN_PROFILE_SCOPE(rigid_body_integrate, count_);
+        __m128 half  = _mm_set1_ps(0.5f * dt);
+        __m128 full  = _mm_set1_ps(dt);
+        __m128 sixth = _mm_set1_ps(dt / 6.f);
+        __m128 two   = _mm_set1_ps(2.f);
+        __m128 h     = _mm_set1_ps(-0.5f * dt / 6.f);
+        for (size_t i = 0; i != block_count(count_); ++i)
+        {
+            block& b = blocks_[i];
+            __m128 stage[6];
+            __m128 k[6];
+            __m128 k_sum[6];
+            __m128 rate_sum[6];
+
+            derivative(b.euler, b.rate, k);
+            for (size_t j = 0; j != 6; ++j)
+            {
+                k_sum[j]    = k[j];
+                rate_sum[j] = b.rate[j];
+                stage[j]    = _mm_add_ps(b.rate[j], _mm_mul_ps(half, k[j]));
+            }
+
+            derivative(b.euler, stage, k);
+            for (size_t j = 0; j != 6; ++j)
+            {
+                k_sum[j]    = _mm_add_ps(k_sum[j], _mm_mul_ps(two, k[j]));
+                rate_sum[j]
+                    = _mm_add_ps(rate_sum[j], _mm_mul_ps(two, stage[j]));
+                stage[j]    = _mm_add_ps(b.rate[j], _mm_mul_ps(half, k[j]));
+            }
+
+            derivative(b.euler, stage, k);
+            for (size_t j = 0; j != 6; ++j)
+            {
+                k_sum[j]    = _mm_add_ps(k_sum[j], _mm_mul_ps(two, k[j]));
+                rate_sum[j]
+                    = _mm_add_ps(rate_sum[j], _mm_mul_ps(two, stage[j]));
+                stage[j]    = _mm_add_ps(b.rate[j], _mm_mul_ps(full, k[j]));
+            }
+
+            derivative(b.euler, stage, k);
+            __m128 l[6];
+            for (size_t j = 0; j != 6; ++j)
+            {
+                k_sum[j]    = _mm_add_ps(k_sum[j], k[j]);
+                rate_sum[j] = _mm_add_ps(rate_sum[j], stage[j]);
+                b.rate[j] = _mm_add_ps(b.rate[j], _mm_mul_ps(sixth, k_sum[j]));
+                l[j]      = _mm_mul_ps(h, rate_sum[j]);
+            }
+            advance(b, l);
+        }
+    }
+
+private:
+    [[nodiscard]] static float& lane(__m128& xmm, size_t i) noexcept
+    {
+        return reinterpret_cast<float*>(&xmm)[i];
+    }
+
+    [[nodiscard]] static float lane(__m128 const& xmm, size_t i) noexcept
+    {
+        return reinterpret_cast<float const*>(&xmm)[i];
+    }
+
+    // Torque free Euler equations in the body frame
+    //
+    // dw/dt = (euler0 w2 w3, euler1 w3 w1, euler2 w1 w2)
+    // dv/dt = v x w
+    static void derivative(__m128 const* KLN_RESTRICT euler,
+                           __m128 const* KLN_RESTRICT rate,
+                           __m128* KLN_RESTRICT out) noexcept
+    {
+        __m128 const* w = rate;
+        __m128 const* v = rate + 3;
+        out[0] = _mm_mul_ps(euler[0], _mm_mul_ps(w[1], w[2]));
+        out[1] = _mm_mul_ps(euler[1], _mm_mul_ps(w[2], w[0]));
+        out[2] = _mm_mul_ps(euler[2], _mm_mul_ps(w[0], w[1]));
+        out[3] = _mm_sub_ps(_mm_mul_ps(v[1], w[2]), _mm_mul_ps(v[2], w[1]));
+        out[4] = _mm_sub_ps(_mm_mul_ps(v[2], w[0]), _mm_mul_ps(v[0], w[2]));
+        out[5] = _mm_sub_ps(_mm_mul_ps(v[0], w[1]), _mm_mul_ps(v[1], w[0]));
+    }
+
+    // M <- M exp(l)
+    static void advance(block& b, __m128 const* l) noexcept
+    {
+        __m128 step[8];
+        __m128 m[8];
+        detail::exp4(l, step);
+        detail::gpMM4(b.motor, step, m);
+        detail::normalize4(m);
+        for (size_t j = 0; j != 8; ++j)
+        {
+            b.motor[j] = m[j];
+        }
+    }
+
+    block* blocks_ = nullptr;
+    size_t count_  = 0;
+};
+/// @}
+} // namespace kln
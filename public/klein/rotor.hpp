@@ -1,6 +1,9 @@
 #pragma once
 
+#include "batch_policy.hpp"
 #include "detail/matrix.hpp"
+#include "detail/profile.hpp"
+#include "detail/validate.hpp"
 #include "direction.hpp"
 #include "line.hpp"
 #include "mat4x4.hpp"
@@ -136,8 +139,10 @@ public:
     /// $rp\widetilde{r}$.
     [[nodiscard]] plane KLN_VEC_CALL operator()(plane const& p) const noexcept
     {
+        KLN_VALIDATE_ROTOR("rotor(plane)", p1_);
         plane out;
         detail::sw012<false, false>(&p.p0_, p1_, nullptr, &out.p0_);
+        KLN_VALIDATE_FINITE("rotor(plane)", out, *this, p);
         return out;
     }
 
@@ -153,13 +158,34 @@ public:
     void KLN_VEC_CALL operator()(plane* in, plane* out, size_t count) const
         noexcept
     {
+        KLN_PROFILE_SCOPE(rotor_planes, count);
+        KLN_VALIDATE_ROTOR("rotor(plane*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(plane*)", in, out, count, *this);
         detail::sw012<true, false>(&in->p0_, p1_, nullptr, &out->p0_, count);
     }
 
+    /// Conjugates an array of planes like the operator above, accessing memory
+    /// as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(plane* in,
+                                 plane* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(rotor_planes, count);
+        KLN_VALIDATE_ROTOR("rotor(plane*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(plane*)", in, out, count, *this);
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::sw012<true, false>(
+                &in->p0_, p1_, nullptr, &out->p0_, count, access);
+        });
+    }
+
     [[nodiscard]] branch KLN_VEC_CALL operator()(branch const& b) const noexcept
     {
+        KLN_VALIDATE_ROTOR("rotor(branch)", p1_);
         branch out;
         detail::swMM<false, false, false>(&b.p1_, p1_, nullptr, &out.p1_);
+        KLN_VALIDATE_FINITE("rotor(branch)", out, *this, b);
         return out;
     }
 
@@ -167,8 +193,10 @@ public:
     /// $r\ell \widetilde{r}$.
     [[nodiscard]] line KLN_VEC_CALL operator()(line const& l) const noexcept
     {
+        KLN_VALIDATE_ROTOR("rotor(line)", p1_);
         line out;
         detail::swMM<false, false, true>(&l.p1_, p1_, nullptr, &out.p1_);
+        KLN_VALIDATE_FINITE("rotor(line)", out, *this, l);
         return out;
     }
 
@@ -183,16 +211,37 @@ public:
     ///     each line individually.
     void KLN_VEC_CALL operator()(line* in, line* out, size_t count) const noexcept
     {
+        KLN_PROFILE_SCOPE(rotor_lines, count);
+        KLN_VALIDATE_ROTOR("rotor(line*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(line*)", in, out, count, *this);
         detail::swMM<true, false, true>(&in->p1_, p1_, nullptr, &out->p1_, count);
     }
 
+    /// Conjugates an array of lines like the operator above, accessing memory
+    /// as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(line* in,
+                                 line* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(rotor_lines, count);
+        KLN_VALIDATE_ROTOR("rotor(line*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(line*)", in, out, count, *this);
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::swMM<true, false, true>(
+                &in->p1_, p1_, nullptr, &out->p1_, count, access);
+        });
+    }
+
     /// Conjugates a point $p$ with this rotor and returns the result
     /// $rp\widetilde{r}$.
     [[nodiscard]] point KLN_VEC_CALL operator()(point const& p) const noexcept
     {
+        KLN_VALIDATE_ROTOR("rotor(point)", p1_);
         // NOTE: Conjugation of a plane and point with a rotor is identical
         point out;
         detail::sw012<false, false>(&p.p3_, p1_, nullptr, &out.p3_);
+        KLN_VALIDATE_FINITE("rotor(point)", out, *this, p);
         return out;
     }
 
@@ -208,18 +257,40 @@ public:
     void KLN_VEC_CALL operator()(point* in, point* out, size_t count) const
         noexcept
     {
+        KLN_PROFILE_SCOPE(rotor_points, count);
+        KLN_VALIDATE_ROTOR("rotor(point*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(point*)", in, out, count, *this);
         // NOTE: Conjugation of a plane and point with a rotor is identical
         detail::sw012<true, false>(&in->p3_, p1_, nullptr, &out->p3_, count);
     }
 
+    /// Conjugates an array of points like the operator above, accessing memory
+    /// as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(point* in,
+                                 point* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(rotor_points, count);
+        KLN_VALIDATE_ROTOR("rotor(point*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(point*)", in, out, count, *this);
+        // NOTE: Conjugation of a plane and point with a rotor is identical
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::sw012<true, false>(
+                &in->p3_, p1_, nullptr, &out->p3_, count, access);
+        });
+    }
+
     /// Conjugates a direction $d$ with this rotor and returns the result
     /// $rd\widetilde{r}$.
     [[nodiscard]] direction KLN_VEC_CALL operator()(direction const& d) const
         noexcept
     {
+        KLN_VALIDATE_ROTOR("rotor(direction)", p1_);
         direction out;
         // NOTE: Conjugation of a plane and point with a rotor is identical
         detail::sw012<false, false>(&d.p3_, p1_, nullptr, &out.p3_);
+        KLN_VALIDATE_FINITE("rotor(direction)", out, *this, d);
         return out;
     }
 
@@ -235,10 +306,30 @@ public:
     void KLN_VEC_CALL operator()(direction* in, direction* out, size_t count) const
         noexcept
     {
+        KLN_PROFILE_SCOPE(rotor_directions, count);
+        KLN_VALIDATE_ROTOR("rotor(direction*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(direction*)", in, out, count, *this);
         // NOTE: Conjugation of a plane and point with a rotor is identical
         detail::sw012<true, false>(&in->p3_, p1_, nullptr, &out->p3_, count);
     }
 
+    /// Conjugates an array of directions like the operator above, accessing
+    /// memory as directed by `policy` (see `kln::batch_policy`).
+    void KLN_VEC_CALL operator()(direction* in,
+                                 direction* out,
+                                 size_t count,
+                                 batch_policy policy) const noexcept
+    {
+        KLN_PROFILE_SCOPE(rotor_directions, count);
+        KLN_VALIDATE_ROTOR("rotor(direction*)", p1_);
+        KLN_VALIDATE_FINITE_ARRAY("rotor(direction*)", in, out, count, *this);
+        // NOTE: Conjugation of a plane and point with a rotor is identical
+        detail::with_access(policy, in == out, [&](auto access) {
+            detail::sw012<true, false>(
+                &in->p3_, p1_, nullptr, &out->p3_, count, access);
+        });
+    }
+
     /// Rotor addition
     rotor& KLN_VEC_CALL operator+=(rotor b) noexcept
     {
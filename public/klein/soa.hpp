@@ -0,0 +1,599 @@
+#pragma once
+
+#include "detail/profile.hpp"
+#include "detail/soa.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+#include "plane.hpp"
+#include "point.hpp"
+#include "rotor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifdef KLEIN_VALIDATE
+#    include <cassert>
+#endif
+
+namespace kln
+{
+/// \defgroup soa Structure of Arrays
+///
+/// Entities hold their components in one `__m128` per partition. This suits
+/// operations on individual entities, but in bulk it leaves lanes unused (a
+/// line fills six of eight lanes) and every sandwich product shuffles its
+/// operands. The containers in this header instead store each component in
+/// its own array of floats, the layout SIMD code elsewhere generally expects:
+///
+/// - `point_soa`: $x$, $y$, $z$, $w$
+/// - `plane_soa`: $x$, $y$, $z$, $d$
+/// - `line_soa`: $e_{23}$, $e_{31}$, $e_{12}$, $e_{01}$, $e_{02}$, $e_{03}$
+/// - `motor_soa`: $1$, $e_{23}$, $e_{31}$, $e_{12}$, $e_{0123}$, $e_{01}$,
+///   $e_{02}$, $e_{03}$
+///
+/// Like the rest of the library, the containers do not allocate. They are
+/// views over caller provided storage of `storage_size(count)` floats, which
+/// must be 16 byte aligned. Each array is padded to a multiple of 16 floats
+/// so that with cache line aligned storage (see `kln::aligned_vector`) every
+/// array begins on a cache line.
+///
+/// `pack` and `unpack` convert from and to arrays of entities by transposing
+/// blocks of four. `kln::apply` conjugates the contents of a container with a
+/// motor or rotor, in which case the sandwich product reduces to a few
+/// multiply-adds per component with no shuffles, or with a `motor_soa` of the
+/// same size, conjugating each entity with its own motor.
+///
+/// !!! example
+///
+///     ```c++
+///         #include <klein/soa.hpp>
+///
+///         kln::aligned_vector<float> storage(kln::point_soa::storage_size(n));
+///         kln::point_soa points{storage.data(), n};
+///         points.pack(cloud.data());
+///
+///         kln::apply(m, points, points);
+///         float const* x = points.x();
+///     ```
+
+/// \addtogroup soa
+/// @{
+
+namespace detail
+{
+    template <size_t Components>
+    class soa_array
+    {
+    public:
+        static constexpr size_t components = Components;
+
+        /// Floats between the starts of consecutive component arrays
+        [[nodiscard]] static constexpr size_t stride_of(size_t count) noexcept
+        {
+            return (count + 15) & ~size_t{15};
+        }
+
+        /// Floats of storage needed for `count` elements
+        [[nodiscard]] static constexpr size_t
+        storage_size(size_t count) noexcept
+        {
+            return Components * stride_of(count);
+        }
+
+        soa_array() noexcept = default;
+
+        soa_array(float* storage, size_t count) noexcept
+            : data_{storage}
+            , count_{count}
+            , stride_{stride_of(count)}
+        {
+#ifdef KLEIN_VALIDATE
+            assert(reinterpret_cast<uintptr_t>(storage) % 16 == 0
+                   && "SoA storage must be 16 byte aligned");
+#endif
+        }
+
+        [[nodiscard]] size_t size() const noexcept
+        {
+            return count_;
+        }
+
+        [[nodiscard]] size_t stride() const noexcept
+        {
+            return stride_;
+        }
+
+        /// The array of component `j`
+        [[nodiscard]] float* component(size_t j) const noexcept
+        {
+            return data_ + j * stride_;
+        }
+
+        // Blocks of four elements, the last of which may be partial
+        [[nodiscard]] size_t blocks() const noexcept
+        {
+            return (count_ + 3) / 4;
+        }
+
+        [[nodiscard]] __m128 load(size_t j, size_t block) const noexcept
+        {
+            return _mm_load_ps(data_ + j * stride_ + 4 * block);
+        }
+
+        void KLN_VEC_CALL store(size_t j, size_t block, __m128 v) const noexcept
+        {
+            _mm_store_ps(data_ + j * stride_ + 4 * block, v);
+        }
+
+    protected:
+        float* data_   = nullptr;
+        size_t count_  = 0;
+        size_t stride_ = 0;
+    };
+
+    // Transposes block k of the partition P of an entity array, reading
+    // zeros past the end
+    template <typename E>
+    KLN_INLINE void soa_gather(E const* in,
+                               size_t count,
+                               size_t k,
+                               __m128 E::*partition,
+                               __m128* rows) noexcept
+    {
+        for (size_t i = 0; i != 4; ++i)
+        {
+            rows[i] = 4 * k + i < count ? in[4 * k + i].*partition
+                                        : _mm_setzero_ps();
+        }
+        _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+    }
+
+    // Inverse of soa_gather, writing only the elements before the end
+    template <typename E>
+    KLN_INLINE void soa_scatter(__m128* rows,
+                                E* out,
+                                size_t count,
+                                size_t k,
+                                __m128 E::*partition) noexcept
+    {
+        _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+        for (size_t i = 0; i != 4 && 4 * k + i < count; ++i)
+        {
+            out[4 * k + i].*partition = rows[i];
+        }
+    }
+} // namespace detail
+
+/// Points stored as arrays of $x$, $y$, $z$, and $w$ coordinates
+class point_soa : public detail::soa_array<4>
+{
+public:
+    using soa_array::soa_array;
+
+    [[nodiscard]] float* x() const noexcept
+    {
+        return component(0);
+    }
+
+    [[nodiscard]] float* y() const noexcept
+    {
+        return component(1);
+    }
+
+    [[nodiscard]] float* z() const noexcept
+    {
+        return component(2);
+    }
+
+    [[nodiscard]] float* w() const noexcept
+    {
+        return component(3);
+    }
+
+    /// Fill the container with the first `size()` points of `in`
+    void pack(point const* in) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            // Partition order (w, x, y, z)
+            __m128 rows[4];
+            detail::soa_gather(in, count_, k, &point::p3_, rows);
+            store(0, k, rows[1]);
+            store(1, k, rows[2]);
+            store(2, k, rows[3]);
+            store(3, k, rows[0]);
+        }
+    }
+
+    /// Write the `size()` points of the container to `out`
+    void unpack(point* out) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            __m128 rows[4] = {load(3, k), load(0, k), load(1, k), load(2, k)};
+            detail::soa_scatter(rows, out, count_, k, &point::p3_);
+        }
+    }
+
+    [[nodiscard]] point get(size_t i) const noexcept
+    {
+        return {_mm_set_ps(z()[i], y()[i], x()[i], w()[i])};
+    }
+
+    void KLN_VEC_CALL set(size_t i, point p) const noexcept
+    {
+        x()[i] = p.x();
+        y()[i] = p.y();
+        z()[i] = p.z();
+        w()[i] = p.w();
+    }
+};
+
+/// Planes $ax + by + cz + d = 0$ stored as arrays of $a$, $b$, $c$, and $d$
+class plane_soa : public detail::soa_array<4>
+{
+public:
+    using soa_array::soa_array;
+
+    [[nodiscard]] float* x() const noexcept
+    {
+        return component(0);
+    }
+
+    [[nodiscard]] float* y() const noexcept
+    {
+        return component(1);
+    }
+
+    [[nodiscard]] float* z() const noexcept
+    {
+        return component(2);
+    }
+
+    [[nodiscard]] float* d() const noexcept
+    {
+        return component(3);
+    }
+
+    /// Fill the container with the first `size()` planes of `in`
+    void pack(plane const* in) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            // Partition order (d, x, y, z)
+            __m128 rows[4];
+            detail::soa_gather(in, count_, k, &plane::p0_, rows);
+            store(0, k, rows[1]);
+            store(1, k, rows[2]);
+            store(2, k, rows[3]);
+            store(3, k, rows[0]);
+        }
+    }
+
+    /// Write the `size()` planes of the container to `out`
+    void unpack(plane* out) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            __m128 rows[4] = {load(3, k), load(0, k), load(1, k), load(2, k)};
+            detail::soa_scatter(rows, out, count_, k, &plane::p0_);
+        }
+    }
+
+    [[nodiscard]] plane get(size_t i) const noexcept
+    {
+        return {x()[i], y()[i], z()[i], d()[i]};
+    }
+
+    void KLN_VEC_CALL set(size_t i, plane p) const noexcept
+    {
+        x()[i] = p.x();
+        y()[i] = p.y();
+        z()[i] = p.z();
+        d()[i] = p.d();
+    }
+};
+
+/// Lines stored as arrays of their six components, ordered $e_{23}$,
+/// $e_{31}$, $e_{12}$, $e_{01}$, $e_{02}$, $e_{03}$ (as in `line::p1_` and
+/// `line::p2_`)
+class line_soa : public detail::soa_array<6>
+{
+public:
+    using soa_array::soa_array;
+
+    /// Fill the container with the first `size()` lines of `in`
+    void pack(line const* in) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            // The scalar and pseudoscalar lanes of a line are zero
+            __m128 rows[4];
+            detail::soa_gather(in, count_, k, &line::p1_, rows);
+            store(0, k, rows[1]);
+            store(1, k, rows[2]);
+            store(2, k, rows[3]);
+            detail::soa_gather(in, count_, k, &line::p2_, rows);
+            store(3, k, rows[1]);
+            store(4, k, rows[2]);
+            store(5, k, rows[3]);
+        }
+    }
+
+    /// Write the `size()` lines of the container to `out`
+    void unpack(line* out) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            __m128 rows[4]
+                = {_mm_setzero_ps(), load(0, k), load(1, k), load(2, k)};
+            detail::soa_scatter(rows, out, count_, k, &line::p1_);
+            rows[0] = _mm_setzero_ps();
+            rows[1] = load(3, k);
+            rows[2] = load(4, k);
+            rows[3] = load(5, k);
+            detail::soa_scatter(rows, out, count_, k, &line::p2_);
+        }
+    }
+
+    [[nodiscard]] line get(size_t i) const noexcept
+    {
+        // The line constructor takes the ideal components first
+        return {component(3)[i],
+                component(4)[i],
+                component(5)[i],
+                component(0)[i],
+                component(1)[i],
+                component(2)[i]};
+    }
+
+    void KLN_VEC_CALL set(size_t i, line l) const noexcept
+    {
+        component(0)[i] = l.e23();
+        component(1)[i] = l.e31();
+        component(2)[i] = l.e12();
+        component(3)[i] = l.e01();
+        component(4)[i] = l.e02();
+        component(5)[i] = l.e03();
+    }
+};
+
+/// Motors stored as arrays of their eight components, ordered $1$, $e_{23}$,
+/// $e_{31}$, $e_{12}$, $e_{0123}$, $e_{01}$, $e_{02}$, $e_{03}$ (as in
+/// `motor::p1_` and `motor::p2_`)
+class motor_soa : public detail::soa_array<8>
+{
+public:
+    using soa_array::soa_array;
+
+    /// Fill the container with the first `size()` motors of `in`
+    void pack(motor const* in) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            __m128 rows[4];
+            detail::soa_gather(in, count_, k, &motor::p1_, rows);
+            for (size_t j = 0; j != 4; ++j)
+            {
+                store(j, k, rows[j]);
+            }
+            detail::soa_gather(in, count_, k, &motor::p2_, rows);
+            for (size_t j = 0; j != 4; ++j)
+            {
+                store(j + 4, k, rows[j]);
+            }
+        }
+    }
+
+    /// Write the `size()` motors of the container to `out`
+    void unpack(motor* out) const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            __m128 rows[4] = {load(0, k), load(1, k), load(2, k), load(3, k)};
+            detail::soa_scatter(rows, out, count_, k, &motor::p1_);
+            for (size_t j = 0; j != 4; ++j)
+            {
+                rows[j] = load(j + 4, k);
+            }
+            detail::soa_scatter(rows, out, count_, k, &motor::p2_);
+        }
+    }
+
+    [[nodiscard]] motor get(size_t i) const noexcept
+    {
+        float m[8];
+        for (size_t j = 0; j != 8; ++j)
+        {
+            m[j] = component(j)[i];
+        }
+        return {_mm_loadu_ps(m), _mm_loadu_ps(m + 4)};
+    }
+
+    void KLN_VEC_CALL set(size_t i, motor m) const noexcept
+    {
+        float buf[8];
+        _mm_storeu_ps(buf, m.p1_);
+        _mm_storeu_ps(buf + 4, m.p2_);
+        for (size_t j = 0; j != 8; ++j)
+        {
+            component(j)[i] = buf[j];
+        }
+    }
+
+    /// Normalize every motor (see `motor::normalize`). Full precision square
+    /// roots and divisions are used.
+    void normalize() const noexcept
+    {
+        for (size_t k = 0; k != blocks(); ++k)
+        {
+            __m128 m[8];
+            for (size_t j = 0; j != 8; ++j)
+            {
+                m[j] = load(j, k);
+            }
+            detail::normalize4(m);
+            for (size_t j = 0; j != 8; ++j)
+            {
+                store(j, k, m[j]);
+            }
+        }
+    }
+};
+
+namespace detail
+{
+    template <typename E>
+    struct soa_traits
+    {
+        static constexpr bool entity = false;
+    };
+
+    template <>
+    struct soa_traits<point_soa>
+    {
+        static constexpr bool entity = true;
+        using terms                  = soa_point_terms;
+    };
+
+    template <>
+    struct soa_traits<plane_soa>
+    {
+        static constexpr bool entity = true;
+        using terms                  = soa_plane_terms;
+    };
+
+    template <>
+    struct soa_traits<line_soa>
+    {
+        static constexpr bool entity = true;
+        using terms                  = soa_line_terms;
+    };
+
+    template <typename E>
+    using enable_if_soa_entity_t = std::enable_if_t<soa_traits<E>::entity>;
+
+    // Conjugates every block of `in` with the motor components m broadcast
+    // to all lanes
+    template <bool Translate, typename E>
+    void soa_apply(__m128 const* m, E const& in, E const& out) noexcept
+    {
+#ifdef KLEIN_VALIDATE
+        assert(out.size() >= in.size() && "Output container is too small");
+#endif
+        KLN_PROFILE_SCOPE(soa_apply, in.size());
+        typename soa_traits<E>::terms terms;
+        soa_terms<Translate>(m, terms);
+        for (size_t k = 0; k != in.blocks(); ++k)
+        {
+            __m128 block[E::components];
+            for (size_t j = 0; j != E::components; ++j)
+            {
+                block[j] = in.load(j, k);
+            }
+            soa_sandwich<Translate>(terms, block, block);
+            for (size_t j = 0; j != E::components; ++j)
+            {
+                out.store(j, k, block[j]);
+            }
+        }
+    }
+
+    // Splats each component of a motor across a register
+    KLN_INLINE void KLN_VEC_CALL soa_broadcast(__m128 p1,
+                                               __m128 p2,
+                                               __m128* m) noexcept
+    {
+        m[0] = KLN_SWIZZLE(p1, 0, 0, 0, 0);
+        m[1] = KLN_SWIZZLE(p1, 1, 1, 1, 1);
+        m[2] = KLN_SWIZZLE(p1, 2, 2, 2, 2);
+        m[3] = KLN_SWIZZLE(p1, 3, 3, 3, 3);
+        m[4] = KLN_SWIZZLE(p2, 0, 0, 0, 0);
+        m[5] = KLN_SWIZZLE(p2, 1, 1, 1, 1);
+        m[6] = KLN_SWIZZLE(p2, 2, 2, 2, 2);
+        m[7] = KLN_SWIZZLE(p2, 3, 3, 3, 3);
+    }
+} // namespace detail
+
+/// Conjugate the points, planes, or lines of `in` with the motor `m`, writing
+/// to `out`, which must be at least as large. The containers may be the same.
+template <typename E, typename = detail::enable_if_soa_entity_t<E>>
+void apply(motor const& m, E in, E out) noexcept
+{
+    __m128 components[8];
+    detail::soa_broadcast(m.p1_, m.p2_, components);
+    detail::soa_apply<true>(components, in, out);
+}
+
+/// Conjugate the points, planes, or lines of `in` with the rotor `r`
+template <typename E, typename = detail::enable_if_soa_entity_t<E>>
+void apply(rotor const& r, E in, E out) noexcept
+{
+    __m128 components[8];
+    detail::soa_broadcast(r.p1_, _mm_setzero_ps(), components);
+    detail::soa_apply<false>(components, in, out);
+}
+
+/// Conjugate the element `i` of `in` with the motor `i` of `m` for every `i`,
+/// writing to `out`. `m` must hold at least as many motors as `in` holds
+/// elements.
+template <typename E, typename = detail::enable_if_soa_entity_t<E>>
+void apply(motor_soa const& m, E in, E out) noexcept
+{
+#ifdef KLEIN_VALIDATE
+    assert(m.size() >= in.size() && "Too few motors");
+    assert(out.size() >= in.size() && "Output container is too small");
+#endif
+    KLN_PROFILE_SCOPE(soa_apply_motors, in.size());
+    for (size_t k = 0; k != in.blocks(); ++k)
+    {
+        __m128 components[8];
+        for (size_t j = 0; j != 8; ++j)
+        {
+            components[j] = m.load(j, k);
+        }
+        typename detail::soa_traits<E>::terms terms;
+        detail::soa_terms<true>(components, terms);
+
+        __m128 block[E::components];
+        for (size_t j = 0; j != E::components; ++j)
+        {
+            block[j] = in.load(j, k);
+        }
+        detail::soa_sandwich<true>(terms, block, block);
+        for (size_t j = 0; j != E::components; ++j)
+        {
+            out.store(j, k, block[j]);
+        }
+    }
+}
+
+/// Compose motors elementwise, storing $a_i b_i$ in `out`. The containers
+/// may be the same.
+inline void multiply(motor_soa a, motor_soa b, motor_soa out) noexcept
+{
+#ifdef KLEIN_VALIDATE
+    assert(b.size() >= a.size() && out.size() >= a.size()
+           && "Containers are too small");
+#endif
+    KLN_PROFILE_SCOPE(soa_multiply, a.size());
+    for (size_t k = 0; k != a.blocks(); ++k)
+    {
+        __m128 lhs[8];
+        __m128 rhs[8];
+        for (size_t j = 0; j != 8; ++j)
+        {
+            lhs[j] = a.load(j, k);
+            rhs[j] = b.load(j, k);
+        }
+        __m128 product[8];
+        detail::gpMM4(lhs, rhs, product);
+        for (size_t j = 0; j != 8; ++j)
+        {
+            out.store(j, k, product[j]);
+        }
+    }
+}
+/// @}
+} // namespace kln
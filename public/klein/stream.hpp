@@ -0,0 +1,326 @@
+#pragma once
+
+#include "detail/thread.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace kln
+{
+/// \defgroup stream Streaming
+///
+/// A `kln::stream` transforms data sets that do not fit in memory. Elements
+/// are read in fixed size chunks from a _source_, transformed in place, and
+/// passed to a _sink_. Reading, transforming, and writing run concurrently on
+/// three threads (the transform runs on the calling thread) which hand chunks
+/// to each other through a small ring of buffers. While the transform works on
+/// chunk $k$, chunk $k + 1$ is being read and chunk $k - 1$ is being written,
+/// so the throughput of the pipeline is that of its slowest stage (normally
+/// the disk) and no more than `buffers` chunks are ever resident.
+///
+/// Like the other containers of the library, the stream does not allocate.
+/// The caller provides storage for `chunk * buffers` elements.
+///
+/// A source is a callable `bool(T* dst, size_t max, size_t& count)` which
+/// reads up to `max` elements into `dst`, stores the number read in `count`,
+/// and returns false on error. Reading fewer than `max` elements signals the
+/// end of the data. A sink is a callable `bool(T const* src, size_t count)`
+/// returning false on error. `stream_file_source`, `stream_file_sink`, and
+/// `stream_memory_source` cover raw arrays of elements in files and in memory
+/// (a memory mapped file, for example). The transform is either a versor with
+/// a batch operator (a motor or rotor) or a callable `void(T* data, size_t
+/// count)`. A chain of motors can be applied by passing their product, or a
+/// callable applying each in turn.
+///
+/// !!! example
+///
+///     ```c++
+///         // 4 MiB chunks, triple buffered
+///         constexpr size_t chunk = (1 << 22) / sizeof(kln::point);
+///         std::vector<kln::point> storage(3 * chunk);
+///         kln::stream<kln::point> s{storage.data(), chunk, 3};
+///
+///         std::FILE* in  = std::fopen("cloud.bin", "rb");
+///         std::FILE* out = std::fopen("moved.bin", "wb");
+///         kln::stream_result r
+///             = s.run(kln::stream_file_source<kln::point>(in),
+///                     m,
+///                     kln::stream_file_sink<kln::point>(out));
+///     ```
+///
+/// !!! tip
+///
+///     The transform may itself be parallel (see `kln::parallel::apply`),
+///     which helps when reading from fast storage or memory.
+
+/// \addtogroup stream
+/// @{
+
+enum class stream_status
+{
+    ok,
+    read_error,
+    write_error,
+    /// The reader or writer thread could not be created. Nothing was written,
+    /// but the source may have been partially consumed.
+    thread_error,
+};
+
+struct stream_result
+{
+    stream_status status = stream_status::ok;
+    /// Number of elements transformed and written
+    uint64_t count = 0;
+};
+
+/// Source reading raw elements of type `T` from a binary file. A trailing
+/// partial element is ignored.
+template <typename T>
+[[nodiscard]] auto stream_file_source(std::FILE* file) noexcept
+{
+    return [file](T* dst, size_t max, size_t& count) {
+        count = std::fread(static_cast<void*>(dst), sizeof(T), max, file);
+        return count == max || std::ferror(file) == 0;
+    };
+}
+
+/// Sink writing raw elements of type `T` to a binary file
+template <typename T>
+[[nodiscard]] auto stream_file_sink(std::FILE* file) noexcept
+{
+    return [file](T const* src, size_t count) {
+        return std::fwrite(
+                   static_cast<void const*>(src), sizeof(T), count, file)
+               == count;
+    };
+}
+
+/// Source copying `count` elements from memory in chunks. When `data` is a
+/// memory mapped file, this touches each page once in order.
+template <typename T>
+[[nodiscard]] auto stream_memory_source(T const* data, size_t count) noexcept
+{
+    return [data, count, offset = size_t{0}](
+               T* dst, size_t max, size_t& read) mutable {
+        read = count - offset < max ? count - offset : max;
+        std::memcpy(static_cast<void*>(dst), data + offset, read * sizeof(T));
+        offset += read;
+        return true;
+    };
+}
+
+template <typename T>
+class stream
+{
+public:
+    static constexpr size_t max_buffers = 8;
+
+    /// The `storage` argument must point to at least `chunk * buffers`
+    /// elements and outlive the stream. The chunk size must be nonzero.
+    /// Between 2 and `max_buffers` buffers may be used. Two buffers let
+    /// reading overlap either the transform or writing, three let all stages
+    /// overlap, and more absorb variations in the latency of the source and
+    /// sink.
+    stream(T* storage, size_t chunk, size_t buffers = 3) noexcept
+        : storage_{storage}
+        , chunk_{chunk}
+        , buffers_{buffers < 2 ? 2
+                               : buffers > max_buffers ? max_buffers : buffers}
+    {}
+
+    [[nodiscard]] size_t chunk() const noexcept
+    {
+        return chunk_;
+    }
+
+    [[nodiscard]] size_t buffers() const noexcept
+    {
+        return buffers_;
+    }
+
+    /// Read all data from `source`, transform it, and write it to `sink`. On
+    /// error, the pipeline stops and the count of the result covers the
+    /// chunks written successfully. The source, sink, and transform must not
+    /// throw.
+    template <typename Source, typename Transform, typename Sink>
+    stream_result
+    run(Source&& source, Transform&& transform, Sink&& sink) noexcept
+    {
+        state s;
+        std::thread reader;
+        std::thread writer;
+        if (!detail::start_thread(reader, [&] { read(s, source); })
+            || !detail::start_thread(writer, [&] { write(s, sink); }))
+        {
+            {
+                std::lock_guard<std::mutex> lock{s.mutex};
+                s.stop = true;
+            }
+            s.changed.notify_all();
+            if (reader.joinable())
+            {
+                reader.join();
+            }
+            return {stream_status::thread_error, 0};
+        }
+
+        for (uint64_t k = 0;; ++k)
+        {
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock{s.mutex};
+                s.changed.wait(lock, [&] {
+                    return s.stop || k < s.read || s.read_done;
+                });
+                if (s.stop || k >= s.read)
+                {
+                    break;
+                }
+                count = s.sizes[k % buffers_];
+            }
+
+            T* data = buffer(k);
+            if constexpr (std::is_invocable_v<Transform&, T*, T*, size_t>)
+            {
+                transform(data, data, count);
+            }
+            else
+            {
+                transform(data, count);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{s.mutex};
+                s.computed = k + 1;
+            }
+            s.changed.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{s.mutex};
+            s.compute_done = true;
+        }
+        s.changed.notify_all();
+
+        reader.join();
+        writer.join();
+        return {s.status, s.written_count};
+    }
+
+private:
+    // Chunk k occupies buffer k % buffers. Each chunk is read, then
+    // transformed, then written, so written <= computed <= read and the reader
+    // may only reuse a buffer once its previous chunk has been written.
+    struct state
+    {
+        std::mutex mutex;
+        std::condition_variable changed;
+        size_t sizes[max_buffers] = {};
+        uint64_t read             = 0;
+        uint64_t computed         = 0;
+        uint64_t written          = 0;
+        uint64_t written_count    = 0;
+        bool read_done            = false;
+        bool compute_done         = false;
+        bool stop                 = false;
+        stream_status status      = stream_status::ok;
+    };
+
+    T* buffer(uint64_t k) const noexcept
+    {
+        return storage_ + (k % buffers_) * chunk_;
+    }
+
+    template <typename Source>
+    void read(state& s, Source& source) noexcept
+    {
+        for (uint64_t k = 0;; ++k)
+        {
+            {
+                std::unique_lock<std::mutex> lock{s.mutex};
+                s.changed.wait(
+                    lock, [&] { return s.stop || k < s.written + buffers_; });
+                if (s.stop)
+                {
+                    return;
+                }
+            }
+
+            size_t count = 0;
+            bool ok      = source(buffer(k), chunk_, count);
+
+            {
+                std::lock_guard<std::mutex> lock{s.mutex};
+                if (!ok)
+                {
+                    s.status = stream_status::read_error;
+                    s.stop   = true;
+                }
+                else
+                {
+                    s.sizes[k % buffers_] = count;
+                    s.read                = count == 0 ? k : k + 1;
+                    s.read_done           = count < chunk_;
+                }
+            }
+            s.changed.notify_all();
+            if (!ok || count < chunk_)
+            {
+                return;
+            }
+        }
+    }
+
+    template <typename Sink>
+    void write(state& s, Sink& sink) noexcept
+    {
+        for (uint64_t k = 0;; ++k)
+        {
+            size_t count;
+            {
+                std::unique_lock<std::mutex> lock{s.mutex};
+                s.changed.wait(lock, [&] {
+                    return s.stop || k < s.computed || s.compute_done;
+                });
+                if (s.stop || k >= s.computed)
+                {
+                    return;
+                }
+                count = s.sizes[k % buffers_];
+            }
+
+            bool ok = sink(static_cast<T const*>(buffer(k)), count);
+
+            {
+                std::lock_guard<std::mutex> lock{s.mutex};
+                if (!ok)
+                {
+                    s.status = stream_status::write_error;
+                    s.stop   = true;
+                }
+                else
+                {
+                    s.written = k + 1;
+                    s.written_count += count;
+                }
+            }
+            s.changed.notify_all();
+            if (!ok)
+            {
+                return;
+            }
+        }
+    }
+
+    T* storage_;
+    size_t chunk_;
+    size_t buffers_;
+};
+/// @}
+} // namespace kln
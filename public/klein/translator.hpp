@@ -1,6 +1,7 @@
 #pragma once
 
 #include "detail/matrix.hpp"
+#include "detail/validate.hpp"
 #include "line.hpp"
 #include "mat4x4.hpp"
 #include "plane.hpp"
@@ -89,6 +90,7 @@ public:
         __m128 tmp = _mm_add_ps(p2_, _mm_set_ss(1.f));
 #endif
         out.p0_ = detail::sw02(p.p0_, tmp);
+        KLN_VALIDATE_FINITE("translator(plane)", out, *this, p);
         return out;
     }
 
@@ -98,6 +100,7 @@ public:
     {
         line out;
         detail::swL2(l.p1_, l.p2_, p2_, &out.p1_);
+        KLN_VALIDATE_FINITE("translator(line)", out, *this, l);
         return out;
     }
 
@@ -107,6 +110,7 @@ public:
     {
         point out;
         out.p3_ = detail::sw32(p.p3_, p2_);
+        KLN_VALIDATE_FINITE("translator(point)", out, *this, p);
         return out;
     }
 
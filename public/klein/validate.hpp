@@ -0,0 +1,193 @@
+#pragma once
+
+#include "detail/validate.hpp"
+#include "line.hpp"
+#include "motor.hpp"
+#include "rotor.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kln
+{
+/// \defgroup validate Validation
+///
+/// Defining `KLEIN_VALIDATE` (or configuring with the `KLEIN_VALIDATE` CMake
+/// option) adds runtime checks to the following operations:
+///
+/// - the geometric, inner, and exterior products (and by extension the
+///   regressive product) verify that their operands and results are finite,
+/// - the sandwich operators of rotors, translators, motors, and planes verify
+///   the same of the versor, the operand, and the result. The variadic
+///   overloads of rotors and motors applied to arrays scan the whole input
+///   array before and the whole output array after the kernel runs, and
+///   report at most one violation per call,
+/// - the sandwich operators of rotors and motors (including the variadic
+///   overloads applied to arrays) measure how far the versor has drifted from
+///   $r\widetilde{r} = 1$ or $m\widetilde{m} = 1$,
+/// - constructing a screw motion `motor(ang_rad, d, axis)` measures how far
+///   the axis is from being a simple bivector ($\ell \wedge \ell = 0$).
+///
+/// Every check increments a thread local counter. A check whose error exceeds
+/// the tolerance (or is not finite) is a violation. Violations are counted per
+/// check and thread, and are passed to an optional process wide callback.
+/// Errors below the tolerance are not violations, but the largest error
+/// observed is tracked regardless so that slow drift is visible before it
+/// becomes a problem.
+///
+/// The checks consist of a few vector instructions and a well predicted branch
+/// and allocate nothing, so they may be enabled in canary builds. The cheapest
+/// products (motor composition, for example) become up to twice as slow, and
+/// the variadic overloads applied to arrays pay for two additional passes
+/// over memory. When `KLEIN_VALIDATE` is not defined, the checks compile to
+/// nothing, the statistics are empty, and the callback is never invoked. The
+/// error measures (`norm_error` and `simple_error`) are always available.
+///
+/// !!! tip
+///
+///     `motor::normalize` uses an approximate reciprocal square root and
+///     leaves a norm error of up to about $7\times 10^{-4}$, just below the
+///     default tolerance. Use `motor::normalize_precise` when lowering the
+///     tolerance.
+///
+/// !!! example
+///
+///     ```c++
+///         kln::validate::set_tolerance(1e-4f);
+///         kln::validate::set_callback(
+///             [](kln::validate::event const& e, void*) {
+///                 std::fprintf(stderr, "%s failed %s (error %g)\n",
+///                     e.site, kln::validate::name(e.check), e.error);
+///             });
+///
+///         point p2 = m(p1);
+///
+///         kln::validate::stats s = kln::validate::get();
+///         float drift = s.max_error[size_t(kln::validate::check::motor_norm)];
+///     ```
+
+/// \addtogroup validate
+/// @{
+namespace validate
+{
+    using check    = detail::validate_check;
+    using event    = detail::validate_event;
+    using callback = detail::validate_callback;
+
+    constexpr size_t check_count = static_cast<size_t>(check::count);
+
+    struct stats
+    {
+        /// Number of checks performed
+        uint64_t checks = 0;
+        /// Number of violations of each check
+        uint64_t violations[check_count] = {};
+        /// Largest error observed by each check, including errors below the
+        /// tolerance
+        float max_error[check_count] = {};
+    };
+
+    /// True if the checks are compiled in
+    [[nodiscard]] constexpr bool enabled() noexcept
+    {
+#ifdef KLEIN_VALIDATE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    [[nodiscard]] constexpr char const* name(check c) noexcept
+    {
+        switch (c)
+        {
+        case check::non_finite_input:
+            return "non_finite_input";
+        case check::non_finite_output:
+            return "non_finite_output";
+        case check::rotor_norm:
+            return "rotor_norm";
+        case check::motor_norm:
+            return "motor_norm";
+        case check::non_simple_line:
+            return "non_simple_line";
+        default:
+            return "unknown";
+        }
+    }
+
+    /// Install a callback invoked on the violating thread for every
+    /// violation. Pass `nullptr` to remove it. The callback must not throw.
+    inline void set_callback([[maybe_unused]] callback f,
+                             [[maybe_unused]] void* user = nullptr) noexcept
+    {
+#ifdef KLEIN_VALIDATE
+        detail::validate_user.store(user, std::memory_order_relaxed);
+        detail::validate_handler.store(f, std::memory_order_release);
+#endif
+    }
+
+    /// Set the error above which the norm and simplicity checks report a
+    /// violation (1e-3 by default)
+    inline void set_tolerance([[maybe_unused]] float tolerance) noexcept
+    {
+#ifdef KLEIN_VALIDATE
+        detail::validate_tolerance.store(tolerance, std::memory_order_relaxed);
+#endif
+    }
+
+    [[nodiscard]] inline float tolerance() noexcept
+    {
+#ifdef KLEIN_VALIDATE
+        return detail::validate_tolerance.load(std::memory_order_relaxed);
+#else
+        return 1e-3f;
+#endif
+    }
+
+    /// Statistics of the calling thread since its last `reset`
+    [[nodiscard]] inline stats get() noexcept
+    {
+        stats out;
+#ifdef KLEIN_VALIDATE
+        detail::validate_counters const& counters = detail::validate_thread;
+        out.checks = counters.checks;
+        for (size_t i = 0; i != check_count; ++i)
+        {
+            out.violations[i] = counters.violations[i];
+            out.max_error[i]  = counters.max_error[i];
+        }
+#endif
+        return out;
+    }
+
+    /// Clear the statistics of the calling thread
+    inline void reset() noexcept
+    {
+#ifdef KLEIN_VALIDATE
+        detail::validate_thread = detail::validate_counters{};
+#endif
+    }
+
+    /// $|r\widetilde{r} - 1|$
+    [[nodiscard]] inline float norm_error(rotor const& r) noexcept
+    {
+        return detail::rotor_norm_error(r.p1_);
+    }
+
+    /// The larger of the scalar and pseudoscalar deviations of
+    /// $m\widetilde{m}$ from $1$
+    [[nodiscard]] inline float norm_error(motor const& m) noexcept
+    {
+        return detail::motor_norm_error(m.p1_, m.p2_);
+    }
+
+    /// $|\ell \wedge \ell|$ relative to the product of the Euclidean and ideal
+    /// norms of the line. Zero for simple lines.
+    [[nodiscard]] inline float simple_error(line const& l) noexcept
+    {
+        return detail::simple_line_error(l.p1_, l.p2_);
+    }
+} // namespace validate
+/// @}
+} // namespace kln
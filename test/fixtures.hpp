@@ -0,0 +1,37 @@
+#pragma once
+
+// Operands and comparisons shared by the tests of the batch operators and of
+// the transforms built on them
+
+#include <klein/klein.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// A screw motion about an axis away from the origin
+inline kln::motor fixture_motor()
+{
+    kln::motor m{0.7f, 2.f, kln::line{1.f, -2.f, 0.5f, 0.2f, -0.4f, 0.8f}};
+    m.normalize_precise();
+    return m;
+}
+
+inline kln::rotor fixture_rotor()
+{
+    return kln::rotor{0.7f, 1.f, -2.f, 0.5f};
+}
+
+// Number of elements that differ bitwise. When the sizes differ, every
+// element of the longer vector without a counterpart counts as well.
+template <typename T, typename A, typename B>
+size_t mismatches(std::vector<T, A> const& a, std::vector<T, B> const& b)
+{
+    size_t common = a.size() < b.size() ? a.size() : b.size();
+    size_t out    = a.size() + b.size() - 2 * common;
+    for (size_t i = 0; i != common; ++i)
+    {
+        out += std::memcmp(&a[i], &b[i], sizeof(T)) == 0 ? 0 : 1;
+    }
+    return out;
+}
@@ -0,0 +1,101 @@
+#include <doctest/doctest.h>
+
+#include <klein/algorithm.hpp>
+#include <klein/klein.hpp>
+
+#include "fixtures.hpp"
+
+#include <array>
+#include <deque>
+#include <execution>
+#include <list>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// Spans several chunks of every entity
+constexpr size_t count = 3 * 4096 + 17;
+
+static_assert(detail::is_contiguous_iterator_v<point*>);
+static_assert(detail::is_contiguous_iterator_v<std::vector<point>::iterator>);
+static_assert(
+    detail::is_contiguous_iterator_v<std::array<line, 4>::const_iterator>);
+static_assert(!detail::is_contiguous_iterator_v<std::deque<point>::iterator>);
+static_assert(!detail::is_contiguous_iterator_v<std::list<point>::iterator>);
+static_assert(
+    !detail::is_contiguous_iterator_v<std::vector<point>::reverse_iterator>);
+
+// Compare each form of kln::transform against the batch operator
+template <typename T, typename V, typename F>
+void check_transform(V const& v, F&& make)
+{
+    std::vector<T> in(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        in[i] = make(static_cast<float>(i));
+    }
+    std::vector<T> expected(count);
+    v(in.data(), expected.data(), count);
+
+    std::vector<T> out(count);
+    auto end = kln::transform(in.begin(), in.end(), out.begin(), v);
+    CHECK_EQ(end - out.begin(), count);
+    CHECK_EQ(mismatches(expected, out), 0);
+
+    out.assign(count, T{});
+    end = kln::transform(
+        std::execution::seq, in.cbegin(), in.cend(), out.begin(), v);
+    CHECK_EQ(end - out.begin(), count);
+    CHECK_EQ(mismatches(expected, out), 0);
+
+    out.assign(count, T{});
+    kln::transform(
+        std::execution::unseq, in.begin(), in.end(), out.begin(), v);
+    CHECK_EQ(mismatches(expected, out), 0);
+
+    out.assign(count, T{});
+    kln::transform(
+        std::execution::par_unseq, in.begin(), in.end(), out.begin(), v);
+    CHECK_EQ(mismatches(expected, out), 0);
+
+    // In place
+    out = in;
+    kln::transform(std::execution::par, out.begin(), out.end(), out.begin(), v);
+    CHECK_EQ(mismatches(expected, out), 0);
+}
+
+template <typename V>
+void check_entities(V const& v)
+{
+    check_transform<point>(v, [](float x) { return point{x, -x, 0.5f * x}; });
+    check_transform<direction>(
+        v, [](float x) { return direction{1.f, x, -x}; });
+    check_transform<plane>(v, [](float x) { return plane{1.f, 2.f, x, -x}; });
+    check_transform<line>(
+        v, [](float x) { return line{x, 1.f, -x, 0.5f, x, 2.f}; });
+}
+} // namespace
+
+TEST_CASE("transform")
+{
+    motor m = fixture_motor();
+    rotor r = fixture_rotor();
+    check_entities(m);
+    check_entities(r);
+
+    // Plain arrays and empty ranges
+    std::array<point, 3> in{point{1.f, 0.f, 0.f},
+                            point{0.f, 1.f, 0.f},
+                            point{0.f, 0.f, 1.f}};
+    point out[3];
+    point* end = kln::transform(
+        std::execution::seq, in.begin(), in.end(), out, m);
+    CHECK_EQ(end, out + 3);
+    CHECK_EQ(out[1].x(), doctest::Approx(m(in[1]).x()));
+    CHECK_EQ(kln::transform(in.begin(), in.begin(), out, m), out);
+    CHECK_EQ(
+        kln::transform(std::execution::seq, in.begin(), in.begin(), out, m),
+        out);
+}
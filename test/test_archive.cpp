@@ -0,0 +1,246 @@
+#include <doctest/doctest.h>
+
+#include <klein/archive.hpp>
+#include <klein/klein.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// Memory with the alignment of a page mapping (up to 64 bytes)
+struct alignas(64) block
+{
+    unsigned char bytes[64];
+};
+
+struct buffer
+{
+    std::vector<block> blocks;
+    size_t size = 0;
+
+    unsigned char* data()
+    {
+        return blocks.front().bytes;
+    }
+};
+
+buffer read_all(std::FILE* file)
+{
+    buffer out;
+    std::fseek(file, 0, SEEK_END);
+    out.size = static_cast<size_t>(std::ftell(file));
+    out.blocks.resize(out.size / sizeof(block) + 1);
+    std::rewind(file);
+    out.size = std::fread(out.data(), 1, out.size, file);
+    return out;
+}
+
+struct scene
+{
+    std::vector<point> points;
+    std::vector<motor> motors;
+    std::vector<float> soa_lines;
+    size_t soa_line_count = 0;
+};
+
+scene make_scene()
+{
+    scene s;
+    for (int i = 0; i != 1000; ++i)
+    {
+        float x = static_cast<float>(i);
+        s.points.emplace_back(x, 2.f * x, -x);
+    }
+    for (int i = 0; i != 10; ++i)
+    {
+        float x = static_cast<float>(i);
+        s.motors.emplace_back(x, 1.f, line{1.f, x, 0.f, 0.f, 1.f, 0.f});
+    }
+    // Three blocks of four lines (six registers each)
+    s.soa_line_count = 11;
+    for (int i = 0; i != 18 * 4; ++i)
+    {
+        s.soa_lines.push_back(static_cast<float>(i / 4));
+    }
+    return s;
+}
+
+buffer write_scene(scene const& s)
+{
+    std::FILE* file = std::tmpfile();
+    archive_writer writer{file, 4};
+    CHECK_EQ(writer.add("points",
+                        s.points.data(),
+                        s.points.size(),
+                        {archive_layout::aos, 64, 4096}),
+             archive_status::ok);
+    CHECK_EQ(writer.add("motors",
+                        s.motors.data(),
+                        s.motors.size(),
+                        {archive_layout::aos, 4096, 0}),
+             archive_status::ok);
+    CHECK_EQ(writer.add("lines",
+                        archive_type::line,
+                        s.soa_lines.data(),
+                        s.soa_line_count,
+                        {archive_layout::soa, 16, 64}),
+             archive_status::ok);
+    CHECK_EQ(writer.finish(), archive_status::ok);
+    buffer out = read_all(file);
+    std::fclose(file);
+    return out;
+}
+} // namespace
+
+TEST_CASE("archive-round-trip")
+{
+    scene s    = make_scene();
+    buffer buf = write_scene(s);
+
+    archive_view archive;
+    REQUIRE_EQ(archive.open(buf.data(), buf.size), archive_status::ok);
+    CHECK_EQ(archive.section_count(), 3);
+
+    archive_span<point> points;
+    REQUIRE_EQ(archive.get("points", points), archive_status::ok);
+    CHECK_EQ(points.count, s.points.size());
+    CHECK_EQ(reinterpret_cast<uintptr_t>(points.data) % 64, 0);
+    CHECK_EQ(std::memcmp(
+                 points.data, s.points.data(), sizeof(point) * points.count),
+             0);
+
+    archive_span<motor> motors;
+    REQUIRE_EQ(archive.get("motors", motors), archive_status::ok);
+    CHECK_EQ(motors.count, s.motors.size());
+    CHECK_EQ((motors.data - reinterpret_cast<motor*>(buf.data()))
+                 * sizeof(motor) % 4096,
+             0);
+    CHECK_EQ(std::memcmp(
+                 motors.data, s.motors.data(), sizeof(motor) * motors.count),
+             0);
+
+    archive_soa_span lines;
+    REQUIRE_EQ(archive.get("lines", archive_type::line, lines),
+               archive_status::ok);
+    CHECK_EQ(lines.count, 11);
+    CHECK_EQ(
+        std::memcmp(lines.data, s.soa_lines.data(), sizeof(__m128) * 18), 0);
+
+    // The spans are usable in place by the batch kernels
+    motor m = s.motors[3];
+    std::vector<point> expected(points.count);
+    m(s.points.data(), expected.data(), points.count);
+    m(points.data, points.data, points.count);
+    CHECK_EQ(std::memcmp(
+                 points.data, expected.data(), sizeof(point) * points.count),
+             0);
+
+    archive_span<plane> planes;
+    archive_span<motor> missing;
+    CHECK_EQ(archive.get("points", planes), archive_status::type_mismatch);
+    CHECK_EQ(archive.get("lines", missing), archive_status::type_mismatch);
+    CHECK_EQ(archive.get("planes", missing), archive_status::not_found);
+}
+
+TEST_CASE("archive-checksums")
+{
+    scene s    = make_scene();
+    buffer buf = write_scene(s);
+
+    archive_view archive;
+    REQUIRE_EQ(archive.open(buf.data(), buf.size), archive_status::ok);
+    archive_section const* points = archive.find("points");
+    REQUIRE(points != nullptr);
+    CHECK_EQ(points->checksum_count(), 4);
+    CHECK_EQ(archive.verify(*points), archive_status::ok);
+    CHECK_EQ(archive.verify(*archive.find("motors")), archive_status::ok);
+    CHECK_EQ(archive.verify(*archive.find("lines")), archive_status::ok);
+
+    // Corrupt the second chunk of points
+    buf.data()[points->offset + 4096 + 5] ^= 1;
+    CHECK_EQ(archive.verify(*points, 0), archive_status::ok);
+    CHECK_EQ(archive.verify(*points, 1), archive_status::checksum_mismatch);
+    CHECK_EQ(archive.verify(*points), archive_status::checksum_mismatch);
+
+    // CRC32C check value
+    CHECK_EQ(detail::crc32c(0, "123456789", 9), 0xe3069283u);
+}
+
+TEST_CASE("archive-invalid")
+{
+    scene s    = make_scene();
+    buffer buf = write_scene(s);
+    archive_view archive;
+
+    CHECK_EQ(archive.open(buf.data(), 32), archive_status::truncated);
+    CHECK_EQ(archive.open(buf.data(), buf.size - 1), archive_status::truncated);
+
+    // Section table corruption is caught by the header checksum
+    buf.data()[sizeof(archive_header) + 30] ^= 1;
+    CHECK_EQ(archive.open(buf.data(), buf.size), archive_status::corrupt);
+    buf.data()[sizeof(archive_header) + 30] ^= 1;
+
+    buf.data()[8] = 2;
+    CHECK_EQ(archive.open(buf.data(), buf.size),
+             archive_status::unsupported_version);
+    buf.data()[0] = 'X';
+    CHECK_EQ(archive.open(buf.data(), buf.size), archive_status::bad_magic);
+    CHECK_EQ(archive.section_count(), 0);
+
+    // The writer refuses sections beyond its capacity
+    std::FILE* file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    archive_writer writer{file, 1};
+    CHECK_EQ(writer.add("a", s.points.data(), 1), archive_status::ok);
+    CHECK_EQ(writer.add("b", s.points.data(), 1), archive_status::full);
+    CHECK_EQ(writer.finish(), archive_status::ok);
+    std::fclose(file);
+}
+
+#ifndef _WIN32
+TEST_CASE("archive-mapped-file")
+{
+    scene s          = make_scene();
+    char const* path = "klein_test_archive.bin";
+    std::FILE* file  = std::fopen(path, "wb");
+    REQUIRE(file != nullptr);
+    archive_writer writer{file, 1};
+    CHECK_EQ(writer.add("points", s.points.data(), s.points.size()),
+             archive_status::ok);
+    CHECK_EQ(writer.finish(), archive_status::ok);
+    std::fclose(file);
+
+    {
+        mapped_file mapping;
+        REQUIRE_EQ(mapping.open(path), archive_status::ok);
+        archive_view archive;
+        REQUIRE_EQ(archive.open(mapping.data(), mapping.size()),
+                   archive_status::ok);
+        archive_span<point> points;
+        REQUIRE_EQ(archive.get("points", points), archive_status::ok);
+        CHECK_EQ(points.count, s.points.size());
+        CHECK_EQ(points.data[999].z(), -999.f);
+
+        // Writes are private to the mapping
+        points.data[0] = point{5.f, 5.f, 5.f};
+    }
+
+    mapped_file mapping;
+    REQUIRE_EQ(mapping.open(path), archive_status::ok);
+    archive_view archive;
+    REQUIRE_EQ(archive.open(mapping.data(), mapping.size()),
+               archive_status::ok);
+    archive_span<point> points;
+    REQUIRE_EQ(archive.get("points", points), archive_status::ok);
+    CHECK_EQ(points.data[0].x(), 0.f);
+    mapping.close();
+    std::remove(path);
+
+    CHECK_EQ(mapping.open("klein_test_missing.bin"), archive_status::io_error);
+}
+#endif
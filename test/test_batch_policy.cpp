@@ -0,0 +1,98 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/memory.hpp>
+
+#include "fixtures.hpp"
+
+#include <cstring>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+batch_policy const policies[] = {
+    {0, false},
+    {0, true},
+    {16, false},
+    {16, true},
+    // Further than the whole array
+    {1000, true},
+};
+
+// Every policy, in place and out of place, matches the default operator bit
+// for bit
+template <typename V, typename T>
+size_t mismatches(V const& v, std::vector<T> const& input)
+{
+    size_t count = input.size();
+    std::vector<T> expected{input};
+    v(expected.data(), expected.data(), count);
+
+    size_t out = 0;
+    for (batch_policy const& policy : policies)
+    {
+        std::vector<T> in{input};
+        std::vector<T> result(count);
+        v(in.data(), result.data(), count, policy);
+        out += std::memcmp(result.data(), expected.data(), sizeof(T) * count)
+                   == 0
+                   ? 0
+                   : 1;
+
+        v(in.data(), in.data(), count, policy);
+        out += std::memcmp(in.data(), expected.data(), sizeof(T) * count) == 0
+                   ? 0
+                   : 1;
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("batch-policy")
+{
+    motor m = fixture_motor();
+    rotor r = fixture_rotor();
+
+    size_t const count = 203;
+    std::vector<plane> planes;
+    std::vector<line> lines;
+    std::vector<point> points;
+    std::vector<direction> directions;
+    for (size_t i = 0; i != count; ++i)
+    {
+        float x = static_cast<float>(i) * 0.1f;
+        planes.emplace_back(x, 1.f, -x, 2.f);
+        lines.emplace_back(x, 1.f, -2.f, 0.5f, x, -x);
+        points.emplace_back(x, 0.5f - x, 0.25f * x);
+        directions.emplace_back(x, 1.f, -0.5f);
+    }
+
+    CHECK_EQ(mismatches(m, planes), 0);
+    CHECK_EQ(mismatches(m, lines), 0);
+    CHECK_EQ(mismatches(m, points), 0);
+    CHECK_EQ(mismatches(m, directions), 0);
+    CHECK_EQ(mismatches(r, planes), 0);
+    CHECK_EQ(mismatches(r, lines), 0);
+    CHECK_EQ(mismatches(r, points), 0);
+    CHECK_EQ(mismatches(r, directions), 0);
+}
+
+TEST_CASE("batch-policy-span")
+{
+    motor m = fixture_motor();
+    aligned_vector<point> in;
+    for (size_t i = 0; i != 100; ++i)
+    {
+        in.emplace_back(static_cast<float>(i), 1.f, -2.f);
+    }
+    aligned_vector<point> expected{in};
+    m(expected.data(), expected.data(), expected.size());
+
+    aligned_vector<point> out(in.size());
+    apply(m, aligned_span<point>{in}, aligned_span<point>{out}, {32, true});
+    CHECK_EQ(
+        std::memcmp(out.data(), expected.data(), sizeof(point) * out.size()),
+        0);
+}
@@ -0,0 +1,199 @@
+#include <doctest/doctest.h>
+
+#include <klein/bvh.hpp>
+#include <klein/klein.hpp>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// Runs each task on its own thread
+struct thread_executor
+{
+    template <typename F>
+    void operator()(size_t count, F&& task) const
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i != count; ++i)
+        {
+            threads.emplace_back([&task, i] { task(i); });
+        }
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+    }
+};
+
+std::vector<segment> make_segments(std::mt19937& rng, size_t count)
+{
+    std::uniform_real_distribution<float> position{-10.f, 10.f};
+    std::uniform_real_distribution<float> offset{-1.f, 1.f};
+    std::vector<segment> out(count);
+    for (segment& s : out)
+    {
+        float x = position(rng);
+        float y = position(rng);
+        float z = position(rng);
+        s.a     = point{x, y, z};
+        s.b     = point{x + offset(rng), y + offset(rng), z + offset(rng)};
+    }
+    return out;
+}
+
+std::vector<disc> make_discs(std::mt19937& rng, size_t count)
+{
+    std::uniform_real_distribution<float> position{-10.f, 10.f};
+    std::uniform_real_distribution<float> normal{-1.f, 1.f};
+    std::vector<disc> out(count);
+    for (disc& d : out)
+    {
+        float x = position(rng);
+        float y = position(rng);
+        float z = position(rng);
+        plane p{normal(rng), normal(rng), normal(rng) + 2.f, 0.f};
+        p.normalize();
+        d.p      = plane{
+            p.x(), p.y(), p.z(), -(p.x() * x + p.y() * y + p.z() * z)};
+        d.center = point{x, y, z};
+        d.radius = 0.5f;
+    }
+    return out;
+}
+
+template <typename T>
+void check_nearest(std::mt19937& rng, std::vector<T> const& primitives)
+{
+    std::vector<typename bvh<T>::node> nodes(
+        bvh<T>::node_count(primitives.size()));
+    std::vector<uint32_t> indices(primitives.size());
+    bvh<T> tree{
+        primitives.data(), primitives.size(), nodes.data(), indices.data()};
+
+    std::uniform_real_distribution<float> position{-12.f, 12.f};
+    for (int i = 0; i != 100; ++i)
+    {
+        point q{position(rng), position(rng), position(rng)};
+
+        float best = INFINITY;
+        for (T const& t : primitives)
+        {
+            best = std::min(best, squared_distance(t, q));
+        }
+
+        bvh_hit hit = tree.nearest(q);
+        REQUIRE_NE(hit.index, bvh_hit::npos);
+        CHECK_EQ(hit.distance2, doctest::Approx(best));
+        CHECK_EQ(squared_distance(primitives[hit.index], q),
+                 doctest::Approx(best));
+
+        bvh_hit none = tree.nearest(q, best * 0.99f);
+        CHECK_EQ(none.index, bvh_hit::npos);
+    }
+}
+
+// Nodes of a hierarchy built by halving ranges down to leaves
+size_t halving_node_count(size_t count)
+{
+    return count <= bvh<segment>::leaf_size
+               ? 1
+               : 1 + halving_node_count(count / 2)
+                     + halving_node_count(count - count / 2);
+}
+} // namespace
+
+TEST_CASE("segment-distance")
+{
+    segment s{point{0.f, 0.f, 0.f}, point{2.f, 0.f, 0.f}};
+    CHECK_EQ(squared_distance(s, point{1.f, 3.f, 0.f}), doctest::Approx(9.f));
+    CHECK_EQ(squared_distance(s, point{-1.f, 0.f, 1.f}), doctest::Approx(2.f));
+    CHECK_EQ(squared_distance(s, point{4.f, 0.f, 0.f}), doctest::Approx(4.f));
+}
+
+TEST_CASE("disc-distance")
+{
+    disc d{plane{0.f, 0.f, 1.f, -1.f}, point{0.f, 0.f, 1.f}, 1.f};
+    CHECK_EQ(squared_distance(d, point{0.5f, 0.f, 3.f}), doctest::Approx(4.f));
+    CHECK_EQ(squared_distance(d, point{3.f, 0.f, 2.f}), doctest::Approx(5.f));
+}
+
+TEST_CASE("bvh-node-count")
+{
+    for (size_t count = 0; count != 5000; ++count)
+    {
+        REQUIRE_EQ(bvh<segment>::node_count(count), halving_node_count(count));
+    }
+}
+
+TEST_CASE("bvh-nearest")
+{
+    std::mt19937 rng{3};
+    check_nearest(rng, make_segments(rng, 1000));
+    check_nearest(rng, make_discs(rng, 1000));
+}
+
+TEST_CASE("bvh-parallel-build")
+{
+    std::mt19937 rng{5};
+    std::vector<segment> segments = make_segments(rng, 3000);
+    size_t node_count             = bvh<segment>::node_count(segments.size());
+
+    std::vector<bvh<segment>::node> serial_nodes(node_count);
+    std::vector<uint32_t> serial_indices(segments.size());
+    bvh<segment> serial{segments.data(),
+                        segments.size(),
+                        serial_nodes.data(),
+                        serial_indices.data()};
+
+    std::vector<bvh<segment>::node> parallel_nodes(node_count);
+    std::vector<uint32_t> parallel_indices(segments.size());
+    bvh<segment> parallel;
+    parallel.build(segments.data(),
+                   segments.size(),
+                   parallel_nodes.data(),
+                   parallel_indices.data(),
+                   thread_executor{});
+
+    CHECK(serial_indices == parallel_indices);
+    for (size_t i = 0; i != node_count; ++i)
+    {
+        CHECK_EQ(serial_nodes[i].first, parallel_nodes[i].first);
+        CHECK_EQ(serial_nodes[i].count, parallel_nodes[i].count);
+    }
+}
+
+TEST_CASE("bvh-line-query")
+{
+    std::mt19937 rng{9};
+    std::vector<segment> segments = make_segments(rng, 1000);
+    std::vector<bvh<segment>::node> nodes(
+        bvh<segment>::node_count(segments.size()));
+    std::vector<uint32_t> indices(segments.size());
+    bvh<segment> tree{
+        segments.data(), segments.size(), nodes.data(), indices.data()};
+
+    // The x-axis
+    line l = point{0.f, 0.f, 0.f} & point{1.f, 0.f, 0.f};
+    std::vector<bool> found(segments.size());
+    tree.for_each_near(l, 1.f, [&](uint32_t i) { found[i] = true; });
+
+    // Every segment with an endpoint within the radius must be reported
+    size_t reported = 0;
+    for (size_t i = 0; i != segments.size(); ++i)
+    {
+        point a  = segments[i].a;
+        float d2 = a.y() * a.y() + a.z() * a.z();
+        if (d2 < 1.f)
+        {
+            CHECK(found[i]);
+        }
+        reported += found[i] ? 1 : 0;
+    }
+
+    // The hierarchy should cull the majority of the segments
+    CHECK_LT(reported, segments.size() / 4);
+}
@@ -0,0 +1,217 @@
+#include <doctest/doctest.h>
+
+#include <klein/clip.hpp>
+#include <klein/klein.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// The unit cube 0 <= x, y, z <= 1
+plane const cube[6] = {plane{1.f, 0.f, 0.f, 0.f},
+                       plane{-1.f, 0.f, 0.f, 1.f},
+                       plane{0.f, 1.f, 0.f, 0.f},
+                       plane{0.f, -1.f, 0.f, 1.f},
+                       plane{0.f, 0.f, 1.f, 0.f},
+                       plane{0.f, 0.f, -1.f, 1.f}};
+
+void check(point const& a, point const& b)
+{
+    CHECK_EQ(a.x(), doctest::Approx(b.x()).epsilon(1e-5));
+    CHECK_EQ(a.y(), doctest::Approx(b.y()).epsilon(1e-5));
+    CHECK_EQ(a.z(), doctest::Approx(b.z()).epsilon(1e-5));
+    CHECK_EQ(a.w(), doctest::Approx(1.f).epsilon(1e-5));
+}
+
+bool inside(point const& x)
+{
+    for (plane const& p : cube)
+    {
+        if ((p ^ x).q < -1e-6f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+float area(point const& a, point const& b, point const& c)
+{
+    float u[3] = {b.x() - a.x(), b.y() - a.y(), b.z() - a.z()};
+    float v[3] = {c.x() - a.x(), c.y() - a.y(), c.z() - a.z()};
+    float n[3] = {u[1] * v[2] - u[2] * v[1],
+                  u[2] * v[0] - u[0] * v[2],
+                  u[0] * v[1] - u[1] * v[0]};
+    return 0.5f * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+}
+} // namespace
+
+TEST_CASE("clip-segments")
+{
+    point in[] = {// Inside
+                  point{0.25f, 0.25f, 0.25f},
+                  point{0.75f, 0.5f, 0.5f},
+                  // Outside
+                  point{2.f, 0.f, 0.f},
+                  point{3.f, 1.f, 1.f},
+                  // Through the cube along x
+                  point{-1.f, 0.5f, 0.5f},
+                  point{2.f, 0.5f, 0.5f},
+                  // Leaving through z = 1
+                  point{0.5f, 0.5f, 0.5f},
+                  point{0.5f, 0.5f, 1.5f},
+                  // Passing by the cube across both x and y slabs
+                  point{3.f, -0.5f, 0.5f},
+                  point{-0.5f, 3.f, 0.5f},
+                  // Entering through y = 0
+                  point{0.5f, -1.f, 0.5f},
+                  point{0.5f, 0.5f, 0.5f}};
+    point out[12];
+    size_t n = clip_segments(cube, 6, in, 6, out);
+    REQUIRE_EQ(n, 4);
+    check(out[0], in[0]);
+    check(out[1], in[1]);
+    check(out[2], point{0.f, 0.5f, 0.5f});
+    check(out[3], point{1.f, 0.5f, 0.5f});
+    check(out[4], in[6]);
+    check(out[5], point{0.5f, 0.5f, 1.f});
+    check(out[6], point{0.5f, 0.f, 0.5f});
+    check(out[7], in[11]);
+
+    // In place
+    n = clip_segments(cube, 6, in, 6, in);
+    REQUIRE_EQ(n, 4);
+    check(in[2], point{0.f, 0.5f, 0.5f});
+    check(in[7], point{0.5f, 0.5f, 0.5f});
+
+    // Without planes every segment survives
+    CHECK_EQ(clip_segments(cube, 0, in, 6, out), 6);
+}
+
+TEST_CASE("clip-polygon")
+{
+    // A hexagon in the plane z = 0.5 about the center of the cube, covering
+    // its section. No vertex lies on a plane.
+    std::vector<point> hexagon;
+    for (int i = 0; i != 6; ++i)
+    {
+        float angle = 0.1f + static_cast<float>(i) * 3.14159265f / 3.f;
+        hexagon.emplace_back(
+            0.5f + 1.2f * std::cos(angle), 0.5f + 1.2f * std::sin(angle), 0.5f);
+    }
+
+    std::vector<point> out(clip_polygon_capacity(6, 6));
+    std::vector<point> scratch(out.size());
+    size_t n
+        = clip_polygon(cube, 6, hexagon.data(), 6, out.data(), scratch.data());
+    REQUIRE_EQ(n, 4);
+    float sum = 0.f;
+    for (size_t i = 0; i != n; ++i)
+    {
+        CHECK(inside(out[i]));
+        sum += area(out[0], out[i], out[(i + 1) % n]);
+    }
+    CHECK_EQ(sum, doctest::Approx(1.f).epsilon(1e-5));
+
+    // A single plane through the center cuts two edges
+    plane half{1.f, 1.f, 0.f, -1.f};
+    n = clip_polygon(&half, 1, hexagon.data(), 6, out.data(), scratch.data());
+    REQUIRE_EQ(n, 5);
+    for (size_t i = 0; i != n; ++i)
+    {
+        CHECK_GE((half ^ out[i]).q, -1e-6f);
+    }
+
+    // Outside a plane
+    plane beyond{1.f, 0.f, 0.f, -2.f};
+    CHECK_EQ(clip_polygon(
+                 &beyond, 1, hexagon.data(), 6, out.data(), scratch.data()),
+             0);
+
+    // Without planes the polygon is copied
+    n = clip_polygon(cube, 0, hexagon.data(), 6, out.data(), scratch.data());
+    REQUIRE_EQ(n, 6);
+    check(out[3], hexagon[3]);
+}
+
+TEST_CASE("clip-triangles")
+{
+    // Triangles in the plane z = 0.5, covering the cube section in various
+    // ways
+    point in[] = {// Inside
+                  point{0.1f, 0.1f, 0.5f},
+                  point{0.9f, 0.1f, 0.5f},
+                  point{0.1f, 0.9f, 0.5f},
+                  // Outside
+                  point{2.f, 2.f, 0.5f},
+                  point{3.f, 2.f, 0.5f},
+                  point{2.f, 3.f, 0.5f},
+                  // Clipped by x = 1 to a quadrilateral
+                  point{0.f, 0.f, 0.5f},
+                  point{1.5f, 0.f, 0.5f},
+                  point{0.f, 0.5f, 0.5f},
+                  // Covering the section
+                  point{-1.f, -1.f, 0.5f},
+                  point{4.f, -1.f, 0.5f},
+                  point{-1.f, 4.f, 0.5f},
+                  // Beyond the corner (1, 1): no vertex is inside and no
+                  // plane has all vertices outside
+                  point{0.6f, 1.5f, 0.5f},
+                  point{1.5f, 0.6f, 0.5f},
+                  point{2.f, 2.f, 0.5f}};
+    // Areas of the clipped triangles
+    float expected = 0.32f + (0.375f - 0.125f / 3.f) + 1.f;
+
+    std::vector<point> out(clip_triangles_capacity(5, 6));
+    size_t n = clip_triangles(cube, 6, in, 5, out.data());
+    // 1 + 0 + 2 + 2 + 0, the clipped triangles being quadrilaterals
+    REQUIRE_EQ(n, 5);
+    check(out[0], in[0]);
+    check(out[1], in[1]);
+    check(out[2], in[2]);
+
+    float sum = 0.f;
+    for (size_t i = 0; i != n; ++i)
+    {
+        point const* t = out.data() + 3 * i;
+        CHECK(inside(t[0]));
+        CHECK(inside(t[1]));
+        CHECK(inside(t[2]));
+        sum += area(t[0], t[1], t[2]);
+    }
+    CHECK_EQ(sum, doctest::Approx(expected).epsilon(1e-5));
+}
+
+TEST_CASE("clip-triangles-plane-limit")
+{
+    // The cube followed by planes every vertex is far inside of, which leave
+    // the result unchanged
+    std::vector<plane> planes(cube, cube + 6);
+    while (planes.size() != clip_max_planes + 1)
+    {
+        planes.emplace_back(0.f, 0.f, 1.f, 10.f);
+    }
+
+    // Clipped by x = 1 to a quadrilateral
+    point in[] = {point{0.f, 0.f, 0.5f},
+                  point{1.5f, 0.f, 0.5f},
+                  point{0.f, 0.5f, 0.5f}};
+
+    std::vector<point> out(clip_triangles_capacity(1, planes.size()));
+    size_t n
+        = clip_triangles(planes.data(), clip_max_planes, in, 1, out.data());
+    REQUIRE_EQ(n, 2);
+    float sum = area(out[0], out[1], out[2]) + area(out[3], out[4], out[5]);
+    CHECK_EQ(sum, doctest::Approx(0.375f - 0.125f / 3.f).epsilon(1e-5));
+
+    // Past the limit nothing is written
+    point sentinel{7.f, 7.f, 7.f};
+    std::fill(out.begin(), out.end(), sentinel);
+    n = clip_triangles(planes.data(), planes.size(), in, 1, out.data());
+    CHECK_EQ(n, 0);
+    check(out[0], sentinel);
+}
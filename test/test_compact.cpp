@@ -0,0 +1,203 @@
+#include <doctest/doctest.h>
+
+#include <klein/compact.hpp>
+#include <klein/klein.hpp>
+
+#include "fixtures.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+uint16_t to_half(float f)
+{
+    point_h h;
+    point p{f, 0.f, 0.f};
+    encode(&p, &h, 1);
+    return h.data[0];
+}
+
+float from_half(uint16_t bits)
+{
+    point_h h{{bits, 0, 0, 0x3c00}};
+    point p;
+    decode(&h, &p, 1);
+    return p.x();
+}
+} // namespace
+
+TEST_CASE("compact-half")
+{
+    CHECK_EQ(to_half(1.f), 0x3c00);
+    CHECK_EQ(to_half(-2.f), 0xc000);
+    CHECK_EQ(to_half(0.1f), 0x2e66);
+    CHECK_EQ(to_half(65504.f), 0x7bff);
+    CHECK_EQ(to_half(1e5f), 0x7c00);
+    CHECK_EQ(to_half(-0.f), 0x8000);
+    CHECK_EQ(to_half(std::ldexp(1.f, -24)), 0x0001);
+    // Ties round to even
+    CHECK_EQ(to_half(1.f + std::ldexp(1.f, -11)), 0x3c00);
+    CHECK_EQ(to_half(1.f + 3.f * std::ldexp(1.f, -11)), 0x3c02);
+
+    CHECK_EQ(from_half(0x3555), doctest::Approx(0.333251953f));
+    CHECK_EQ(from_half(0x0001), std::ldexp(1.f, -24));
+    CHECK(std::isinf(from_half(0xfc00)));
+    CHECK(std::isnan(from_half(0x7e00)));
+
+    // Every finite half survives a round trip
+    size_t failures = 0;
+    for (uint32_t bits = 0; bits != 0x10000; ++bits)
+    {
+        if ((bits & 0x7c00) != 0x7c00)
+        {
+            uint16_t h = static_cast<uint16_t>(bits);
+            failures += to_half(from_half(h)) == h ? 0 : 1;
+        }
+    }
+    CHECK_EQ(failures, 0);
+}
+
+TEST_CASE("compact-layout")
+{
+    point p{1.f, 2.f, 3.f};
+    point_h ph;
+    encode(&p, &ph, 1);
+    CHECK_EQ(ph.data[0], 0x3c00);
+    CHECK_EQ(ph.data[1], 0x4000);
+    CHECK_EQ(ph.data[2], 0x4200);
+    CHECK_EQ(ph.data[3], 0x3c00);
+
+    plane pl{1.f, 2.f, 3.f, 4.f};
+    plane_h plh;
+    encode(&pl, &plh, 1);
+    CHECK_EQ(plh.data[3], 0x4400);
+    plane pl2;
+    decode(&plh, &pl2, 1);
+    CHECK_EQ(pl2.x(), 1.f);
+    CHECK_EQ(pl2.d(), 4.f);
+
+    float z_axis[4] = {0.f, 0.f, 0.f, 1.f};
+    direction d{z_axis};
+    direction_n16 dn;
+    encode(&d, &dn, 1);
+    CHECK_EQ(dn.data[2], 32767);
+    CHECK_EQ(dn.data[3], 0);
+}
+
+TEST_CASE("compact-apply")
+{
+    motor m = fixture_motor();
+    rotor r = fixture_rotor();
+
+    // Several blocks and a partial one
+    size_t const count = 3 * 64 + 13;
+    std::vector<point> points;
+    std::vector<plane> planes;
+    std::vector<direction> directions;
+    for (size_t i = 0; i != count; ++i)
+    {
+        float x = static_cast<float>(i) * 0.01f;
+        points.emplace_back(x, 0.5f - x, 0.25f * x);
+        planes.emplace_back(x, 1.f, -x, 2.f);
+        directions.emplace_back(x, 1.f, -0.5f);
+    }
+
+    // The fused kernels match decoding, transforming, and encoding
+    std::vector<point_h> ph(count);
+    encode(points.data(), ph.data(), count);
+    std::vector<point> decoded(count);
+    decode(ph.data(), decoded.data(), count);
+    m(decoded.data(), decoded.data(), count);
+    std::vector<point_h> expected_ph(count);
+    encode(decoded.data(), expected_ph.data(), count);
+    apply(m, ph.data(), ph.data(), count);
+    CHECK_EQ(mismatches(expected_ph, ph), 0);
+    CHECK_EQ(decoded[100].y(),
+             doctest::Approx(m(points[100]).y()).epsilon(1e-3));
+
+    std::vector<plane_h> plh(count);
+    encode(planes.data(), plh.data(), count);
+    std::vector<plane> decoded_planes(count);
+    decode(plh.data(), decoded_planes.data(), count);
+    r(decoded_planes.data(), decoded_planes.data(), count);
+    std::vector<plane_h> expected_plh(count);
+    encode(decoded_planes.data(), expected_plh.data(), count);
+    std::vector<plane_h> out_plh(count);
+    apply(r, plh.data(), out_plh.data(), count);
+    CHECK_EQ(mismatches(expected_plh, out_plh), 0);
+
+    std::vector<direction_h> dh(count);
+    encode(directions.data(), dh.data(), count);
+    std::vector<direction> decoded_directions(count);
+    decode(dh.data(), decoded_directions.data(), count);
+    m(decoded_directions.data(), decoded_directions.data(), count);
+    std::vector<direction_h> expected_dh(count);
+    encode(decoded_directions.data(), expected_dh.data(), count);
+    apply(m, dh.data(), dh.data(), count);
+    CHECK_EQ(mismatches(expected_dh, dh), 0);
+}
+
+TEST_CASE("compact-snorm")
+{
+    motor m = fixture_motor();
+
+    snorm16_range box;
+    box.offset[0] = 10.f;
+    box.extent[0] = 2.f;
+    box.extent[1] = 4.f;
+    box.extent[2] = 8.f;
+
+    size_t const count = 100;
+    std::vector<point> points;
+    for (size_t i = 0; i != count; ++i)
+    {
+        float t = static_cast<float>(i) / count;
+        points.emplace_back(9.f + t, -3.f * t, 8.f * t - 4.f);
+    }
+
+    std::vector<point_n16> pn(count);
+    encode(points.data(), pn.data(), count, box);
+    std::vector<point> decoded(count);
+    decode(pn.data(), decoded.data(), count, box);
+    for (size_t i = 0; i != count; ++i)
+    {
+        CHECK(std::abs(decoded[i].x() - points[i].x()) <= 1.f / 32767.f);
+        CHECK(std::abs(decoded[i].y() - points[i].y()) <= 2.f / 32767.f);
+        CHECK(std::abs(decoded[i].z() - points[i].z()) <= 4.f / 32767.f);
+        CHECK_EQ(decoded[i].w(), 1.f);
+    }
+
+    // Outside the box values clamp
+    point far{100.f, 0.f, 0.f};
+    point_n16 clamped;
+    encode(&far, &clamped, 1, box);
+    CHECK_EQ(clamped.data[0], 32767);
+
+    // Transform into a larger box
+    snorm16_range out_box;
+    out_box.extent[0] = out_box.extent[1] = out_box.extent[2] = 32.f;
+    m(decoded.data(), decoded.data(), count);
+    std::vector<point_n16> expected(count);
+    encode(decoded.data(), expected.data(), count, out_box);
+    std::vector<point_n16> out(count);
+    apply(m, pn.data(), out.data(), count, box, out_box);
+    CHECK_EQ(mismatches(expected, out), 0);
+
+    std::vector<direction> directions;
+    for (size_t i = 0; i != count; ++i)
+    {
+        directions.emplace_back(static_cast<float>(i), 1.f, -2.f);
+    }
+    std::vector<direction_n16> dn(count);
+    encode(directions.data(), dn.data(), count);
+    std::vector<direction> decoded_directions(count);
+    decode(dn.data(), decoded_directions.data(), count);
+    m(decoded_directions.data(), decoded_directions.data(), count);
+    std::vector<direction_n16> expected_dn(count);
+    encode(decoded_directions.data(), expected_dn.data(), count);
+    apply(m, dn.data(), dn.data(), count);
+    CHECK_EQ(mismatches(expected_dn, dn), 0);
+}
@@ -103,4 +103,29 @@ TEST_CASE("motor-blend")
     CHECK_EQ(result.e02(), doctest::Approx(m2.e02()).epsilon(0.01));
     CHECK_EQ(result.e03(), doctest::Approx(m2.e03()).epsilon(0.01));
     CHECK_EQ(result.e0123(), doctest::Approx(m2.e0123()).epsilon(0.01));
-}
\ No newline at end of file
+}
+
+TEST_CASE("motor-exp-log-degenerate")
+{
+    // A pure translation has no Euclidean part
+    line l{1.f, -2.f, 3.f, 0.f, 0.f, 0.f};
+    motor m = exp(l);
+    CHECK_EQ(m.scalar(), doctest::Approx(1.f));
+    CHECK_EQ(m.e01(), doctest::Approx(1.f));
+    CHECK_EQ(m.e02(), doctest::Approx(-2.f));
+    CHECK_EQ(m.e03(), doctest::Approx(3.f));
+    CHECK_EQ(m.e0123(), doctest::Approx(0.f));
+
+    line l2 = log(m);
+    CHECK_EQ(l2.e01(), doctest::Approx(1.f));
+    CHECK_EQ(l2.e02(), doctest::Approx(-2.f));
+    CHECK_EQ(l2.e03(), doctest::Approx(3.f));
+    CHECK_EQ(l2.e23(), doctest::Approx(0.f));
+
+    // The log of the identity is zero
+    line l3 = log(motor{1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f});
+    CHECK_EQ(l3.e01(), doctest::Approx(0.f));
+    CHECK_EQ(l3.e23(), doctest::Approx(0.f));
+    CHECK_EQ(l3.e31(), doctest::Approx(0.f));
+    CHECK_EQ(l3.e12(), doctest::Approx(0.f));
+}
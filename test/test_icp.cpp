@@ -0,0 +1,199 @@
+#define _USE_MATH_DEFINES
+#include <doctest/doctest.h>
+
+#include <klein/icp.hpp>
+#include <klein/klein.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// Sample points on a bumpy height field so that the cloud constrains all six
+// degrees of freedom
+std::vector<point> make_surface(size_t resolution)
+{
+    std::vector<point> points;
+    for (size_t i = 0; i != resolution; ++i)
+    {
+        for (size_t j = 0; j != resolution; ++j)
+        {
+            float x = static_cast<float>(i) / resolution * 2.f - 1.f;
+            float y = static_cast<float>(j) / resolution * 2.f - 1.f;
+            float z
+                = 0.3f * std::sin(3.f * x) * std::cos(2.f * y) + 0.2f * x * y;
+            points.emplace_back(x, y, z);
+        }
+    }
+    return points;
+}
+} // namespace
+
+TEST_CASE("kd-tree-nearest")
+{
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<float> dist{-10.f, 10.f};
+
+    std::vector<point> points(500);
+    for (point& p : points)
+    {
+        p = point{dist(rng), dist(rng), dist(rng)};
+    }
+    std::vector<kd_tree::node> storage(points.size());
+    kd_tree tree{points.data(), points.size(), storage.data()};
+    CHECK_EQ(tree.size(), points.size());
+
+    for (int i = 0; i != 100; ++i)
+    {
+        point q{dist(rng), dist(rng), dist(rng)};
+
+        float best = INFINITY;
+        for (point const& p : points)
+        {
+            float dx = p.x() - q.x();
+            float dy = p.y() - q.y();
+            float dz = p.z() - q.z();
+            best     = std::min(best, dx * dx + dy * dy + dz * dz);
+        }
+
+        kd_tree::neighbor n = tree.nearest(q);
+        REQUIRE_NE(n.index, kd_tree::npos);
+        CHECK_EQ(n.distance2, doctest::Approx(best));
+        CHECK_EQ(n.p.x(), points[n.index].x());
+
+        // Nothing lies within a radius smaller than the nearest neighbor
+        kd_tree::neighbor none = tree.nearest(q, best * 0.99f);
+        CHECK_EQ(none.index, kd_tree::npos);
+    }
+}
+
+TEST_CASE("icp-point-to-point")
+{
+    std::vector<point> target = make_surface(24);
+    std::vector<kd_tree::node> storage(target.size());
+    kd_tree tree{target.data(), target.size(), storage.data()};
+
+    // Displace the source by the inverse of a known motor
+    rotor r{0.1f, 0.3f, -0.5f, 1.f};
+    translator t{0.08f, 1.f, 0.5f, -0.2f};
+    motor expected = t * r;
+    motor inverse  = ~expected;
+
+    std::vector<point> source(target.size());
+    for (size_t i = 0; i != target.size(); ++i)
+    {
+        source[i] = inverse(target[i]);
+    }
+
+    std::vector<point> scratch(source.size());
+    motor m{1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    icp_options options;
+    options.max_iterations = 50;
+    icp_stats stats        = icp_point_to_point(
+        m, source.data(), source.size(), tree, scratch.data(), options);
+
+    CHECK(stats.converged);
+    CHECK_EQ(stats.correspondences, source.size());
+    CHECK_LT(stats.final_rms, 1e-3f);
+    CHECK_LT(stats.final_rms, stats.initial_rms);
+
+    for (size_t i = 0; i < source.size(); i += 37)
+    {
+        point p = m(source[i]);
+        CHECK_EQ(p.x(), doctest::Approx(target[i].x()).epsilon(0.001));
+        CHECK_EQ(p.y(), doctest::Approx(target[i].y()).epsilon(0.001));
+        CHECK_EQ(p.z(), doctest::Approx(target[i].z()).epsilon(0.001));
+    }
+}
+
+TEST_CASE("icp-point-to-plane")
+{
+    std::vector<point> target = make_surface(24);
+    std::vector<kd_tree::node> storage(target.size());
+    kd_tree tree{target.data(), target.size(), storage.data()};
+
+    // Tangent planes from the analytic surface normal
+    std::vector<plane> planes(target.size());
+    for (size_t i = 0; i != target.size(); ++i)
+    {
+        float x  = target[i].x();
+        float y  = target[i].y();
+        float dx = 0.9f * std::cos(3.f * x) * std::cos(2.f * y) + 0.2f * y;
+        float dy = -0.6f * std::sin(3.f * x) * std::sin(2.f * y) + 0.2f * x;
+        plane p{-dx, -dy, 1.f, 0.f};
+        p.normalize();
+        // Move the plane through the target point
+        planes[i] = plane{p.x(),
+                          p.y(),
+                          p.z(),
+                          -(p.x() * x + p.y() * y + p.z() * target[i].z())};
+    }
+
+    rotor r{0.1f, -0.2f, 0.4f, 1.f};
+    translator t{0.05f, 0.3f, 1.f, 0.5f};
+    motor expected = t * r;
+    motor inverse  = ~expected;
+
+    std::vector<point> source(target.size());
+    for (size_t i = 0; i != target.size(); ++i)
+    {
+        source[i] = inverse(target[i]);
+    }
+
+    std::vector<point> scratch(source.size());
+    motor m{1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    icp_stats stats = icp_point_to_plane(m,
+                                         source.data(),
+                                         source.size(),
+                                         tree,
+                                         planes.data(),
+                                         scratch.data());
+
+    CHECK(stats.converged);
+    CHECK_LT(stats.final_rms, 1e-3f);
+
+    for (size_t i = 0; i < source.size(); i += 37)
+    {
+        point p = m(source[i]);
+        CHECK_EQ(p.x(), doctest::Approx(target[i].x()).epsilon(0.01));
+        CHECK_EQ(p.y(), doctest::Approx(target[i].y()).epsilon(0.01));
+        CHECK_EQ(p.z(), doctest::Approx(target[i].z()).epsilon(0.01));
+    }
+}
+
+TEST_CASE("kd-tree-parallel-build")
+{
+    std::mt19937 rng{11};
+    std::uniform_real_distribution<float> dist{-10.f, 10.f};
+
+    std::vector<point> points(2000);
+    for (point& p : points)
+    {
+        p = point{dist(rng), dist(rng), dist(rng)};
+    }
+
+    std::vector<kd_tree::node> serial(points.size());
+    kd_tree{points.data(), points.size(), serial.data()};
+
+    // Execute the tasks in reverse order to simulate concurrent scheduling
+    std::vector<kd_tree::node> parallel(points.size());
+    kd_tree tree;
+    tree.build(points.data(),
+               points.size(),
+               parallel.data(),
+               [](size_t count, auto&& task) {
+                   for (size_t i = count; i != 0; --i)
+                   {
+                       task(i - 1);
+                   }
+               });
+
+    for (size_t i = 0; i != points.size(); ++i)
+    {
+        CHECK_EQ(serial[i].index, parallel[i].index);
+        CHECK_EQ(serial[i].axis, parallel[i].axis);
+    }
+}
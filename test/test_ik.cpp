@@ -0,0 +1,145 @@
+#define _USE_MATH_DEFINES
+#include <doctest/doctest.h>
+
+#include <klein/ik.hpp>
+#include <klein/klein.hpp>
+
+#include <cmath>
+
+using namespace kln;
+
+namespace
+{
+// A shoulder (ball joint), elbow (hinge), and wrist (hinge) with unit links
+// along x
+struct arm
+{
+    ik::joint joints[5];
+    motor frames[5];
+    point positions[6];
+    float lengths[5];
+    ik::scratch scratch{frames, positions, lengths};
+    ik::chain chain;
+
+    arm()
+    {
+        line x_axis{0.f, 0.f, 0.f, 1.f, 0.f, 0.f};
+        line y_axis{0.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+        line z_axis{0.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+        joints[0].axis   = z_axis;
+        joints[1].axis   = y_axis;
+        joints[2].axis   = x_axis;
+        joints[3].axis   = z_axis;
+        joints[3].offset = translator{1.f, 1.f, 0.f, 0.f};
+        joints[4].axis   = y_axis;
+        joints[4].offset = translator{1.f, 1.f, 0.f, 0.f};
+        chain            = ik::chain{joints,
+                          5,
+                          motor{translator{1.f, 0.f, 0.f, 1.f}},
+                          point{1.f, 0.f, 0.f}};
+    }
+};
+
+// Three ball joints with unit links along x
+struct limb
+{
+    ik::joint joints[9];
+    motor frames[9];
+    point positions[10];
+    float lengths[9];
+    ik::scratch scratch{frames, positions, lengths};
+    ik::chain chain;
+
+    limb()
+    {
+        line axes[3] = {{0.f, 0.f, 0.f, 0.f, 0.f, 1.f},
+                        {0.f, 0.f, 0.f, 0.f, 1.f, 0.f},
+                        {0.f, 0.f, 0.f, 1.f, 0.f, 0.f}};
+        for (size_t i = 0; i != 9; ++i)
+        {
+            joints[i].axis = axes[i % 3];
+        }
+        joints[3].offset = translator{1.f, 1.f, 0.f, 0.f};
+        joints[6].offset = translator{1.f, 1.f, 0.f, 0.f};
+        chain            = ik::chain{joints,
+                          9,
+                          motor{translator{1.f, 0.f, 0.f, 1.f}},
+                          point{1.f, 0.f, 0.f}};
+    }
+};
+
+template <typename Chain, typename Solver>
+void check_reach(Solver&& solve, float x, float y, float z, size_t iterations)
+{
+    Chain a;
+    point target{x, y, z};
+    ik::options options;
+    options.max_iterations = iterations;
+    ik::result r           = solve(a.chain, target, a.scratch, options);
+
+    CHECK(r.converged);
+    CHECK_LE(r.distance, options.tolerance);
+
+    // The reported distance agrees with forward kinematics
+    point effector = ik::forward(a.chain, a.frames);
+    float dx       = effector.x() - x;
+    float dy       = effector.y() - y;
+    float dz       = effector.z() - z;
+    CHECK_EQ(std::sqrt(dx * dx + dy * dy + dz * dz),
+             doctest::Approx(r.distance).epsilon(0.01));
+}
+} // namespace
+
+TEST_CASE("ik-forward")
+{
+    arm a;
+    a.joints[0].angle = M_PI * 0.5f;
+    point effector    = ik::forward(a.chain, a.frames);
+    CHECK_EQ(effector.x(), doctest::Approx(0.f).epsilon(1e-4));
+    CHECK_EQ(effector.y(), doctest::Approx(3.f).epsilon(1e-4));
+    CHECK_EQ(effector.z(), doctest::Approx(1.f).epsilon(1e-4));
+}
+
+TEST_CASE("ik-ccd")
+{
+    auto ccd = [](auto&&... args) { return ik::ccd(args...); };
+    check_reach<arm>(ccd, 1.f, 2.f, 1.5f, 200);
+    check_reach<arm>(ccd, -0.5f, 1.f, -0.5f, 200);
+    check_reach<limb>(ccd, 0.f, 0.f, 3.5f, 200);
+}
+
+TEST_CASE("ik-fabrik")
+{
+    auto fabrik = [](auto&&... args) { return ik::fabrik(args...); };
+    // Hinges generally cannot realize the positions FABRIK solves for so the
+    // solver is exercised on ball joints
+    check_reach<limb>(fabrik, 1.f, 2.f, 1.5f, 16);
+    check_reach<limb>(fabrik, -0.5f, 1.f, -0.5f, 16);
+    check_reach<limb>(fabrik, 0.f, 0.f, 3.5f, 16);
+}
+
+TEST_CASE("ik-dls")
+{
+    auto dls = [](auto&&... args) { return ik::dls(args...); };
+    check_reach<arm>(dls, 1.f, 2.f, 1.5f, 200);
+    check_reach<arm>(dls, -0.5f, 1.f, -0.5f, 200);
+    check_reach<limb>(dls, 1.f, 1.f, 2.f, 200);
+}
+
+TEST_CASE("ik-limits")
+{
+    arm a;
+    for (ik::joint& j : a.joints)
+    {
+        j.min_angle = -0.1f;
+        j.max_angle = 0.1f;
+    }
+
+    // The target is out of reach within the limits
+    ik::result r = ik::ccd(a.chain, point{-3.f, 0.f, 1.f}, a.scratch);
+    CHECK_FALSE(r.converged);
+    for (ik::joint const& j : a.joints)
+    {
+        CHECK_LE(std::abs(j.angle), 0.1f);
+    }
+}
@@ -0,0 +1,236 @@
+#include <doctest/doctest.h>
+
+#include <klein/interop.hpp>
+#include <klein/klein.hpp>
+
+#include "fixtures.hpp"
+
+#include <cstddef>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// Exercises full blocks of four and every length of the partial last block
+constexpr size_t counts[] = {0, 1, 2, 3, 4, 5, 6, 7, 37};
+
+float coordinate(size_t i, int j)
+{
+    return static_cast<float>((static_cast<int>(i) * 7 + j * 3) % 11) - 5.f;
+}
+
+// Reference results from the batch operators of the versor
+template <typename V>
+void check_xyz(V const& v)
+{
+    for (size_t count : counts)
+    {
+        std::vector<float> xyz(3 * count);
+        std::vector<point> points(count);
+        std::vector<direction> directions(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            float x            = coordinate(i, 0);
+            float y            = coordinate(i, 1);
+            float z            = coordinate(i, 2);
+            xyz[3 * i]         = x;
+            xyz[3 * i + 1]     = y;
+            xyz[3 * i + 2]     = z;
+            points[i]          = point{x, y, z};
+            float data[4]      = {0.f, x, y, z};
+            directions[i]      = direction{data};
+        }
+        v(points.data(), points.data(), count);
+        v(directions.data(), directions.data(), count);
+
+        // The float past the end must remain untouched
+        std::vector<float> out(3 * count + 1, 42.f);
+        apply_xyz<point>(v, xyz.data(), out.data(), count);
+        CHECK_EQ(out[3 * count], 42.f);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQ(out[3 * i], doctest::Approx(points[i].x()));
+            CHECK_EQ(out[3 * i + 1], doctest::Approx(points[i].y()));
+            CHECK_EQ(out[3 * i + 2], doctest::Approx(points[i].z()));
+        }
+
+        // In place
+        apply_xyz<direction>(v, xyz.data(), xyz.data(), count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQ(xyz[3 * i], doctest::Approx(directions[i].x()));
+            CHECK_EQ(xyz[3 * i + 1], doctest::Approx(directions[i].y()));
+            CHECK_EQ(xyz[3 * i + 2], doctest::Approx(directions[i].z()));
+        }
+    }
+}
+
+template <typename V>
+void check_xyzw(V const& v)
+{
+    for (size_t count : counts)
+    {
+        std::vector<float> xyzw(4 * count);
+        std::vector<point> points(count);
+        std::vector<direction> directions(count);
+        std::vector<plane> planes(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            float x             = coordinate(i, 0);
+            float y             = coordinate(i, 1);
+            float z             = coordinate(i, 2);
+            float w             = 1.f + static_cast<float>(i % 3);
+            xyzw[4 * i]         = x;
+            xyzw[4 * i + 1]     = y;
+            xyzw[4 * i + 2]     = z;
+            xyzw[4 * i + 3]     = w;
+            float point_data[4] = {w, x, y, z};
+            points[i].load(point_data);
+            float direction_data[4] = {0.f, x, y, z};
+            directions[i]           = direction{direction_data};
+            planes[i]               = plane{x, y, z, w};
+        }
+        v(points.data(), points.data(), count);
+        v(directions.data(), directions.data(), count);
+        v(planes.data(), planes.data(), count);
+
+        std::vector<float> out(4 * count + 1, 42.f);
+        apply_xyzw<point>(v, xyzw.data(), out.data(), count);
+        CHECK_EQ(out[4 * count], 42.f);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQ(out[4 * i], doctest::Approx(points[i].x()));
+            CHECK_EQ(out[4 * i + 1], doctest::Approx(points[i].y()));
+            CHECK_EQ(out[4 * i + 2], doctest::Approx(points[i].z()));
+            CHECK_EQ(out[4 * i + 3], doctest::Approx(points[i].w()));
+        }
+
+        apply_xyzw<direction>(v, xyzw.data(), out.data(), count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQ(out[4 * i], doctest::Approx(directions[i].x()));
+            CHECK_EQ(out[4 * i + 1], doctest::Approx(directions[i].y()));
+            CHECK_EQ(out[4 * i + 2], doctest::Approx(directions[i].z()));
+            CHECK_EQ(out[4 * i + 3], xyzw[4 * i + 3]);
+        }
+
+        // In place
+        apply_xyzw<plane>(v, xyzw.data(), xyzw.data(), count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQ(xyzw[4 * i], doctest::Approx(planes[i].x()));
+            CHECK_EQ(xyzw[4 * i + 1], doctest::Approx(planes[i].y()));
+            CHECK_EQ(xyzw[4 * i + 2], doctest::Approx(planes[i].z()));
+            CHECK_EQ(xyzw[4 * i + 3], doctest::Approx(planes[i].d()));
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("interop-xyz")
+{
+    motor m = fixture_motor();
+    rotor r = fixture_rotor();
+    check_xyz(m);
+    check_xyz(r);
+}
+
+TEST_CASE("interop-xyzw")
+{
+    motor m = fixture_motor();
+    rotor r = fixture_rotor();
+    check_xyzw(m);
+    check_xyzw(r);
+}
+
+namespace
+{
+struct vertex
+{
+    float uv[2];
+    float position[3];
+    float normal[3];
+    float color;
+};
+
+template <typename V>
+void check_vertices(V const& v)
+{
+    for (size_t count : counts)
+    {
+        std::vector<vertex> vertices(count + 1);
+        std::vector<point> points(count);
+        std::vector<direction> directions(count);
+        for (size_t i = 0; i != count + 1; ++i)
+        {
+            vertex& u = vertices[i];
+            u.uv[0]   = 0.25f;
+            u.uv[1]   = 0.75f;
+            u.color   = 42.f;
+            for (int j = 0; j != 3; ++j)
+            {
+                u.position[j] = coordinate(i, j);
+                u.normal[j]   = coordinate(i, j + 5);
+            }
+            if (i != count)
+            {
+                points[i]
+                    = point{u.position[0], u.position[1], u.position[2]};
+                float data[4] = {0.f, u.normal[0], u.normal[1], u.normal[2]};
+                directions[i] = direction{data};
+            }
+        }
+        v(points.data(), points.data(), count);
+        v(directions.data(), directions.data(), count);
+
+        vertex_layout layout{sizeof(vertex),
+                             offsetof(vertex, position),
+                             offsetof(vertex, normal)};
+        apply_vertices(v, vertices.data(), layout, count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            vertex const& u = vertices[i];
+            CHECK_EQ(u.position[0], doctest::Approx(points[i].x()));
+            CHECK_EQ(u.position[1], doctest::Approx(points[i].y()));
+            CHECK_EQ(u.position[2], doctest::Approx(points[i].z()));
+            CHECK_EQ(u.normal[0], doctest::Approx(directions[i].x()));
+            CHECK_EQ(u.normal[1], doctest::Approx(directions[i].y()));
+            CHECK_EQ(u.normal[2], doctest::Approx(directions[i].z()));
+
+            // Other attributes are untouched
+            CHECK_EQ(u.uv[0], 0.25f);
+            CHECK_EQ(u.uv[1], 0.75f);
+            CHECK_EQ(u.color, 42.f);
+        }
+
+        // The vertex past the end must remain untouched
+        CHECK_EQ(vertices[count].position[0], coordinate(count, 0));
+        CHECK_EQ(vertices[count].normal[2], coordinate(count, 7));
+
+        // Only the normals
+        layout.position = no_attribute;
+        apply_vertices(v, vertices.data(), layout, count);
+        v(directions.data(), directions.data(), count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            CHECK_EQ(vertices[i].position[0], doctest::Approx(points[i].x()));
+            CHECK_EQ(vertices[i].normal[0],
+                     doctest::Approx(directions[i].x()));
+            CHECK_EQ(vertices[i].normal[1],
+                     doctest::Approx(directions[i].y()));
+            CHECK_EQ(vertices[i].normal[2],
+                     doctest::Approx(directions[i].z()));
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("interop-vertices")
+{
+    motor m{1.f, 4.f, 3.f, 2.f, 5.f, 6.f, 7.f, 8.f};
+    m.normalize_precise();
+    rotor r{0.7f, 1.f, -2.f, 0.5f};
+    check_vertices(m);
+    check_vertices(r);
+}
@@ -0,0 +1,112 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/memory.hpp>
+
+#include "fixtures.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+bool is_aligned(void const* p)
+{
+    return reinterpret_cast<uintptr_t>(p) % cache_line_size == 0;
+}
+} // namespace
+
+TEST_CASE("aligned-vector")
+{
+    line axis{1.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+    aligned_vector<motor> motors;
+    for (int i = 0; i != 100; ++i)
+    {
+        motors.emplace_back(0.1f * static_cast<float>(i), 1.f, axis);
+        CHECK(is_aligned(motors.data()));
+    }
+    motor last{0.1f * 99.f, 1.f, axis};
+    CHECK_EQ(std::memcmp(&motors[99], &last, sizeof(motor)), 0);
+
+    aligned_vector<plane> planes(3);
+    CHECK(is_aligned(planes.data()));
+    aligned_span<plane> span{planes};
+    CHECK_EQ(span.size(), 3);
+    CHECK_EQ(span.data, planes.data());
+}
+
+TEST_CASE("arena")
+{
+    arena a{4096};
+    REQUIRE_EQ(a.capacity(), 4096);
+
+    aligned_span<point> p = a.allocate<point>(3);
+    REQUIRE_EQ(p.count, 3);
+    CHECK(is_aligned(p.data));
+    CHECK_EQ(a.used(), 3 * sizeof(point));
+
+    // The next allocation starts on a fresh cache line
+    aligned_span<motor> m = a.allocate<motor>(5);
+    REQUIRE_EQ(m.count, 5);
+    CHECK(is_aligned(m.data));
+    CHECK_EQ(reinterpret_cast<unsigned char*>(m.data)
+                 - reinterpret_cast<unsigned char*>(p.data),
+             64);
+
+    // Exhaustion leaves the arena untouched
+    size_t used = a.used();
+    CHECK(a.allocate<point>(4096).empty());
+    CHECK(a.allocate<point>(SIZE_MAX / 4).empty());
+    CHECK_EQ(a.used(), used);
+
+    a.reset();
+    CHECK_EQ(a.used(), 0);
+    CHECK_EQ(a.allocate<point>(256).count, 256);
+    CHECK(a.allocate_bytes(1) == nullptr);
+
+    // Moves transfer ownership
+    arena b{static_cast<arena&&>(a)};
+    CHECK_EQ(a.capacity(), 0);
+    CHECK_EQ(b.capacity(), 4096);
+    CHECK(a.allocate<point>(1).empty());
+
+    // Caller storage need not be aligned
+    std::vector<unsigned char> storage(1000);
+    arena c{storage.data() + 1, storage.size() - 1};
+    aligned_span<line> l = c.allocate<line>(4);
+    REQUIRE_EQ(l.count, 4);
+    CHECK(is_aligned(l.data));
+    CHECK(l.end() <= reinterpret_cast<line*>(storage.data() + storage.size()));
+}
+
+TEST_CASE("arena-huge-pages")
+{
+    // Falls back to regular pages when no huge pages are reserved
+    arena a{100, arena_pages::huge};
+    REQUIRE_EQ(a.capacity(), huge_page_size);
+    aligned_span<point> p = a.allocate<point>(huge_page_size / sizeof(point));
+    REQUIRE_EQ(p.count, huge_page_size / sizeof(point));
+    std::memset(p.data, 0, huge_page_size);
+}
+
+TEST_CASE("apply-span")
+{
+    motor m = fixture_motor();
+    arena a{1 << 16};
+    aligned_span<point> in  = a.allocate<point>(101);
+    aligned_span<point> out = a.allocate<point>(101);
+    for (size_t i = 0; i != in.size(); ++i)
+    {
+        in[i] = point{static_cast<float>(i), 1.f, -2.f};
+    }
+    std::vector<point> expected(in.begin(), in.end());
+    m(expected.data(), expected.data(), expected.size());
+
+    apply(m, in, out);
+    CHECK_EQ(std::memcmp(out.data, expected.data(), sizeof(point) * 101), 0);
+    apply(m, in);
+    CHECK_EQ(std::memcmp(in.data, expected.data(), sizeof(point) * 101), 0);
+}
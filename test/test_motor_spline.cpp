@@ -0,0 +1,259 @@
+#define _USE_MATH_DEFINES
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/motor_spline.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace kln;
+
+namespace
+{
+// Unless KLEIN_PRECISE is defined, exp and log use approximate reciprocal
+// square roots, so a log/exp round trip is accurate to about 1e-3
+constexpr float round_trip_epsilon = 2e-3f;
+
+// Motors are compared by their action since m and -m are the same motion
+void check_action(motor const& a, motor const& b, float epsilon)
+{
+    point points[2] = {point{1.f, 2.f, 3.f}, point{-1.f, 0.5f, 2.f}};
+    for (point p : points)
+    {
+        point pa = a(p);
+        point pb = b(p);
+        CHECK_EQ(pa.x(), doctest::Approx(pb.x()).epsilon(epsilon));
+        CHECK_EQ(pa.y(), doctest::Approx(pb.y()).epsilon(epsilon));
+        CHECK_EQ(pa.z(), doctest::Approx(pb.z()).epsilon(epsilon));
+    }
+}
+
+void check_motor(motor const& a, motor const& b, float epsilon)
+{
+    CHECK_EQ(a.scalar(), doctest::Approx(b.scalar()).epsilon(epsilon));
+    CHECK_EQ(a.e23(), doctest::Approx(b.e23()).epsilon(epsilon));
+    CHECK_EQ(a.e31(), doctest::Approx(b.e31()).epsilon(epsilon));
+    CHECK_EQ(a.e12(), doctest::Approx(b.e12()).epsilon(epsilon));
+    CHECK_EQ(a.e01(), doctest::Approx(b.e01()).epsilon(epsilon));
+    CHECK_EQ(a.e02(), doctest::Approx(b.e02()).epsilon(epsilon));
+    CHECK_EQ(a.e03(), doctest::Approx(b.e03()).epsilon(epsilon));
+    CHECK_EQ(a.e0123(), doctest::Approx(b.e0123()).epsilon(epsilon));
+}
+
+// e^l in double precision. The scalar exp approximates reciprocals even with
+// KLEIN_PRECISE, so the batched kernels are held to this instead.
+motor exp_reference(line const& l)
+{
+    double a[3] = {l.e23(), l.e31(), l.e12()};
+    double b[3] = {l.e01(), l.e02(), l.e03()};
+    double u    = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+    double ab   = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    // sin u / u and (cos u - sin u / u) / u^2
+    double sinc = u < 1e-6 ? 1.0 : std::sin(u) / u;
+    double g    = u < 1e-2 ? -1.0 / 3.0 : (std::cos(u) - sinc) / (u * u);
+    float c[8];
+    c[0] = static_cast<float>(std::cos(u));
+    for (size_t i = 0; i != 3; ++i)
+    {
+        c[1 + i] = static_cast<float>(sinc * a[i]);
+        c[4 + i] = static_cast<float>(sinc * b[i] + ab * g * a[i]);
+    }
+    c[7] = static_cast<float>(ab * sinc);
+    return {c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7]};
+}
+
+// The spline through count controls at time t, following the cumulative form
+// documented in motor_spline.hpp with exp_reference
+motor spline_reference(motor const* controls,
+                       line const* logs,
+                       size_t count,
+                       motor_spline::basis basis,
+                       float t)
+{
+    bool bezier     = basis == motor_spline::basis::bezier;
+    size_t segments = bezier ? (count - 1) / 3 : count - 3;
+    t               = std::clamp(t, 0.f, static_cast<float>(segments));
+    size_t i        = std::min(static_cast<size_t>(t), segments - 1);
+    float u         = t - static_cast<float>(i);
+
+    float w[3];
+    switch (basis)
+    {
+    case motor_spline::basis::b_spline:
+        w[0] = (5.f + 3.f * u - 3.f * u * u + u * u * u) / 6.f;
+        w[1] = (1.f + 3.f * u + 3.f * u * u - 2.f * u * u * u) / 6.f;
+        w[2] = u * u * u / 6.f;
+        break;
+    case motor_spline::basis::catmull_rom:
+        w[0] = 1.f + 0.5f * (u - 2.f * u * u + u * u * u);
+        w[1] = 0.5f * (u + 3.f * u * u - 2.f * u * u * u);
+        w[2] = 0.5f * (u * u * u - u * u);
+        break;
+    case motor_spline::basis::bezier:
+        w[0] = 3.f * u - 3.f * u * u + u * u * u;
+        w[1] = 3.f * u * u - 2.f * u * u * u;
+        w[2] = u * u * u;
+        break;
+    }
+
+    size_t first = bezier ? 3 * i : i;
+    motor out    = controls[first];
+    for (size_t j = 0; j != 3; ++j)
+    {
+        out = out * exp_reference(logs[first + j] * w[j]);
+    }
+    return out;
+}
+
+// Screw motions about lines which wander through space
+struct keys
+{
+    motor controls[10];
+    line logs[motor_spline::log_count(10)];
+
+    keys()
+    {
+        for (size_t i = 0; i != 10; ++i)
+        {
+            float f     = static_cast<float>(i);
+            line axis   = line{0.3f * f,
+                             -0.2f * f,
+                             1.f,
+                             std::cos(f),
+                             std::sin(f),
+                             0.5f};
+            controls[i] = motor{0.4f * f, 0.1f * f, axis};
+            controls[i].normalize_precise();
+        }
+    }
+};
+} // namespace
+
+TEST_CASE("motor-spline-catmull-rom")
+{
+    keys k;
+    motor_spline spline{
+        k.controls, 10, k.logs, motor_spline::basis::catmull_rom};
+    REQUIRE_EQ(spline.segment_count(), 7);
+
+    // Every interior control is interpolated
+    for (size_t i = 0; i <= spline.segment_count(); ++i)
+    {
+        check_action(spline(static_cast<float>(i)),
+                     k.controls[i + 1],
+                     round_trip_epsilon);
+    }
+
+    // C1 across segment boundaries
+    motor before = spline(2.999f);
+    motor at     = spline(3.f);
+    motor after  = spline(3.001f);
+    check_action(before, at, 1e-2f);
+    check_action(after, at, 1e-2f);
+}
+
+TEST_CASE("motor-spline-bezier")
+{
+    keys k;
+    motor_spline spline{k.controls, 10, k.logs, motor_spline::basis::bezier};
+    REQUIRE_EQ(spline.segment_count(), 3);
+
+    // The controls shared by successive segments are interpolated
+    for (size_t i = 0; i <= spline.segment_count(); ++i)
+    {
+        check_action(spline(static_cast<float>(i)),
+                     k.controls[3 * i],
+                     round_trip_epsilon);
+    }
+
+    // Times outside the valid range are clamped
+    check_action(spline(-1.f), k.controls[0], round_trip_epsilon);
+    check_action(spline(4.f), k.controls[9], round_trip_epsilon);
+}
+
+TEST_CASE("motor-spline-b-spline")
+{
+    // Translations commute so the spline reduces to the B-spline of the
+    // displacements
+    float x[6] = {0.f, 1.f, 3.f, 2.f, -1.f, 0.5f};
+    motor controls[6];
+    for (size_t i = 0; i != 6; ++i)
+    {
+        controls[i] = motor{translator{x[i], 1.f, 0.f, 0.f}};
+    }
+    line logs[motor_spline::log_count(6)];
+    motor_spline spline{controls, 6, logs};
+    REQUIRE_EQ(spline.segment_count(), 3);
+
+    for (size_t i = 0; i != 3; ++i)
+    {
+        float expected = (x[i] + 4.f * x[i + 1] + x[i + 2]) / 6.f;
+        point p        = spline(static_cast<float>(i))(origin{});
+        CHECK_EQ(p.x(), doctest::Approx(expected).epsilon(1e-5));
+        CHECK_EQ(p.y(), doctest::Approx(0.f).epsilon(1e-5));
+        CHECK_EQ(p.z(), doctest::Approx(0.f).epsilon(1e-5));
+    }
+}
+
+TEST_CASE("motor-spline-evaluate")
+{
+    keys k;
+    motor_spline::basis bases[3] = {motor_spline::basis::b_spline,
+                                    motor_spline::basis::catmull_rom,
+                                    motor_spline::basis::bezier};
+    for (motor_spline::basis b : bases)
+    {
+        motor_spline spline{k.controls, 10, k.logs, b};
+
+        // A count which is not a multiple of four exercises the tail
+        float times[37];
+        for (size_t i = 0; i != 37; ++i)
+        {
+            times[i] = -0.5f
+                       + (spline.segment_count() + 1.f) * static_cast<float>(i)
+                             / 36.f;
+        }
+        motor out[38];
+        out[37] = motor{2.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+        spline.evaluate(times, 37, out);
+
+        for (size_t i = 0; i != 37; ++i)
+        {
+            // exp4 and gpMM4 are exact up to rounding while the scalar path
+            // inherits the approximations of exp
+            check_motor(out[i],
+                        spline_reference(k.controls, k.logs, 10, b, times[i]),
+                        1e-5f);
+            check_motor(out[i], spline(times[i]), round_trip_epsilon);
+        }
+        // Nothing is written past the end
+        CHECK_EQ(out[37].scalar(), 2.f);
+    }
+}
+
+TEST_CASE("motor-spline-degenerate")
+{
+    keys k;
+    float times[5] = {-1.f, 0.f, 0.5f, 1.f, 2.f};
+    motor out[5];
+
+    // Too few controls for a segment
+    for (size_t count = 1; count != 4; ++count)
+    {
+        motor_spline spline{k.controls, count, k.logs};
+        REQUIRE_EQ(spline.segment_count(), 0);
+        check_motor(spline(0.5f), k.controls[0], 1e-6f);
+        spline.evaluate(times, 5, out);
+        for (motor const& m : out)
+        {
+            check_motor(m, k.controls[0], 1e-6f);
+        }
+    }
+
+    // No controls at all
+    motor_spline empty;
+    REQUIRE_EQ(empty.segment_count(), 0);
+    motor identity{1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    check_motor(empty(0.5f), identity, 1e-6f);
+}
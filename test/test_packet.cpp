@@ -0,0 +1,123 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/packet.hpp>
+
+using namespace kln;
+
+namespace
+{
+line test_line(size_t i)
+{
+    float f = static_cast<float>(i);
+    return {0.5f * f, 1.f, 2.f - f, f - 3.f, 1.f, 0.25f * f + 1.f};
+}
+
+void check(line const& a, line const& b)
+{
+    CHECK_EQ(a.e23(), doctest::Approx(b.e23()).epsilon(1e-5));
+    CHECK_EQ(a.e31(), doctest::Approx(b.e31()).epsilon(1e-5));
+    CHECK_EQ(a.e12(), doctest::Approx(b.e12()).epsilon(1e-5));
+    CHECK_EQ(a.e01(), doctest::Approx(b.e01()).epsilon(1e-5));
+    CHECK_EQ(a.e02(), doctest::Approx(b.e02()).epsilon(1e-5));
+    CHECK_EQ(a.e03(), doctest::Approx(b.e03()).epsilon(1e-5));
+}
+
+void check(point const& a, point const& b)
+{
+    CHECK_EQ(a.x(), doctest::Approx(b.x()).epsilon(1e-5));
+    CHECK_EQ(a.y(), doctest::Approx(b.y()).epsilon(1e-5));
+    CHECK_EQ(a.z(), doctest::Approx(b.z()).epsilon(1e-5));
+    CHECK_EQ(a.w(), doctest::Approx(b.w()).epsilon(1e-5));
+}
+
+template <size_t Width>
+void check_packet()
+{
+    line lines[Width];
+    for (size_t i = 0; i != Width; ++i)
+    {
+        lines[i] = test_line(i);
+    }
+    line_packet<Width> packet{lines};
+    for (size_t i = 0; i != Width; ++i)
+    {
+        check(packet.get(i), lines[i]);
+    }
+
+    motor m{1.f, 4.f, 3.f, 2.f, 5.f, 6.f, 7.f, 8.f};
+    m.normalize();
+    line_packet<Width> moved = apply(m, packet);
+    rotor r{0.7f, 1.f, -2.f, 0.5f};
+    line_packet<Width> rotated = apply(r, packet);
+    for (size_t i = 0; i != Width; ++i)
+    {
+        check(moved.get(i), m(lines[i]));
+        check(rotated.get(i), r(lines[i]));
+    }
+
+    // No line is parallel to the plane
+    plane p{1.f, 2.f, 0.5f, 3.f};
+    point_packet<Width> hits = p ^ packet;
+    point stored[Width];
+    hits.store(stored);
+    for (size_t i = 0; i != Width; ++i)
+    {
+        check(hits.get(i), p ^ lines[i]);
+        check(stored[i], p ^ lines[i]);
+    }
+    hits.normalize();
+    for (size_t i = 0; i != Width; ++i)
+    {
+        // point::normalize uses an approximate reciprocal
+        point meet = p ^ lines[i];
+        float w    = meet.w();
+        check(hits.get(i), point{meet.x() / w, meet.y() / w, meet.z() / w});
+        CHECK_EQ(hits.get(i).w(), 1.f);
+    }
+
+    line_packet<Width> unit = packet.normalized();
+    for (size_t i = 0; i != Width; ++i)
+    {
+        line l = unit.get(i);
+        // l^2 = -1, so the squared norm is one and the pseudoscalar of
+        // l * ~l vanishes
+        CHECK_EQ(l.squared_norm(), doctest::Approx(1.f).epsilon(1e-5));
+        float bc = l.e23() * l.e01() + l.e31() * l.e02() + l.e12() * l.e03();
+        CHECK_EQ(bc, doctest::Approx(0.f).scale(1.f).epsilon(1e-5));
+        line expected = lines[i];
+        expected.normalize();
+        CHECK(l.approx_eq(expected, 1e-3f));
+    }
+}
+} // namespace
+
+TEST_CASE("packet-lines")
+{
+    check_packet<4>();
+    check_packet<8>();
+}
+
+TEST_CASE("packet-partial")
+{
+    line lines[5];
+    for (size_t i = 0; i != 5; ++i)
+    {
+        lines[i] = test_line(i);
+    }
+    line_packet<8> packet{lines, 5};
+    for (size_t i = 5; i != 8; ++i)
+    {
+        check(packet.get(i), line{0.f, 0.f, 0.f, 0.f, 0.f, 0.f});
+    }
+
+    // Only the first five lines are written back
+    line out[6];
+    out[5] = test_line(9);
+    apply(motor{translator{1.f, 0.f, 0.f, 1.f}}, packet).store(out, 5);
+    check(out[5], test_line(9));
+    for (size_t i = 0; i != 5; ++i)
+    {
+        check(out[i], translator{1.f, 0.f, 0.f, 1.f}(lines[i]));
+    }
+}
@@ -0,0 +1,153 @@
+#include <doctest/doctest.h>
+
+#include <klein/kd_tree.hpp>
+#include <klein/klein.hpp>
+#include <klein/parallel.hpp>
+
+#include "fixtures.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// Large enough for several chunks of every entity
+constexpr size_t count = 3 * 4096 + 17;
+
+template <typename T>
+bool equal(T const& a, T const& b)
+{
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+// Transform the same array serially and in parallel (out of place and in
+// place) and compare the results bit for bit
+template <typename V, typename T, typename F>
+void check_apply(V const& v, F&& make, parallel::pool& p)
+{
+    std::vector<T> in(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        in[i] = make(static_cast<float>(i));
+    }
+    std::vector<T> expected(count);
+    std::vector<T> actual(count);
+    std::vector<T> in_place = in;
+
+    v(in.data(), expected.data(), count);
+    parallel::apply(v, in.data(), actual.data(), count, p);
+    parallel::apply(v, in_place.data(), in_place.data(), count, p);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i != count; ++i)
+    {
+        mismatches += equal(expected[i], actual[i]) ? 0 : 1;
+        mismatches += equal(expected[i], in_place[i]) ? 0 : 1;
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+template <typename V>
+void check_entities(V const& v, parallel::pool& p)
+{
+    check_apply<V, point>(
+        v, [](float x) { return point{x, -x, 0.5f * x}; }, p);
+    check_apply<V, direction>(
+        v, [](float x) { return direction{1.f, x, -x}; }, p);
+    check_apply<V, plane>(
+        v, [](float x) { return plane{1.f, 2.f, x, -x}; }, p);
+    check_apply<V, line>(
+        v, [](float x) { return line{x, 1.f, -x, 0.5f, x, 2.f}; }, p);
+}
+} // namespace
+
+TEST_CASE("parallel-apply")
+{
+    motor m = fixture_motor();
+    rotor r = fixture_rotor();
+
+    parallel::pool p{4};
+    CHECK_EQ(p.size(), 4);
+    check_entities(m, p);
+    check_entities(r, p);
+
+    // A pool of one worker runs everything on the calling thread
+    parallel::pool serial{1};
+    CHECK_EQ(serial.size(), 1);
+    check_entities(m, serial);
+
+    // Empty arrays are never dereferenced
+    parallel::apply(m, static_cast<point*>(nullptr), nullptr, 0, p);
+}
+
+TEST_CASE("parallel-executor")
+{
+    parallel::pool p{3};
+
+    // Every task runs exactly once, repeatedly
+    for (size_t n : {size_t{0}, size_t{1}, size_t{2}, size_t{1000}})
+    {
+        std::vector<std::atomic<int>> calls(n);
+        for (int round = 0; round != 5; ++round)
+        {
+            p(n, [&calls](size_t i) { ++calls[i]; });
+        }
+        size_t wrong = 0;
+        for (std::atomic<int>& c : calls)
+        {
+            wrong += c.load() == 5 ? 0 : 1;
+        }
+        CHECK_EQ(wrong, 0);
+    }
+
+    // Chunks cover the range without overlap
+    std::vector<std::atomic<int>> touched(10001);
+    p.for_each_chunk(touched.size(), 64, [&touched](size_t begin, size_t end) {
+        CHECK_LE(end - begin, 64);
+        for (size_t i = begin; i != end; ++i)
+        {
+            ++touched[i];
+        }
+    });
+    size_t wrong = 0;
+    for (std::atomic<int>& t : touched)
+    {
+        wrong += t.load() == 1 ? 0 : 1;
+    }
+    CHECK_EQ(wrong, 0);
+
+    // The pool is a valid executor for building trees
+    std::vector<point> points;
+    for (int i = 0; i != 500; ++i)
+    {
+        float x = static_cast<float>(i);
+        points.emplace_back(x * 0.37f, 10.f - x * 0.11f, x * x * 0.001f);
+    }
+    std::vector<kd_tree::node> storage(points.size());
+    std::vector<kd_tree::node> serial_storage(points.size());
+    kd_tree tree;
+    kd_tree serial_tree;
+    tree.build(points.data(), points.size(), storage.data(), p);
+    serial_tree.build(points.data(), points.size(), serial_storage.data());
+
+    point query{20.f, 5.f, 30.f};
+    CHECK_EQ(tree.nearest(query).index, serial_tree.nearest(query).index);
+}
+
+TEST_CASE("parallel-first-touch")
+{
+    parallel::pool p{4};
+    std::unique_ptr<point[]> points{new point[count]};
+    parallel::first_touch(points.get(), count, p);
+
+    size_t nonzero = 0;
+    for (size_t i = 0; i != count; ++i)
+    {
+        nonzero += equal(points[i], point{_mm_setzero_ps()}) ? 0 : 1;
+    }
+    CHECK_EQ(nonzero, 0);
+}
@@ -0,0 +1,74 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/profile.hpp>
+#include <klein/soa.hpp>
+
+#include <cstring>
+
+using namespace kln;
+
+TEST_CASE("profile")
+{
+    profile::reset();
+
+    motor m{1.f, 4.f, 3.f, 2.f, 5.f, 6.f, 7.f, 8.f};
+    point points[37];
+    for (point& p : points)
+    {
+        p = point{1.f, 2.f, 3.f};
+    }
+    m(points, points, 37);
+    m(points, points, 37);
+
+    rotor r{1.f, 0.f, 0.f, 1.f};
+    line lines[5] = {line{1.f, 2.f, 3.f, 4.f, 5.f, 6.f},
+                     line{0.f, 1.f, 0.f, 1.f, 0.f, 0.f},
+                     line{-1.f, 0.5f, 2.f, 0.f, 0.f, 1.f},
+                     line{3.f, 0.f, -2.f, 1.f, -1.f, 0.5f},
+                     line{0.f, 0.f, 0.f, 0.f, 1.f, 0.f}};
+    line rotated[5];
+    r(lines, rotated, 5);
+    for (size_t i = 0; i != 5; ++i)
+    {
+        // The probes leave the results of the batch operator unchanged
+        CHECK(rotated[i].approx_eq(r(lines[i]), 1e-5f));
+    }
+
+    alignas(16) float storage[point_soa::storage_size(37)];
+    point_soa soa{storage, 37};
+    soa.pack(points);
+    apply(m, soa, soa);
+
+    profile::stats s = profile::get(profile::kernel::motor_points);
+    if constexpr (profile::enabled())
+    {
+        CHECK_EQ(s.calls, 2);
+        CHECK_EQ(s.elements, 74);
+        CHECK_EQ(profile::get(profile::kernel::rotor_lines).calls, 1);
+        CHECK_EQ(profile::get(profile::kernel::motor_lines).calls, 0);
+        CHECK_EQ(profile::get(profile::kernel::soa_apply).elements, 37);
+        if (profile::counters_available())
+        {
+            CHECK_GT(s.instructions, 0);
+        }
+
+        size_t visited = 0;
+        profile::for_each([&](profile::kernel, profile::stats const&) {
+            ++visited;
+        });
+        CHECK_EQ(visited, 3);
+
+        profile::reset();
+        CHECK_EQ(profile::get(profile::kernel::motor_points).calls, 0);
+    }
+    else
+    {
+        CHECK_EQ(s.calls, 0);
+        CHECK_FALSE(profile::counters_available());
+    }
+
+    CHECK_EQ(std::strcmp(profile::name(profile::kernel::motor_points),
+                         "motor_points"),
+             0);
+}
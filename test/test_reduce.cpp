@@ -0,0 +1,200 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/reduce.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+// Exercises every length of the partial last block
+constexpr size_t counts[] = {0, 1, 2, 3, 4, 5, 6, 7, 37};
+
+float coordinate(size_t i, int j)
+{
+    return static_cast<float>((static_cast<int>(i) * 7 + j * 3) % 11) - 5.f;
+}
+
+std::vector<point> test_points(size_t count)
+{
+    std::vector<point> out;
+    for (size_t i = 0; i != count; ++i)
+    {
+        out.emplace_back(coordinate(i, 0), coordinate(i, 1), coordinate(i, 2));
+    }
+    return out;
+}
+
+std::vector<plane> test_planes(size_t count)
+{
+    std::vector<plane> out;
+    for (size_t i = 0; i != count; ++i)
+    {
+        out.emplace_back(coordinate(i, 0),
+                         coordinate(i, 1),
+                         coordinate(i, 2),
+                         coordinate(i, 3));
+    }
+    return out;
+}
+
+std::vector<line> test_lines(size_t count)
+{
+    std::vector<line> out;
+    for (size_t i = 0; i != count; ++i)
+    {
+        out.emplace_back(coordinate(i, 0),
+                         coordinate(i, 1),
+                         coordinate(i, 2),
+                         coordinate(i, 3),
+                         coordinate(i, 4),
+                         coordinate(i, 5));
+    }
+    return out;
+}
+
+template <typename E>
+void check_dot_sum(std::vector<E> const& a, std::vector<E> const& b)
+{
+    double expected = 0.0;
+    for (size_t i = 0; i != a.size(); ++i)
+    {
+        expected += a[i] | b[i];
+    }
+    float sum = dot_sum(a.data(), b.data(), a.size());
+    CHECK_EQ(sum, doctest::Approx(expected));
+    sum = dot_sum(a.data(), b.data(), a.size(), summation::compensated);
+    CHECK_EQ(sum, doctest::Approx(expected));
+}
+} // namespace
+
+TEST_CASE("reduce-dot")
+{
+    for (size_t count : counts)
+    {
+        std::vector<point> points = test_points(count + 3);
+        check_dot_sum(std::vector<point>(points.begin(), points.end() - 3),
+                      std::vector<point>(points.begin() + 3, points.end()));
+
+        std::vector<plane> planes = test_planes(count + 3);
+        check_dot_sum(std::vector<plane>(planes.begin(), planes.end() - 3),
+                      std::vector<plane>(planes.begin() + 3, planes.end()));
+
+        std::vector<line> lines = test_lines(count + 3);
+        check_dot_sum(std::vector<line>(lines.begin(), lines.end() - 3),
+                      std::vector<line>(lines.begin() + 3, lines.end()));
+    }
+}
+
+TEST_CASE("reduce-distance")
+{
+    plane p{1.f, 2.f, -2.f, 0.5f};
+    p.normalize();
+    point c{0.5f, -1.f, 2.f};
+
+    for (size_t count : counts)
+    {
+        std::vector<point> points = test_points(count);
+        double plane_sum = 0.0;
+        double point_sum = 0.0;
+        float plane_max  = 0.f;
+        float point_max  = 0.f;
+        for (point const& x : points)
+        {
+            float d = (p ^ x).q;
+            plane_sum += d * d;
+            plane_max = std::max(plane_max, std::abs(d));
+
+            float dx = x.x() - c.x();
+            float dy = x.y() - c.y();
+            float dz = x.z() - c.z();
+            float d2 = dx * dx + dy * dy + dz * dz;
+            point_sum += d2;
+            point_max = std::max(point_max, std::sqrt(d2));
+        }
+
+        CHECK_EQ(squared_distance_sum(p, points.data(), count),
+                 doctest::Approx(plane_sum));
+        CHECK_EQ(squared_distance_sum(
+                     p, points.data(), count, summation::compensated),
+                 doctest::Approx(plane_sum));
+        CHECK_EQ(squared_distance_sum(c, points.data(), count),
+                 doctest::Approx(point_sum));
+        CHECK_EQ(max_distance(p, points.data(), count),
+                 doctest::Approx(plane_max));
+        CHECK_EQ(max_distance(c, points.data(), count),
+                 doctest::Approx(point_max));
+    }
+}
+
+TEST_CASE("reduce-moments")
+{
+    std::vector<point> points = test_points(37);
+    std::vector<float> weights(37);
+    for (size_t i = 0; i != 37; ++i)
+    {
+        weights[i] = 0.5f + static_cast<float>(i % 4);
+    }
+
+    point_moments m     = moments(points.data(), weights.data(), 37);
+    double expected[10] = {};
+    for (size_t i = 0; i != 37; ++i)
+    {
+        double w = weights[i];
+        double x = points[i].x();
+        double y = points[i].y();
+        double z = points[i].z();
+        double terms[10]
+            = {1.0, x, y, z, x * x, x * y, x * z, y * y, y * z, z * z};
+        for (size_t j = 0; j != 10; ++j)
+        {
+            expected[j] += w * terms[j];
+        }
+    }
+    CHECK_EQ(m.weight, doctest::Approx(expected[0]));
+    for (size_t j = 0; j != 3; ++j)
+    {
+        CHECK_EQ(m.first[j], doctest::Approx(expected[1 + j]));
+    }
+    for (size_t j = 0; j != 6; ++j)
+    {
+        CHECK_EQ(m.second[j], doctest::Approx(expected[4 + j]));
+    }
+
+    // Unit weights
+    m = moments(points.data(), nullptr, 5, summation::compensated);
+    CHECK_EQ(m.weight, 5.f);
+    point centroid = m.centroid();
+    float x        = 0.f;
+    for (size_t i = 0; i != 5; ++i)
+    {
+        x += points[i].x();
+    }
+    CHECK_EQ(centroid.x(), doctest::Approx(x / 5.f));
+
+    // Points on the plane z = 1 have no variance in z
+    point flat[4] = {point{0.f, 0.f, 1.f},
+                     point{2.f, 0.f, 1.f},
+                     point{0.f, 2.f, 1.f},
+                     point{2.f, 2.f, 1.f}};
+    float covariance[6];
+    moments(flat, nullptr, 4).covariance(covariance);
+    CHECK_EQ(covariance[0], doctest::Approx(1.f));
+    CHECK_EQ(covariance[1], doctest::Approx(0.f));
+    CHECK_EQ(covariance[3], doctest::Approx(1.f));
+    CHECK_EQ(covariance[5], doctest::Approx(0.f));
+}
+
+TEST_CASE("reduce-compensated")
+{
+    // A large first term swamps the rest in a plain single precision sum
+    std::vector<plane> a(4097, plane{1.f, 0.f, 0.f, 0.f});
+    std::vector<plane> b(4097, plane{1e-4f, 0.f, 0.f, 0.f});
+    b[0] = plane{1e4f, 0.f, 0.f, 0.f};
+    float sum = dot_sum(a.data(), b.data(), a.size(), summation::compensated);
+    CHECK_EQ(sum, doctest::Approx(1e4 + 4096 * 1e-4).epsilon(1e-7));
+}
@@ -0,0 +1,170 @@
+#define _USE_MATH_DEFINES
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/rigid_body.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+void check_motor(motor const& a, motor const& b, float epsilon)
+{
+    CHECK_EQ(a.scalar(), doctest::Approx(b.scalar()).epsilon(epsilon));
+    CHECK_EQ(a.e23(), doctest::Approx(b.e23()).epsilon(epsilon));
+    CHECK_EQ(a.e31(), doctest::Approx(b.e31()).epsilon(epsilon));
+    CHECK_EQ(a.e12(), doctest::Approx(b.e12()).epsilon(epsilon));
+    CHECK_EQ(a.e01(), doctest::Approx(b.e01()).epsilon(epsilon));
+    CHECK_EQ(a.e02(), doctest::Approx(b.e02()).epsilon(epsilon));
+    CHECK_EQ(a.e03(), doctest::Approx(b.e03()).epsilon(epsilon));
+    CHECK_EQ(a.e0123(), doctest::Approx(b.e0123()).epsilon(epsilon));
+}
+} // namespace
+
+TEST_CASE("soa-sincos")
+{
+    for (float x = -20.f; x < 20.f; x += 0.37f)
+    {
+        __m128 s;
+        __m128 c;
+        detail::sincos_ps(_mm_set_ps(x, -x, 0.5f * x, 0.f), s, c);
+        float sv[4];
+        float cv[4];
+        _mm_storeu_ps(sv, s);
+        _mm_storeu_ps(cv, c);
+        CHECK_EQ(sv[3], doctest::Approx(std::sin(x)).epsilon(1e-5));
+        CHECK_EQ(cv[3], doctest::Approx(std::cos(x)).epsilon(1e-5));
+        CHECK_EQ(sv[2], doctest::Approx(-std::sin(x)).epsilon(1e-5));
+        CHECK_EQ(cv[1], doctest::Approx(std::cos(0.5f * x)).epsilon(1e-5));
+        CHECK_EQ(sv[0], 0.f);
+        CHECK_EQ(cv[0], 1.f);
+    }
+}
+
+TEST_CASE("soa-exp-gp")
+{
+    // Lines with a large, a small, a vanishing, and a purely ideal rotation
+    line lines[4] = {line{1.f, -2.f, 0.5f, 0.8f, -1.2f, 0.4f},
+                     line{0.3f, 0.1f, -0.2f, 0.01f, 0.02f, -0.03f},
+                     line{0.3f, 0.1f, -0.2f, 1e-5f, 0.f, 0.f},
+                     line{0.3f, 0.1f, -0.2f, 0.f, 0.f, 0.f}};
+
+    std::vector<rigid_body::block> storage(rigid_body::block_count(4));
+    rigid_body bodies{storage.data(), 4};
+    motor start{1.f, 2.f, -1.f, 0.5f, 0.2f, -0.3f, 0.7f, 0.1f};
+    start.normalize_precise();
+    for (size_t i = 0; i != 4; ++i)
+    {
+        bodies.set_motor(i, start);
+        bodies.set_rate(i, lines[i]);
+    }
+    bodies.integrate_kinematic(0.5f);
+
+    for (size_t i = 0; i != 4; ++i)
+    {
+        motor expected = start * exp(lines[i] * -0.25f);
+        expected.normalize_precise();
+        check_motor(bodies.get_motor(i), expected, 1e-3f);
+    }
+}
+
+TEST_CASE("rigid-body-kinematic")
+{
+    // Spin about the z-axis at one radian per second for half a turn
+    std::vector<rigid_body::block> storage(rigid_body::block_count(5));
+    rigid_body bodies{storage.data(), 5};
+    bodies.set_rate(4, line{0.f, 0.f, 0.f, 0.f, 0.f, 1.f});
+    for (int i = 0; i != 100; ++i)
+    {
+        bodies.integrate_kinematic(M_PI / 100.f);
+    }
+
+    point p = bodies.get_motor(4)(point{1.f, 0.f, 0.f});
+    CHECK_EQ(p.x(), doctest::Approx(-1.f).epsilon(1e-4));
+    CHECK_EQ(p.y(), doctest::Approx(0.f).epsilon(1e-4));
+
+    // Bodies at rest are unaffected
+    CHECK_EQ(bodies.get_motor(0).scalar(), 1.f);
+}
+
+TEST_CASE("rigid-body-conservation")
+{
+    // An asymmetric body spinning near its intermediate axis tumbles. The
+    // kinetic energy and the magnitude of the angular momentum are conserved.
+    float ix = 1.f;
+    float iy = 2.f;
+    float iz = 3.f;
+    std::vector<rigid_body::block> storage(rigid_body::block_count(2));
+    rigid_body bodies{storage.data(), 2};
+    for (size_t i = 0; i != 2; ++i)
+    {
+        bodies.set_inertia(i, ix, iy, iz);
+        bodies.set_rate(i, line{1.f, 0.f, 0.f, 0.01f, 2.f, 0.01f});
+    }
+
+    auto invariants = [&](line l, float& energy, float& momentum2) {
+        float wx  = l.e23();
+        float wy  = l.e31();
+        float wz  = l.e12();
+        energy    = ix * wx * wx + iy * wy * wy + iz * wz * wz;
+        momentum2 = ix * ix * wx * wx + iy * iy * wy * wy + iz * iz * wz * wz;
+    };
+
+    float energy;
+    float momentum2;
+    invariants(bodies.get_rate(0), energy, momentum2);
+
+    for (int i = 0; i != 1000; ++i)
+    {
+        bodies.integrate_rk4(0.005f);
+    }
+
+    float rk4_energy;
+    float rk4_momentum2;
+    invariants(bodies.get_rate(0), rk4_energy, rk4_momentum2);
+    CHECK_EQ(rk4_energy, doctest::Approx(energy).epsilon(1e-4));
+    CHECK_EQ(rk4_momentum2, doctest::Approx(momentum2).epsilon(1e-4));
+
+    // The angular velocity must have left the intermediate axis
+    CHECK_LT(std::abs(bodies.get_rate(0).e31()), 1.9f);
+
+    // The world linear velocity (and hence the speed in the body frame) is
+    // constant
+    line rate = bodies.get_rate(1);
+    float speed2 = rate.e01() * rate.e01() + rate.e02() * rate.e02()
+                   + rate.e03() * rate.e03();
+    CHECK_EQ(speed2, doctest::Approx(1.f).epsilon(1e-3));
+
+    // The motor remains normalized
+    motor m = bodies.get_motor(0);
+    motor n = m;
+    n.normalize_precise();
+    check_motor(m, n, 1e-5f);
+}
+
+TEST_CASE("rigid-body-symplectic")
+{
+    std::vector<rigid_body::block> storage(rigid_body::block_count(1));
+    rigid_body bodies{storage.data(), 1};
+    bodies.set_inertia(0, 1.f, 2.f, 3.f);
+    bodies.set_rate(0, line{0.f, 0.f, 0.f, 1.f, 0.5f, 0.2f});
+
+    line before = bodies.get_rate(0);
+    for (int i = 0; i != 1000; ++i)
+    {
+        bodies.integrate_symplectic(0.001f);
+    }
+    line after = bodies.get_rate(0);
+
+    // First order accuracy over a short horizon
+    auto energy = [](line l) {
+        return l.e23() * l.e23() + 2.f * l.e31() * l.e31()
+               + 3.f * l.e12() * l.e12();
+    };
+    CHECK_EQ(energy(after), doctest::Approx(energy(before)).epsilon(1e-2));
+    CHECK_NE(after.e23(), before.e23());
+}
@@ -0,0 +1,212 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/memory.hpp>
+#include <klein/soa.hpp>
+
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+constexpr size_t count = 11;
+
+motor test_motor()
+{
+    motor m{1.f, 4.f, 3.f, 2.f, 5.f, 6.f, 7.f, 8.f};
+    m.normalize();
+    return m;
+}
+
+template <typename E>
+std::vector<E> test_entities();
+
+template <>
+std::vector<point> test_entities()
+{
+    std::vector<point> out;
+    for (size_t i = 0; i != count; ++i)
+    {
+        float f = static_cast<float>(i);
+        out.emplace_back(f - 3.f, 0.5f * f, 2.f - f);
+    }
+    return out;
+}
+
+template <>
+std::vector<plane> test_entities()
+{
+    std::vector<plane> out;
+    for (size_t i = 0; i != count; ++i)
+    {
+        float f = static_cast<float>(i);
+        out.emplace_back(1.f, f - 2.f, 0.5f * f, 3.f - f);
+    }
+    return out;
+}
+
+template <>
+std::vector<line> test_entities()
+{
+    std::vector<line> out;
+    for (size_t i = 0; i != count; ++i)
+    {
+        float f = static_cast<float>(i);
+        out.emplace_back(f, -1.f, 2.f, 0.5f * f, 1.f, 3.f - f);
+    }
+    return out;
+}
+
+void check(point const& a, point const& b)
+{
+    CHECK_EQ(a.x(), doctest::Approx(b.x()).epsilon(1e-5));
+    CHECK_EQ(a.y(), doctest::Approx(b.y()).epsilon(1e-5));
+    CHECK_EQ(a.z(), doctest::Approx(b.z()).epsilon(1e-5));
+    CHECK_EQ(a.w(), doctest::Approx(b.w()).epsilon(1e-5));
+}
+
+void check(plane const& a, plane const& b)
+{
+    CHECK_EQ(a.x(), doctest::Approx(b.x()).epsilon(1e-5));
+    CHECK_EQ(a.y(), doctest::Approx(b.y()).epsilon(1e-5));
+    CHECK_EQ(a.z(), doctest::Approx(b.z()).epsilon(1e-5));
+    CHECK_EQ(a.d(), doctest::Approx(b.d()).epsilon(1e-5));
+}
+
+void check(line const& a, line const& b)
+{
+    CHECK_EQ(a.e23(), doctest::Approx(b.e23()).epsilon(1e-5));
+    CHECK_EQ(a.e31(), doctest::Approx(b.e31()).epsilon(1e-5));
+    CHECK_EQ(a.e12(), doctest::Approx(b.e12()).epsilon(1e-5));
+    CHECK_EQ(a.e01(), doctest::Approx(b.e01()).epsilon(1e-5));
+    CHECK_EQ(a.e02(), doctest::Approx(b.e02()).epsilon(1e-5));
+    CHECK_EQ(a.e03(), doctest::Approx(b.e03()).epsilon(1e-5));
+}
+
+void check(motor const& a, motor const& b)
+{
+    CHECK_EQ(a.scalar(), doctest::Approx(b.scalar()).epsilon(1e-5));
+    CHECK_EQ(a.e23(), doctest::Approx(b.e23()).epsilon(1e-5));
+    CHECK_EQ(a.e31(), doctest::Approx(b.e31()).epsilon(1e-5));
+    CHECK_EQ(a.e12(), doctest::Approx(b.e12()).epsilon(1e-5));
+    CHECK_EQ(a.e01(), doctest::Approx(b.e01()).epsilon(1e-5));
+    CHECK_EQ(a.e02(), doctest::Approx(b.e02()).epsilon(1e-5));
+    CHECK_EQ(a.e03(), doctest::Approx(b.e03()).epsilon(1e-5));
+    CHECK_EQ(a.e0123(), doctest::Approx(b.e0123()).epsilon(1e-5));
+}
+
+template <typename E, typename S>
+void check_apply()
+{
+    std::vector<E> in = test_entities<E>();
+    aligned_vector<float> storage(S::storage_size(count));
+    S soa{storage.data(), count};
+    soa.pack(in.data());
+
+    motor m = test_motor();
+    apply(m, soa, soa);
+    std::vector<E> out(count);
+    soa.unpack(out.data());
+    for (size_t i = 0; i != count; ++i)
+    {
+        check(out[i], m(in[i]));
+    }
+
+    rotor r{0.7f, 1.f, -2.f, 0.5f};
+    soa.pack(in.data());
+    apply(r, soa, soa);
+    for (size_t i = 0; i != count; ++i)
+    {
+        check(soa.get(i), r(in[i]));
+    }
+}
+} // namespace
+
+TEST_CASE("soa-pack")
+{
+    std::vector<point> points = test_entities<point>();
+    aligned_vector<float> storage(point_soa::storage_size(count));
+    point_soa soa{storage.data(), count};
+    CHECK_EQ(soa.stride(), 16);
+    soa.pack(points.data());
+    for (size_t i = 0; i != count; ++i)
+    {
+        CHECK_EQ(soa.x()[i], points[i].x());
+        CHECK_EQ(soa.y()[i], points[i].y());
+        CHECK_EQ(soa.z()[i], points[i].z());
+        CHECK_EQ(soa.w()[i], points[i].w());
+    }
+
+    // The write past the last element must leave the output untouched
+    std::vector<point> out(count + 1);
+    out[count] = point{9.f, 9.f, 9.f};
+    soa.unpack(out.data());
+    for (size_t i = 0; i != count; ++i)
+    {
+        check(out[i], points[i]);
+    }
+    check(out[count], point{9.f, 9.f, 9.f});
+
+    soa.set(3, point{1.f, 2.f, 3.f});
+    check(soa.get(3), point{1.f, 2.f, 3.f});
+
+    std::vector<line> lines = test_entities<line>();
+    aligned_vector<float> line_storage(line_soa::storage_size(count));
+    line_soa lsoa{line_storage.data(), count};
+    lsoa.pack(lines.data());
+    std::vector<line> lout(count);
+    lsoa.unpack(lout.data());
+    for (size_t i = 0; i != count; ++i)
+    {
+        check(lout[i], lines[i]);
+        check(lsoa.get(i), lines[i]);
+    }
+}
+
+TEST_CASE("soa-apply")
+{
+    check_apply<point, point_soa>();
+    check_apply<plane, plane_soa>();
+    check_apply<line, line_soa>();
+}
+
+TEST_CASE("soa-motors")
+{
+    std::vector<motor> motors;
+    for (size_t i = 0; i != count; ++i)
+    {
+        float f = static_cast<float>(i);
+        motors.emplace_back(1.f, f, 0.5f, -f, 0.2f * f, 1.f, 2.f, 3.f);
+    }
+
+    aligned_vector<float> storage(motor_soa::storage_size(count));
+    motor_soa msoa{storage.data(), count};
+    msoa.pack(motors.data());
+    msoa.normalize();
+    for (size_t i = 0; i != count; ++i)
+    {
+        motors[i].normalize_precise();
+        check(msoa.get(i), motors[i]);
+    }
+
+    std::vector<point> points = test_entities<point>();
+    aligned_vector<float> point_storage(point_soa::storage_size(count));
+    point_soa psoa{point_storage.data(), count};
+    psoa.pack(points.data());
+    apply(msoa, psoa, psoa);
+    for (size_t i = 0; i != count; ++i)
+    {
+        check(psoa.get(i), motors[i](points[i]));
+    }
+
+    aligned_vector<float> product_storage(motor_soa::storage_size(count));
+    motor_soa product{product_storage.data(), count};
+    multiply(msoa, msoa, product);
+    std::vector<motor> out(count);
+    product.unpack(out.data());
+    for (size_t i = 0; i != count; ++i)
+    {
+        check(out[i], motors[i] * motors[i]);
+    }
+}
@@ -0,0 +1,145 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/stream.hpp>
+
+#include "fixtures.hpp"
+
+#include <cstdio>
+#include <vector>
+
+using namespace kln;
+
+namespace
+{
+std::vector<point> make_points(size_t count)
+{
+    std::vector<point> out;
+    out.reserve(count);
+    for (size_t i = 0; i != count; ++i)
+    {
+        float x = static_cast<float>(i);
+        out.emplace_back(x, -0.5f * x, 2.f);
+    }
+    return out;
+}
+} // namespace
+
+TEST_CASE("stream-memory")
+{
+    motor m = fixture_motor();
+
+    std::vector<point> storage(4 * 64);
+    // Partial last chunk, exact multiple of the chunk, a single partial
+    // chunk, and no data at all
+    for (size_t count : {size_t{1000}, size_t{640}, size_t{5}, size_t{0}})
+    {
+        for (size_t buffers : {size_t{2}, size_t{3}, size_t{4}})
+        {
+            std::vector<point> in = make_points(count);
+            std::vector<point> expected(count);
+            m(in.data(), expected.data(), count);
+
+            stream<point> s{storage.data(), 64, buffers};
+            CHECK_EQ(s.buffers(), buffers);
+            std::vector<point> out;
+            stream_result r
+                = s.run(stream_memory_source(in.data(), count),
+                        m,
+                        [&out](point const* data, size_t n) {
+                            out.insert(out.end(), data, data + n);
+                            return true;
+                        });
+            CHECK_EQ(r.status, stream_status::ok);
+            CHECK_EQ(r.count, count);
+            CHECK_EQ(mismatches(expected, out), 0);
+        }
+    }
+}
+
+TEST_CASE("stream-chain")
+{
+    // A callable applying two motors in turn
+    motor a = fixture_motor();
+    motor b{-0.3f, 1.f, line{0.f, 1.f, 0.f, 1.f, 0.f, 0.f}};
+    std::vector<point> in = make_points(300);
+    std::vector<point> expected(in.size());
+    a(in.data(), expected.data(), in.size());
+    b(expected.data(), expected.data(), expected.size());
+
+    std::vector<point> storage(3 * 32);
+    stream<point> s{storage.data(), 32};
+    std::vector<point> out;
+    stream_result r = s.run(
+        stream_memory_source(in.data(), in.size()),
+        [&](point* data, size_t n) {
+            a(data, data, n);
+            b(data, data, n);
+        },
+        [&out](point const* data, size_t n) {
+            out.insert(out.end(), data, data + n);
+            return true;
+        });
+    CHECK_EQ(r.count, in.size());
+    CHECK_EQ(mismatches(expected, out), 0);
+}
+
+TEST_CASE("stream-file")
+{
+    rotor ro{0.7f, 1.f, -2.f, 0.5f};
+    std::vector<point> in = make_points(777);
+    std::vector<point> expected(in.size());
+    ro(in.data(), expected.data(), in.size());
+
+    std::FILE* src = std::tmpfile();
+    std::FILE* dst = std::tmpfile();
+    REQUIRE(src != nullptr);
+    REQUIRE(dst != nullptr);
+    std::fwrite(in.data(), sizeof(point), in.size(), src);
+    std::rewind(src);
+
+    std::vector<point> storage(3 * 100);
+    stream<point> s{storage.data(), 100};
+    stream_result r = s.run(stream_file_source<point>(src),
+                            ro,
+                            stream_file_sink<point>(dst));
+    CHECK_EQ(r.status, stream_status::ok);
+    CHECK_EQ(r.count, in.size());
+
+    std::rewind(dst);
+    std::vector<point> out(in.size() + 1);
+    out.resize(std::fread(out.data(), sizeof(point), out.size(), dst));
+    CHECK_EQ(mismatches(expected, out), 0);
+    std::fclose(src);
+    std::fclose(dst);
+}
+
+TEST_CASE("stream-errors")
+{
+    std::vector<point> in = make_points(1000);
+    std::vector<point> storage(3 * 100);
+    stream<point> s{storage.data(), 100};
+    auto identity = [](point*, size_t) {};
+
+    // The sink fails on its fourth chunk
+    int calls       = 0;
+    stream_result r = s.run(stream_memory_source(in.data(), in.size()),
+                            identity,
+                            [&calls](point const*, size_t) {
+                                return ++calls < 4;
+                            });
+    CHECK_EQ(r.status, stream_status::write_error);
+    CHECK_EQ(r.count, 300);
+
+    // The source fails on its third chunk
+    int reads = 0;
+    r         = s.run(
+        [&reads](point*, size_t max, size_t& count) {
+            count = max;
+            return ++reads < 3;
+        },
+        identity,
+        [](point const*, size_t) { return true; });
+    CHECK_EQ(r.status, stream_status::read_error);
+    CHECK_LE(r.count, 200);
+}
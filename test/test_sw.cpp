@@ -135,6 +135,29 @@ TEST_CASE("construct-motor")
     CHECK_EQ(l.e03(), doctest::Approx(-0.5).epsilon(0.001));
 }
 
+TEST_CASE("construct-motor-via-translator")
+{
+    translator t{2.f, 1.f, -1.f, 0.5f};
+    point p1{1.f, 2.f, 3.f};
+    point expected = t(p1);
+
+    motor m{t};
+    CHECK_EQ(m.scalar(), 1.f);
+    point p2 = m(p1);
+    CHECK_EQ(p2.x(), doctest::Approx(expected.x()));
+    CHECK_EQ(p2.y(), doctest::Approx(expected.y()));
+    CHECK_EQ(p2.z(), doctest::Approx(expected.z()));
+    CHECK_EQ(p2.w(), doctest::Approx(1.f));
+
+    m  = rotor{1.f, 0.f, 0.f, 1.f};
+    m  = t;
+    p2 = m(p1);
+    CHECK_EQ(m.scalar(), 1.f);
+    CHECK_EQ(p2.x(), doctest::Approx(expected.x()));
+    CHECK_EQ(p2.y(), doctest::Approx(expected.y()));
+    CHECK_EQ(p2.z(), doctest::Approx(expected.z()));
+}
+
 TEST_CASE("construct-motor-via-screw-axis")
 {
     motor m{M_PI * 0.5f, 1.f, line{0.f, 0.f, 0.f, 0.f, 0.f, 1.f}};
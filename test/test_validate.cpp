@@ -0,0 +1,169 @@
+#include <doctest/doctest.h>
+
+#include <klein/klein.hpp>
+#include <klein/validate.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace kln;
+
+namespace
+{
+struct recorder
+{
+    int calls = 0;
+    validate::event last{};
+};
+
+void record(validate::event const& e, void* user)
+{
+    recorder* r = static_cast<recorder*>(user);
+    ++r->calls;
+    r->last = e;
+}
+
+size_t index(validate::check c)
+{
+    return static_cast<size_t>(c);
+}
+} // namespace
+
+TEST_CASE("validate-measures")
+{
+    rotor r{0.7f, 1.f, -2.f, 0.5f};
+    CHECK_LT(validate::norm_error(r), 1e-5f);
+    CHECK_EQ(validate::norm_error(r * 1.1f), doctest::Approx(0.21f));
+
+    motor m{0.3f, 0.5f, line{1.f, -2.f, 0.5f, 0.2f, -0.4f, 0.8f}};
+    m.normalize_precise();
+    CHECK_LT(validate::norm_error(m), 1e-5f);
+
+    // Perturbing the ideal part breaks m * ~m = 1 in the pseudoscalar only
+    motor drifted = m;
+    drifted.p2_   = _mm_add_ps(drifted.p2_, _mm_set_ps(0.f, 0.f, 0.f, 0.01f));
+    CHECK_EQ(validate::norm_error(drifted),
+             doctest::Approx(0.02f * m.scalar()).epsilon(0.01f));
+
+    // The join of two points is simple
+    line simple = point{1.f, 2.f, 3.f} & point{-1.f, 0.5f, 2.f};
+    CHECK_LT(validate::simple_error(simple), 1e-5f);
+
+    // e23 + e01 is not
+    line screw{1.f, 0.f, 0.f, 1.f, 0.f, 0.f};
+    CHECK_EQ(validate::simple_error(screw), doctest::Approx(1.f));
+}
+
+TEST_CASE("validate")
+{
+    recorder rec;
+    validate::reset();
+    validate::set_callback(&record, &rec);
+
+    rotor r{0.7f, 1.f, -2.f, 0.5f};
+    point p{1.f, 2.f, 3.f};
+    point q = r(p);
+
+    rotor drifted = r * 1.01f;
+    q             = drifted(q);
+
+    float nan = std::numeric_limits<float>::quiet_NaN();
+    plane a{1.f, 0.f, 0.f, 0.f};
+    plane b{0.f, nan, 0.f, 0.f};
+    motor ab = a * b;
+
+    plane big{1e30f, 0.f, 0.f, 1e30f};
+    motor overflow = big * big;
+
+    line screw{1.f, 0.f, 0.f, 1.f, 0.f, 0.f};
+    motor m{0.5f, 1.f, screw};
+
+    validate::stats s = validate::get();
+    if constexpr (validate::enabled())
+    {
+        CHECK_GE(s.checks, 5);
+        CHECK_EQ(s.violations[index(validate::check::rotor_norm)], 1);
+        CHECK_EQ(s.max_error[index(validate::check::rotor_norm)],
+                 doctest::Approx(0.0201f).epsilon(0.01f));
+        CHECK_EQ(s.violations[index(validate::check::non_finite_input)], 1);
+        CHECK_EQ(s.violations[index(validate::check::non_finite_output)], 1);
+        CHECK_EQ(s.violations[index(validate::check::non_simple_line)], 1);
+        CHECK_EQ(s.violations[index(validate::check::motor_norm)], 0);
+
+        CHECK_EQ(rec.calls, 4);
+        CHECK_EQ(rec.last.check, validate::check::non_simple_line);
+        CHECK_EQ(std::strcmp(rec.last.site, "motor(float, float, line)"), 0);
+
+        // Drift below the tolerance is tracked but not reported
+        validate::reset();
+        validate::set_tolerance(0.1f);
+        q = drifted(q);
+        s = validate::get();
+        CHECK_EQ(s.violations[index(validate::check::rotor_norm)], 0);
+        CHECK_GT(s.max_error[index(validate::check::rotor_norm)], 0.02f);
+        CHECK_EQ(validate::tolerance(), 0.1f);
+        validate::set_tolerance(1e-3f);
+
+        validate::reset();
+        CHECK_EQ(validate::get().checks, 0);
+    }
+    else
+    {
+        CHECK_EQ(s.checks, 0);
+        CHECK_EQ(rec.calls, 0);
+    }
+
+    validate::set_callback(nullptr);
+    CHECK_EQ(std::strcmp(validate::name(validate::check::motor_norm),
+                         "motor_norm"),
+             0);
+    (void)ab;
+    (void)overflow;
+    (void)m;
+}
+
+TEST_CASE("validate-arrays")
+{
+    recorder rec;
+    validate::reset();
+    validate::set_callback(&record, &rec);
+
+    // About a simple axis, so constructing it reports nothing
+    motor m{0.3f, 0.5f, line{1.f, -2.f, 0.5f, 2.f, 1.f, 0.f}};
+    m.normalize_precise();
+    float nan = std::numeric_limits<float>::quiet_NaN();
+
+    point points[3] = {
+        point{1.f, 2.f, 3.f}, point{-1.f, 0.f, 2.f}, point{0.f, 1.f, 0.f}};
+    point out[3];
+    m(points, out, 3);
+
+    // Detected in place, before the input is overwritten
+    points[1] = point{nan, 0.f, 0.f};
+    m(points, points, 3);
+
+    plane planes[2] = {plane{1.f, 0.f, 0.f, 0.f}, plane{0.f, 0.f, 0.f, 3e38f}};
+    rotor r{0.7f, 1.f, -2.f, 0.5f};
+    rotor scaled = r * 1e20f;
+    plane planes_out[2];
+    validate::set_tolerance(std::numeric_limits<float>::infinity());
+    scaled(planes, planes_out, 2, batch_policy{64, true});
+    validate::set_tolerance(1e-3f);
+
+    validate::stats s = validate::get();
+    if constexpr (validate::enabled())
+    {
+        CHECK_EQ(s.violations[index(validate::check::non_finite_input)], 1);
+        CHECK_EQ(s.violations[index(validate::check::non_finite_output)], 1);
+        CHECK_EQ(rec.calls, 2);
+        CHECK_EQ(rec.last.check, validate::check::non_finite_output);
+        CHECK_EQ(std::strcmp(rec.last.site, "rotor(plane*)"), 0);
+    }
+    else
+    {
+        CHECK_EQ(rec.calls, 0);
+    }
+
+    validate::set_callback(nullptr);
+}